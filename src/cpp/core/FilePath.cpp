@@ -746,6 +746,22 @@ Error FilePath::copy(const FilePath& targetPath) const
    }
 }
 
+Error FilePath::link(const FilePath& targetPath) const
+{
+   try
+   {
+      boost::filesystem::create_hard_link(pImpl_->path, targetPath.pImpl_->path);
+      return Success();
+   }
+   catch(const boost::filesystem::filesystem_error& e)
+   {
+      Error error(e.code(), ERROR_LOCATION);
+      addErrorProperties(pImpl_->path, &error);
+      error.addProperty("target-path", targetPath.absolutePath());
+      return error;
+   }
+}
+
 
 
 bool FilePath::isHidden() const
@@ -18,6 +18,7 @@
 
 #include <core/Error.hpp>
 #include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
 
 namespace rstudio {
 namespace core {
@@ -38,6 +39,33 @@ TEST_CASE("file paths")
 
       CHECK(aPath.relativePath(pPath) == "a");
    }
+
+   SECTION("hard links share contents")
+   {
+      FilePath dirPath;
+      REQUIRE(!FilePath::tempFilePath(&dirPath));
+      REQUIRE(!dirPath.ensureDirectory());
+
+      FilePath source = dirPath.childPath("source");
+      FilePath target = dirPath.childPath("target");
+      REQUIRE(!writeStringToFile(source, "contents"));
+      REQUIRE(!source.link(target));
+
+      std::string contents;
+      REQUIRE(!readStringFromFile(target, &contents));
+      CHECK(contents == "contents");
+
+      // removing one path leaves the other intact
+      REQUIRE(!source.remove());
+      REQUIRE(!readStringFromFile(target, &contents));
+      CHECK(contents == "contents");
+
+      // links can't replace an existing file
+      REQUIRE(!writeStringToFile(source, "other"));
+      CHECK(source.link(target));
+
+      REQUIRE(!dirPath.remove());
+   }
 }
 
 } // end namespace tests
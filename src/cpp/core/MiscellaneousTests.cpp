@@ -19,6 +19,9 @@
 #include <string>
 #include <iostream>
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 #include <core/Algorithm.hpp>
 #include <core/RegexUtils.hpp>
 #include <core/collection/LruCache.hpp>
@@ -30,6 +33,27 @@ namespace unit_tests {
 
 using namespace core::collection;
 
+namespace {
+
+std::size_t stringCost(const int&, const std::string& value)
+{
+   return value.size();
+}
+
+void exerciseCache(LruCache<int, std::string>* pCache, int seed, int iterations)
+{
+   std::string value(64, 'x');
+   std::string result;
+   for (int i = 0; i < iterations; ++i)
+   {
+      int key = (seed * 7919 + i * 31) % 4096;
+      if (!pCache->get(key, &result))
+         pCache->insert(key, value);
+   }
+}
+
+} // anonymous namespace
+
 class SuppressOutputScope
 {
 public:
@@ -232,6 +256,83 @@ context("LruCache")
       expect_true(cache.get(5000, &val));
       expect_false(cache.get(900, &val));
    }
+
+   test_that("Capacity can be measured by entry cost")
+   {
+      LruCache<int, std::string> cache(100, 1, stringCost);
+      for (int i = 0; i < 10; ++i)
+      {
+         cache.insert(i, std::string(20, 'x'));
+      }
+
+      // only five 20 byte entries fit in 100 bytes
+      expect_true(cache.size() == 5);
+      expect_true(cache.cost() == 100);
+      expect_true(cache.statistics().evictions == 5);
+
+      // entries larger than the capacity are never cached
+      cache.insert(100, std::string(200, 'x'));
+      std::string val;
+      expect_false(cache.get(100, &val));
+      expect_true(cache.get(9, &val));
+   }
+
+   test_that("Expired entries are not returned")
+   {
+      LruCache<int, int> cache(100, 1, LruCache<int, int>::CostFunction(),
+                               boost::chrono::milliseconds(1));
+      cache.insert(1, 1);
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+
+      int val;
+      expect_false(cache.get(1, &val));
+      expect_true(cache.size() == 0);
+      expect_true(cache.statistics().expirations == 1);
+   }
+
+   test_that("Statistics track hits and misses")
+   {
+      LruCache<int, int> cache(10);
+      cache.insert(1, 1);
+
+      int val;
+      cache.get(1, &val);
+      cache.get(1, &val);
+      cache.get(2, &val);
+
+      LruCacheStatistics stats = cache.statistics();
+      expect_true(stats.hits == 2);
+      expect_true(stats.misses == 1);
+      expect_true(stats.entries == 1);
+   }
+
+   test_that("Sharded cache is consistent under concurrent access")
+   {
+      const int kThreads = 8;
+      const int kIterations = 50000;
+
+      // 1024 64 byte entries split across 16 shards
+      LruCache<int, std::string> cache(64 * 1024, 16, stringCost);
+
+      boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+      boost::thread_group threads;
+      for (int i = 0; i < kThreads; ++i)
+      {
+         threads.create_thread(boost::bind(exerciseCache, &cache, i, kIterations));
+      }
+      threads.join_all();
+      boost::posix_time::time_duration elapsed =
+            boost::posix_time::microsec_clock::universal_time() - start;
+
+      LruCacheStatistics stats = cache.statistics();
+      expect_true(stats.hits + stats.misses == static_cast<std::size_t>(kThreads * kIterations));
+      expect_true(stats.cost <= 64 * 1024);
+      expect_true(stats.cost == stats.entries * 64);
+
+      // contention between the threads shouldn't serialize them to a crawl
+      // (the bound is loose enough for debug builds)
+      expect_true(elapsed < boost::posix_time::seconds(30));
+   }
 }
 
 } // namespace unit_tests
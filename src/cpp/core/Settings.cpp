@@ -19,13 +19,19 @@
 #include <core/FilePath.hpp>
 #include <core/SafeConvert.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/system/System.hpp>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
 
 namespace rstudio {
 namespace core {
 
 Settings::Settings()
    : updatePending_(false),
-     isDirty_(false)
+     isDirty_(false),
+     flushScheduled_(false)
 {
 }
 
@@ -37,7 +43,10 @@ Error Settings::initialize(const FilePath& filePath)
 {
    settingsFile_ = filePath ;
    settingsMap_.clear() ;
+   writtenSettingsMap_.clear() ;
+   isDirty_ = false;
    Error error = core::readStringMapFromFile(settingsFile_, &settingsMap_) ;
+   writtenSettingsMap_ = settingsMap_;
    if (error)
    {
       // we don't consider file-not-found and error because it is a 
@@ -60,7 +69,7 @@ void Settings::set(const std::string& name, const std::string& value)
       isDirty_ = true;
       
       if (!updatePending_)
-         writeSettings() ;
+         onDirty() ;
    }
 }
    
@@ -142,20 +151,90 @@ void Settings::beginUpdate()
 void Settings::endUpdate()
 {
    updatePending_ = false ;
+   if (isDirty_)
+      onDirty();
+}
+
+void Settings::setDeferredWrites(const boost::function<void()>& scheduleFlush)
+{
+   scheduleFlush_ = scheduleFlush;
+}
+
+void Settings::flush()
+{
+   flushScheduled_ = false;
    if (isDirty_)
       writeSettings();
 }
 
+void Settings::onDirty()
+{
+   if (!scheduleFlush_)
+   {
+      writeSettings();
+   }
+   else if (!flushScheduled_)
+   {
+      flushScheduled_ = true;
+      scheduleFlush_();
+   }
+}
+
 void Settings::writeSettings() 
 {
    isDirty_ = false;
-   Error error = core::writeStringMapToFile(settingsFile_, settingsMap_) ; 
+
+   // skip the write if nothing has changed since the file was last read or
+   // written (e.g. a value was changed and then changed back)
+   if (settingsMap_ == writtenSettingsMap_)
+      return;
+
+   // write to a temporary file alongside the settings file and then move it
+   // into place, so the settings file is never observed partially written.
+   // for symlinked settings files this is done alongside the file linked to
+   // (so the link survives), and the replaced file's permissions are kept
+   Error error;
+   FilePath targetFile = settingsFile_;
+   if (settingsFile_.isSymlink() &&
+       core::system::realPath(settingsFile_, &targetFile))
+   {
+      // a dangling link; there's nothing to replace so write through it
+      error = core::writeStringMapToFile(settingsFile_, settingsMap_);
+   }
+   else
+   {
+      FilePath tempFile = targetFile.parent().childPath(
+               "." + targetFile.filename() + "-" +
+               core::system::generateShortenedUuid());
+      error = core::writeStringMapToFile(tempFile, settingsMap_) ;
+#ifndef _WIN32
+      struct stat st;
+      if (!error && ::stat(targetFile.absolutePath().c_str(), &st) == 0 &&
+          ::chmod(tempFile.absolutePath().c_str(), st.st_mode & 07777) == -1)
+      {
+         error = systemError(errno, ERROR_LOCATION);
+         error.addProperty("path", tempFile);
+      }
+#endif
+      if (!error)
+         error = tempFile.move(targetFile, FilePath::MoveDirect);
+      if (error)
+      {
+         Error removeError = tempFile.removeIfExists();
+         if (removeError)
+            LOG_ERROR(removeError);
+      }
+   }
+
    if (error)
-     LOG_ERROR(error);
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   writtenSettingsMap_ = settingsMap_;
 }
 
 
 }
 }
-
-
@@ -0,0 +1,148 @@
+/*
+ * SettingsTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <boost/bind.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Settings.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+void countFlush(int* pCount)
+{
+   ++*pCount;
+}
+
+std::string readValue(const FilePath& filePath, const std::string& name)
+{
+   Settings settings;
+   REQUIRE(!settings.initialize(filePath));
+   return settings.get(name);
+}
+
+} // anonymous namespace
+
+TEST_CASE("settings")
+{
+   SECTION("changes are written immediately by default")
+   {
+      FilePath filePath;
+      REQUIRE(!FilePath::tempFilePath(&filePath));
+
+      Settings settings;
+      REQUIRE(!settings.initialize(filePath));
+      settings.set("name", std::string("value"));
+      CHECK(readValue(filePath, "name") == "value");
+
+      filePath.remove();
+   }
+
+   SECTION("deferred changes are coalesced until flushed")
+   {
+      FilePath filePath;
+      REQUIRE(!FilePath::tempFilePath(&filePath));
+
+      int flushes = 0;
+      Settings settings;
+      REQUIRE(!settings.initialize(filePath));
+      settings.setDeferredWrites(boost::bind(countFlush, &flushes));
+
+      settings.set("a", 1);
+      settings.set("b", 2);
+      settings.set("a", 3);
+      CHECK(flushes == 1);
+      CHECK(!filePath.exists());
+
+      settings.flush();
+      CHECK(readValue(filePath, "a") == "3");
+      CHECK(readValue(filePath, "b") == "2");
+
+      // a new batch of changes schedules another flush
+      settings.set("b", 4);
+      CHECK(flushes == 2);
+
+      filePath.remove();
+   }
+
+   SECTION("unchanged settings are not rewritten")
+   {
+      FilePath filePath;
+      REQUIRE(!FilePath::tempFilePath(&filePath));
+
+      int flushes = 0;
+      Settings settings;
+      REQUIRE(!settings.initialize(filePath));
+      settings.setDeferredWrites(boost::bind(countFlush, &flushes));
+
+      settings.set("a", 1);
+      settings.flush();
+      REQUIRE(filePath.exists());
+
+      // change a value and then change it back; the flush has nothing to
+      // write so the file is left alone
+      REQUIRE(!writeStringToFile(filePath, "a=sentinel\n"));
+      settings.set("a", 2);
+      settings.set("a", 1);
+      settings.flush();
+      CHECK(readValue(filePath, "a") == "sentinel");
+
+      filePath.remove();
+   }
+
+#ifndef _WIN32
+   SECTION("symlinks and permissions are kept when writing")
+   {
+      FilePath targetPath, linkPath;
+      REQUIRE(!FilePath::tempFilePath(&targetPath));
+      REQUIRE(!FilePath::tempFilePath(&linkPath));
+      REQUIRE(!writeStringToFile(targetPath, "a=1\n"));
+      REQUIRE(::chmod(targetPath.absolutePath().c_str(), 0640) == 0);
+      REQUIRE(::symlink(targetPath.absolutePath().c_str(),
+                        linkPath.absolutePath().c_str()) == 0);
+
+      Settings settings;
+      REQUIRE(!settings.initialize(linkPath));
+      settings.set("a", 2);
+
+      CHECK(linkPath.isSymlink());
+      CHECK(readValue(targetPath, "a") == "2");
+
+      struct stat st;
+      REQUIRE(::stat(targetPath.absolutePath().c_str(), &st) == 0);
+      CHECK((st.st_mode & 07777) == 0640);
+
+      linkPath.remove();
+      targetPath.remove();
+   }
+#endif
+}
+
+} // end namespace tests
+} // end namespace core
+} // end namespace rstudio
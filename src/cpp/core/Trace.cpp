@@ -17,10 +17,20 @@
 #include <core/Trace.hpp>
 
 #include <map>
+#include <vector>
 
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
+#include <boost/thread/tss.hpp>
 
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
 #include <core/Thread.hpp>
+#include <core/json/Json.hpp>
+#include <core/system/Environment.hpp>
+#include <core/system/System.hpp>
 
 #include <iostream>
 
@@ -32,8 +42,244 @@ namespace {
 
 boost::mutex s_traceMutex ;
 
+// number of spans retained per thread
+const std::size_t kSpanBufferSize = 8192;
+
+// number of exited threads whose spans are retained
+const std::size_t kMaxExitedSpanBuffers = 8;
+
+struct SpanEvent
+{
+   const char* name;
+   std::string detail;
+   boost::int64_t start;
+   boost::int64_t duration;
+};
+
+struct SpanBuffer : boost::noncopyable
+{
+   SpanBuffer(int threadId)
+      : threadId(threadId), next(0), exited(false)
+   {
+   }
+
+   void record(const char* name, const std::string& detail,
+               boost::int64_t start, boost::int64_t duration)
+   {
+      LOCK_MUTEX(mutex)
+      {
+         // grow until full, then overwrite the oldest span
+         if (events.size() < kSpanBufferSize)
+            events.push_back(SpanEvent());
+
+         SpanEvent& event = events[next];
+         event.name = name;
+         event.detail = detail;
+         event.start = start;
+         event.duration = duration;
+
+         next = (next + 1) % kSpanBufferSize;
+      }
+      END_LOCK_MUTEX
+   }
+
+   void copyTo(std::vector<SpanEvent>* pEvents)
+   {
+      LOCK_MUTEX(mutex)
+      {
+         if (events.size() == kSpanBufferSize)
+            pEvents->insert(pEvents->end(), events.begin() + next, events.end());
+         pEvents->insert(pEvents->end(), events.begin(), events.begin() + next);
+      }
+      END_LOCK_MUTEX
+   }
+
+   const int threadId;
+   std::vector<SpanEvent> events;
+   std::size_t next;
+
+   // set (under s_spanBuffersMutex) when the owning thread exits
+   bool exited;
+
+   // only contended while spans are being exported
+   boost::mutex mutex;
+};
+
+boost::atomic<int> s_spansEnabled(-1);
+
+// buffers for all threads that have recorded spans (in order of creation)
+boost::mutex s_spanBuffersMutex;
+std::vector<boost::shared_ptr<SpanBuffer> > s_spanBuffers;
+int s_nextThreadId = 1;
+
+void releaseThreadSpanBuffer(SpanBuffer* pBuffer)
+{
+   // the buffer is owned by s_spanBuffers; keep it so that the thread's
+   // spans can still be exported, but drop the oldest buffers of other
+   // exited threads so that threads which come and go don't accumulate
+   LOCK_MUTEX(s_spanBuffersMutex)
+   {
+      pBuffer->exited = true;
+
+      std::size_t exitedCount = 0;
+      for (std::size_t i = 0; i < s_spanBuffers.size(); ++i)
+      {
+         if (s_spanBuffers[i]->exited)
+            ++exitedCount;
+      }
+
+      std::vector<boost::shared_ptr<SpanBuffer> >::iterator it =
+                                                      s_spanBuffers.begin();
+      while (exitedCount > kMaxExitedSpanBuffers && it != s_spanBuffers.end())
+      {
+         if ((*it)->exited)
+         {
+            it = s_spanBuffers.erase(it);
+            --exitedCount;
+         }
+         else
+         {
+            ++it;
+         }
+      }
+   }
+   END_LOCK_MUTEX
+}
+
+boost::thread_specific_ptr<SpanBuffer> s_pThreadSpanBuffer(releaseThreadSpanBuffer);
+
+SpanBuffer& threadSpanBuffer()
+{
+   SpanBuffer* pBuffer = s_pThreadSpanBuffer.get();
+   if (pBuffer == NULL)
+   {
+      LOCK_MUTEX(s_spanBuffersMutex)
+      {
+         boost::shared_ptr<SpanBuffer> pNewBuffer(
+                                       new SpanBuffer(s_nextThreadId++));
+         s_spanBuffers.push_back(pNewBuffer);
+         pBuffer = pNewBuffer.get();
+      }
+      END_LOCK_MUTEX
+
+      s_pThreadSpanBuffer.reset(pBuffer);
+   }
+   return *pBuffer;
+}
+
+boost::int64_t nowMicroseconds()
+{
+   using namespace boost::chrono;
+   return duration_cast<microseconds>(
+            steady_clock::now().time_since_epoch()).count();
+}
+
 } // anonymous namespace
 
+bool spansEnabled()
+{
+   int enabled = s_spansEnabled.load(boost::memory_order_relaxed);
+   if (enabled < 0)
+   {
+      enabled = core::system::getenv("RSTUDIO_TRACE_SPANS") == "1" ? 1 : 0;
+      s_spansEnabled.store(enabled, boost::memory_order_relaxed);
+   }
+   return enabled == 1;
+}
+
+void setSpansEnabled(bool enabled)
+{
+   s_spansEnabled.store(enabled ? 1 : 0, boost::memory_order_relaxed);
+}
+
+Span::Span(const char* name)
+   : name_(name), start_(-1)
+{
+   if (spansEnabled())
+      start_ = nowMicroseconds();
+}
+
+Span::~Span()
+{
+   try
+   {
+      end();
+   }
+   catch(...)
+   {
+   }
+}
+
+void Span::end()
+{
+   if (active())
+   {
+      threadSpanBuffer().record(name_,
+                                detail_,
+                                start_,
+                                nowMicroseconds() - start_);
+      start_ = -1;
+   }
+}
+
+void writeChromeTrace(std::ostream& os)
+{
+   // snapshot the buffers
+   std::vector<boost::shared_ptr<SpanBuffer> > buffers;
+   LOCK_MUTEX(s_spanBuffersMutex)
+   {
+      buffers = s_spanBuffers;
+   }
+   END_LOCK_MUTEX
+
+   int pid = static_cast<int>(core::system::currentProcessId());
+
+   json::Array traceEvents;
+   for (std::size_t i = 0; i < buffers.size(); ++i)
+   {
+      std::vector<SpanEvent> events;
+      buffers[i]->copyTo(&events);
+
+      for (std::vector<SpanEvent>::const_iterator it = events.begin();
+           it != events.end();
+           ++it)
+      {
+         json::Object event;
+         event["name"] = it->name;
+         event["cat"] = "rstudio";
+         event["ph"] = "X";
+         event["ts"] = it->start;
+         event["dur"] = it->duration;
+         event["pid"] = pid;
+         event["tid"] = buffers[i]->threadId;
+         if (!it->detail.empty())
+         {
+            json::Object args;
+            args["detail"] = it->detail;
+            event["args"] = args;
+         }
+         traceEvents.push_back(event);
+      }
+   }
+
+   json::Object trace;
+   trace["traceEvents"] = traceEvents;
+   trace["displayTimeUnit"] = "ms";
+
+   json::write(trace, os);
+}
+
+Error writeChromeTrace(const FilePath& filePath)
+{
+   boost::shared_ptr<std::ostream> pStream;
+   Error error = filePath.open_w(&pStream);
+   if (error)
+      return error;
+
+   writeChromeTrace(*pStream);
+   return Success();
+}
+
 
 void add(void* key, const std::string& functionName)
 {
@@ -0,0 +1,136 @@
+/*
+ * TraceTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/Trace.hpp>
+
+#include <sstream>
+
+#include <core/json/Json.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace trace {
+namespace tests {
+
+namespace {
+
+// find the last exported event with the given name
+bool findEvent(const std::string& name, json::Object* pEvent)
+{
+   std::ostringstream ostr;
+   writeChromeTrace(ostr);
+
+   json::Value traceJson;
+   if (!json::parse(ostr.str(), &traceJson) ||
+       !json::isType<json::Object>(traceJson))
+   {
+      return false;
+   }
+
+   bool found = false;
+   const json::Object& traceObject = traceJson.get_obj();
+   const json::Array& events =
+                  traceObject.find("traceEvents")->second.get_array();
+   for (std::size_t i = 0; i < events.size(); ++i)
+   {
+      const json::Object& event = events[i].get_obj();
+      json::Object::const_iterator it = event.find("name");
+      if (it != event.end() && it->second.get_str() == name)
+      {
+         *pEvent = event;
+         found = true;
+      }
+   }
+   return found;
+}
+
+boost::int64_t int64Field(const json::Object& event, const std::string& name)
+{
+   return event.find(name)->second.get_int64();
+}
+
+} // anonymous namespace
+
+context("TraceTests")
+{
+   test_that("Spans are only recorded when enabled")
+   {
+      setSpansEnabled(false);
+      {
+         TRACE_SPAN("trace.tests.disabled");
+      }
+
+      json::Object event;
+      expect_false(findEvent("trace.tests.disabled", &event));
+   }
+
+   test_that("Nested spans are exported within their parent")
+   {
+      setSpansEnabled(true);
+      {
+         TRACE_SPAN_DETAIL("trace.tests.outer", "outer detail");
+         {
+            TRACE_SPAN("trace.tests.inner");
+         }
+      }
+      setSpansEnabled(false);
+
+      json::Object outer, inner;
+      REQUIRE(findEvent("trace.tests.outer", &outer));
+      REQUIRE(findEvent("trace.tests.inner", &inner));
+
+      expect_true(outer.find("ph")->second.get_str() == "X");
+      expect_true(int64Field(outer, "ts") <= int64Field(inner, "ts"));
+      expect_true(int64Field(inner, "ts") + int64Field(inner, "dur") <=
+                  int64Field(outer, "ts") + int64Field(outer, "dur"));
+      expect_true(int64Field(outer, "tid") == int64Field(inner, "tid"));
+
+      const json::Object& args = outer.find("args")->second.get_obj();
+      expect_true(args.find("detail")->second.get_str() == "outer detail");
+   }
+
+   test_that("Ending a span records it once")
+   {
+      setSpansEnabled(true);
+      boost::int64_t endedDuration;
+      {
+         Span span("trace.tests.ended");
+         span.end();
+         expect_false(span.active());
+
+         json::Object event;
+         REQUIRE(findEvent("trace.tests.ended", &event));
+         endedDuration = int64Field(event, "dur");
+      }
+      setSpansEnabled(false);
+
+      // destroying the span doesn't record it again
+      std::ostringstream ostr;
+      writeChromeTrace(ostr);
+      std::string trace = ostr.str();
+      std::string::size_type first = trace.find("trace.tests.ended");
+      expect_true(first != std::string::npos);
+      expect_true(trace.find("trace.tests.ended", first + 1) ==
+                  std::string::npos);
+      expect_true(endedDuration >= 0);
+   }
+}
+
+} // namespace tests
+} // namespace trace
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,882 @@
+/*
+ * Zip.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/Zip.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <istream>
+#include <ostream>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <zlib.h>
+
+#include <core/Error.hpp>
+#include <core/Log.hpp>
+
+// record signatures
+#define kLocalHeaderSignature          0x04034b50
+#define kDataDescriptorSignature       0x08074b50
+#define kCentralHeaderSignature        0x02014b50
+#define kEndOfCentralDirSignature      0x06054b50
+#define kZip64EndOfCentralDirSignature 0x06064b50
+#define kZip64LocatorSignature         0x07064b50
+
+// fixed sizes of records (excluding their variable length fields)
+#define kLocalHeaderSize          30
+#define kCentralHeaderSize        46
+#define kEndOfCentralDirSize      22
+#define kZip64EndOfCentralDirSize 56
+#define kZip64LocatorSize         20
+
+#define kZip64ExtraId 0x0001
+
+// general purpose flags
+#define kFlagEncrypted      0x0001
+#define kFlagDataDescriptor 0x0008
+#define kFlagUtf8           0x0800
+
+#define kMethodStored   0
+#define kMethodDeflated 8
+
+// versions needed to extract (2.0 for deflate, 4.5 for zip64)
+#define kVersionDefault 20
+#define kVersionZip64   45
+
+// 'made by' host for archives which record unix file modes
+#define kHostUnix 3
+
+#define kMax16 0xFFFFULL
+#define kMax32 0xFFFFFFFFULL
+
+// files at least this large are written with zip64 sizes (leaving room for
+// deflate's slight expansion of incompressible data)
+#define kZip64Threshold 0xFF000000ULL
+
+#define kBufferSize (64 * 1024)
+#define kDefaultMemoryUsage 8
+
+namespace rstudio {
+namespace core {
+namespace zip {
+
+namespace {
+
+void put16(std::string* pOutput, boost::uint16_t value)
+{
+   pOutput->push_back(static_cast<char>(value & 0xFF));
+   pOutput->push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+void put32(std::string* pOutput, boost::uint32_t value)
+{
+   put16(pOutput, static_cast<boost::uint16_t>(value & 0xFFFF));
+   put16(pOutput, static_cast<boost::uint16_t>(value >> 16));
+}
+
+void put64(std::string* pOutput, boost::uint64_t value)
+{
+   put32(pOutput, static_cast<boost::uint32_t>(value & kMax32));
+   put32(pOutput, static_cast<boost::uint32_t>(value >> 32));
+}
+
+boost::uint16_t get16(const char* data)
+{
+   const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+   return static_cast<boost::uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+boost::uint32_t get32(const char* data)
+{
+   return get16(data) | (static_cast<boost::uint32_t>(get16(data + 2)) << 16);
+}
+
+boost::uint64_t get64(const char* data)
+{
+   return get32(data) | (static_cast<boost::uint64_t>(get32(data + 4)) << 32);
+}
+
+Error invalidArchiveError(const FilePath& archivePath,
+                          const ErrorLocation& location)
+{
+   Error error = systemError(boost::system::errc::illegal_byte_sequence,
+                             location);
+   error.addProperty("path", archivePath);
+   return error;
+}
+
+Error ioError(const FilePath& path, const ErrorLocation& location)
+{
+   Error error = systemError(boost::system::errc::io_error, location);
+   error.addProperty("path", path);
+   return error;
+}
+
+void freeDeflateStream(z_stream* pStream)
+{
+   (void)::deflateEnd(pStream);
+   delete pStream;
+}
+
+void freeInflateStream(z_stream* pStream)
+{
+   (void)::inflateEnd(pStream);
+   delete pStream;
+}
+
+void dosDateTime(std::time_t time,
+                 boost::uint16_t* pDosTime,
+                 boost::uint16_t* pDosDate)
+{
+   std::tm tm = std::tm();
+#ifdef _WIN32
+   ::localtime_s(&tm, &time);
+#else
+   ::localtime_r(&time, &tm);
+#endif
+
+   // dos dates can't precede 1980
+   if (tm.tm_year < 80)
+   {
+      *pDosTime = 0;
+      *pDosDate = (1 << 5) | 1;
+      return;
+   }
+
+   *pDosTime = static_cast<boost::uint16_t>(
+            (tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2));
+   *pDosDate = static_cast<boost::uint16_t>(
+            ((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+}
+
+boost::uint32_t fileMode(const FilePath& path, bool isDirectory)
+{
+#ifndef _WIN32
+   struct stat st;
+   if (::stat(path.absolutePath().c_str(), &st) == 0)
+      return st.st_mode & 0xFFFF;
+#endif
+   return isDirectory ? 040755 : 0100644;
+}
+
+bool addEntry(const FilePath& parentPath,
+              std::vector<ZipEntry>* pEntries,
+              int,
+              const FilePath& path)
+{
+   // files outside the parent are archived by name alone
+   std::string name = path.relativePath(parentPath);
+   if (name.empty() || name.find("..") == 0)
+      name = path.filename();
+#ifdef _WIN32
+   boost::algorithm::replace_all(name, "\\", "/");
+#endif
+
+   if (path.isDirectory())
+      name.push_back('/');
+   pEntries->push_back(ZipEntry(name, path));
+   return true;
+}
+
+// an entry as described by an archive's central directory
+struct ArchiveEntry
+{
+   std::string name;
+   boost::uint16_t flags;
+   boost::uint16_t method;
+   boost::uint32_t crc;
+   boost::uint64_t compressedSize;
+   boost::uint64_t uncompressedSize;
+   boost::uint64_t offset;
+
+   // unix file mode (zero if the archive doesn't record one)
+   boost::uint32_t mode;
+};
+
+bool readAt(std::istream& is,
+            boost::uint64_t offset,
+            std::size_t size,
+            std::string* pData)
+{
+   is.clear();
+   is.seekg(static_cast<std::streamoff>(offset));
+   pData->resize(size);
+   if (size > 0)
+      is.read(&(*pData)[0], size);
+   return is && static_cast<std::size_t>(is.gcount()) == size;
+}
+
+Error readCentralDirectory(const FilePath& archivePath,
+                           std::istream& is,
+                           std::vector<ArchiveEntry>* pEntries)
+{
+   is.seekg(0, std::ios::end);
+   boost::uint64_t archiveSize = static_cast<boost::uint64_t>(is.tellg());
+
+   // the end of central directory record ends the archive, followed only by
+   // a comment of up to 64K
+   std::size_t tailSize = static_cast<std::size_t>(
+            std::min<boost::uint64_t>(archiveSize, kEndOfCentralDirSize + kMax16));
+   std::string tail;
+   if (tailSize < kEndOfCentralDirSize ||
+       !readAt(is, archiveSize - tailSize, tailSize, &tail))
+   {
+      return invalidArchiveError(archivePath, ERROR_LOCATION);
+   }
+
+   std::size_t endPos = std::string::npos;
+   for (std::size_t i = tailSize - kEndOfCentralDirSize + 1; i-- > 0; )
+   {
+      if (get32(tail.data() + i) == kEndOfCentralDirSignature)
+      {
+         endPos = i;
+         break;
+      }
+   }
+   if (endPos == std::string::npos)
+      return invalidArchiveError(archivePath, ERROR_LOCATION);
+
+   const char* pEnd = tail.data() + endPos;
+   boost::uint64_t count = get16(pEnd + 10);
+   boost::uint64_t directorySize = get32(pEnd + 12);
+   boost::uint64_t directoryOffset = get32(pEnd + 16);
+
+   // values which don't fit are in the zip64 record, which is found via the
+   // locator immediately preceding the end record
+   if (count == kMax16 || directorySize == kMax32 || directoryOffset == kMax32)
+   {
+      boost::uint64_t endOffset = archiveSize - tailSize + endPos;
+      std::string locator, zip64End;
+      if (endOffset < kZip64LocatorSize ||
+          !readAt(is, endOffset - kZip64LocatorSize, kZip64LocatorSize, &locator) ||
+          get32(locator.data()) != kZip64LocatorSignature ||
+          !readAt(is, get64(locator.data() + 8), kZip64EndOfCentralDirSize, &zip64End) ||
+          get32(zip64End.data()) != kZip64EndOfCentralDirSignature)
+      {
+         return invalidArchiveError(archivePath, ERROR_LOCATION);
+      }
+
+      count = get64(zip64End.data() + 32);
+      directorySize = get64(zip64End.data() + 40);
+      directoryOffset = get64(zip64End.data() + 48);
+   }
+
+   std::string directory;
+   if (directoryOffset > archiveSize ||
+       directorySize > archiveSize - directoryOffset ||
+       !readAt(is, directoryOffset, static_cast<std::size_t>(directorySize), &directory))
+   {
+      return invalidArchiveError(archivePath, ERROR_LOCATION);
+   }
+
+   std::size_t pos = 0;
+   for (boost::uint64_t i = 0; i < count; i++)
+   {
+      const char* pHeader = directory.data() + pos;
+      if (directory.size() - pos < kCentralHeaderSize ||
+          get32(pHeader) != kCentralHeaderSignature)
+      {
+         return invalidArchiveError(archivePath, ERROR_LOCATION);
+      }
+
+      boost::uint16_t madeBy = get16(pHeader + 4);
+      std::size_t nameSize = get16(pHeader + 28);
+      std::size_t extraSize = get16(pHeader + 30);
+      std::size_t commentSize = get16(pHeader + 32);
+      if (directory.size() - pos - kCentralHeaderSize <
+          nameSize + extraSize + commentSize)
+      {
+         return invalidArchiveError(archivePath, ERROR_LOCATION);
+      }
+
+      ArchiveEntry entry;
+      entry.flags = get16(pHeader + 8);
+      entry.method = get16(pHeader + 10);
+      entry.crc = get32(pHeader + 16);
+      entry.compressedSize = get32(pHeader + 20);
+      entry.uncompressedSize = get32(pHeader + 24);
+      entry.offset = get32(pHeader + 42);
+      entry.name.assign(pHeader + kCentralHeaderSize, nameSize);
+
+      boost::uint32_t attributes = get32(pHeader + 38);
+      entry.mode = (madeBy >> 8) == kHostUnix ? (attributes >> 16) : 0;
+
+      // the zip64 extra field holds (in order) whichever values didn't fit
+      const char* pExtra = pHeader + kCentralHeaderSize + nameSize;
+      for (std::size_t e = 0; e + 4 <= extraSize; )
+      {
+         boost::uint16_t id = get16(pExtra + e);
+         std::size_t size = get16(pExtra + e + 2);
+         if (e + 4 + size > extraSize)
+            break;
+
+         if (id == kZip64ExtraId)
+         {
+            const char* pValue = pExtra + e + 4;
+            const char* pValueEnd = pValue + size;
+            boost::uint64_t* values[] = { &entry.uncompressedSize,
+                                          &entry.compressedSize,
+                                          &entry.offset };
+            for (std::size_t v = 0; v < 3; v++)
+            {
+               if (*values[v] == kMax32 && pValueEnd - pValue >= 8)
+               {
+                  *values[v] = get64(pValue);
+                  pValue += 8;
+               }
+            }
+         }
+
+         e += 4 + size;
+      }
+
+      pEntries->push_back(entry);
+      pos += kCentralHeaderSize + nameSize + extraSize + commentSize;
+   }
+
+   return Success();
+}
+
+Error openArchive(const FilePath& archivePath,
+                  boost::shared_ptr<std::istream>* pStream,
+                  std::vector<ArchiveEntry>* pEntries)
+{
+   Error error = archivePath.open_r(pStream);
+   if (error)
+      return error;
+
+   return readCentralDirectory(archivePath, **pStream, pEntries);
+}
+
+// resolve where an entry is extracted to, rejecting names which would
+// escape the target directory
+Error entryTargetPath(const FilePath& archivePath,
+                      const std::string& name,
+                      const FilePath& targetPath,
+                      FilePath* pEntryPath)
+{
+   std::string path = name;
+   boost::algorithm::replace_all(path, "\\", "/");
+
+   bool valid = !path.empty() &&
+                path[0] != '/' &&
+                !(path.size() > 1 && path[1] == ':');
+
+   std::vector<std::string> components;
+   boost::algorithm::split(components, path, boost::algorithm::is_any_of("/"));
+   BOOST_FOREACH(const std::string& component, components)
+   {
+      if (component == "..")
+         valid = false;
+   }
+
+   if (!valid)
+   {
+      Error error = systemError(boost::system::errc::invalid_argument,
+                                ERROR_LOCATION);
+      error.addProperty("path", archivePath);
+      error.addProperty("entry", name);
+      return error;
+   }
+
+   while (!path.empty() && path[path.size() - 1] == '/')
+      path.erase(path.size() - 1);
+
+   *pEntryPath = path.empty() ? targetPath : targetPath.complete(path);
+   return Success();
+}
+
+Error extractEntry(const FilePath& archivePath,
+                   std::istream& is,
+                   const ArchiveEntry& entry,
+                   const FilePath& entryPath)
+{
+   if ((entry.flags & kFlagEncrypted) ||
+       (entry.method != kMethodStored && entry.method != kMethodDeflated))
+   {
+      Error error = systemError(boost::system::errc::operation_not_supported,
+                                ERROR_LOCATION);
+      error.addProperty("path", archivePath);
+      error.addProperty("entry", entry.name);
+      return error;
+   }
+
+   // the data follows the local header (whose variable length fields may
+   // differ from those in the central directory)
+   std::string header;
+   if (!readAt(is, entry.offset, kLocalHeaderSize, &header) ||
+       get32(header.data()) != kLocalHeaderSignature)
+   {
+      return invalidArchiveError(archivePath, ERROR_LOCATION);
+   }
+   is.clear();
+   is.seekg(static_cast<std::streamoff>(
+               entry.offset + kLocalHeaderSize +
+               get16(header.data() + 26) + get16(header.data() + 28)));
+
+   Error error = entryPath.parent().ensureDirectory();
+   if (error)
+      return error;
+
+   boost::shared_ptr<std::ostream> pOutput;
+   error = entryPath.open_w(&pOutput);
+   if (error)
+      return error;
+
+   boost::shared_ptr<z_stream> zStream;
+   if (entry.method == kMethodDeflated)
+   {
+      zStream.reset(new z_stream(), freeInflateStream);
+      int res = ::inflateInit2(zStream.get(), -MAX_WBITS);
+      if (res != Z_OK)
+         return systemError(res, "ZLib initialization error", ERROR_LOCATION);
+   }
+
+   std::vector<char> input(kBufferSize);
+   std::vector<char> output(kBufferSize);
+   boost::uint64_t remaining = entry.compressedSize;
+   boost::uint64_t written = 0;
+   uLong crc = ::crc32(0L, Z_NULL, 0);
+   bool finished = false;
+   while (!finished)
+   {
+      std::size_t inputSize = static_cast<std::size_t>(
+               std::min<boost::uint64_t>(remaining, kBufferSize));
+      if (inputSize > 0)
+      {
+         is.read(&input[0], inputSize);
+         if (static_cast<std::size_t>(is.gcount()) != inputSize)
+            return invalidArchiveError(archivePath, ERROR_LOCATION);
+         remaining -= inputSize;
+      }
+
+      if (entry.method == kMethodStored)
+      {
+         pOutput->write(&input[0], inputSize);
+         crc = ::crc32(crc, reinterpret_cast<const Bytef*>(&input[0]),
+                       static_cast<uInt>(inputSize));
+         written += inputSize;
+         finished = remaining == 0;
+      }
+      else
+      {
+         zStream->next_in = reinterpret_cast<Bytef*>(&input[0]);
+         zStream->avail_in = static_cast<uInt>(inputSize);
+         do
+         {
+            zStream->next_out = reinterpret_cast<Bytef*>(&output[0]);
+            zStream->avail_out = kBufferSize;
+            int res = ::inflate(zStream.get(), Z_NO_FLUSH);
+            if (res != Z_OK && res != Z_STREAM_END && res != Z_BUF_ERROR)
+               return invalidArchiveError(archivePath, ERROR_LOCATION);
+
+            std::size_t produced = kBufferSize - zStream->avail_out;
+            pOutput->write(&output[0], produced);
+            crc = ::crc32(crc, reinterpret_cast<const Bytef*>(&output[0]),
+                          static_cast<uInt>(produced));
+            written += produced;
+            finished = res == Z_STREAM_END;
+         } while (!finished && zStream->avail_out == 0);
+
+         // all of the data has been read but the stream didn't end
+         if (!finished && remaining == 0)
+            return invalidArchiveError(archivePath, ERROR_LOCATION);
+      }
+
+      if (pOutput->fail())
+         return ioError(entryPath, ERROR_LOCATION);
+
+      // don't write more than the archive claims the entry holds
+      if (written > entry.uncompressedSize)
+         return invalidArchiveError(archivePath, ERROR_LOCATION);
+   }
+
+   pOutput->flush();
+   if (pOutput->fail())
+      return ioError(entryPath, ERROR_LOCATION);
+
+   if (written != entry.uncompressedSize || crc != entry.crc)
+      return invalidArchiveError(archivePath, ERROR_LOCATION);
+
+#ifndef _WIN32
+   // restore permissions (e.g. the executable bit) recorded by the archive
+   if (entry.mode & 0777)
+      ::chmod(entryPath.absolutePath().c_str(), entry.mode & 0777);
+#endif
+
+   return Success();
+}
+
+} // anonymous namespace
+
+Error listEntries(const FilePath& parentPath,
+                  const std::vector<std::string>& files,
+                  std::vector<ZipEntry>* pEntries)
+{
+   BOOST_FOREACH(const std::string& file, files)
+   {
+      FilePath path = parentPath.complete(file);
+      addEntry(parentPath, pEntries, 0, path);
+      if (path.isDirectory())
+      {
+         Error error = path.childrenRecursive(
+                  boost::bind(addEntry, parentPath, pEntries, _1, _2));
+         if (error)
+            return error;
+      }
+   }
+
+   return Success();
+}
+
+ZipWriter::ZipWriter(const std::vector<ZipEntry>& entries)
+   : state_(EntryHeader),
+     entries_(entries),
+     index_(0),
+     written_(0),
+     inputEnded_(false)
+{
+}
+
+ZipWriter::~ZipWriter()
+{
+}
+
+Error ZipWriter::nextChunk(std::size_t chunkSize, std::string* pChunk)
+{
+   pChunk->clear();
+   while (pChunk->size() < chunkSize && state_ != Finished)
+   {
+      if (state_ == EntryHeader)
+      {
+         if (index_ == entries_.size())
+         {
+            writeCentralDirectory(pChunk);
+            state_ = Finished;
+            continue;
+         }
+
+         Error error = beginEntry(pChunk);
+         if (error)
+            return error;
+      }
+      else
+      {
+         bool done = false;
+         Error error = compressEntry(chunkSize, pChunk, &done);
+         if (error)
+            return error;
+
+         if (done)
+         {
+            error = endEntry(pChunk);
+            if (error)
+               return error;
+         }
+      }
+   }
+
+   written_ += pChunk->size();
+   return Success();
+}
+
+Error ZipWriter::beginEntry(std::string* pOutput)
+{
+   const ZipEntry& entry = entries_[index_];
+   if (entry.name.empty() || entry.name.size() > kMax16)
+   {
+      Error error = systemError(boost::system::errc::filename_too_long,
+                                ERROR_LOCATION);
+      error.addProperty("path", entry.path);
+      return error;
+   }
+
+   Record record;
+   record.name = entry.name;
+   record.crc = ::crc32(0L, Z_NULL, 0);
+   record.compressedSize = 0;
+   record.uncompressedSize = 0;
+   record.offset = written_ + pOutput->size();
+   record.isDirectory = entry.name[entry.name.size() - 1] == '/';
+   record.mode = fileMode(entry.path, record.isDirectory);
+   record.zip64 = !record.isDirectory && entry.path.size() >= kZip64Threshold;
+   dosDateTime(entry.path.lastWriteTime(), &record.dosTime, &record.dosDate);
+
+   if (!record.isDirectory)
+   {
+      Error error = entry.path.open_r(&pInput_);
+      if (error)
+         return error;
+
+      zStream_.reset(new z_stream(), freeDeflateStream);
+      int res = ::deflateInit2(zStream_.get(),
+                               Z_DEFAULT_COMPRESSION,
+                               Z_DEFLATED,
+                               -MAX_WBITS,
+                               kDefaultMemoryUsage,
+                               Z_DEFAULT_STRATEGY);
+      if (res != Z_OK)
+         return systemError(res, "ZLib initialization error", ERROR_LOCATION);
+
+      inputBuffer_.resize(kBufferSize);
+      inputEnded_ = false;
+   }
+
+   // sizes and checksum are unknown until the data has been compressed, so
+   // they're left empty here and written in a descriptor after the data
+   put32(pOutput, kLocalHeaderSignature);
+   put16(pOutput, record.zip64 ? kVersionZip64 : kVersionDefault);
+   put16(pOutput, kFlagUtf8 | (record.isDirectory ? 0 : kFlagDataDescriptor));
+   put16(pOutput, record.isDirectory ? kMethodStored : kMethodDeflated);
+   put16(pOutput, record.dosTime);
+   put16(pOutput, record.dosDate);
+   put32(pOutput, 0);
+   put32(pOutput, record.zip64 ? kMax32 : 0);
+   put32(pOutput, record.zip64 ? kMax32 : 0);
+   put16(pOutput, static_cast<boost::uint16_t>(record.name.size()));
+   put16(pOutput, record.zip64 ? 20 : 0);
+   pOutput->append(record.name);
+   if (record.zip64)
+   {
+      put16(pOutput, kZip64ExtraId);
+      put16(pOutput, 16);
+      put64(pOutput, 0);
+      put64(pOutput, 0);
+   }
+
+   records_.push_back(record);
+   if (record.isDirectory)
+      index_++;
+   else
+      state_ = EntryData;
+
+   return Success();
+}
+
+Error ZipWriter::compressEntry(std::size_t chunkSize,
+                               std::string* pOutput,
+                               bool* pDone)
+{
+   Record& record = records_.back();
+   z_stream* pStream = zStream_.get();
+
+   // read more input once zlib has consumed the last of it
+   if (pStream->avail_in == 0 && !inputEnded_)
+   {
+      pInput_->read(&inputBuffer_[0], inputBuffer_.size());
+      if (pInput_->bad())
+         return ioError(entries_[index_].path, ERROR_LOCATION);
+
+      std::size_t read = static_cast<std::size_t>(pInput_->gcount());
+      inputEnded_ = pInput_->eof() || read == 0;
+      record.crc = ::crc32(record.crc,
+                           reinterpret_cast<const Bytef*>(&inputBuffer_[0]),
+                           static_cast<uInt>(read));
+      record.uncompressedSize += read;
+
+      pStream->next_in = reinterpret_cast<Bytef*>(&inputBuffer_[0]);
+      pStream->avail_in = static_cast<uInt>(read);
+   }
+
+   // compress directly into the chunk
+   std::size_t outputSize = pOutput->size();
+   std::size_t available = std::max<std::size_t>(
+            chunkSize > outputSize ? chunkSize - outputSize : 0, 1024);
+   pOutput->resize(outputSize + available);
+   pStream->next_out = reinterpret_cast<Bytef*>(&(*pOutput)[outputSize]);
+   pStream->avail_out = static_cast<uInt>(available);
+
+   int res = ::deflate(pStream, inputEnded_ ? Z_FINISH : Z_NO_FLUSH);
+   std::size_t produced = available - pStream->avail_out;
+   pOutput->resize(outputSize + produced);
+   if (res == Z_STREAM_ERROR)
+      return systemError(res, "ZLib compression error", ERROR_LOCATION);
+
+   record.compressedSize += produced;
+
+   // sizes which no longer fit (because the file grew after we checked it)
+   // can't be recorded without zip64
+   if (!record.zip64 &&
+       (record.uncompressedSize > kMax32 || record.compressedSize > kMax32))
+   {
+      Error error = systemError(boost::system::errc::file_too_large,
+                                ERROR_LOCATION);
+      error.addProperty("path", entries_[index_].path);
+      return error;
+   }
+
+   *pDone = res == Z_STREAM_END;
+   return Success();
+}
+
+Error ZipWriter::endEntry(std::string* pOutput)
+{
+   pInput_.reset();
+   zStream_.reset();
+
+   const Record& record = records_.back();
+   put32(pOutput, kDataDescriptorSignature);
+   put32(pOutput, record.crc);
+   if (record.zip64)
+   {
+      put64(pOutput, record.compressedSize);
+      put64(pOutput, record.uncompressedSize);
+   }
+   else
+   {
+      put32(pOutput, static_cast<boost::uint32_t>(record.compressedSize));
+      put32(pOutput, static_cast<boost::uint32_t>(record.uncompressedSize));
+   }
+
+   index_++;
+   state_ = EntryHeader;
+   return Success();
+}
+
+void ZipWriter::writeCentralDirectory(std::string* pOutput)
+{
+   boost::uint64_t directoryOffset = written_ + pOutput->size();
+   std::size_t directoryStart = pOutput->size();
+
+   BOOST_FOREACH(const Record& record, records_)
+   {
+      // values which don't fit in their fields go in the zip64 extra field
+      bool offset64 = record.offset >= kMax32;
+      std::string extra;
+      if (record.zip64)
+      {
+         put64(&extra, record.uncompressedSize);
+         put64(&extra, record.compressedSize);
+      }
+      if (offset64)
+         put64(&extra, record.offset);
+
+      std::string extraField;
+      if (!extra.empty())
+      {
+         put16(&extraField, kZip64ExtraId);
+         put16(&extraField, static_cast<boost::uint16_t>(extra.size()));
+         extraField.append(extra);
+      }
+
+      put32(pOutput, kCentralHeaderSignature);
+      put16(pOutput, (kHostUnix << 8) | kVersionZip64);
+      put16(pOutput, extra.empty() ? kVersionDefault : kVersionZip64);
+      put16(pOutput, kFlagUtf8 | (record.isDirectory ? 0 : kFlagDataDescriptor));
+      put16(pOutput, record.isDirectory ? kMethodStored : kMethodDeflated);
+      put16(pOutput, record.dosTime);
+      put16(pOutput, record.dosDate);
+      put32(pOutput, record.crc);
+      put32(pOutput, record.zip64 ?
+               kMax32 : static_cast<boost::uint32_t>(record.compressedSize));
+      put32(pOutput, record.zip64 ?
+               kMax32 : static_cast<boost::uint32_t>(record.uncompressedSize));
+      put16(pOutput, static_cast<boost::uint16_t>(record.name.size()));
+      put16(pOutput, static_cast<boost::uint16_t>(extraField.size()));
+      put16(pOutput, 0);
+      put16(pOutput, 0);
+      put16(pOutput, 0);
+      put32(pOutput, (record.mode << 16) | (record.isDirectory ? 0x10 : 0));
+      put32(pOutput, offset64 ?
+               kMax32 : static_cast<boost::uint32_t>(record.offset));
+      pOutput->append(record.name);
+      pOutput->append(extraField);
+   }
+
+   boost::uint64_t directorySize = pOutput->size() - directoryStart;
+   boost::uint64_t count = records_.size();
+   if (count >= kMax16 || directorySize >= kMax32 || directoryOffset >= kMax32)
+   {
+      boost::uint64_t zip64EndOffset = written_ + pOutput->size();
+      put32(pOutput, kZip64EndOfCentralDirSignature);
+      put64(pOutput, kZip64EndOfCentralDirSize - 12);
+      put16(pOutput, (kHostUnix << 8) | kVersionZip64);
+      put16(pOutput, kVersionZip64);
+      put32(pOutput, 0);
+      put32(pOutput, 0);
+      put64(pOutput, count);
+      put64(pOutput, count);
+      put64(pOutput, directorySize);
+      put64(pOutput, directoryOffset);
+
+      put32(pOutput, kZip64LocatorSignature);
+      put32(pOutput, 0);
+      put64(pOutput, zip64EndOffset);
+      put32(pOutput, 1);
+   }
+
+   put32(pOutput, kEndOfCentralDirSignature);
+   put16(pOutput, 0);
+   put16(pOutput, 0);
+   put16(pOutput, static_cast<boost::uint16_t>(std::min<boost::uint64_t>(count, kMax16)));
+   put16(pOutput, static_cast<boost::uint16_t>(std::min<boost::uint64_t>(count, kMax16)));
+   put32(pOutput, static_cast<boost::uint32_t>(std::min<boost::uint64_t>(directorySize, kMax32)));
+   put32(pOutput, static_cast<boost::uint32_t>(std::min<boost::uint64_t>(directoryOffset, kMax32)));
+   put16(pOutput, 0);
+}
+
+Error listArchive(const FilePath& archivePath, std::vector<std::string>* pNames)
+{
+   boost::shared_ptr<std::istream> pStream;
+   std::vector<ArchiveEntry> entries;
+   Error error = openArchive(archivePath, &pStream, &entries);
+   if (error)
+      return error;
+
+   BOOST_FOREACH(const ArchiveEntry& entry, entries)
+   {
+      pNames->push_back(entry.name);
+   }
+   return Success();
+}
+
+Error extractArchive(const FilePath& archivePath, const FilePath& targetPath)
+{
+   boost::shared_ptr<std::istream> pStream;
+   std::vector<ArchiveEntry> entries;
+   Error error = openArchive(archivePath, &pStream, &entries);
+   if (error)
+      return error;
+
+   BOOST_FOREACH(const ArchiveEntry& entry, entries)
+   {
+      FilePath entryPath;
+      error = entryTargetPath(archivePath, entry.name, targetPath, &entryPath);
+      if (error)
+         return error;
+
+      if (entry.name[entry.name.size() - 1] == '/')
+         error = entryPath.ensureDirectory();
+      else
+         error = extractEntry(archivePath, *pStream, entry, entryPath);
+      if (error)
+         return error;
+   }
+
+   return Success();
+}
+
+} // namespace zip
+} // namespace core
+} // namespace rstudio
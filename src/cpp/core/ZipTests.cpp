@@ -0,0 +1,168 @@
+/*
+ * ZipTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+#include <algorithm>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Zip.hpp>
+
+namespace rstudio {
+namespace core {
+namespace zip {
+namespace tests {
+
+namespace {
+
+FilePath createTempDir()
+{
+   FilePath dirPath;
+   REQUIRE(!FilePath::tempFilePath(&dirPath));
+   REQUIRE(!dirPath.ensureDirectory());
+   return dirPath;
+}
+
+std::string binaryContents(std::size_t size)
+{
+   std::string contents;
+   unsigned int value = 1;
+   for (std::size_t i = 0; i < size; i++)
+   {
+      value = value * 1103515245 + 12345;
+      contents.push_back(static_cast<char>(value >> 16));
+   }
+   return contents;
+}
+
+void writeArchive(const std::vector<ZipEntry>& entries,
+                  std::size_t chunkSize,
+                  const FilePath& archivePath)
+{
+   ZipWriter writer(entries);
+   std::string archive, chunk;
+   do
+   {
+      REQUIRE(!writer.nextChunk(chunkSize, &chunk));
+      archive.append(chunk);
+   } while (!chunk.empty());
+
+   REQUIRE(!writeStringToFile(archivePath, archive));
+}
+
+std::string fileContents(const FilePath& filePath)
+{
+   std::string contents;
+   REQUIRE(!readStringFromFile(filePath, &contents));
+   return contents;
+}
+
+} // anonymous namespace
+
+TEST_CASE("zip archives")
+{
+   SECTION("files and folders round trip through an archive")
+   {
+      FilePath sourceDir = createTempDir();
+      std::string text(100000, 'a');
+      std::string binary = binaryContents(300000);
+      REQUIRE(!writeStringToFile(sourceDir.childPath("a.txt"), text));
+      REQUIRE(!sourceDir.childPath("data/nested").ensureDirectory());
+      REQUIRE(!writeStringToFile(sourceDir.childPath("data/b.bin"), binary));
+      REQUIRE(!writeStringToFile(sourceDir.childPath("data/nested/empty"), ""));
+
+      std::vector<std::string> files;
+      files.push_back("a.txt");
+      files.push_back("data");
+      std::vector<ZipEntry> entries;
+      REQUIRE(!listEntries(sourceDir, files, &entries));
+      REQUIRE(entries.size() == 5);
+
+      FilePath archivePath = createTempDir().childPath("test.zip");
+      writeArchive(entries, 4096, archivePath);
+
+      std::vector<std::string> names;
+      REQUIRE(!listArchive(archivePath, &names));
+      std::sort(names.begin(), names.end());
+      REQUIRE(names.size() == 5);
+      CHECK(names[0] == "a.txt");
+      CHECK(names[1] == "data/");
+      CHECK(names[2] == "data/b.bin");
+      CHECK(names[3] == "data/nested/");
+      CHECK(names[4] == "data/nested/empty");
+
+      FilePath targetDir = createTempDir();
+      REQUIRE(!extractArchive(archivePath, targetDir));
+      CHECK(fileContents(targetDir.childPath("a.txt")) == text);
+      CHECK(fileContents(targetDir.childPath("data/b.bin")) == binary);
+      CHECK(fileContents(targetDir.childPath("data/nested/empty")).empty());
+
+      sourceDir.remove();
+      archivePath.parent().remove();
+      targetDir.remove();
+   }
+
+   SECTION("damaged archives are rejected")
+   {
+      FilePath sourceDir = createTempDir();
+      REQUIRE(!writeStringToFile(sourceDir.childPath("a.bin"),
+                                 binaryContents(10000)));
+      std::vector<ZipEntry> entries;
+      entries.push_back(ZipEntry("a.bin", sourceDir.childPath("a.bin")));
+      FilePath archivePath = sourceDir.childPath("test.zip");
+      writeArchive(entries, 65536, archivePath);
+
+      // corrupt the compressed data
+      std::string archive = fileContents(archivePath);
+      archive[100] = static_cast<char>(archive[100] ^ 0xFF);
+      REQUIRE(!writeStringToFile(archivePath, archive));
+
+      FilePath targetDir = createTempDir();
+      CHECK(extractArchive(archivePath, targetDir));
+
+      // not an archive at all
+      REQUIRE(!writeStringToFile(archivePath, "not a zip file"));
+      std::vector<std::string> names;
+      CHECK(listArchive(archivePath, &names));
+
+      sourceDir.remove();
+      targetDir.remove();
+   }
+
+   SECTION("entries can't be extracted outside the target")
+   {
+      FilePath sourceDir = createTempDir();
+      REQUIRE(!writeStringToFile(sourceDir.childPath("a.txt"), "a"));
+      std::vector<ZipEntry> entries;
+      entries.push_back(ZipEntry("../escaped.txt", sourceDir.childPath("a.txt")));
+      FilePath archivePath = sourceDir.childPath("test.zip");
+      writeArchive(entries, 65536, archivePath);
+
+      FilePath targetDir = createTempDir();
+      CHECK(extractArchive(archivePath, targetDir));
+      CHECK(!targetDir.parent().childPath("escaped.txt").exists());
+
+      sourceDir.remove();
+      targetDir.remove();
+   }
+}
+
+} // namespace tests
+} // namespace zip
+} // namespace core
+} // namespace rstudio
@@ -33,22 +33,31 @@ ChunkProxy::ChunkProxy(const boost::shared_ptr<AsyncConnection>& pClientConnecti
    pClientConnection_(pClientConnection),
    maxBufferSize_(maxBufferSize),
    wroteHeaders_(false),
+   chunked_(true),
    currentBufferSize_(0),
    bufferFull_(false)
 {
 }
 
-void ChunkProxy::proxy(const boost::shared_ptr<IAsyncClient>& pServerConnection)
+void ChunkProxy::proxy(const boost::shared_ptr<IAsyncClient>& pServerConnection,
+                       const boost::function<void()>& onResponseRead)
 {
    pServerConnection_ = pServerConnection;
+   onResponseRead_ = onResponseRead;
    pServerConnection_->setChunkHandler(boost::bind(&ChunkProxy::queueChunk,
                                                    shared_from_this(),
                                                    _1, _2));
+
+   // relay large non-chunked responses as they're read too (responses
+   // which fit in the buffer are written in one piece once complete)
+   pServerConnection_->setContentStreamThreshold(maxBufferSize_);
 }
 
 bool ChunkProxy::queueChunk(const http::Response& response,
                             const std::string& chunk)
 {
+   boost::function<void()> onResponseRead;
+
    LOCK_MUTEX(mutex_)
    {
       if (currentBufferSize_ + chunk.size() > maxBufferSize_)
@@ -62,11 +71,21 @@ bool ChunkProxy::queueChunk(const http::Response& response,
          return false;
       }
 
+      // chunked responses are relayed chunk by chunk; the content of other
+      // responses is relayed as is (an empty chunk marks the end of either)
+      if (!wroteHeaders_)
+         chunked_ = response.headerValue(kTransferEncoding) == kChunkedTransferEncoding;
+
       // queue the chunk
-      std::string formattedChunk = http::util::formatMessageAsHttpChunk(chunk);
+      std::string formattedChunk = chunked_ ?
+               http::util::formatMessageAsHttpChunk(chunk) : chunk;
       currentBufferSize_ += formattedChunk.size();
       writeBuffer_.emplace(std::move(formattedChunk));
 
+      // an empty chunk marks the end of the response
+      if (chunk.empty())
+         onResponseRead.swap(onResponseRead_);
+
       if (!wroteHeaders_)
       {
          // write the response headers and first chunk
@@ -89,6 +108,10 @@ bool ChunkProxy::queueChunk(const http::Response& response,
    }
    END_LOCK_MUTEX
 
+   // notify outside of the lock (the callback doesn't concern the proxy)
+   if (onResponseRead)
+      onResponseRead();
+
    return true;
 }
 
@@ -137,7 +160,7 @@ void ChunkProxy::onChunkWrote(const boost::system::error_code& ec)
    LOCK_MUTEX(mutex_)
    {
       const std::string& chunk = writeBuffer_.front();
-      bool lastChunk = isLastChunk(chunk);
+      bool lastChunk = chunked_ ? isLastChunk(chunk) : chunk.empty();
       currentBufferSize_ -= writeBuffer_.front().size();
       writeBuffer_.pop();
 
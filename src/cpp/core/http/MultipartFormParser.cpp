@@ -0,0 +1,274 @@
+/*
+ * MultipartFormParser.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/MultipartFormParser.hpp>
+
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+#include <boost/algorithm/string/trim.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/http/Header.hpp>
+#include <core/system/System.hpp>
+
+// limits on the parts of the body which are held in memory
+#define kMaxPartHeadersSize (64 * 1024)
+#define kMaxFieldSize       (1024 * 1024)
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+Error invalidBodyError(const ErrorLocation& location)
+{
+   return systemError(boost::system::errc::protocol_error, location);
+}
+
+} // anonymous namespace
+
+MultipartFormParser::MultipartFormParser(const std::string& contentType,
+                                         const FilePath& spoolPath)
+   : state_(Preamble),
+     delimiter_("\r\n" + util::multipartBoundary(contentType)),
+     spoolPath_(spoolPath),
+     partIsFile_(false)
+{
+   // the first boundary needn't be preceded by a line break; supply one so
+   // that all boundaries can be found the same way
+   pending_ = "\r\n";
+}
+
+Error MultipartFormParser::parse(const char* buffer, std::size_t len)
+{
+   // a body without a boundary can't be parsed
+   if (delimiter_.size() <= 2)
+      return invalidBodyError(ERROR_LOCATION);
+
+   pending_.append(buffer, len);
+
+   while (true)
+   {
+      switch (state_)
+      {
+         case Preamble:
+         case PartBody:
+         {
+            // find the delimiter which ends this part (or the preamble); if
+            // it isn't here yet, consume everything which can't be the start
+            // of the delimiter
+            std::size_t pos = pending_.find(delimiter_);
+            std::size_t consumed = pos;
+            if (pos == std::string::npos)
+            {
+               if (pending_.size() < delimiter_.size())
+                  return Success();
+               consumed = pending_.size() - delimiter_.size() + 1;
+            }
+
+            if (state_ == PartBody)
+            {
+               Error error = appendToPart(pending_.data(), consumed);
+               if (error)
+                  return error;
+            }
+
+            if (pos == std::string::npos)
+            {
+               pending_.erase(0, consumed);
+               return Success();
+            }
+
+            if (state_ == PartBody)
+            {
+               Error error = endPart();
+               if (error)
+                  return error;
+            }
+
+            pending_.erase(0, pos + delimiter_.size());
+            state_ = Boundary;
+            break;
+         }
+
+         case Boundary:
+         {
+            // the boundary is followed either by '--' (the end of the body)
+            // or by a line break and the next part's headers
+            if (pending_.size() < 2)
+               return Success();
+
+            if (pending_.compare(0, 2, "--") == 0)
+            {
+               pending_.clear();
+               state_ = Complete;
+               break;
+            }
+
+            std::size_t pos = pending_.find("\r\n");
+            if (pos == std::string::npos)
+            {
+               if (pending_.size() > kMaxPartHeadersSize)
+                  return invalidBodyError(ERROR_LOCATION);
+               return Success();
+            }
+
+            pending_.erase(0, pos + 2);
+            state_ = PartHeaders;
+            break;
+         }
+
+         case PartHeaders:
+         {
+            // headers end with an empty line (which is all there is when the
+            // part has no headers)
+            if (pending_.size() < 2)
+               return Success();
+
+            std::size_t headersEnd = 0;
+            if (pending_.compare(0, 2, "\r\n") != 0)
+            {
+               std::size_t pos = pending_.find("\r\n\r\n");
+               if (pos == std::string::npos)
+               {
+                  if (pending_.size() > kMaxPartHeadersSize)
+                     return invalidBodyError(ERROR_LOCATION);
+                  return Success();
+               }
+               headersEnd = pos + 2;
+            }
+
+            Error error = beginPart(pending_.substr(0, headersEnd));
+            if (error)
+               return error;
+
+            pending_.erase(0, headersEnd + 2);
+            state_ = PartBody;
+            break;
+         }
+
+         case Complete:
+         {
+            // ignore the epilogue
+            pending_.clear();
+            return Success();
+         }
+      }
+   }
+}
+
+Error MultipartFormParser::beginPart(const std::string& headers)
+{
+   std::istringstream headerStream(headers);
+   headerStream.unsetf(std::ios::skipws);
+   Headers partHeaders;
+   http::parseHeaders(headerStream, &partHeaders);
+
+   partName_.clear();
+   partIsFile_ = false;
+   partFile_ = File();
+   partValue_.clear();
+
+   // parts which aren't form fields are skipped
+   std::string cDisp = http::headerValue(partHeaders, "Content-Disposition");
+   std::string filename;
+   if (cDisp.empty() ||
+       !util::parseFormDataDisposition(cDisp, &partName_, &partIsFile_, &filename))
+   {
+      partName_.clear();
+      return Success();
+   }
+
+   if (partIsFile_)
+   {
+      partFile_.name = filename;
+      partFile_.contentType = http::headerValue(partHeaders, "Content-Type");
+      if (partFile_.contentType.empty())
+         partFile_.contentType = "application/octet-stream";
+
+      partFile_.pSpoolFile.reset(new SpoolFile(spoolPath_.childPath(
+               "upload-" + core::system::generateShortenedUuid())));
+
+      Error error = partFile_.pSpoolFile->path().open_w(&pPartStream_);
+      if (error)
+         return error;
+   }
+
+   return Success();
+}
+
+Error MultipartFormParser::appendToPart(const char* data, std::size_t len)
+{
+   if (partName_.empty() || len == 0)
+      return Success();
+
+   if (partIsFile_)
+   {
+      pPartStream_->write(data, len);
+      if (pPartStream_->fail())
+      {
+         Error error = systemError(boost::system::errc::io_error,
+                                   ERROR_LOCATION);
+         error.addProperty("path", partFile_.pSpoolFile->path());
+         return error;
+      }
+   }
+   else
+   {
+      if (partValue_.size() + len > kMaxFieldSize)
+         return systemError(boost::system::errc::file_too_large,
+                            ERROR_LOCATION);
+      partValue_.append(data, len);
+   }
+
+   return Success();
+}
+
+Error MultipartFormParser::endPart()
+{
+   if (partName_.empty())
+      return Success();
+
+   if (partIsFile_)
+   {
+      pPartStream_->flush();
+      bool failed = pPartStream_->fail();
+      pPartStream_.reset();
+
+      // only the first file with a given name is kept (the contents of
+      // others are removed along with them)
+      files_.insert(std::make_pair(partName_, partFile_));
+      partFile_ = File();
+
+      if (failed)
+         return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+   }
+   else
+   {
+      boost::algorithm::trim(partValue_);
+      fields_.push_back(std::make_pair(partName_, partValue_));
+   }
+
+   partName_.clear();
+   return Success();
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
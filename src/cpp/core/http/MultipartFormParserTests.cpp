@@ -0,0 +1,194 @@
+/*
+ * MultipartFormParserTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/MultipartFormParser.hpp>
+
+#include <vector>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/RequestParser.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+namespace tests {
+
+namespace {
+
+const char* const kContentType = "multipart/form-data; boundary=XyZ";
+
+std::string formBody(const std::string& fileContents)
+{
+   return "--XyZ\r\n"
+          "Content-Disposition: form-data; name=\"targetDirectory\"\r\n"
+          "\r\n"
+          "~/data\r\n"
+          "--XyZ\r\n"
+          "Content-Disposition: form-data; name=\"file\"; filename=\"a.bin\"\r\n"
+          "Content-Type: application/octet-stream\r\n"
+          "\r\n" +
+          fileContents +
+          "\r\n--XyZ--\r\n";
+}
+
+std::string spooledContents(const File& file)
+{
+   std::string contents;
+   REQUIRE(file.pSpoolFile);
+   REQUIRE(!readStringFromFile(file.pSpoolFile->path(), &contents));
+   return contents;
+}
+
+std::size_t spooledFileCount(const FilePath& spoolPath)
+{
+   std::vector<FilePath> children;
+   REQUIRE(!spoolPath.children(&children));
+   return children.size();
+}
+
+} // anonymous namespace
+
+context("MultipartFormParserTests")
+{
+   FilePath spoolPath;
+   REQUIRE(!FilePath::tempFilePath(&spoolPath));
+   REQUIRE(!spoolPath.ensureDirectory());
+
+   test_that("Fields are collected and files are spooled")
+   {
+      std::string fileContents("line one\r\n--Xy\r\nbinary\0data", 27);
+      std::string body = formBody(fileContents);
+
+      {
+         MultipartFormParser parser(kContentType, spoolPath);
+         REQUIRE(!parser.parse(body.data(), body.size()));
+         REQUIRE(parser.complete());
+
+         REQUIRE(parser.fields().size() == 1);
+         expect_true(parser.fields()[0].first == "targetDirectory");
+         expect_true(parser.fields()[0].second == "~/data");
+
+         REQUIRE(parser.files().size() == 1);
+         const File& file = parser.files().begin()->second;
+         expect_true(file.name == "a.bin");
+         expect_true(file.contentType == "application/octet-stream");
+         expect_true(file.contents.empty());
+         expect_true(file.pSpoolFile->path().parent() == spoolPath);
+         expect_true(spooledContents(file) == fileContents);
+      }
+
+      // the spooled file is removed along with the parser
+      expect_true(spooledFileCount(spoolPath) == 0);
+   }
+
+   test_that("Bodies can be parsed in arbitrarily small pieces")
+   {
+      std::string fileContents = "\r\n--Xy is only part of a boundary\r\n--X";
+      std::string body = formBody(fileContents);
+
+      MultipartFormParser parser(kContentType, spoolPath);
+      for (std::size_t i = 0; i < body.size(); i++)
+         REQUIRE(!parser.parse(body.data() + i, 1));
+      REQUIRE(parser.complete());
+
+      REQUIRE(parser.files().size() == 1);
+      const File& file = parser.files().begin()->second;
+      expect_true(spooledContents(file) == fileContents);
+   }
+
+   test_that("Spooled files are removed if the body is incomplete")
+   {
+      // omit the end of the closing boundary
+      std::string body = formBody("contents");
+      {
+         MultipartFormParser parser(kContentType, spoolPath);
+         REQUIRE(!parser.parse(body.data(), body.size() - 3));
+         REQUIRE(!parser.complete());
+         REQUIRE(parser.files().size() == 1);
+         expect_true(spooledFileCount(spoolPath) == 1);
+      }
+      expect_true(spooledFileCount(spoolPath) == 0);
+   }
+
+   test_that("Spooled files can be moved elsewhere")
+   {
+      std::string body = formBody("contents");
+      FilePath targetPath = spoolPath.parent().childPath(
+                                       spoolPath.filename() + "-moved");
+      {
+         MultipartFormParser parser(kContentType, spoolPath);
+         REQUIRE(!parser.parse(body.data(), body.size()));
+         REQUIRE(parser.files().size() == 1);
+         const File& file = parser.files().begin()->second;
+         REQUIRE(!file.pSpoolFile->moveTo(targetPath));
+      }
+      expect_true(spooledFileCount(spoolPath) == 0);
+
+      std::string contents;
+      expect_false(readStringFromFile(targetPath, &contents));
+      expect_true(contents == "contents");
+      targetPath.remove();
+   }
+
+   test_that("Bodies without a boundary are rejected")
+   {
+      MultipartFormParser parser("multipart/form-data", spoolPath);
+      expect_true(parser.parse("--\r\n", 4));
+   }
+
+   test_that("Request parser spools large forms")
+   {
+      std::string body = formBody(std::string(4096, 'x'));
+      std::string request =
+            "POST /upload HTTP/1.1\r\n"
+            "Content-Type: " + std::string(kContentType) + "\r\n"
+            "Content-Length: " + safe_convert::numberToString(body.size()) + "\r\n"
+            "\r\n" + body;
+
+      {
+         Request req;
+         RequestParser parser;
+         parser.setFormSpoolThreshold(1024, spoolPath);
+         RequestParser::status status =
+               parser.parse(req, request.data(), request.data() + request.size());
+         REQUIRE(status == RequestParser::complete);
+
+         expect_true(req.body().empty());
+         expect_true(req.formFieldValue("targetDirectory") == "~/data");
+         const File& file = req.uploadedFile("file");
+         expect_true(spooledContents(file) == std::string(4096, 'x'));
+
+         // the request keeps the file after the parser is reset
+         parser.reset();
+         expect_true(spooledFileCount(spoolPath) == 1);
+      }
+
+      // files nobody claimed are removed along with the request
+      expect_true(spooledFileCount(spoolPath) == 0);
+   }
+
+   spoolPath.removeIfExists();
+}
+
+} // namespace tests
+} // namespace http
+} // namespace core
+} // namespace rstudio
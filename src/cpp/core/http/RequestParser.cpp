@@ -16,345 +16,375 @@
 
 #include <core/http/RequestParser.hpp>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
+#include <cstring>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <core/Error.hpp>
+#include <core/Log.hpp>
 
 namespace rstudio {
 namespace core {
 namespace http {
 
+namespace {
+
+// character classes
+enum
+{
+   kTokenChar = 1,   // may appear in methods and header names
+   kControlChar = 2  // may not appear in uris or header values
+};
+
+class CharClasses
+{
+public:
+   CharClasses()
+   {
+      const char* tspecials = "()<>@,;:\\\"/[]?={} \t";
+      for (int c = 0; c < 256; c++)
+      {
+         unsigned char flags = 0;
+         bool isControl = c <= 31 || c == 127;
+         if (isControl)
+            flags |= kControlChar;
+         if (c <= 127 && !isControl && !std::strchr(tspecials, c))
+            flags |= kTokenChar;
+         classes_[c] = flags;
+      }
+   }
+
+   bool is(char c, unsigned char flags) const
+   {
+      return (classes_[static_cast<unsigned char>(c)] & flags) != 0;
+   }
+
+private:
+   unsigned char classes_[256];
+};
+
+const CharClasses s_charClasses;
+
+bool isTokenChar(char c)
+{
+   return s_charClasses.is(c, kTokenChar);
+}
+
+bool isControlChar(char c)
+{
+   return s_charClasses.is(c, kControlChar);
+}
+
+bool isToken(const char* begin, const char* end)
+{
+   if (begin == end)
+      return false;
+
+   for (const char* it = begin; it != end; ++it)
+   {
+      if (!isTokenChar(*it))
+         return false;
+   }
+   return true;
+}
+
+bool containsControlChar(const char* begin, const char* end)
+{
+   for (const char* it = begin; it != end; ++it)
+   {
+      if (isControlChar(*it))
+         return true;
+   }
+   return false;
+}
+
+// parse one or more digits
+bool parseNumber(const char** pBegin, const char* end, int* pNumber)
+{
+   const char* it = *pBegin;
+   int number = 0;
+   while (it != end && *it >= '0' && *it <= '9')
+      number = number * 10 + (*it++ - '0');
+
+   if (it == *pBegin)
+      return false;
+
+   *pBegin = it;
+   *pNumber = number;
+   return true;
+}
+
+bool parseContentLength(const char* begin, const char* end, std::size_t* pLength)
+{
+   if (begin != end && *begin == '+')
+      ++begin;
+   if (begin == end)
+      return false;
+
+   std::size_t length = 0;
+   for (const char* it = begin; it != end; ++it)
+   {
+      if (*it < '0' || *it > '9')
+         return false;
+
+      std::size_t digit = *it - '0';
+      if (length > (static_cast<std::size_t>(-1) - digit) / 10)
+         return false;
+      length = length * 10 + digit;
+   }
+
+   *pLength = length;
+   return true;
+}
+
+} // anonymous namespace
+
 RequestParser::RequestParser()
-  : state_(method_start), 
-    content_length_(0), 
-    parsing_content_length_(false), 
-    parsing_body_(false)
+  : parsing_request_line_(true),
+    parsing_body_(false),
+    content_length_(0),
+    body_bytes_read_(0),
+    form_spool_threshold_(0),
+    body_stream_threshold_(0)
 {
 }
 
 void RequestParser::reset()
 {
-  state_ = method_start;
-  content_length_ = 0 ;
-  parsing_content_length_ = false ;
+  parsing_request_line_ = true ;
   parsing_body_ = false ;
+  line_buffer_.clear();
+  content_length_ = 0 ;
+  body_bytes_read_ = 0 ;
+  form_parser_.reset();
 }
 
-RequestParser::status RequestParser::consume(Request& req, char input)
+RequestParser::status RequestParser::parse(Request& req,
+                                           const char* begin,
+                                           const char* end)
 {
-  switch (state_)
+  // request line and headers
+  while (!parsing_body_ && begin != end)
   {
-  case method_start:
-    if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-    {
-      return error;
-    }
-    else
-    {
-      state_ = method;
-      req.method_.push_back(input);
-      return incomplete;
-    }
-  case method:
-    if (input == ' ')
-    {
-      state_ = uri;
-      return incomplete;
-    }
-    else if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-    {
-      return error;
-    }
-    else
-    {
-      req.method_.push_back(input);
-      return incomplete;
-    }
-  case uri_start:
-    if (is_ctl(input))
-    {
-      return error;
-    }
-    else
-    {
-      state_ = uri;
-      req.uri_.push_back(input);
-      return incomplete;
-    }
-  case uri:
-    if (input == ' ')
-    {
-      state_ = http_version_h;
-      return incomplete;
-    }
-    else if (is_ctl(input))
-    {
-      return error;
-    }
-    else
-    {
-      req.uri_.push_back(input);
-      return incomplete;
-    }
-  case http_version_h:
-    if (input == 'H')
-    {
-      state_ = http_version_t_1;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_t_1:
-    if (input == 'T')
-    {
-      state_ = http_version_t_2;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_t_2:
-    if (input == 'T')
-    {
-      state_ = http_version_p;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_p:
-    if (input == 'P')
-    {
-      state_ = http_version_slash;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_slash:
-    if (input == '/')
-    {
-      req.httpVersionMajor_ = 0;
-      req.httpVersionMinor_ = 0;
-      state_ = http_version_major_start;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_major_start:
-    if (is_digit(input))
-    {
-      req.httpVersionMajor_ = req.httpVersionMajor_ * 10 + input - '0';
-      state_ = http_version_major;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_major:
-    if (input == '.')
-    {
-      state_ = http_version_minor_start;
-      return incomplete;
-    }
-    else if (is_digit(input))
-    {
-      req.httpVersionMajor_ = req.httpVersionMajor_ * 10 + input - '0';
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_minor_start:
-    if (is_digit(input))
-    {
-      req.httpVersionMinor_ = req.httpVersionMinor_ * 10 + input - '0';
-      state_ = http_version_minor;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case http_version_minor:
-    if (input == '\r')
-    {
-      state_ = expecting_newline_1;
-      return incomplete;
-    }
-    else if (is_digit(input))
-    {
-      req.httpVersionMinor_ = req.httpVersionMinor_ * 10 + input - '0';
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case expecting_newline_1:
-    if (input == '\n')
-    {
-      state_ = header_line_start;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case header_line_start:
-    if (input == '\r')
-    {
-      state_ = expecting_newline_3;
-      return incomplete;
-    }
-    else if (!req.headers_.empty() && (input == ' ' || input == '\t'))
-    {
-      state_ = header_lws;
-      return incomplete;
-    }
-    else if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-    {
-      return error;
-    }
-    else
-    {
-      req.headers_.push_back(Header());
-      req.headers_.back().name.push_back(input);
-      state_ = header_name;
-      return incomplete;
-    }
-  case header_lws:
-    if (input == '\r')
-    {
-      state_ = expecting_newline_2;
-      return incomplete;
-    }
-    else if (input == ' ' || input == '\t')
-    {
-      return incomplete;
-    }
-    else if (is_ctl(input))
-    {
-      return error;
-    }
-    else
-    {
-      state_ = header_value;
-      req.headers_.back().value.push_back(input);
+    const char* newline = static_cast<const char*>(
+                                std::memchr(begin, '\n', end - begin));
+    if (!newline)
+    {
+      // save the start of the line until the rest of it arrives (a CR may
+      // only end a line, so one followed by anything else is an error which
+      // needn't wait for the rest of the line)
+      std::size_t scanFrom = line_buffer_.empty() ? 0 : line_buffer_.size() - 1;
+      line_buffer_.append(begin, end);
+      if (std::memchr(line_buffer_.data() + scanFrom, '\r',
+                      line_buffer_.size() - 1 - scanFrom))
+      {
+        return error;
+      }
       return incomplete;
     }
-  case header_name:
-    if (input == ':')
-    {
-      state_ = space_before_header_value;
-      
-      // look for special content-length state
-      if ( boost::iequals(req.headers_.back().name, "Content-Length") )
-         parsing_content_length_ = true ;
 
-      return incomplete;
-    }
-    else if (!is_char(input) || is_ctl(input) || is_tspecial(input))
+    // lines must end with CRLF
+    status st;
+    if (line_buffer_.empty())
     {
-      return error;
+      if (newline == begin || newline[-1] != '\r')
+        return error;
+      st = parseLine(req, begin, newline - 1);
     }
     else
     {
-      req.headers_.back().name.push_back(input);
-      return incomplete;
-    }
-  case space_before_header_value:
-    if (input == ' ')
-    {
-      state_ = header_value;
-      return incomplete;
+      line_buffer_.append(begin, newline + 1);
+      std::size_t size = line_buffer_.size();
+      if (size < 2 || line_buffer_[size - 2] != '\r')
+        return error;
+      const char* line = line_buffer_.data();
+      st = parseLine(req, line, line + size - 2);
+      line_buffer_.clear();
     }
-    else
-    {
+    begin = newline + 1;
+
+    if (st == error)
       return error;
-    }
-  case header_value:
-    if (input == '\r')
+    else if (st == complete)
     {
-      state_ = expecting_newline_2;
+      // if we have a body then continue parsing it
+      if (content_length_ == 0)
+        return complete;
 
-      // if this header was Content-Length then save it
-      if (parsing_content_length_)
+      parsing_body_ = true;
+      beginBody(req);
+
+      // hand over requests with large bodies once their headers are read
+      // (along with the start of the body if it's in this buffer)
+      if (body_stream_threshold_ > 0 &&
+          content_length_ > body_stream_threshold_ &&
+          !form_parser_)
       {
-         content_length_ = boost::lexical_cast<int>(req.headers_.back().value);
-         parsing_content_length_ = false ;
+        status bodyStatus = begin == end ? incomplete :
+                                           parseBody(req, begin, end);
+        return bodyStatus == incomplete ? headers_complete : bodyStatus;
       }
-
-      return incomplete;
-    }
-    else if (is_ctl(input))
-    {
-      return error;
     }
-    else
-    {
-      req.headers_.back().value.push_back(input);
-      return incomplete;
-    }
-  case expecting_newline_2:
-    if (input == '\n')
-    {
-      state_ = header_line_start;
-      return incomplete;
-    }
-    else
-    {
-      return error;
-    }
-  case expecting_newline_3:
-    if ( input == '\n' )
-    {
-      return complete ;
-    }
-    else
-    {
-      return error ;
-    }
-  default:
-    return error;
   }
+
+  if (!parsing_body_ || begin == end)
+    return incomplete;
+
+  return parseBody(req, begin, end);
+}
+
+RequestParser::status RequestParser::parseLine(Request& req,
+                                               const char* begin,
+                                               const char* end)
+{
+  if (parsing_request_line_)
+  {
+    parsing_request_line_ = false;
+    return parseRequestLine(req, begin, end);
+  }
+
+  // an empty line ends the headers
+  if (begin == end)
+    return complete;
+
+  return parseHeaderLine(req, begin, end);
+}
+
+RequestParser::status RequestParser::parseRequestLine(Request& req,
+                                                      const char* begin,
+                                                      const char* end)
+{
+  // method
+  const char* methodEnd = static_cast<const char*>(
+                                std::memchr(begin, ' ', end - begin));
+  if (!methodEnd || !isToken(begin, methodEnd))
+    return error;
+
+  // uri
+  const char* uriBegin = methodEnd + 1;
+  const char* uriEnd = static_cast<const char*>(
+                                std::memchr(uriBegin, ' ', end - uriBegin));
+  if (!uriEnd || containsControlChar(uriBegin, uriEnd))
+    return error;
+
+  // version
+  const char* it = uriEnd + 1;
+  int major = 0, minor = 0;
+  if (end - it < 5 || std::memcmp(it, "HTTP/", 5) != 0)
+    return error;
+  it += 5;
+  if (!parseNumber(&it, end, &major) || it == end || *it++ != '.')
+    return error;
+  if (!parseNumber(&it, end, &minor) || it != end)
+    return error;
+
+  req.method_.assign(begin, methodEnd);
+  req.uri_.assign(uriBegin, uriEnd);
+  req.httpVersionMajor_ = major;
+  req.httpVersionMinor_ = minor;
+  return incomplete;
 }
 
-bool RequestParser::is_char(int c)
+RequestParser::status RequestParser::parseHeaderLine(Request& req,
+                                                     const char* begin,
+                                                     const char* end)
 {
-  return c >= 0 && c <= 127;
+  // continuation of the previous header's value
+  if (!req.headers_.empty() && (*begin == ' ' || *begin == '\t'))
+  {
+    while (begin != end && (*begin == ' ' || *begin == '\t'))
+      ++begin;
+
+    if (containsControlChar(begin, end))
+      return error;
+
+    req.headers_.back().value.append(begin, end);
+    return incomplete;
+  }
+
+  // the name is followed by a colon and a single space
+  const char* colon = static_cast<const char*>(
+                                std::memchr(begin, ':', end - begin));
+  if (!colon || !isToken(begin, colon))
+    return error;
+
+  const char* valueBegin = colon + 1;
+  if (valueBegin == end || *valueBegin++ != ' ')
+    return error;
+  if (containsControlChar(valueBegin, end))
+    return error;
+
+  req.headers_.push_back(Header());
+  Header& header = req.headers_.back();
+  header.name.assign(begin, colon);
+  header.value.assign(valueBegin, end);
+
+  if (boost::algorithm::iequals(header.name, "Content-Length") &&
+      !parseContentLength(valueBegin, end, &content_length_))
+  {
+    return error;
+  }
+
+  return incomplete;
 }
 
-bool RequestParser::is_ctl(int c)
+void RequestParser::beginBody(Request& req)
 {
-  return (c >= 0 && c <= 31) || c == 127;
+  body_bytes_read_ = 0 ;
+
+  // spool large form bodies rather than reading them into memory
+  std::string contentType = req.headerValue("Content-Type");
+  if (form_spool_threshold_ > 0 &&
+      !form_spool_path_.empty() &&
+      content_length_ > form_spool_threshold_ &&
+      contentType.find("multipart/form-data") == 0)
+  {
+     form_parser_.reset(new MultipartFormParser(contentType, form_spool_path_));
+  }
 }
 
-bool RequestParser::is_tspecial(int c)
+RequestParser::status RequestParser::parseBody(Request& req,
+                                               const char* begin,
+                                               const char* end)
 {
-  switch (c)
+  std::size_t available = std::min(static_cast<std::size_t>(end - begin),
+                                    content_length_ - body_bytes_read_);
+
+  if (form_parser_)
+  {
+     Error parseError = form_parser_->parse(begin, available);
+     if (parseError)
+     {
+        LOG_ERROR(parseError);
+        return error;
+     }
+  }
+  else
   {
-  case '(': case ')': case '<': case '>': case '@':
-  case ',': case ';': case ':': case '\\': case '"':
-  case '/': case '[': case ']': case '?': case '=':
-  case '{': case '}': case ' ': case '\t':
-    return true;
-  default:
-    return false;
+     req.body_.append(begin, available);
   }
+
+  body_bytes_read_ += available;
+  if (body_bytes_read_ == content_length_)
+     return endBody(req);
+
+  return incomplete;
 }
 
-bool RequestParser::is_digit(int c)
+RequestParser::status RequestParser::endBody(Request& req)
 {
-  return c >= '0' && c <= '9';
+  if (form_parser_)
+  {
+     if (!form_parser_->complete())
+        return error;
+
+     // the form has already been parsed, so the request needn't parse it
+     req.formFields_ = form_parser_->fields();
+     req.files_ = form_parser_->files();
+     req.parsedFormFields_ = true;
+     form_parser_.reset();
+  }
+  return complete;
 }
 
 } // namespace http
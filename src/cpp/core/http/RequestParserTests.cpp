@@ -0,0 +1,314 @@
+/*
+ * RequestParserTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/RequestParser.hpp>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/http/Request.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+namespace tests {
+
+namespace {
+
+const char* const kRequest =
+      "POST /rpc/console_input?x=1 HTTP/1.1\r\n"
+      "Host: localhost:8787\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+      "Accept: application/json, text/plain, */*\r\n"
+      "Content-Type: application/json\r\n"
+      "Cookie: user-id=jsmith|Fri%2C%2008%20Jun%202018; csrf-token=1234\r\n"
+      "Content-Length: 27\r\n"
+      "\r\n"
+      "{\"method\":\"console_input\"}\n";
+
+// parse a request, feeding it to the parser in pieces of the given sizes
+// (the last size is used for the rest of the request)
+RequestParser::status parseInPieces(const std::string& input,
+                                    const std::vector<std::size_t>& sizes,
+                                    Request* pRequest)
+{
+   RequestParser parser;
+   const char* it = input.data();
+   const char* end = input.data() + input.size();
+   RequestParser::status status = RequestParser::incomplete;
+   std::size_t i = 0;
+   while (it != end && status == RequestParser::incomplete)
+   {
+      std::size_t size = sizes[std::min(i++, sizes.size() - 1)];
+      size = std::max<std::size_t>(1, std::min<std::size_t>(size, end - it));
+      status = parser.parse(*pRequest, it, it + size);
+      it += size;
+   }
+   return status;
+}
+
+RequestParser::status parse(const std::string& input, Request* pRequest)
+{
+   return parseInPieces(input, std::vector<std::size_t>(1, input.size()),
+                        pRequest);
+}
+
+RequestParser::status parse(const std::string& input)
+{
+   Request request;
+   return parse(input, &request);
+}
+
+std::string describe(const Request& request)
+{
+   std::ostringstream ostr;
+   ostr << request.method() << "|" << request.uri() << "|"
+        << request.httpVersionMajor() << "." << request.httpVersionMinor();
+   for (std::size_t i = 0; i < request.headers().size(); i++)
+   {
+      const Header& header = request.headers()[i];
+      ostr << "|" << header.name << ":" << header.value;
+   }
+   ostr << "|" << request.body();
+   return ostr.str();
+}
+
+// small deterministic generator (so that failures can be reproduced)
+class Random
+{
+public:
+   explicit Random(unsigned int seed) : state_(seed) {}
+
+   std::size_t next(std::size_t bound)
+   {
+      state_ = state_ * 1103515245 + 12345;
+      return (state_ >> 16) % bound;
+   }
+
+private:
+   unsigned int state_;
+};
+
+} // anonymous namespace
+
+context("RequestParserTests")
+{
+   test_that("Requests are parsed into their parts")
+   {
+      Request request;
+      REQUIRE(parse(kRequest, &request) == RequestParser::complete);
+      expect_true(request.method() == "POST");
+      expect_true(request.uri() == "/rpc/console_input?x=1");
+      expect_true(request.httpVersionMajor() == 1);
+      expect_true(request.httpVersionMinor() == 1);
+      expect_true(request.headers().size() == 6);
+      expect_true(request.headerValue("Host") == "localhost:8787");
+      expect_true(request.headerValue("Accept") == "application/json, text/plain, */*");
+      expect_true(request.cookieValue("csrf-token") == "1234");
+      expect_true(request.body() == "{\"method\":\"console_input\"}\n");
+   }
+
+   test_that("Requests without bodies complete at the end of their headers")
+   {
+      Request request;
+      REQUIRE(parse("GET / HTTP/1.0\r\n\r\nextra", &request) == RequestParser::complete);
+      expect_true(request.method() == "GET");
+      expect_true(request.uri() == "/");
+      expect_true(request.httpVersionMinor() == 0);
+      expect_true(request.headers().empty());
+      expect_true(request.body().empty());
+   }
+
+   test_that("Incomplete requests are reported as such")
+   {
+      std::string input(kRequest);
+      for (std::size_t size = 0; size < input.size(); size++)
+         REQUIRE(parse(input.substr(0, size)) == RequestParser::incomplete);
+   }
+
+   test_that("Headers are as lenient as before")
+   {
+      // continuation lines are appended to the previous value
+      Request request;
+      REQUIRE(parse("GET / HTTP/1.1\r\n"
+                    "X-Long: one\r\n"
+                    " \t two\r\n"
+                    "\r\n", &request) == RequestParser::complete);
+      expect_true(request.headerValue("X-Long") == "onetwo");
+
+      // anything but control characters may appear in uris and values
+      REQUIRE(parse("GET /caf\xc3\xa9 HTTP/1.1\r\n"
+                    "X-Name: caf\xc3\xa9  \r\n"
+                    "X-Empty: \r\n"
+                    "\r\n", &request) == RequestParser::complete);
+      expect_true(request.uri() == "/caf\xc3\xa9");
+
+      // an empty uri is accepted (as was the case)
+      expect_true(parse("GET  HTTP/1.1\r\n\r\n") == RequestParser::complete);
+
+      // content lengths may be signed
+      expect_true(parse("POST / HTTP/1.1\r\nContent-Length: +1\r\n\r\nx") ==
+                  RequestParser::complete);
+   }
+
+   test_that("Malformed requests are rejected")
+   {
+      const char* malformed[] = {
+         "\r\n",
+         "(GET) / HTTP/1.1\r\n\r\n",
+         "GET / HTTP/1.1\n\r\n",
+         "GET /\x01 HTTP/1.1\r\n\r\n",
+         "GET / HTTP/1.1x\r\n\r\n",
+         "GET / HTTP/x.1\r\n\r\n",
+         "GET / HTTP/1.\r\n\r\n",
+         "GET / HTTP/1.1 \r\n\r\n",
+         "GET / FTP/1.1\r\n\r\n",
+         "GET /\r\n\r\n",
+         "GET / a HTTP/1.1\r\n\r\n",
+         "GET / HTTP/1.1\r\n Host: continuation of nothing\r\n\r\n",
+         "GET / HTTP/1.1\r\nHost:localhost\r\n\r\n",
+         "GET / HTTP/1.1\r\nHost\r\n\r\n",
+         "GET / HTTP/1.1\r\nBad Name: value\r\n\r\n",
+         "GET / HTTP/1.1\r\nHost: a\tb\r\n\r\n",
+         "GET / HTTP/1.1\r\nHost: a\rb\r\n\r\n",
+         "GET / HTTP/1.1\r\nHost: a\r\r\n\r\n",
+         "GET / HTTP/1.1\r\nHost: a\rb",
+         "GET / HTTP/1.1\r\n\r{}",
+         "POST / HTTP/1.1\r\nContent-Length: ten\r\n\r\n",
+         "POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+         "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n",
+      };
+
+      for (std::size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++)
+      {
+         INFO(malformed[i]);
+         CHECK(parse(malformed[i]) == RequestParser::error);
+      }
+   }
+
+   test_that("Parsing doesn't depend on how the input is split (fuzz)")
+   {
+      std::string alphabet("\r\n :\t/HTTP1.0aZ\x01\x7f\xff");
+      Random random(20180608);
+      for (int i = 0; i < 2000; i++)
+      {
+         // mutate the request
+         std::string input(kRequest);
+         std::size_t mutations = 1 + random.next(4);
+         for (std::size_t j = 0; j < mutations; j++)
+         {
+            std::size_t pos = random.next(input.size());
+            char c = alphabet[random.next(alphabet.size())];
+            switch (random.next(3))
+            {
+               case 0: input[pos] = c; break;
+               case 1: input.insert(pos, 1, c); break;
+               case 2: input.erase(pos, 1); break;
+            }
+         }
+
+         Request whole;
+         RequestParser::status wholeStatus = parse(input, &whole);
+
+         // byte at a time and in random pieces
+         std::vector<std::size_t> sizes(1, 1);
+         Request bytes;
+         RequestParser::status bytesStatus = parseInPieces(input, sizes, &bytes);
+
+         sizes.clear();
+         for (int j = 0; j < 16; j++)
+            sizes.push_back(1 + random.next(40));
+         Request pieces;
+         RequestParser::status piecesStatus = parseInPieces(input, sizes, &pieces);
+
+         INFO(input);
+         REQUIRE(bytesStatus == wholeStatus);
+         REQUIRE(piecesStatus == wholeStatus);
+         if (wholeStatus == RequestParser::complete)
+         {
+            REQUIRE(describe(bytes) == describe(whole));
+            REQUIRE(describe(pieces) == describe(whole));
+         }
+      }
+   }
+
+   test_that("Requests with large bodies can be handed over after their headers")
+   {
+      std::string input(kRequest);
+      std::size_t headersEnd = input.find("\r\n\r\n") + 4;
+
+      // the start of the body is parsed along with the headers
+      Request request;
+      RequestParser parser;
+      parser.setBodyStreamThreshold(10);
+      const char* begin = input.data();
+      const char* end = begin + input.size();
+      REQUIRE(parser.parse(request, begin, begin + headersEnd + 5) ==
+              RequestParser::headers_complete);
+      expect_true(request.headerValue("Host") == "localhost:8787");
+      expect_true(request.body() == "{\"met");
+
+      // parsing may continue to read the rest of it
+      REQUIRE(parser.parse(request, begin + headersEnd + 5, end) ==
+              RequestParser::complete);
+      expect_true(request.body() == "{\"method\":\"console_input\"}\n");
+
+      // bodies which are read along with their headers, or are under the
+      // threshold, complete as usual
+      Request wholeRequest;
+      RequestParser wholeParser;
+      wholeParser.setBodyStreamThreshold(10);
+      expect_true(wholeParser.parse(wholeRequest, begin, end) ==
+                  RequestParser::complete);
+
+      Request smallRequest;
+      RequestParser smallParser;
+      smallParser.setBodyStreamThreshold(1024);
+      expect_true(smallParser.parse(smallRequest, begin, begin + headersEnd) ==
+                  RequestParser::incomplete);
+   }
+
+   test_that("Requests are parsed quickly (throughput)")
+   {
+      std::string input(kRequest);
+      const int kRequests = 20000;
+
+      using namespace boost::posix_time;
+      ptime start = microsec_clock::universal_time();
+      for (int i = 0; i < kRequests; i++)
+      {
+         Request request;
+         RequestParser parser;
+         REQUIRE(parser.parse(request, input.data(), input.data() + input.size()) ==
+                 RequestParser::complete);
+      }
+      double seconds = (microsec_clock::universal_time() - start)
+                                              .total_microseconds() / 1.0e6;
+
+      // a very conservative bound (so as to hold for debug builds on slow
+      // machines); the rate is reported for comparison
+      double megabytesPerSecond =
+            (input.size() * static_cast<double>(kRequests)) / (1024 * 1024) /
+            std::max(seconds, 1.0e-6);
+      WARN("request parser throughput: " << megabytesPerSecond << " MB/s");
+      CHECK(megabytesPerSecond > 1);
+   }
+}
+
+} // namespace tests
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -30,8 +30,11 @@
 #include <core/Hash.hpp>
 #include <core/RegexUtils.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/collection/LruCache.hpp>
 
 #ifndef _WIN32
+#include <sys/stat.h>
+
 #include "zlib.h"
 #endif
 
@@ -255,6 +258,183 @@ private:
 };
 #endif
 
+// static files up to this size are held in the static content cache; larger
+// files are read and encoded per request
+#define kMaxStaticContentSize (2 * 1024 * 1024)
+#define kMaxStaticContentCacheSize (64 * 1024 * 1024)
+#define kStaticContentCacheShards 8
+
+struct StaticContent
+{
+   std::time_t lastWriteTime;
+   boost::int64_t modified;
+   uintmax_t size;
+   std::string mimeType;
+   std::string eTag;
+   std::string contentETag;
+   std::string content;
+   std::string gzipContent;
+};
+
+typedef collection::LruCache<std::string, boost::shared_ptr<const StaticContent> >
+   StaticContentCache;
+
+std::size_t staticContentCost(const std::string& key,
+                              const boost::shared_ptr<const StaticContent>& pContent)
+{
+   return key.size() + pContent->content.size() + pContent->gzipContent.size();
+}
+
+StaticContentCache& staticContentCache()
+{
+   static StaticContentCache instance(kMaxStaticContentCacheSize,
+                                      kStaticContentCacheShards,
+                                      staticContentCost);
+   return instance;
+}
+
+#ifndef _WIN32
+Error gzipString(const std::string& input, std::string* pOutput)
+{
+   z_stream stream;
+   stream.zalloc = Z_NULL;
+   stream.zfree = Z_NULL;
+   stream.opaque = Z_NULL;
+
+   int res = deflateInit2(&stream,
+                          Z_BEST_COMPRESSION,
+                          Z_DEFLATED,
+                          kGzipWindow,
+                          kDefaultMemoryUsage,
+                          Z_DEFAULT_STRATEGY);
+   if (res != Z_OK)
+      return systemError(res, "ZLib initialization error", ERROR_LOCATION);
+
+   std::string output(deflateBound(&stream, input.size()), '\0');
+   stream.avail_in = static_cast<uInt>(input.size());
+   stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+   stream.avail_out = static_cast<uInt>(output.size());
+   stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+
+   res = deflate(&stream, Z_FINISH);
+   output.resize(output.size() - stream.avail_out);
+   (void)deflateEnd(&stream);
+
+   if (res != Z_STREAM_END)
+      return systemError(res, "ZLib compression error", ERROR_LOCATION);
+
+   pOutput->swap(output);
+   return Success();
+}
+#endif
+
+// read the size and modification time (in nanoseconds where available) of
+// a file. returns a modification time of 0 if the file was modified too
+// recently for its time to tell it apart from a later rewrite
+void fileStamp(const FilePath& filePath,
+               std::time_t* pLastWriteTime,
+               boost::int64_t* pModified,
+               uintmax_t* pSize)
+{
+#ifndef _WIN32
+   struct stat st;
+   if (::stat(filePath.absolutePath().c_str(), &st) == -1)
+   {
+      *pLastWriteTime = 0;
+      *pModified = 0;
+      *pSize = 0;
+      return;
+   }
+
+#ifdef __APPLE__
+   const struct timespec& mtime = st.st_mtimespec;
+#else
+   const struct timespec& mtime = st.st_mtim;
+#endif
+   *pLastWriteTime = mtime.tv_sec;
+   *pModified = static_cast<boost::int64_t>(mtime.tv_sec) * 1000000000 +
+                mtime.tv_nsec;
+   *pSize = st.st_size;
+#else
+   *pLastWriteTime = filePath.lastWriteTime();
+   *pModified = static_cast<boost::int64_t>(*pLastWriteTime) * 1000000000;
+   *pSize = filePath.size();
+#endif
+
+   // file systems may record times at a coarse granularity, so a file
+   // modified within the last second could be rewritten (with the same
+   // size) without its time changing
+   if (*pLastWriteTime >= ::time(NULL) - 1)
+      *pModified = 0;
+}
+
+// the entity tag of a variant of static content
+std::string variantETag(const std::string& eTag, bool gzip)
+{
+   if (!gzip)
+      return eTag;
+
+   // insert the suffix within the quotes (if any)
+   if (boost::algorithm::ends_with(eTag, "\""))
+      return eTag.substr(0, eTag.size() - 1) + "-gzip\"";
+   else
+      return eTag + "-gzip";
+}
+
+// returns an empty pointer if the file isn't eligible for caching
+boost::shared_ptr<const StaticContent> staticContent(const FilePath& filePath,
+                                                     Error* pError)
+{
+   std::time_t lastWriteTime;
+   boost::int64_t modified;
+   uintmax_t size;
+   fileStamp(filePath, &lastWriteTime, &modified, &size);
+   if (size > kMaxStaticContentSize)
+      return boost::shared_ptr<const StaticContent>();
+
+   // check for an up to date cache entry (recently modified files are read
+   // again, as their time can't be relied upon)
+   std::string key = filePath.absolutePath();
+   boost::shared_ptr<const StaticContent> pContent;
+   if (modified != 0 &&
+       staticContentCache().get(key, &pContent) &&
+       pContent->modified == modified &&
+       pContent->size == size)
+   {
+      return pContent;
+   }
+
+   // read and encode the file
+   boost::shared_ptr<StaticContent> pNewContent = boost::make_shared<StaticContent>();
+   *pError = core::readStringFromFile(filePath, &pNewContent->content);
+   if (*pError)
+      return boost::shared_ptr<const StaticContent>();
+
+   // the entity tags are derived from the content (rather than the time it
+   // was written) so that they change whenever it does
+   pNewContent->lastWriteTime = lastWriteTime;
+   pNewContent->modified = modified;
+   pNewContent->size = size;
+   pNewContent->mimeType = filePath.mimeContentType();
+   pNewContent->contentETag = core::hash::crc32Hash(pNewContent->content);
+   pNewContent->eTag = boost::str(boost::format("\"%1$x-%2%\"") %
+                                  pNewContent->content.size() %
+                                  core::hash::crc32HexHash(pNewContent->content));
+
+#ifndef _WIN32
+   Error error = gzipString(pNewContent->content, &pNewContent->gzipContent);
+   if (error)
+   {
+      // serve uncompressed
+      LOG_ERROR(error);
+      pNewContent->gzipContent.clear();
+   }
+#endif
+
+   staticContentCache().insert(key, pNewContent);
+   return pNewContent;
+}
+
 } // anonymous namespace
 
 Response::Response() 
@@ -387,12 +567,115 @@ Error Response::setBody(const std::string& content)
 Error Response::setCacheableBody(const FilePath& filePath,
                                  const Request& request)
 {
-   std::string content;
-   Error error = core::readStringFromFile(filePath, &content);
+   Error error;
+   boost::shared_ptr<const StaticContent> pContent = staticContent(filePath, &error);
    if (error)
       return error;
 
-   return setCacheableBody(content, request);
+   // too large to cache
+   if (!pContent)
+   {
+      std::string content;
+      error = core::readStringFromFile(filePath, &content);
+      if (error)
+         return error;
+
+      return setCacheableBody(content, request);
+   }
+
+   // the gzip and identity variants have distinct entity tags
+   bool gzip = contentEncoding() == kGzipEncoding && !pContent->gzipContent.empty();
+   std::string eTag = variantETag(pContent->contentETag, gzip);
+   setHeader("ETag", eTag);
+   setHeader("Vary", "Accept-Encoding");
+   if (eTag == request.headerValue("If-None-Match"))
+   {
+      removeHeader("Content-Type"); // upstream code may have set this
+      setStatusCode(status::NotModified);
+      return Success();
+   }
+
+   if (gzip)
+      setBodyPrecompressed(pContent->gzipContent, kGzipEncoding);
+   else
+      return setBody(pContent->content);
+
+   return Success();
+}
+
+void Response::setCacheableFile(const FilePath& filePath, const Request& request)
+{
+   // ensure that the file exists
+   if (!filePath.exists())
+   {
+      setNotFoundError(request);
+      return;
+   }
+
+   // padded responses can't be served from the cache
+   NullOutputFilter nullFilter;
+   if (usePadding(request, filePath))
+   {
+      setCacheableFile(filePath, request, nullFilter);
+      return;
+   }
+
+   Error error;
+   boost::shared_ptr<const StaticContent> pContent = staticContent(filePath, &error);
+   if (error)
+   {
+      setError(status::InternalServerError, error.code().message());
+      return;
+   }
+
+   // too large to cache
+   if (!pContent)
+   {
+      setCacheableFile(filePath, request, nullFilter);
+      return;
+   }
+
+   // range requests are served from the uncompressed content
+   bool range = !request.headerValue("Range").empty();
+   bool gzip = !range &&
+               request.acceptsEncoding(kGzipEncoding) &&
+               !pContent->gzipContent.empty();
+
+   // set validators (the gzip and identity variants have distinct entity tags)
+   using namespace boost::posix_time;
+   ptime lastModifiedDate = from_time_t(pContent->lastWriteTime);
+   std::string eTag = variantETag(pContent->eTag, gzip);
+   setHeader("Last-Modified", util::httpDate(lastModifiedDate));
+   setHeader("ETag", eTag);
+   setHeader("Vary", "Accept-Encoding");
+
+   // compare against If-None-Match, falling back to If-Modified-Since
+   std::string ifNoneMatch = request.headerValue("If-None-Match");
+   if ((!ifNoneMatch.empty() && ifNoneMatch == eTag) ||
+       (ifNoneMatch.empty() && lastModifiedDate == request.ifModifiedSince()))
+   {
+      removeHeader("Content-Type"); // upstream code may have set this
+      setStatusCode(status::NotModified);
+      return;
+   }
+
+   if (range)
+   {
+      setRangeableFile(pContent->content, pContent->mimeType, request);
+      return;
+   }
+
+   setContentType(pContent->mimeType);
+   if (gzip)
+   {
+      setBodyPrecompressed(pContent->gzipContent, kGzipEncoding);
+   }
+   else
+   {
+      removeHeader("Content-Encoding");
+      body_ = pContent->content;
+      setContentLength(static_cast<int>(body_.length()));
+   }
 }
 
 void Response::setDynamicHtml(const std::string& html,
@@ -578,6 +861,14 @@ std::string Response::eTagForContent(const std::string& content)
    return core::hash::crc32Hash(content);
 }   
 
+void Response::setBodyPrecompressed(const std::string& body,
+                                    const std::string& encoding)
+{
+   setContentEncoding(encoding);
+   body_ = body;
+   setContentLength(static_cast<int>(body_.length()));
+}
+
 void Response::appendFirstLineBuffers(
       std::vector<boost::asio::const_buffer>& buffers) const 
 {
@@ -751,26 +1042,30 @@ void Response::setStreamFile(const FilePath& filePath,
    }
 #endif
 
-   // streaming will be performed via chunked encoding
-   setHeader(kTransferEncoding, kChunkedTransferEncoding);
-
    boost::shared_ptr<FileStreamResponse> fileStream(
             new FileStreamResponse(filePath, buffSize, usePadding(request, filePath)));
 
 #ifndef _WIN32
    if (compressionType)
    {
-      streamResponse_.reset(
-               new ZlibCompressionStreamResponse(fileStream, buffSize, compressionType.get()));
+      setStreamResponse(boost::shared_ptr<StreamResponse>(
+               new ZlibCompressionStreamResponse(fileStream, buffSize, compressionType.get())));
    }
    else
    {
-      streamResponse_ = fileStream;
+      setStreamResponse(fileStream);
    }
 #else
-   streamResponse_ = fileStream;
+   setStreamResponse(fileStream);
 #endif
+}
+
+void Response::setStreamResponse(const boost::shared_ptr<StreamResponse>& streamResponse)
+{
+   // streaming will be performed via chunked encoding
+   setHeader(kTransferEncoding, kChunkedTransferEncoding);
 
+   streamResponse_ = streamResponse;
    Error error = streamResponse_->initialize();
    if (error)
       setError(status::InternalServerError, error.code().message());
@@ -44,6 +44,30 @@ namespace rstudio {
 namespace core {
 namespace http {
 
+SpoolFile::~SpoolFile()
+{
+   try
+   {
+      if (!path_.empty())
+      {
+         Error error = path_.removeIfExists();
+         if (error)
+            LOG_ERROR(error);
+      }
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
+Error SpoolFile::moveTo(const FilePath& targetPath)
+{
+   Error error = path_.move(targetPath);
+   if (error)
+      return error;
+
+   path_ = FilePath();
+   return Success();
+}
+
 namespace util {
 
    
@@ -135,10 +159,7 @@ void parseQueryString(const std::string& queryString, Fields* pFields)
    return parseFields(queryString, "&", "=", pFields, FieldDecodeQueryString);
 }
       
-void parseMultipartForm(const std::string& contentType,
-                        const std::string& body, 
-                        Fields* pFields,
-                        Files* pFiles)
+std::string multipartBoundary(const std::string& contentType)
 {
    // get the boundary token
    std::string boundaryPrefix("boundary=");
@@ -151,6 +172,44 @@ void parseMultipartForm(const std::string& contentType,
       boundary = "--" + boundary;
       boost::algorithm::trim(boundary);
    }
+   return boundary;
+}
+
+bool parseFormDataDisposition(const std::string& contentDisposition,
+                              std::string* pName,
+                              bool* pIsFile,
+                              std::string* pFilename)
+{
+   // parse values out of content disposition
+   std::string nameRegex("form-data; name=\"(.*)\"");
+   boost::smatch nameMatch;
+   if (!regex_utils::match(contentDisposition, nameMatch, boost::regex(nameRegex)))
+      return false;
+
+   // check for filename
+   std::string filenameRegex(nameRegex + "; filename=\"(.*)\"");
+   boost::smatch fileMatch;
+   if (regex_utils::match(contentDisposition, fileMatch, boost::regex(filenameRegex)))
+   {
+      *pName = fileMatch[1];
+      *pIsFile = true;
+      *pFilename = fileMatch[2];
+   }
+   else
+   {
+      *pName = nameMatch[1];
+      *pIsFile = false;
+      pFilename->clear();
+   }
+   return true;
+}
+
+void parseMultipartForm(const std::string& contentType,
+                        const std::string& body, 
+                        Fields* pFields,
+                        Files* pFiles)
+{
+   std::string boundary = multipartBoundary(contentType);
    
    // extract the fields
    size_t beginBoundaryLoc = body.find(boundary);
@@ -170,46 +229,36 @@ void parseMultipartForm(const std::string& contentType,
       
       // check for content-disposition
       std::string cDisp = http::headerValue(headers,"Content-Disposition");
-      if (!cDisp.empty())
+      std::string name, filename;
+      bool isFile = false;
+      if (!cDisp.empty() &&
+          parseFormDataDisposition(cDisp, &name, &isFile, &filename))
       {
-         // parse values out of content disposition
-         std::string nameRegex("form-data; name=\"(.*)\"");
-         boost::smatch nameMatch;
-         if (regex_utils::match(cDisp, nameMatch, boost::regex(nameRegex)))
+         // read the rest of the stream
+         std::ostringstream valueStream ;
+         std::copy(std::istream_iterator<char>(partStream),
+                   std::istream_iterator<char>(),
+                   std::ostream_iterator<char>(valueStream));
+                    
+         if (isFile)
+         {
+            File uploadedFile;
+            uploadedFile.name = filename;
+            uploadedFile.contentType = http::headerValue(headers, 
+                                                         "Content-Type");
+            if (uploadedFile.contentType.empty())
+               uploadedFile.contentType = "application/octet-stream";
+            
+            uploadedFile.contents = valueStream.str();
+            pFiles->insert(std::make_pair(name, uploadedFile));
+         }
+         // else process regular form field
+         else
          {
-            // read the rest of the stream
-            std::ostringstream valueStream ;
-            std::copy(std::istream_iterator<char>(partStream),
-                      std::istream_iterator<char>(),
-                      std::ostream_iterator<char>(valueStream));
-                       
-            // check for filename
-            std::string filenameRegex(nameRegex + "; filename=\"(.*)\"");
-            boost::smatch fileMatch;
-            if (regex_utils::match(cDisp, fileMatch, boost::regex(filenameRegex)))
-            {
-               std::string name(fileMatch[1]);
-               
-               File uploadedFile;
-               uploadedFile.name = fileMatch[2];
-               uploadedFile.contentType = http::headerValue(headers, 
-                                                            "Content-Type");
-               if (uploadedFile.contentType.empty())
-                  uploadedFile.contentType = "application/octet-stream";
-               
-               uploadedFile.contents = valueStream.str();
-               pFiles->insert(std::make_pair(name, uploadedFile));
-            }
-            // else process regular form field
-            else
-            {
-               std::string name(nameMatch[1]);
-               std::string value = valueStream.str();
-               boost::algorithm::trim(value);
-               pFields->push_back(std::make_pair(name, value));
-            }
+            std::string value = valueStream.str();
+            boost::algorithm::trim(value);
+            pFields->push_back(std::make_pair(name, value));
          }
-         
       }
                 
       // next boundary
@@ -157,6 +157,10 @@ public:
    // copy to path
    Error copy(const FilePath& targetPath) const;
 
+   // create a hard link to this file at path (the file's contents are then
+   // shared by both paths)
+   Error link(const FilePath& targetPath) const;
+
    // is this a hidden file?
    bool isHidden() const ;
 
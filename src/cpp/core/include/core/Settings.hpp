@@ -57,14 +57,27 @@ public:
    void beginUpdate();
    void endUpdate();
 
+   // by default each change is written as it is made. when writes are
+   // deferred changes are accumulated instead, and scheduleFlush is called
+   // (once per batch of changes) so the owner can arrange for flush() to be
+   // called shortly afterwards
+   void setDeferredWrites(const boost::function<void()>& scheduleFlush);
+
+   // write any pending changes
+   void flush();
+
 private:
+   void onDirty();
    void writeSettings() ;
 
 private:
    FilePath settingsFile_ ;
    std::map<std::string, std::string> settingsMap_ ;
+   std::map<std::string, std::string> writtenSettingsMap_ ;
    bool updatePending_ ;
    bool isDirty_;
+   boost::function<void()> scheduleFlush_;
+   bool flushScheduled_;
 };
 
 }
@@ -19,14 +19,54 @@
 #include <iosfwd>
 #include <string>
 
+#include <boost/cstdint.hpp>
 #include <boost/current_function.hpp>
+#include <boost/utility.hpp>
 
 namespace rstudio {
 namespace core { 
+
+class Error;
+class FilePath;
+
 namespace trace {
 
 void add(void* key, const std::string& functionName);
 
+// spans record the duration of a named region of code (plus an optional
+// detail string) into a fixed size ring buffer owned by the current thread.
+// the buffers of exited threads are kept (so their spans can be exported)
+// but only for the most recently exited few.
+// recording is off by default (set RSTUDIO_TRACE_SPANS=1 to enable it) and
+// costs only a flag check when off. recorded spans can be written out in
+// the Chrome trace event format for viewing in chrome://tracing
+bool spansEnabled();
+void setSpansEnabled(bool enabled);
+
+class Span : boost::noncopyable
+{
+public:
+   // name must be a string literal (it is stored by pointer)
+   explicit Span(const char* name);
+   ~Span();
+
+   bool active() const { return start_ >= 0; }
+   void setDetail(const std::string& detail) { detail_ = detail; }
+
+   // record the span now rather than on destruction (for spans which end
+   // in a callback, e.g. when an asynchronous response arrives)
+   void end();
+
+private:
+   const char* name_;
+   std::string detail_;
+   boost::int64_t start_;
+};
+
+// write the spans retained so far (for all threads)
+void writeChromeTrace(std::ostream& os);
+Error writeChromeTrace(const FilePath& filePath);
+
 } // namespace trace
 } // namespace core 
 } // namespace rstudio
@@ -34,5 +74,14 @@ void add(void* key, const std::string& functionName);
 #define TRACE_CURRENT_METHOD \
    core::trace::add(this, BOOST_CURRENT_FUNCTION);
 
-#endif // CORE_PERFORMANCE_TIMER_HPP
+#define TRACE_SPAN(__NAME__) \
+   ::rstudio::core::trace::Span rstudioTraceSpan(__NAME__);
+
+// the detail expression is only evaluated when spans are being recorded
+#define TRACE_SPAN_DETAIL(__NAME__, __DETAIL__) \
+   ::rstudio::core::trace::Span rstudioTraceSpan(__NAME__); \
+   if (rstudioTraceSpan.active()) \
+      rstudioTraceSpan.setDetail(__DETAIL__);
+
+#endif // CORE_TRACE_HPP
 
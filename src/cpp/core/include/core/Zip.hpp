@@ -0,0 +1,126 @@
+/*
+ * Zip.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_ZIP_HPP
+#define CORE_ZIP_HPP
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <core/FilePath.hpp>
+
+struct z_stream_s;
+
+namespace rstudio {
+namespace core {
+
+class Error;
+
+namespace zip {
+
+// a file or directory to be written to an archive
+struct ZipEntry
+{
+   ZipEntry() {}
+   ZipEntry(const std::string& name, const FilePath& path)
+      : name(name), path(path)
+   {
+   }
+
+   // name within the archive ('/' separated; directories end with '/')
+   std::string name;
+
+   // file or directory the entry is read from
+   FilePath path;
+};
+
+// list the entries needed to archive the given files and directories
+// (specified relative to parentPath); directories are added recursively
+Error listEntries(const FilePath& parentPath,
+                  const std::vector<std::string>& files,
+                  std::vector<ZipEntry>* pEntries);
+
+// Writes a zip archive incrementally, so that it can be streamed to a client
+// as it's produced rather than assembled on disk first. Each call to
+// nextChunk compresses just enough of the input to fill one chunk. Sizes and
+// checksums follow each entry's data (as they aren't known until it has been
+// compressed), and zip64 records are written for large files and archives.
+class ZipWriter : boost::noncopyable
+{
+public:
+   explicit ZipWriter(const std::vector<ZipEntry>& entries);
+   ~ZipWriter();
+
+   // produce the next chunk of the archive (of roughly chunkSize bytes);
+   // an empty chunk indicates that the archive is complete
+   Error nextChunk(std::size_t chunkSize, std::string* pChunk);
+
+private:
+   // what the central directory records about each entry
+   struct Record
+   {
+      std::string name;
+      boost::uint32_t crc;
+      boost::uint64_t compressedSize;
+      boost::uint64_t uncompressedSize;
+      boost::uint64_t offset;
+      boost::uint16_t dosTime;
+      boost::uint16_t dosDate;
+      boost::uint32_t mode;
+      bool isDirectory;
+      bool zip64;
+   };
+
+   Error beginEntry(std::string* pOutput);
+   Error compressEntry(std::size_t chunkSize, std::string* pOutput, bool* pDone);
+   Error endEntry(std::string* pOutput);
+   void writeCentralDirectory(std::string* pOutput);
+
+   enum State
+   {
+      EntryHeader,
+      EntryData,
+      Finished
+   } state_;
+
+   std::vector<ZipEntry> entries_;
+   std::vector<Record> records_;
+   std::size_t index_;
+   boost::uint64_t written_;
+
+   // the entry being compressed
+   boost::shared_ptr<std::istream> pInput_;
+   boost::shared_ptr<z_stream_s> zStream_;
+   std::vector<char> inputBuffer_;
+   bool inputEnded_;
+};
+
+// list the names of the entries in an archive
+Error listArchive(const FilePath& archivePath, std::vector<std::string>* pNames);
+
+// extract an archive into the given directory; entries which would be
+// written outside of it are rejected
+Error extractArchive(const FilePath& archivePath, const FilePath& targetPath);
+
+} // namespace zip
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_ZIP_HPP
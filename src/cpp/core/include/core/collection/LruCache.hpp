@@ -16,8 +16,15 @@
 #ifndef CORE_COLLECTION_LRU_CACHE_HPP
 #define CORE_COLLECTION_LRU_CACHE_HPP
 
-#include <map>
-#include <deque>
+#include <list>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <core/Error.hpp>
 #include <core/Thread.hpp>
@@ -26,41 +33,96 @@ namespace rstudio {
 namespace core {
 namespace collection {
 
-template <typename KeyType, typename ValueType>
-class LruCache
+struct LruCacheStatistics
+{
+   LruCacheStatistics() :
+      hits(0), misses(0), evictions(0), expirations(0), entries(0), cost(0)
+   {
+   }
+
+   std::size_t hits;
+   std::size_t misses;
+   std::size_t evictions;
+   std::size_t expirations;
+   std::size_t entries;
+   std::size_t cost;
+};
+
+// thread-safe least recently used cache
+//
+// entries are partitioned into shards by key hash, each shard having its own
+// lock and its own share of the total capacity, so that concurrent readers
+// of different keys don't contend. within a shard, recency is tracked with
+// a linked list whose nodes are indexed by the key map, making lookups,
+// promotions and evictions constant time.
+//
+// capacity is expressed as a total cost; by default each entry costs 1 (so
+// the capacity is an entry count) but a cost function may be supplied to
+// account for e.g. the number of bytes held by each entry. entries may also
+// be given a time to live, after which they are no longer returned.
+//
+// note that with more than one shard the least recently used ordering is
+// maintained per shard rather than across the whole cache
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = boost::hash<KeyType> >
+class LruCache : boost::noncopyable
 {
 public:
-   LruCache(unsigned int maxSize) : maxSize_(maxSize) {}
+   typedef boost::function<std::size_t(const KeyType&, const ValueType&)> CostFunction;
+
+   LruCache(unsigned int maxSize)
+   {
+      init(maxSize, 1, CostFunction(), boost::chrono::milliseconds(0));
+   }
+
+   LruCache(std::size_t maxCost,
+            std::size_t numShards,
+            const CostFunction& costFunction = CostFunction(),
+            boost::chrono::milliseconds timeToLive = boost::chrono::milliseconds(0))
+   {
+      init(maxCost, numShards, costFunction, timeToLive);
+   }
+
    virtual ~LruCache() {}
 
    void insert(const KeyType& key,
                const ValueType& value)
    {
-      LOCK_MUTEX(mutex_)
+      std::size_t cost = costFunction_ ? costFunction_(key, value) : 1;
+      Shard& shard = shardFor(key);
+
+      LOCK_MUTEX(shard.mutex)
       {
-         if (map_.count(key) > 0)
-         {
-            // key already exists - we are updating the value instead of inserting it
-            // we need to remove any existing entries in the queue for that key
-            // so that this entry's LRU "time" is effectively updated
-            removeKey(key);
-         }
-         else if (map_.size() >= maxSize_)
-         {
-            // the cache has reached maximum size
-            // remove the oldest key from the cache which is at the front of the deque
-            // new items are added to the back, meaning the front always contains the oldest items
-            KeyType expiredKey = keyQueue_.front();
-            keyQueue_.pop_front();
+         // if the key already exists we are updating the value instead of
+         // inserting it; drop the existing entry so that this entry's LRU
+         // "time" is effectively updated
+         typename IndexType::iterator iter = shard.index.find(key);
+         if (iter != shard.index.end())
+            shard.erase(iter);
 
-            map_.erase(expiredKey);
-         }
+         // entries that can never fit are not cached
+         if (cost > shard.maxCost)
+            return;
 
-         // add new key to the back
-         keyQueue_.push_back(key);
+         // evict the oldest entries (at the back of the list) until the new
+         // entry fits
+         while (!shard.entries.empty() && shard.cost + cost > shard.maxCost)
+         {
+            shard.erase(shard.index.find(shard.entries.back().key));
+            ++shard.evictions;
+         }
 
-         // store value
-         map_[key] = value;
+         // add the new entry to the front
+         Entry entry;
+         entry.key = key;
+         entry.value = value;
+         entry.cost = cost;
+         if (timeToLive_.count() > 0)
+            entry.expires = Clock::now() + timeToLive_;
+         shard.entries.push_front(entry);
+         shard.index[key] = shard.entries.begin();
+         shard.cost += cost;
       }
       END_LOCK_MUTEX
    }
@@ -68,17 +130,30 @@ public:
    bool get(const KeyType& key,
             ValueType* pValue)
    {
-      LOCK_MUTEX(mutex_)
+      Shard& shard = shardFor(key);
+
+      LOCK_MUTEX(shard.mutex)
       {
-         typename CollectionType::iterator iter = map_.find(key);
-         if (iter == map_.end())
+         typename IndexType::iterator iter = shard.index.find(key);
+         if (iter == shard.index.end())
+         {
+            ++shard.misses;
             return false;
+         }
 
-         *pValue = iter->second;
+         if (timeToLive_.count() > 0 && iter->second->expires <= Clock::now())
+         {
+            shard.erase(iter);
+            ++shard.expirations;
+            ++shard.misses;
+            return false;
+         }
 
-         // remove key from queue and add new entry to update its LRU "time"
-         removeKey(key);
-         keyQueue_.push_back(key);
+         *pValue = iter->second->value;
+
+         // move the entry to the front to update its LRU "time"
+         shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+         ++shard.hits;
 
          return true;
       }
@@ -89,46 +164,141 @@ public:
 
    void remove(const KeyType& key)
    {
-      LOCK_MUTEX(mutex_)
+      Shard& shard = shardFor(key);
+
+      LOCK_MUTEX(shard.mutex)
       {
-         removeKey(key);
-         map_.erase(key);
+         typename IndexType::iterator iter = shard.index.find(key);
+         if (iter != shard.index.end())
+            shard.erase(iter);
       }
       END_LOCK_MUTEX
    }
 
-   size_t size()
+   void clear()
    {
-      LOCK_MUTEX(mutex_)
+      for (std::size_t i = 0; i < shards_.size(); ++i)
       {
-         return map_.size();
+         Shard& shard = *shards_[i];
+         LOCK_MUTEX(shard.mutex)
+         {
+            shard.index.clear();
+            shard.entries.clear();
+            shard.cost = 0;
+         }
+         END_LOCK_MUTEX
       }
-      END_LOCK_MUTEX
+   }
 
-      return 0;
+   size_t size()
+   {
+      return statistics().entries;
    }
 
-private:
+   // total cost of all entries currently held
+   size_t cost()
+   {
+      return statistics().cost;
+   }
 
-   void removeKey(const KeyType& key)
+   LruCacheStatistics statistics()
    {
-      for (size_t i = 0; i < keyQueue_.size(); ++i)
+      LruCacheStatistics stats;
+      for (std::size_t i = 0; i < shards_.size(); ++i)
       {
-         if (keyQueue_.at(i) == key)
+         Shard& shard = *shards_[i];
+         LOCK_MUTEX(shard.mutex)
          {
-            keyQueue_.erase(keyQueue_.begin() + i);
-            return;
+            stats.hits += shard.hits;
+            stats.misses += shard.misses;
+            stats.evictions += shard.evictions;
+            stats.expirations += shard.expirations;
+            stats.entries += shard.index.size();
+            stats.cost += shard.cost;
          }
+         END_LOCK_MUTEX
       }
+      return stats;
    }
 
-   unsigned int maxSize_;
+private:
+
+   typedef boost::chrono::steady_clock Clock;
 
-   typedef std::map<KeyType, ValueType> CollectionType;
-   CollectionType map_;
-   std::deque<KeyType> keyQueue_;
+   struct Entry
+   {
+      KeyType key;
+      ValueType value;
+      std::size_t cost;
+      Clock::time_point expires;
+   };
+
+   typedef std::list<Entry> EntryList;
+   typedef boost::unordered_map<KeyType, typename EntryList::iterator, HashType> IndexType;
+
+   struct Shard : boost::noncopyable
+   {
+      Shard() :
+         maxCost(0), cost(0), hits(0), misses(0), evictions(0), expirations(0)
+      {
+      }
+
+      void erase(typename IndexType::iterator iter)
+      {
+         cost -= iter->second->cost;
+         entries.erase(iter->second);
+         index.erase(iter);
+      }
+
+      // most recently used entries are at the front
+      EntryList entries;
+      IndexType index;
+
+      std::size_t maxCost;
+      std::size_t cost;
+
+      std::size_t hits;
+      std::size_t misses;
+      std::size_t evictions;
+      std::size_t expirations;
+
+      boost::mutex mutex;
+   };
+
+   void init(std::size_t maxCost,
+             std::size_t numShards,
+             const CostFunction& costFunction,
+             boost::chrono::milliseconds timeToLive)
+   {
+      if (numShards == 0)
+         numShards = 1;
+
+      costFunction_ = costFunction;
+      timeToLive_ = timeToLive;
+
+      // divide the capacity among the shards, rounding up so that the
+      // total capacity is never less than requested
+      std::size_t shardCost = (maxCost + numShards - 1) / numShards;
+      for (std::size_t i = 0; i < numShards; ++i)
+      {
+         boost::shared_ptr<Shard> pShard(new Shard());
+         pShard->maxCost = shardCost;
+         shards_.push_back(pShard);
+      }
+   }
+
+   Shard& shardFor(const KeyType& key)
+   {
+      if (shards_.size() == 1)
+         return *shards_[0];
+
+      return *shards_[hash_(key) % shards_.size()];
+   }
 
-   boost::mutex mutex_;
+   std::vector<boost::shared_ptr<Shard> > shards_;
+   CostFunction costFunction_;
+   boost::chrono::milliseconds timeToLive_;
+   HashType hash_;
 };
 
 } // namespace collection
@@ -36,6 +36,7 @@
 #include <core/system/System.hpp>
 #include <core/Thread.hpp>
 
+#include <core/http/AsyncConnection.hpp>
 #include <core/http/ChunkParser.hpp>
 #include <core/http/Request.hpp>
 #include <core/http/Response.hpp>
@@ -62,12 +63,17 @@ namespace core {
 namespace http {
 
 // chunked handler for reading chunked encoding chunks
-// ONLY used for responses that return chunked encoding
+// ONLY used for responses that return chunked encoding (or for responses
+// whose content is streamed -- see setContentStreamThreshold)
 typedef boost::function<bool(const http::Response&, const std::string&)> ChunkHandler;
 
 typedef boost::function<void(const http::Response&)> ResponseHandler;
 typedef boost::function<void(const core::Error&)> ErrorHandler;
 
+// reads the next piece of a request body which is still being received
+// (see AsyncConnection::readRequestBody)
+typedef boost::function<void(const RequestBodyHandler&)> RequestBodyReader;
+
 class IAsyncClient : public Socket
 {
 public:
@@ -78,6 +84,8 @@ public:
                         const ErrorHandler& errorHandler,
                         const ChunkHandler& chunkHandler = ChunkHandler()) = 0;
    virtual void setChunkHandler(const ChunkHandler& chunkHandler) = 0;
+   virtual void setContentStreamThreshold(std::size_t threshold) = 0;
+   virtual void setRequestBodyReader(const RequestBodyReader& reader) = 0;
    virtual void resumeChunkProcessing() = 0;
    virtual void disableHandlers() = 0;
    virtual void close() = 0;
@@ -93,9 +101,12 @@ public:
    AsyncClient(boost::asio::io_service& ioService,
                bool logToStderr = false)
       : chunkedEncoding_(false),
+        streamingContent_(false),
+        contentBytesRead_(0),
         ioService_(ioService),
         connectionRetryContext_(ioService),
         logToStderr_(logToStderr),
+        contentStreamThreshold_(0),
         closed_(false)
    {
    }
@@ -143,6 +154,7 @@ public:
       responseHandler_ = ResponseHandler();
       errorHandler_ = ErrorHandler();
       chunkHandler_ = ChunkHandler();
+      requestBodyReader_ = RequestBodyReader();
    }
 
    // satisfy lower-level http::Socket interface (used when the client
@@ -193,6 +205,22 @@ public:
       chunkHandler_ = chunkHandler;
    }
 
+   // deliver the content of (non-chunked) responses larger than the given
+   // number of bytes to the chunk handler as it is read rather than
+   // accumulating it in the response; the content is delivered unaltered,
+   // with the same flow control as chunks (0, the default, never streams)
+   virtual void setContentStreamThreshold(std::size_t threshold)
+   {
+      contentStreamThreshold_ = threshold;
+   }
+
+   // write the rest of the request body (after the body in the request)
+   // as the reader provides it, before reading the response
+   virtual void setRequestBodyReader(const RequestBodyReader& reader)
+   {
+      requestBodyReader_ = reader;
+   }
+
    virtual void resumeChunkProcessing()
    {
       if (!chunkState_)
@@ -410,14 +438,19 @@ private:
       {
          if (!ec)
          {
-            // initiate async read of the first line of the response
-            boost::asio::async_read_until(
-              socket(),
-              responseBuffer_,
-              "\r\n",
-              boost::bind(&AsyncClient<SocketService>::handleReadStatusLine,
-                          AsyncClient<SocketService>::shared_from_this(),
-                          boost::asio::placeholders::error));
+            // write the next piece of the request body if it's still
+            // being read, otherwise read the response
+            if (requestBodyReader_)
+            {
+               requestBodyReader_(
+                  boost::bind(&AsyncClient<SocketService>::handleReadRequestBody,
+                              AsyncClient<SocketService>::shared_from_this(),
+                              _1, _2));
+            }
+            else
+            {
+               readResponse();
+            }
          }
          else
          {
@@ -427,6 +460,46 @@ private:
       CATCH_UNEXPECTED_ASYNC_CLIENT_EXCEPTION
    }
 
+   void handleReadRequestBody(const Error& error, const std::string& piece)
+   {
+      try
+      {
+         if (error)
+         {
+            handleError(error);
+         }
+         else if (piece.empty())
+         {
+            requestBodyReader_ = RequestBodyReader();
+            readResponse();
+         }
+         else
+         {
+            requestBodyPiece_ = piece;
+            boost::asio::async_write(
+                socket(),
+                boost::asio::buffer(requestBodyPiece_),
+                boost::bind(
+                     &AsyncClient<SocketService>::handleWrite,
+                     AsyncClient<SocketService>::shared_from_this(),
+                     boost::asio::placeholders::error));
+         }
+      }
+      CATCH_UNEXPECTED_ASYNC_CLIENT_EXCEPTION
+   }
+
+   void readResponse()
+   {
+      // initiate async read of the first line of the response
+      boost::asio::async_read_until(
+        socket(),
+        responseBuffer_,
+        "\r\n",
+        boost::bind(&AsyncClient<SocketService>::handleReadStatusLine,
+                    AsyncClient<SocketService>::shared_from_this(),
+                    boost::asio::placeholders::error));
+   }
+
    void handleReadStatusLine(const boost::system::error_code& ec)
    {
       try
@@ -523,6 +596,14 @@ private:
                }
             }
 
+            // stream large bodies to the chunk handler (if requested)
+            if (shouldStreamContent())
+            {
+               streamingContent_ = true;
+               streamContent();
+               return;
+            }
+
             // append any lefover buffer contents to the body
             if (responseBuffer_.size() > 0)
                ResponseParser::appendToBody(&responseBuffer_, &response_);
@@ -552,6 +633,13 @@ private:
                return;
             }
 
+            // likewise for streamed content
+            if (streamingContent_)
+            {
+               streamContent();
+               return;
+            }
+
             // copy content
             ResponseParser::appendToBody(&responseBuffer_, &response_);
 
@@ -608,6 +696,49 @@ private:
       }
    }
 
+   bool shouldStreamContent()
+   {
+      // responses to HEAD requests and those with these statuses have no
+      // content (regardless of their Content-Length)
+      int status = response_.statusCode();
+      if (!chunkHandler_ ||
+          contentStreamThreshold_ == 0 ||
+          request_.method() == "HEAD" ||
+          status / 100 == 1 ||
+          status == status::NoContent ||
+          status == status::NotModified)
+      {
+         return false;
+      }
+
+      return response_.contentLength() > contentStreamThreshold_;
+   }
+
+   void streamContent()
+   {
+      // hand the content read so far to the chunk handler as is
+      std::deque<boost::shared_ptr<std::string> > chunks;
+      if (responseBuffer_.size() > 0)
+      {
+         const char* bufferPtr =
+               boost::asio::buffer_cast<const char*>(responseBuffer_.data());
+         chunks.push_back(boost::make_shared<std::string>(
+                             bufferPtr, responseBuffer_.size()));
+         contentBytesRead_ += responseBuffer_.size();
+         responseBuffer_.consume(responseBuffer_.size());
+      }
+
+      bool complete = contentBytesRead_ >= response_.contentLength();
+      bool chunksHandled = deliverChunks(chunks, complete);
+      if (chunksHandled)
+      {
+         if (!complete)
+            readSomeContent();
+         else
+            closeAndRespond();
+      }
+   }
+
    bool deliverChunks(std::deque<boost::shared_ptr<std::string> >& chunks,
                       bool complete)
    {
@@ -657,7 +788,8 @@ private:
       if (!keepConnectionAlive())
          close();
 
-      if (responseHandler_ && (!chunkedEncoding_ || !chunkHandler_))
+      bool streamed = chunkedEncoding_ || streamingContent_;
+      if (responseHandler_ && (!streamed || !chunkHandler_))
          responseHandler_(response_);
       else if (chunkHandler_)
          chunkHandler_(response_, ""); // completion of chunks signified by empty chunk
@@ -709,6 +841,8 @@ private:
 protected:
    http::Response response_;
    bool chunkedEncoding_;
+   bool streamingContent_;
+   std::size_t contentBytesRead_;
 
 private:
    boost::asio::io_service& ioService_;
@@ -720,6 +854,9 @@ private:
    boost::asio::streambuf responseBuffer_;
    boost::shared_ptr<ChunkParser> chunkParser_;
    ChunkHandler chunkHandler_;
+   std::size_t contentStreamThreshold_;
+   RequestBodyReader requestBodyReader_;
+   std::string requestBodyPiece_;
 
    boost::shared_ptr<ChunkState> chunkState_;
 
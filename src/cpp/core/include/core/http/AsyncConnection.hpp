@@ -16,6 +16,7 @@
 #ifndef CORE_HTTP_ASYNC_CONNECTION_HPP
 #define CORE_HTTP_ASYNC_CONNECTION_HPP
 
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/asio/io_service.hpp>
 
@@ -42,6 +43,10 @@ typedef boost::function<void(boost::asio::io_service&,
 
 typedef boost::function<void(const std::string&,Response*)> ResponseFilter;
 
+// receives the next piece of a streamed request body (an empty piece
+// marks the end of the body)
+typedef boost::function<void(const Error&, const std::string&)> RequestBodyHandler;
+
 // abstract base (insulate clients from knowledge of protocol-specifics)
 class AsyncConnection : public Socket
 {
@@ -54,6 +59,13 @@ public:
    // request
    virtual const http::Request& request() const = 0;
 
+   // requests for streaming handlers may be handled before their body has
+   // been read (request().body() then holds only the start of it); the rest
+   // of the body is read a piece at a time by calling this until it provides
+   // an empty piece. for requests which were read completely the empty piece
+   // is provided immediately
+   virtual void readRequestBody(const RequestBodyHandler& handler) = 0;
+
    // populate or set response then call writeResponse when done
    virtual http::Response& response() = 0;
    virtual void writeResponse(bool close = true) = 0;
@@ -98,19 +98,29 @@ public:
          boost::shared_ptr<AsyncConnectionImpl<SocketType> >,
          http::Request*)> Handler;
 
+   // decides (once its headers are read) whether a request with a large
+   // body should be handled while its body is still being read
+   typedef boost::function<bool(const http::Request&)> StreamBodyPredicate;
+
 public:
    AsyncConnectionImpl(boost::asio::io_service& ioService,
                        boost::shared_ptr<boost::asio::ssl::context> sslContext,
                        const Handler& handler,
                        const RequestFilter& requestFilter = RequestFilter(),
-                       const ResponseFilter& responseFilter = ResponseFilter())
+                       const ResponseFilter& responseFilter = ResponseFilter(),
+                       const StreamBodyPredicate& streamBody = StreamBodyPredicate())
       : ioService_(ioService),
         handler_(handler),
         requestFilter_(requestFilter),
         responseFilter_(responseFilter),
+        streamBody_(streamBody),
+        bodyBytesRemaining_(0),
         closed_(false)
         
    {
+      if (streamBody_)
+         requestParser_.setBodyStreamThreshold(1024 * 1024);
+
       if (sslContext)
       {
          sslStream_.reset(new boost::asio::ssl::stream<SocketType>(ioService, *sslContext));
@@ -159,6 +169,22 @@ public:
       return request_;
    }
 
+   virtual void readRequestBody(const RequestBodyHandler& handler)
+   {
+      if (bodyBytesRemaining_ == 0)
+      {
+         ioService_.post(boost::bind(handler, Success(), std::string()));
+         return;
+      }
+
+      socketOperations_->asyncReadSome(boost::asio::buffer(buffer_),
+                                       boost::bind(&AsyncConnectionImpl<SocketType>::handleReadBody,
+                                                   AsyncConnectionImpl<SocketType>::shared_from_this(),
+                                                   boost::asio::placeholders::error,
+                                                   boost::asio::placeholders::bytes_transferred,
+                                                   handler));
+   }
+
    virtual http::Response& response()
    {
       return response_;
@@ -166,15 +192,7 @@ public:
 
    virtual void writeResponse(bool close = true)
    {
-      // add extra response headers
-      if (!response_.containsHeader("Date"))
-         response_.setHeader("Date", util::httpDate());
-      if (close)
-         response_.setHeader("Connection", "close");
-
-      // call the response filter if we have one
-      if (responseFilter_)
-         responseFilter_(originalUri_, &response_);
+      prepareResponse(close);
 
       if (response_.isStreamResponse())
       {
@@ -218,8 +236,8 @@ public:
 
    virtual void writeResponseHeaders(Socket::Handler handler)
    {
-      if (!response_.containsHeader("Date"))
-         response_.setHeader("Date", util::httpDate());
+      // the connection is closed once the body has been streamed
+      prepareResponse(true);
 
       // write only the header buffers
       socketOperations_->asyncWrite(response_.headerBuffers(), handler);
@@ -275,6 +293,19 @@ public:
    }
    
 private:
+
+   void prepareResponse(bool close)
+   {
+      // add extra response headers
+      if (!response_.containsHeader("Date"))
+         response_.setHeader("Date", util::httpDate());
+      if (close)
+         response_.setHeader("Connection", "close");
+
+      // call the response filter if we have one
+      if (responseFilter_)
+         responseFilter_(originalUri_, &response_);
+   }
    
    void handleRead(const boost::system::error_code& e,
                    std::size_t bytesTransferred)
@@ -296,8 +327,11 @@ private:
                writeResponse();
             }
             
-            // incomplete -- keep reading
-            else if (status == RequestParser::incomplete)
+            // incomplete -- keep reading (unless the rest of the body is
+            // to be read by the handler)
+            else if (status == RequestParser::incomplete ||
+                     (status == RequestParser::headers_complete &&
+                      !streamBody_(request_)))
             {
                readSome();
             }
@@ -305,6 +339,14 @@ private:
             // got valid request -- handle it 
             else
             {
+               if (status == RequestParser::headers_complete)
+               {
+                  std::size_t contentLength = request_.contentLength();
+                  std::size_t bodySize = request_.body().size();
+                  bodyBytesRemaining_ = contentLength > bodySize ?
+                                        contentLength - bodySize : 0;
+               }
+
                // record the original uri
                originalUri_ = request_.absoluteUri();
 
@@ -402,6 +444,25 @@ private:
                                                    boost::asio::placeholders::bytes_transferred));
    }
 
+   void handleReadBody(const boost::system::error_code& e,
+                       std::size_t bytesTransferred,
+                       const RequestBodyHandler& handler)
+   {
+      try
+      {
+         if (e)
+         {
+            handler(Error(e, ERROR_LOCATION), std::string());
+            return;
+         }
+
+         std::size_t size = std::min(bytesTransferred, bodyBytesRemaining_);
+         bodyBytesRemaining_ -= size;
+         handler(Success(), std::string(buffer_.data(), size));
+      }
+      CATCH_UNEXPECTED_EXCEPTION
+   }
+
    void handleHandshake(const boost::system::error_code& ec)
    {
       if (ec)
@@ -447,6 +508,8 @@ private:
    Handler handler_;
    RequestFilter requestFilter_;
    ResponseFilter responseFilter_;
+   StreamBodyPredicate streamBody_;
+   std::size_t bodyBytesRemaining_;
    boost::array<char, 8192> buffer_ ;
    RequestParser requestParser_ ;
    std::string originalUri_;
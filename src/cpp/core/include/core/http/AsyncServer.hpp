@@ -49,6 +49,11 @@ public:
    virtual void addProxyHandler(const std::string& prefix,
                                 const AsyncUriHandlerFunction& handler) = 0;
 
+   // handlers which are passed requests with large bodies once their
+   // headers are read (and read the rest of the body themselves)
+   virtual void addStreamingHandler(const std::string& prefix,
+                                    const AsyncUriHandlerFunction& handler) = 0;
+
 
    virtual void addBlockingHandler(const std::string& prefix,
                                    const UriHandlerFunction& handler) = 0;
@@ -87,6 +87,13 @@ public:
       BOOST_ASSERT(!running_);
       uriHandlers_.add(AsyncUriHandler(baseUri_ + prefix, handler, true));
    }
+
+   virtual void addStreamingHandler(const std::string& prefix,
+                                    const AsyncUriHandlerFunction& handler)
+   {
+      BOOST_ASSERT(!running_);
+      uriHandlers_.add(AsyncUriHandler(baseUri_ + prefix, handler, false, true));
+   }
    
    virtual void addHandler(const std::string& prefix,
                            const AsyncUriHandlerFunction& handler)
@@ -278,7 +285,11 @@ private:
 
          // response filter
          boost::bind(&AsyncServerImpl<ProtocolType>::connectionResponseFilter,
-                     this, _1, _2)
+                     this, _1, _2),
+
+         // whether to stream the request body
+         boost::bind(&AsyncServerImpl<ProtocolType>::streamsRequestBody,
+                     this, _1)
       ));
 
       // wait for next connection
@@ -410,6 +421,11 @@ private:
          continuation(boost::shared_ptr<http::Response>());
    }
 
+   bool streamsRequestBody(const http::Request& request)
+   {
+      return uriHandlers_.handlerFor(request.uri()).streamsRequestBody();
+   }
+
    void connectionResponseFilter(const std::string& originalUri,
                                  http::Response* pResponse)
    {
@@ -40,12 +40,14 @@ typedef boost::function<void(
 class AsyncUriHandler
 {
 public:
-   AsyncUriHandler() : isProxyHandler_(false) {} // other members default initialized
+   AsyncUriHandler() : isProxyHandler_(false), streamsRequestBody_(false) {} // other members default initialized
 
    AsyncUriHandler(const std::string& prefix,
                    AsyncUriHandlerFunction function,
-                   bool isProxyHandler = false)
-       : prefix_(prefix), function_(function), isProxyHandler_(isProxyHandler)
+                   bool isProxyHandler = false,
+                   bool streamsRequestBody = false)
+       : prefix_(prefix), function_(function), isProxyHandler_(isProxyHandler),
+         streamsRequestBody_(streamsRequestBody)
    {
    }
 
@@ -73,10 +75,18 @@ public:
       return isProxyHandler_;
    }
 
+   // whether the handler reads large request bodies itself
+   // (see AsyncConnection::readRequestBody)
+   bool streamsRequestBody() const
+   {
+      return streamsRequestBody_;
+   }
+
 private:
    std::string prefix_;
    AsyncUriHandlerFunction function_ ;
    bool isProxyHandler_;
+   bool streamsRequestBody_;
 
 };
 
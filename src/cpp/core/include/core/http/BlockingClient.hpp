@@ -17,7 +17,8 @@
 #define CORE_HTTP_BLOCKING_CLIENT_HPP
 
 #include <boost/function.hpp>
-
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <core/FilePath.hpp>
 
@@ -30,31 +31,67 @@ namespace http {
 namespace {
 
 void responseHandler(const http::Response& response,
-                     http::Response* pTargetResponse)
+                     http::Response* pTargetResponse,
+                     boost::asio::deadline_timer* pTimer)
 {
    pTargetResponse->assign(response);
+
+   boost::system::error_code ec;
+   pTimer->cancel(ec);
 }
 
-void errorHandler(const Error& error, Error* pTargetError)
+void errorHandler(const Error& error,
+                  Error* pTargetError,
+                  boost::asio::deadline_timer* pTimer)
 {
    *pTargetError = error;
+
+   boost::system::error_code ec;
+   pTimer->cancel(ec);
+}
+
+template <typename SocketService>
+void timeoutHandler(const boost::system::error_code& ec,
+                    boost::shared_ptr<AsyncClient<SocketService> > pClient,
+                    Error* pTargetError)
+{
+   // cancelled once the request completes
+   if (ec)
+      return;
+
+   // closing the client abandons the request (without calling its handlers)
+   *pTargetError = systemError(boost::system::errc::timed_out, ERROR_LOCATION);
+   pClient->close();
 }
 
 }
 
+// send a request and wait for its response (giving up once the optional
+// timeout elapses)
 template <typename SocketService>
 Error sendRequest(boost::asio::io_service& ioService,
                   boost::shared_ptr<AsyncClient<SocketService> > pClient,
                   const http::Request& request,
-                  http::Response* pResponse)
+                  http::Response* pResponse,
+                  const boost::posix_time::time_duration& timeout =
+                                    boost::posix_time::not_a_date_time)
 {
    // assign request
    pClient->request().assign(request);
 
-   // start execution
+   // start the timeout
    Error error;
-   pClient->execute(boost::bind(responseHandler, _1, pResponse),
-                    boost::bind(errorHandler, _1, &error));
+   boost::asio::deadline_timer timer(ioService);
+   if (!timeout.is_special())
+   {
+      timer.expires_from_now(timeout);
+      timer.async_wait(boost::bind(timeoutHandler<SocketService>,
+                                   _1, pClient, &error));
+   }
+
+   // start execution
+   pClient->execute(boost::bind(responseHandler, _1, pResponse, &timer),
+                    boost::bind(errorHandler, _1, &error, &timer));
 
    // run the io service
    boost::system::error_code ec;
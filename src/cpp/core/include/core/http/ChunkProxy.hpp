@@ -36,7 +36,11 @@ public:
    ChunkProxy(const boost::shared_ptr<AsyncConnection>& pClientConnection,
               uint64_t maxBufferSize = defaultMaxBufferSize);
 
-   void proxy(const boost::shared_ptr<IAsyncClient>& pServerConnection);
+   // relay streamed responses from the server connection (onResponseRead
+   // is called once the whole response has been read from it)
+   void proxy(const boost::shared_ptr<IAsyncClient>& pServerConnection,
+              const boost::function<void()>& onResponseRead =
+                                                boost::function<void()>());
 
 private:
 
@@ -50,10 +54,12 @@ private:
    boost::shared_ptr<AsyncConnection> pClientConnection_;
    boost::shared_ptr<IAsyncClient> pServerConnection_;
    http::Response serverResponse_;
+   boost::function<void()> onResponseRead_;
    uint64_t maxBufferSize_;
 
    boost::mutex mutex_;
    bool wroteHeaders_;
+   bool chunked_;
    std::queue<std::string> writeBuffer_;
    uint64_t currentBufferSize_;
    bool bufferFull_;
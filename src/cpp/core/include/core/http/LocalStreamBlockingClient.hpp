@@ -27,7 +27,9 @@ namespace http {
 
 inline Error sendRequest(const FilePath& localStreamPath,
                          const http::Request& request,
-                         http::Response* pResponse)
+                         http::Response* pResponse,
+                         const boost::posix_time::time_duration& timeout =
+                                       boost::posix_time::not_a_date_time)
 {
    // create client
    boost::asio::io_service ioService;
@@ -38,7 +40,8 @@ inline Error sendRequest(const FilePath& localStreamPath,
    return sendRequest<boost::asio::local::stream_protocol::socket>(ioService,
                                                                    pClient,
                                                                    request,
-                                                                   pResponse);
+                                                                   pResponse,
+                                                                   timeout);
 }
    
 } // namespace http
@@ -0,0 +1,94 @@
+/*
+ * MultipartFormParser.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_MULTIPART_FORM_PARSER_HPP
+#define CORE_HTTP_MULTIPART_FORM_PARSER_HPP
+
+#include <iosfwd>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <core/http/Util.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+
+namespace http {
+
+/// Incremental parser for multipart/form-data bodies. Form fields are
+/// collected in memory, while the contents of file parts are written to
+/// files as they arrive, so the memory used is bounded no matter how large
+/// the uploaded files are. The spooled files are removed along with the
+/// parser (or the last copy of its files) unless moved elsewhere.
+class MultipartFormParser : boost::noncopyable
+{
+public:
+   /// Construct ready to parse a body with the given Content-Type, spooling
+   /// its files into the given directory.
+   MultipartFormParser(const std::string& contentType,
+                       const FilePath& spoolPath);
+
+   /// Parses the next buffer of the body.
+   Error parse(const char* buffer, std::size_t len);
+
+   /// Returns true once the closing boundary has been parsed.
+   bool complete() const { return state_ == Complete; }
+
+   const Fields& fields() const { return fields_; }
+   const Files& files() const { return files_; }
+
+private:
+   Error beginPart(const std::string& headers);
+   Error appendToPart(const char* data, std::size_t len);
+   Error endPart();
+
+   // state of the parser
+   enum State
+   {
+      Preamble,
+      Boundary,
+      PartHeaders,
+      PartBody,
+      Complete
+   } state_;
+
+   // delimiter preceding each boundary ("\r\n--<boundary>")
+   std::string delimiter_;
+
+   FilePath spoolPath_;
+
+   // input which can't be consumed until more of the body arrives
+   std::string pending_;
+
+   // the part being read
+   std::string partName_;
+   bool partIsFile_;
+   File partFile_;
+   std::string partValue_;
+   boost::shared_ptr<std::ostream> pPartStream_;
+
+   Fields fields_;
+   Files files_;
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_MULTIPART_FORM_PARSER_HPP
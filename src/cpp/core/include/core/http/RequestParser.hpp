@@ -17,13 +17,20 @@
 #ifndef CORE_HTTP_REQUEST_PARSER_HPP
 #define CORE_HTTP_REQUEST_PARSER_HPP
 
+#include <boost/shared_ptr.hpp>
+
+#include <core/FilePath.hpp>
 #include <core/http/Request.hpp>
+#include <core/http/MultipartFormParser.hpp>
 
 namespace rstudio {
 namespace core {
 namespace http {
 
-/// Parser for incoming requests.
+/// Parser for incoming requests. Lines are located with memchr (which the
+/// C library vectorizes) and header names and values are copied out of the
+/// input in one piece, rather than the input being consumed a character at
+/// a time.
 class RequestParser
 {
 public:
@@ -33,97 +40,67 @@ public:
   /// Reset to initial parser state.
   void reset();
 
+  /// Spool the files in multipart/form-data bodies larger than the given
+  /// number of bytes to files in the given directory as they're received,
+  /// rather than buffering the body in memory (the request's form fields and
+  /// uploaded files are then available but its body is empty). Off by default.
+  void setFormSpoolThreshold(std::size_t threshold, const FilePath& spoolPath)
+  {
+     form_spool_threshold_ = threshold;
+     form_spool_path_ = spoolPath;
+  }
+
+  /// Return headers_complete once the headers of requests whose bodies are
+  /// larger than the given number of bytes have been parsed, so that they
+  /// can be handled while their body is still being read (the request's body
+  /// then holds as much of it as was parsed along with the headers). Parsing
+  /// may also continue to read the body as usual. Off by default.
+  void setBodyStreamThreshold(std::size_t threshold)
+  {
+     body_stream_threshold_ = threshold;
+  }
+
   // enum for parse results
   enum status
   {
      incomplete,
      complete,
-     error
+     error,
+     headers_complete
   };
 
-  template <typename InputIterator>
-  status parse(Request& req, InputIterator begin, InputIterator end)
-  {
-    while (begin != end)
-    {
-       // header parsing
-      if (!parsing_body_)
-      {
-         status st = consume(req, *begin++);
-         if ( st == error )
-         {
-            return st ;
-         }
-         else if ( st == complete  )
-         {
-            // if we have a body then continue parsing it
-            if (content_length_ > 0)
-            {
-               parsing_body_ = true ;
-               continue ;
-            }
-            else
-            {
-               return st ;
-            }
-         }
-      }
-      // body parsing
-      else
-      {
-         req.body_.push_back(*begin++) ;
-         if (req.body_.size() == content_length_)
-            return complete ;
-      }
-    }
-    return incomplete ;
-  }
+  /// Parse the next buffer of input (returns incomplete until the whole
+  /// request, including its body, has been read).
+  status parse(Request& req, const char* begin, const char* end);
 
 private:
-  /// Handle the next character of input.
-  status consume(Request& req, char input);
+  /// Parse a line of the request line and headers (without its CRLF).
+  status parseLine(Request& req, const char* begin, const char* end);
+  status parseRequestLine(Request& req, const char* begin, const char* end);
+  status parseHeaderLine(Request& req, const char* begin, const char* end);
+
+  /// Prepare to read the request's body.
+  void beginBody(Request& req);
 
-  /// Check if a byte is an HTTP character.
-  static bool is_char(int c);
+  /// Consume as much of the body as is available.
+  status parseBody(Request& req, const char* begin, const char* end);
 
-  /// Check if a byte is an HTTP control character.
-  static bool is_ctl(int c);
+  /// Finish reading the request's body.
+  status endBody(Request& req);
 
-  /// Check if a byte is defined as an HTTP tspecial character.
-  static bool is_tspecial(int c);
+  bool parsing_request_line_ ;
+  bool parsing_body_ ;
 
-  /// Check if a byte is a digit.
-  static bool is_digit(int c);
+  // the start of a line which was split across buffers (lines which are
+  // entirely within a buffer are parsed in place)
+  std::string line_buffer_ ;
 
-  /// The current state of the parser.
-  enum state
-  {
-    method_start,
-    method,
-    uri_start,
-    uri,
-    http_version_h,
-    http_version_t_1,
-    http_version_t_2,
-    http_version_p,
-    http_version_slash,
-    http_version_major_start,
-    http_version_major,
-    http_version_minor_start,
-    http_version_minor,
-    expecting_newline_1,
-    header_line_start,
-    header_lws,
-    header_name,
-    space_before_header_value,
-    header_value,
-    expecting_newline_2,
-    expecting_newline_3
-  } state_;
-  
   std::size_t content_length_ ;
-  bool parsing_content_length_ ;
-  bool parsing_body_ ;
+  std::size_t body_bytes_read_ ;
+  std::size_t form_spool_threshold_ ;
+  std::size_t body_stream_threshold_ ;
+  FilePath form_spool_path_ ;
+  boost::shared_ptr<MultipartFormParser> form_parser_ ;
 };
 
 } // namespace http
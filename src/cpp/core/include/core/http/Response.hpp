@@ -57,6 +57,7 @@ enum Code {
    SwitchingProtocols = 101,
    Ok = 200,
    Created = 201,
+   NoContent = 204,
    PartialContent = 206,
    MovedPermanently = 301,
    MovedTemporarily = 302,
@@ -261,6 +262,9 @@ public:
                       const Request& request,
                       std::streamsize buffSize = 65536);
 
+   // stream a body produced incrementally (via chunked encoding)
+   void setStreamResponse(const boost::shared_ptr<StreamResponse>& streamResponse);
+
    Error setBody(const FilePath& filePath, std::streamsize buffSize = 512)
    {
       NullOutputFilter nullFilter;
@@ -333,11 +337,12 @@ public:
              filePath.mimeContentType() == "text/html";
    }
    
-   void setCacheableFile(const FilePath& filePath, const Request& request)
-   {
-      NullOutputFilter nullFilter;
-      setCacheableFile(filePath, request, nullFilter);
-   }
+   // serve a static file from the in-memory static content cache (which
+   // holds the file contents along with a precompressed gzip variant, keyed
+   // by path and invalidated by modification time and size). supports
+   // ETag (distinct for each encoding) / If-Modified-Since revalidation and
+   // range requests.
+   void setCacheableFile(const FilePath& filePath, const Request& request);
    
    template <typename Filter>
    void setCacheableFile(const FilePath& filePath, 
@@ -415,6 +420,8 @@ private:
    void removeCachingHeaders();
    void setCacheForeverHeaders(bool publicAccessiblity);
    std::string eTagForContent(const std::string& content);
+   void setBodyPrecompressed(const std::string& body,
+                             const std::string& encoding);
   
 private:
 
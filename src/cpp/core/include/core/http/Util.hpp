@@ -21,15 +21,18 @@
 #include <map>
 
 #include <boost/asio/buffer.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/system/error_code.hpp>
 
+#include <core/FilePath.hpp>
+
 namespace rstudio {
 namespace core {
    
 class Error;
-class FilePath;
 
 namespace http {
       
@@ -54,12 +57,35 @@ private:
    std::string name_ ;
 };     
    
+// the contents of an uploaded file which were written to disk as the
+// request was read (see RequestParser::setFormSpoolThreshold). the file is
+// removed along with the last reference to it (e.g. when the request is
+// destroyed) unless it has been moved elsewhere first
+class SpoolFile : boost::noncopyable
+{
+public:
+   explicit SpoolFile(const FilePath& path) : path_(path) {}
+   ~SpoolFile();
+
+   const FilePath& path() const { return path_; }
+
+   // move the contents to the given path (which then owns them)
+   Error moveTo(const FilePath& targetPath);
+
+private:
+   FilePath path_;
+};
+
 struct File
 {
    bool empty() const { return name.empty(); }
    std::string name;
    std::string contentType;
    std::string contents;   
+
+   // files which were spooled to disk have their contents here rather than
+   // in contents
+   boost::shared_ptr<SpoolFile> pSpoolFile;
 };
 
 typedef std::map<std::string,File> Files;
@@ -132,6 +158,17 @@ void parseFields(const std::string& fields,
    
 void parseForm(const std::string& body, Fields* pFields);
    
+// the boundary delimiting the parts of a multipart body (including its 
+// leading dashes)
+std::string multipartBoundary(const std::string& contentType);
+
+// parse the Content-Disposition header of a multipart/form-data part; returns
+// false if the part isn't a form field
+bool parseFormDataDisposition(const std::string& contentDisposition,
+                              std::string* pName,
+                              bool* pIsFile,
+                              std::string* pFilename);
+
 void parseMultipartForm(const std::string& contentType,
                         const std::string& body, 
                         Fields* pFields,
@@ -17,6 +17,9 @@
 #ifndef CORE_R_UTIL_ACTIVE_SESSIONS_HPP
 #define CORE_R_UTIL_ACTIVE_SESSIONS_HPP
 
+#include <map>
+#include <string>
+
 #include <boost/noncopyable.hpp>
 
 #include <core/Error.hpp>
@@ -340,10 +343,16 @@ private:
    void writeProperty(const std::string& name, const std::string& value) const;
    std::string readProperty(const std::string& name) const;
 
+   // remember properties once read, so that reading them again (e.g. when
+   // validating and then sorting a list of sessions) doesn't go to disk
+   void cacheProperties() { cacheProperties_ = true; }
+
 private:
    std::string id_;
    FilePath scratchPath_;
    FilePath propertiesPath_;
+   bool cacheProperties_ = false;
+   mutable std::map<std::string, std::string> properties_;
 };
 
 
@@ -383,6 +392,11 @@ public:
 
    static boost::shared_ptr<ActiveSession> emptySession(const std::string& id);
 
+private:
+   std::vector<boost::shared_ptr<ActiveSession> > validSessions(
+                                    const FilePath& userHomePath,
+                                    bool projectSharingEnabled) const;
+
 private:
    core::FilePath storagePath_;
 };
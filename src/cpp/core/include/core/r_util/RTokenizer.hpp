@@ -27,6 +27,7 @@
 #include <core/StringUtils.hpp>
 #include <core/collection/Position.hpp>
 
+#include <boost/cstdint.hpp>
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/regex.hpp>
@@ -88,7 +89,9 @@ public:
           std::size_t row,
           std::size_t column)
       : type_(type), begin_(begin), end_(end),
-        offset_(offset), row_(row), column_(column)
+        offset_(static_cast<boost::uint32_t>(offset)),
+        row_(static_cast<boost::uint32_t>(row)),
+        column_(static_cast<boost::uint32_t>(column))
    {
    }
    
@@ -145,13 +148,13 @@ public:
    static void unspecified_bool_true() {}
    operator unspecified_bool_type() const
    {
-      return offset_ == static_cast<std::size_t>(-1) ?
+      return offset_ == kInvalidOffset ?
                                              0 :
                                              unspecified_bool_true;
    }
    bool operator!() const
    {
-      return offset_ == static_cast<std::size_t>(-1);
+      return offset_ == kInvalidOffset;
    }
    
    std::wstring::const_iterator begin() const
@@ -177,13 +180,23 @@ public:
    }
 
 private:
-   std::wstring emptyToken_;
+   // tokens are created (and copied) in bulk so are kept small: null tokens
+   // share a single empty range rather than each owning one, and positions
+   // are stored as 32 bit values
+   static const std::wstring& emptyContent()
+   {
+      static const std::wstring instance;
+      return instance;
+   }
+
+   static const boost::uint32_t kInvalidOffset = static_cast<boost::uint32_t>(-1);
+
    TokenType type_ = TokenType::ERR;
-   std::wstring::const_iterator begin_ = emptyToken_.cbegin();
-   std::wstring::const_iterator end_ = emptyToken_.cend();
-   std::size_t offset_ = -1;
-   std::size_t row_ = 0;
-   std::size_t column_ = 0;
+   std::wstring::const_iterator begin_ = emptyContent().cbegin();
+   std::wstring::const_iterator end_ = emptyContent().cend();
+   boost::uint32_t offset_ = kInvalidOffset;
+   boost::uint32_t row_ = 0;
+   boost::uint32_t column_ = 0;
 };
 
 // Tokenize R code. Note that the RToken instances which are returned are
@@ -222,8 +235,7 @@ private:
    wchar_t peek();
    wchar_t peek(std::size_t lookahead);
    wchar_t eat();
-   std::size_t tokenLength(const boost::wregex& regex);
-   void eatUntil(const boost::wregex& regex);
+   std::size_t delimitedLength(wchar_t delimiter);
    RToken consumeToken(RToken::TokenType tokenType, std::size_t length);
    
 private:
@@ -38,6 +38,12 @@ public:
    virtual Error checkSpelling(const std::string& word,
                                bool *pCorrect) = 0;
 
+   // check a batch of words at once; pCorrect receives an entry for each
+   // word. words which can't be checked (e.g. because they can't be
+   // represented in the dictionary's encoding) are reported as correct
+   virtual Error checkSpelling(const std::vector<std::string>& words,
+                               std::vector<bool>* pCorrect) = 0;
+
    virtual Error suggestionList(const std::string& word,
                                 std::vector<std::string>* pSugs) = 0;
 
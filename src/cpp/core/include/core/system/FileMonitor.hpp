@@ -117,10 +117,16 @@ struct Callbacks
 // guarantee that the deletion of your shared_ptr object is invoked on the same
 // thread that called registerMonitor you should also bind a function to
 // onUnregistered (otherwise the delete will occur on the file monitoring thread)
+//
+// if a snapshotPath is provided then the directory listings read while
+// registering are saved there, and a later registration for the same
+// directory re-reads only those directories which have changed since (see
+// core::system::scanFiles for the caveats)
 void registerMonitor(const core::FilePath& filePath,
                      bool recursive,
                      const boost::function<bool(const FileInfo&)>& filter,
-                     const Callbacks& callbacks);
+                     const Callbacks& callbacks,
+                     const core::FilePath& snapshotPath = core::FilePath());
 
 // unregister a file monitor. note that file monitors can be automatically
 // unregistered in the case of errors or a call to global file_monitor::stop,
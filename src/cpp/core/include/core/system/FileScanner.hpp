@@ -17,6 +17,11 @@
 #ifndef CORE_SYSTEM_FILE_SCANNER_HPP
 #define CORE_SYSTEM_FILE_SCANNER_HPP
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
 
 #include <core/Error.hpp>
@@ -60,6 +65,40 @@ inline Error scanFiles(const FileInfo& fromRoot,
    return scanFiles(pTree->set_head(fromRoot), options, pTree);
 }
 
+// the (unfiltered) entries read from a directory along with the modification
+// time of the directory (in nanoseconds since the epoch) when they were read
+struct DirectoryListing
+{
+   DirectoryListing()
+      : modified(0)
+   {
+   }
+
+   boost::int64_t modified;
+   std::vector<FileInfo> entries;
+};
+
+// the listings of the directories visited by a scan (keyed by path)
+typedef std::map<std::string, DirectoryListing> FileScanSnapshot;
+
+// scan files, re-using the names listed in a previous snapshot for any
+// directory which hasn't been modified since that snapshot was taken (the
+// entries are still stat'ed, as modifying a file doesn't modify its
+// directory). the listings used are recorded in pCurrent (which can be saved
+// and passed to a later scan).
+// (only posix records directory times -- elsewhere this is a full scan)
+Error scanFiles(const FileInfo& fromRoot,
+                const FileScannerOptions& options,
+                const FileScanSnapshot& previous,
+                tree<FileInfo>* pTree,
+                FileScanSnapshot* pCurrent);
+
+Error readFileScanSnapshot(const FilePath& snapshotPath,
+                           FileScanSnapshot* pSnapshot);
+
+Error writeFileScanSnapshot(const FilePath& snapshotPath,
+                            const FileScanSnapshot& snapshot);
+
 
 } // namespace system
 } // namespace core
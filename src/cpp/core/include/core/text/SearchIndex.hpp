@@ -0,0 +1,180 @@
+/*
+ * SearchIndex.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_TEXT_SEARCH_INDEX_HPP
+#define CORE_TEXT_SEARCH_INDEX_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace boost {
+namespace iostreams {
+   class mapped_file_source;
+}
+}
+
+namespace rstudio {
+namespace core {
+
+class Error;
+class FilePath;
+
+namespace text {
+
+// fields of a document which can be searched. matches are weighted by the
+// field they occur in (e.g. a match on a topic name ranks above a match
+// found somewhere in a description)
+enum SearchField
+{
+   SearchFieldName        = 0,
+   SearchFieldAlias       = 1,
+   SearchFieldTitle       = 2,
+   SearchFieldKeyword     = 3,
+   SearchFieldDescription = 4,
+   SearchFieldText        = 5
+};
+
+// split text into lower case search terms. compound identifiers such as
+// 'read.csv' yield both the whole identifier and its parts
+std::vector<std::string> searchTerms(const std::string& text);
+
+struct SearchDocument
+{
+   SearchDocument() {}
+   SearchDocument(const std::string& name,
+                  const std::string& title,
+                  const std::string& type)
+      : name(name), title(title), type(type)
+   {
+   }
+
+   void addText(SearchField field, const std::string& text)
+   {
+      content.push_back(std::make_pair(field, text));
+   }
+
+   std::string name;
+   std::string title;
+   std::string type;
+   std::vector<std::pair<SearchField, std::string> > content;
+};
+
+// accumulates documents and writes them as an inverted index file
+class SearchIndexBuilder : boost::noncopyable
+{
+public:
+   SearchIndexBuilder() {}
+
+   void addDocument(const SearchDocument& document);
+
+   std::size_t documentCount() const { return documents_.size(); }
+
+   Error write(const FilePath& filePath) const;
+
+private:
+   struct Document
+   {
+      std::string name;
+      std::string title;
+      std::string type;
+   };
+
+   std::vector<Document> documents_;
+
+   // term => (document => mask of fields the term occurs in)
+   std::map<std::string, std::map<boost::uint32_t, boost::uint32_t> > terms_;
+};
+
+struct SearchOptions
+{
+   SearchOptions()
+      : prefix(true), fuzzy(true), maxResults(100)
+   {
+   }
+
+   // match index terms which begin with a query term
+   bool prefix;
+
+   // match index terms within a small edit distance of a query term
+   bool fuzzy;
+
+   std::size_t maxResults;
+};
+
+struct SearchMatch
+{
+   SearchMatch() : document(0), score(0) {}
+   SearchMatch(std::size_t document, double score)
+      : document(document), score(score)
+   {
+   }
+
+   std::size_t document;
+   double score;
+};
+
+// read only view of an index file written by SearchIndexBuilder. the file
+// is memory mapped so opening an index is cheap and its pages are shared
+// with (and cached by) the operating system
+class SearchIndex : boost::noncopyable
+{
+public:
+   SearchIndex();
+   ~SearchIndex();
+
+   Error open(const FilePath& filePath);
+
+   std::size_t documentCount() const;
+   std::string documentName(std::size_t document) const;
+   std::string documentTitle(std::size_t document) const;
+   std::string documentType(std::size_t document) const;
+
+   // find the documents matching all of the query's terms, ordered by
+   // descending score
+   std::vector<SearchMatch> search(const std::string& query,
+                                   const SearchOptions& options) const;
+
+private:
+   const char* string(boost::uint32_t offset) const;
+
+   void matchTerm(const std::string& queryTerm,
+                  const SearchOptions& options,
+                  std::map<std::size_t, double>* pScores) const;
+
+   void addPostings(std::size_t term,
+                    double quality,
+                    std::map<std::size_t, double>* pScores) const;
+
+   boost::shared_ptr<boost::iostreams::mapped_file_source> pFile_;
+   const char* pDocuments_;
+   const char* pTerms_;
+   const char* pPostings_;
+   const char* pStrings_;
+   std::size_t documentCount_;
+   std::size_t termCount_;
+   std::size_t postingCount_;
+   std::size_t stringsSize_;
+};
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_TEXT_SEARCH_INDEX_HPP
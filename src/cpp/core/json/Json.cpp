@@ -25,6 +25,7 @@
 
 #include <core/Log.hpp>
 #include <core/Thread.hpp>
+#include <core/Trace.hpp>
 
 #include "spirit/json_spirit.h"
 
@@ -151,6 +152,7 @@ bool parse(const std::string& input, Value* pValue)
 
 void write(const Value& value, std::ostream& os)
 {
+   TRACE_SPAN("json.write");
    json_spirit::write(value, os);
 }
 
@@ -161,6 +163,7 @@ void writeFormatted(const Value& value, std::ostream& os)
 
 std::string write(const Value& value)
 {
+   TRACE_SPAN("json.write");
    return json_spirit::write(value);
 }
 
@@ -15,10 +15,12 @@
 
 #include <core/libclang/SourceIndex.hpp>
 
+#include <iostream>
+
 #include <boost/foreach.hpp>
 
 #include <core/FilePath.hpp>
-#include <core/PerformanceTimer.hpp>
+#include <core/Trace.hpp>
 
 #include <core/system/ProcessArgs.hpp>
 
@@ -154,12 +156,9 @@ TranslationUnit SourceIndex::getTranslationUnit(const std::string& filename,
 {
    FilePath filePath(filename);
 
-   boost::scoped_ptr<core::PerformanceTimer> pTimer;
+   TRACE_SPAN_DETAIL("clang.index", filePath.absolutePath());
    if (verbose_ > 0)
-   {
       std::cerr << "CLANG INDEXING: " << filePath.absolutePath() << std::endl;
-      pTimer.reset(new core::PerformanceTimer(filePath.filename()));
-   }
 
    // get the arguments and last write time for this file
    std::vector<std::string> args;
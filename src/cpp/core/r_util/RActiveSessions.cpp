@@ -42,31 +42,59 @@ namespace {
 void ActiveSession::writeProperty(const std::string& name,
                                  const std::string& value) const
 {
+   // write to a temporary file and move it into place so that concurrent
+   // readers (e.g. another process listing sessions, which destroys those
+   // with missing properties) never see a partially written value
    FilePath propertyFile = propertiesPath_.childPath(name);
-   Error error = core::writeStringToFile(propertyFile, value);
+   FilePath tempFile = propertiesPath_.childPath(
+            "." + name + "-" + core::system::generateShortenedUuid());
+   Error error = core::writeStringToFile(tempFile, value);
+   if (!error)
+      error = tempFile.move(propertyFile, FilePath::MoveDirect);
    if (error)
+   {
       LOG_ERROR(error);
+
+      Error removeError = tempFile.removeIfExists();
+      if (removeError)
+         LOG_ERROR(removeError);
+      return;
+   }
+
+   if (cacheProperties_)
+      properties_[name] = boost::algorithm::trim_copy(value);
 }
 
 std::string ActiveSession::readProperty(const std::string& name) const
 {
    using namespace rstudio::core;
+
+   if (cacheProperties_)
+   {
+      std::map<std::string, std::string>::const_iterator it =
+                                                      properties_.find(name);
+      if (it != properties_.end())
+         return it->second;
+   }
+
+   std::string value;
    FilePath readPath = propertiesPath_.childPath(name);
    if (readPath.exists())
    {
-      std::string value;
       Error error = core::readStringFromFile(readPath, &value);
       if (error)
       {
+         // don't cache failed reads
          LOG_ERROR(error);
          return std::string();
       }
-      return boost::algorithm::trim_copy(value);
-   }
-   else
-   {
-      return std::string();
+      boost::algorithm::trim(value);
    }
+
+   if (cacheProperties_)
+      properties_[name] = value;
+
+   return value;
 }
 
 Error ActiveSessions::create(const std::string& project,
@@ -134,7 +162,7 @@ bool compareActivityLevel(boost::shared_ptr<ActiveSession> a,
 
 } // anonymous namespace
 
-std::vector<boost::shared_ptr<ActiveSession> > ActiveSessions::list(
+std::vector<boost::shared_ptr<ActiveSession> > ActiveSessions::validSessions(
                                        const FilePath& userHomePath,
                                        bool projectSharingEnabled) const
 {
@@ -158,6 +186,9 @@ std::vector<boost::shared_ptr<ActiveSession> > ActiveSessions::list(
          boost::shared_ptr<ActiveSession> pSession = get(id);
          if (!pSession->empty())
          {
+            // validation and sorting read some properties several times
+            pSession->cacheProperties();
+
             if (pSession->validate(userHomePath, projectSharingEnabled))
             {
                sessions.push_back(pSession);
@@ -177,6 +208,16 @@ std::vector<boost::shared_ptr<ActiveSession> > ActiveSessions::list(
 
    }
 
+   return sessions;
+}
+
+std::vector<boost::shared_ptr<ActiveSession> > ActiveSessions::list(
+                                       const FilePath& userHomePath,
+                                       bool projectSharingEnabled) const
+{
+   std::vector<boost::shared_ptr<ActiveSession> > sessions =
+                        validSessions(userHomePath, projectSharingEnabled);
+
    // sort by activity level (most active sessions first)
    std::sort(sessions.begin(), sessions.end(), compareActivityLevel);
 
@@ -187,7 +228,8 @@ std::vector<boost::shared_ptr<ActiveSession> > ActiveSessions::list(
 size_t ActiveSessions::count(const FilePath& userHomePath,
                              bool projectSharingEnabled) const
 {
-   return list(userHomePath, projectSharingEnabled).size();
+   // (no need to sort, which reads the activity properties of each session)
+   return validSessions(userHomePath, projectSharingEnabled).size();
 }
 
 boost::shared_ptr<ActiveSession> ActiveSessions::get(const std::string& id) const
@@ -13,24 +13,10 @@
  *
  */
 
-// A very low level assertion (line 595 of cpp_regex_traits.hpp) is firing
-// on WindowsXP when we create a boost::wregex within R session. This code
-// is part of boost attempting to detect the sort syntax, and the assertion
-// is that there are no nulls in a buffer after a call to locale->transform.
-// Within the same method there are workarounds for both borland c++ and
-// dinkumware c++ std library to strip embedded nulls, so it seems as if
-// there is some variation in whether nulls come out of the call to transforn.
-// Note also that boost has a macro titled BOOST_REGEX_NO_WIN32 which we are
-// not using, which means that boost regex does call into native windows APIs
-// for locale oriented functions (thus explaining a difference in runtime
-// behavior across platforms). Tokenization appears to continue to work
-// correctly in the presence of the assertion (with the annoying side effect
-// of logging an assertion every time the product starts up)
-
 #include <core/r_util/RTokenizer.hpp>
 
-#include <boost/regex.hpp>
-
+#include <algorithm>
+#include <cwctype>
 #include <iostream>
 #include <sstream>
 
@@ -45,37 +31,88 @@ namespace r_util {
 
 namespace {
 
-class TokenPatterns
+// character classes for the ASCII range, consulted by the scanners below in
+// place of regular expressions (tokenization sits underneath indexing,
+// diagnostics and completions so the per-character checks need to be cheap)
+enum CharClass
 {
-private:
-   friend TokenPatterns& tokenPatterns();
-   TokenPatterns()
-      : NUMBER(L"[0-9]*(\\.[0-9]*)?([eE][+-]?[0-9]*)?[Li]?"),
-        HEX_NUMBER(L"0x[0-9a-fA-F]*L?"),
-        USER_OPERATOR(L"%[^%]*%"),
-        QUOTED_IDENTIFIER(L"`[^`]*`"),
-        UNTIL_END_QUOTE(L"[\\\\\'\"]"),
-        WHITESPACE(L"[\\s\x00A0\x3000]+"),
-        COMMENT(L"#[^\\n]*$")
+   CharDigit      = 1 << 0,
+   CharHexDigit   = 1 << 1,
+   CharWhitespace = 1 << 2,
+   CharIdentifier = 1 << 3
+};
+
+class CharClassTable
+{
+public:
+   CharClassTable()
    {
+      std::fill(table_, table_ + 128, 0);
+
+      for (int c = '0'; c <= '9'; ++c)
+         table_[c] |= CharDigit | CharHexDigit | CharIdentifier;
+
+      for (int c = 'a'; c <= 'z'; ++c)
+         table_[c] |= CharIdentifier;
+
+      for (int c = 'A'; c <= 'Z'; ++c)
+         table_[c] |= CharIdentifier;
+
+      for (int c = 'a'; c <= 'f'; ++c)
+         table_[c] |= CharHexDigit;
+
+      for (int c = 'A'; c <= 'F'; ++c)
+         table_[c] |= CharHexDigit;
+
+      table_[static_cast<int>('.')] |= CharIdentifier;
+      table_[static_cast<int>('_')] |= CharIdentifier;
+
+      const char* whitespace = " \t\n\v\f\r";
+      for (const char* pChar = whitespace; *pChar; ++pChar)
+         table_[static_cast<int>(*pChar)] |= CharWhitespace;
    }
 
-public:
-   const boost::wregex NUMBER;
-   const boost::wregex HEX_NUMBER;
-   const boost::wregex USER_OPERATOR;
-   const boost::wregex QUOTED_IDENTIFIER;
-   const boost::wregex UNTIL_END_QUOTE;
-   const boost::wregex WHITESPACE;
-   const boost::wregex COMMENT;
+   bool is(wchar_t c, int charClass) const
+   {
+      return c >= 0 && c < 128 && (table_[c] & charClass);
+   }
+
+private:
+   unsigned char table_[128];
 };
 
-TokenPatterns& tokenPatterns()
+const CharClassTable& charClasses()
 {
-   static TokenPatterns instance;
+   static CharClassTable instance;
    return instance;
 }
 
+inline bool isDigit(wchar_t c)
+{
+   return charClasses().is(c, CharDigit);
+}
+
+inline bool isHexDigit(wchar_t c)
+{
+   return charClasses().is(c, CharHexDigit);
+}
+
+inline bool isWhitespace(wchar_t c)
+{
+   if (c < 128)
+      return charClasses().is(c, CharWhitespace);
+
+   return c == L'\x00A0' || c == L'\x3000' || std::iswspace(c);
+}
+
+inline bool isIdentifierChar(wchar_t c)
+{
+   if (c < 128)
+      return charClasses().is(c, CharIdentifier);
+
+   return string_utils::isalnum(c);
+}
+
 void updatePosition(std::wstring::const_iterator pos,
                     std::size_t length,
                     std::size_t* pRow,
@@ -214,7 +251,11 @@ RToken RTokenizer::nextToken()
 
 RToken RTokenizer::matchWhitespace()
 {
-   return consumeToken(RToken::WHITESPACE, tokenLength(tokenPatterns().WHITESPACE));
+   std::wstring::const_iterator it = pos_;
+   while (it != end_ && isWhitespace(*it))
+      ++it;
+
+   return consumeToken(RToken::WHITESPACE, it - pos_);
 }
 
 RToken RTokenizer::matchStringLiteral()
@@ -224,7 +265,9 @@ RToken RTokenizer::matchStringLiteral()
 
    while (!eol())
    {
-      eatUntil(tokenPatterns().UNTIL_END_QUOTE);
+      // skip to the next quote or escape
+      while (!eol() && *pos_ != L'\\' && *pos_ != L'\'' && *pos_ != L'"')
+         ++pos_;
 
       if (eol())
          break ;
@@ -268,18 +311,51 @@ RToken RTokenizer::matchStringLiteral()
 
 RToken RTokenizer::matchNumber()
 {
-   std::size_t length = tokenLength(tokenPatterns().HEX_NUMBER);
-   if (length == 0)
-      length = tokenLength(tokenPatterns().NUMBER);
+   std::wstring::const_iterator it = pos_;
+
+   if (peek() == L'0' && peek(1) == L'x')
+   {
+      // 0x[0-9a-fA-F]*L?
+      it += 2;
+      while (it != end_ && isHexDigit(*it))
+         ++it;
+      if (it != end_ && *it == L'L')
+         ++it;
+   }
+   else
+   {
+      // [0-9]*(\.[0-9]*)?([eE][+-]?[0-9]*)?[Li]?
+      while (it != end_ && isDigit(*it))
+         ++it;
+
+      if (it != end_ && *it == L'.')
+      {
+         ++it;
+         while (it != end_ && isDigit(*it))
+            ++it;
+      }
 
-   return consumeToken(RToken::NUMBER, length);
+      if (it != end_ && (*it == L'e' || *it == L'E'))
+      {
+         ++it;
+         if (it != end_ && (*it == L'+' || *it == L'-'))
+            ++it;
+         while (it != end_ && isDigit(*it))
+            ++it;
+      }
+
+      if (it != end_ && (*it == L'L' || *it == L'i'))
+         ++it;
+   }
+
+   return consumeToken(RToken::NUMBER, it - pos_);
 }
 
 RToken RTokenizer::matchIdentifier()
 {
    std::wstring::const_iterator start = pos_ ;
    eat();
-   while (string_utils::isalnum(peek()) || peek() == L'.' || peek() == L'_')
+   while (!eol() && isIdentifierChar(*pos_))
       eat();
    
    std::size_t row = row_;
@@ -296,7 +372,7 @@ RToken RTokenizer::matchIdentifier()
 
 RToken RTokenizer::matchQuotedIdentifier()
 {
-   std::size_t length = tokenLength(tokenPatterns().QUOTED_IDENTIFIER);
+   std::size_t length = delimitedLength(L'`');
    if (length == 0)
       return consumeToken(RToken::ERR, 1);
    else
@@ -305,12 +381,17 @@ RToken RTokenizer::matchQuotedIdentifier()
 
 RToken RTokenizer::matchComment()
 {
-   return consumeToken(RToken::COMMENT, tokenLength(tokenPatterns().COMMENT));
+   // comments run up to (but don't include) the end of the line
+   std::wstring::const_iterator it = std::find(pos_, end_, L'\n');
+   if (it != end_ && it - pos_ > 1 && *(it - 1) == L'\r')
+      --it;
+
+   return consumeToken(RToken::COMMENT, it - pos_);
 }
 
 RToken RTokenizer::matchUserOperator()
 {
-   std::size_t length = tokenLength(tokenPatterns().USER_OPERATOR);
+   std::size_t length = delimitedLength(L'%');
    if (length == 0)
       return consumeToken(RToken::ERR, 1);
    else
@@ -402,30 +483,18 @@ wchar_t RTokenizer::eat()
    return result ;
 }
 
-std::size_t RTokenizer::tokenLength(const boost::wregex& regex)
+std::size_t RTokenizer::delimitedLength(wchar_t delimiter)
 {
-   boost::wsmatch match;
-   std::wstring::const_iterator end = data_.end();
-   boost::match_flag_type flg = boost::match_default | boost::match_continuous;
-   if (regex_utils::search(pos_, end, match, regex, flg))
-      return match.length();
-   else
+   // the delimiter at the current position opens the token; find the one
+   // which closes it
+   if (eol() || *pos_ != delimiter)
       return 0;
-}
 
-void RTokenizer::eatUntil(const boost::wregex& regex)
-{
-   boost::wsmatch match;
-   std::wstring::const_iterator end = data_.end();
-   if (regex_utils::search(pos_, end, match, regex))
-   {
-      pos_ = match[0].first;
-   }
-   else
-   {
-      // eat all on failure to match
-      pos_ = data_.end();
-   }
+   std::wstring::const_iterator it = std::find(pos_ + 1, end_, delimiter);
+   if (it == end_)
+      return 0;
+
+   return (it - pos_) + 1;
 }
 
 
@@ -467,19 +536,17 @@ public:
    typedef std::wstring key_type;
    typedef std::string mapped_type;
    
-   bool contains(const RToken& token) const
+   // look up (converting on first use) the UTF-8 form of a token's content
+   const mapped_type& get(const RToken& token)
    {
-      return database_.count(token.content());
-   }
-   
-   std::string& get(const RToken& token)
-   {
-      return database_[token.content()];
-   }
-   
-   void put(const RToken& token, const mapped_type& value)
-   {
-      database_[token.content()] = value;
+      key_type content = token.content();
+      std::map<key_type, mapped_type>::iterator it = database_.lower_bound(content);
+      if (it == database_.end() || it->first != content)
+      {
+         mapped_type value = string_utils::wideToUtf8(content);
+         it = database_.insert(it, std::make_pair(content, value));
+      }
+      return it->second;
    }
    
 private:
@@ -494,13 +561,7 @@ ConversionCache& conversionCache()
 
 const std::string& RToken::contentAsUtf8() const
 {
-   ConversionCache& cache = conversionCache();
-   if (cache.contains(*this))
-      return cache.get(*this);
-   
-   std::string result = string_utils::wideToUtf8(content());
-   cache.put(*this, result);
-   return cache.get(*this);
+   return conversionCache().get(*this);
 }
 
 std::string RToken::asString() const
@@ -19,6 +19,7 @@
 
 #include <iostream>
 
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/foreach.hpp>
 
 #include <tests/TestThat.hpp>
@@ -231,6 +232,33 @@ void testWhitespace()
 }
 
 
+std::wstring largeRSource()
+{
+   std::wstring chunk =
+         L"#' Compute summary statistics for a data set\n"
+         L"summarize <- function(data, cols = names(data), na.rm = TRUE, ...)\n"
+         L"{\n"
+         L"   result <- list()\n"
+         L"   for (col in cols) {\n"
+         L"      x <- data[[col]]\n"
+         L"      if (is.numeric(x) && length(x) > 0L) {\n"
+         L"         result[[col]] <- c(mean = mean(x, na.rm = na.rm),\n"
+         L"                            sd = sd(x, na.rm = na.rm),\n"
+         L"                            q = quantile(x, 0.95)[1])\n"
+         L"      } else {\n"
+         L"         result[[col]] <- sprintf('%s: %d values', col, length(x))\n"
+         L"      }\n"
+         L"   }\n"
+         L"   `attr<-`(result, \"class\", \"summary\") %>% invisible()\n"
+         L"}\n"
+         L"x <- 0xFFL + 1e-3 * 2i; y <<- x ** 2 -> z; \x00C1b <- \"\\\"\"\n";
+
+   std::wstring code;
+   for (std::size_t i = 0; i < 2000; ++i)
+      code += chunk;
+   return code;
+}
+
 } // anonymous namespace
 
 
@@ -269,6 +297,64 @@ context("RTokenizer")
       expect_true(rTokens.at(2).isType(RToken::OPER));
       expect_true(rTokens.at(2).contentEquals(L"**"));
    }
+
+   test_that("Unterminated user operators and quoted identifiers are errors")
+   {
+      RTokens rTokens(L"a %in b");
+      expect_true(rTokens.at(2).isType(RToken::ERR));
+      expect_true(rTokens.at(2).contentEquals(L'%'));
+
+      RTokens quoted(L"`a b");
+      expect_true(quoted.at(0).isType(RToken::ERR));
+      expect_true(quoted.at(0).contentEquals(L'`'));
+   }
+
+   test_that("Large sources are tokenized losslessly")
+   {
+      std::wstring code = largeRSource();
+
+      boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+      RTokens rTokens(code);
+      boost::posix_time::time_duration elapsed =
+            boost::posix_time::microsec_clock::universal_time() - start;
+
+      // the tokens should cover the source exactly, with positions
+      // which agree with their offsets
+      std::wstring joined;
+      std::size_t row = 0;
+      std::size_t column = 0;
+      std::size_t errors = 0;
+      for (std::size_t i = 0, n = rTokens.size(); i < n; ++i)
+      {
+         const RToken& token = rTokens.atUnsafe(i);
+         expect_true(token.offset() == joined.size());
+         expect_true(token.row() == row && token.column() == column);
+
+         if (token.isType(RToken::ERR))
+            ++errors;
+
+         for (std::wstring::const_iterator it = token.begin(); it != token.end(); ++it)
+         {
+            if (*it == L'\n')
+            {
+               ++row;
+               column = 0;
+            }
+            else
+            {
+               ++column;
+            }
+         }
+         joined.append(token.begin(), token.end());
+      }
+
+      expect_true(joined == code);
+      expect_true(errors == 0);
+
+      // about a megabyte of code should take well under a second; allow
+      // plenty of headroom for debug builds
+      expect_true(elapsed < boost::posix_time::seconds(10));
+   }
 }
 
 } // namespace r_util
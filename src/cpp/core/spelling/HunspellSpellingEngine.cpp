@@ -16,6 +16,7 @@
 #include <core/spelling/HunspellSpellingEngine.hpp>
 
 #include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <core/Error.hpp>
@@ -40,6 +41,9 @@ namespace spelling {
 
 namespace {
 
+// maximum number of spelling results cached per dictionary
+const std::size_t kMaxCachedResults = 100000;
+
 // remove morphological description from text
 void removeMorphologicalDescription(std::string* pText)
 {
@@ -112,6 +116,8 @@ class SpellChecker : boost::noncopyable
 public:
    virtual ~SpellChecker() {}
    virtual Error checkSpelling(const std::string& word, bool *pCorrect) = 0;
+   virtual Error checkSpelling(const std::vector<std::string>& words,
+                               std::vector<bool>* pCorrect) = 0;
    virtual Error suggestionList(const std::string& word,
                                 std::vector<std::string>* pSugs) = 0;
    virtual Error wordChars(std::wstring* pWordChars) = 0;
@@ -126,6 +132,13 @@ public:
       return Success();
    }
 
+   Error checkSpelling(const std::vector<std::string>& words,
+                       std::vector<bool>* pCorrect)
+   {
+      pCorrect->assign(words.size(), true);
+      return Success();
+   }
+
    Error suggestionList(const std::string& word,
                         std::vector<std::string>* pSugs)
    {
@@ -267,15 +280,131 @@ private:
    }
 
 
+   // convert a batch of words to the dictionary encoding. all of the
+   // encodings used by hunspell dictionaries are ASCII compatible so the
+   // words are joined by newlines and converted with a single call; if that
+   // fails (e.g. because one of the words can't be represented) we fall back
+   // to converting the words individually. words which can't be converted
+   // are left empty
+   void encodeWords(const std::vector<std::string>& words,
+                    std::vector<std::string>* pEncoded)
+   {
+      if (encoding_ == "UTF-8")
+      {
+         *pEncoded = words;
+         return;
+      }
+
+      std::string encoded;
+      Error error = iconvstrFunc_(boost::algorithm::join(words, "\n"),
+                                  "UTF-8",
+                                  encoding_,
+                                  false,
+                                  &encoded);
+      if (!error)
+      {
+         boost::algorithm::split(*pEncoded,
+                                 encoded,
+                                 boost::algorithm::is_any_of("\n"));
+         if (pEncoded->size() == words.size())
+            return;
+      }
+
+      pEncoded->clear();
+      BOOST_FOREACH(const std::string& word, words)
+      {
+         error = iconvstrFunc_(word, "UTF-8", encoding_, false, &encoded);
+         if (error)
+         {
+            // some combinations of platform, non-ASCII characters, and
+            // locale are known to fail in iconv; we just won't be able to
+            // spell check those words
+            LOG_ERROR(error);
+            encoded.clear();
+         }
+         pEncoded->push_back(encoded);
+      }
+   }
+
+   void cacheResult(const std::string& word, bool correct)
+   {
+      // the cache is dropped along with the checker whenever the dictionaries
+      // in use change; it only needs bounding for very long sessions
+      if (results_.size() >= kMaxCachedResults)
+         results_.clear();
+
+      results_[word] = correct;
+   }
+
 public:
    Error checkSpelling(const std::string& word, bool *pCorrect)
    {
+      ResultCache::const_iterator it = results_.find(word);
+      if (it != results_.end())
+      {
+         *pCorrect = it->second;
+         return Success();
+      }
+
       std::string encoded;
       Error error = iconvstrFunc_(word,"UTF-8",encoding_,false,&encoded);
       if (error)
          return error;
 
       *pCorrect = pHunspell_->spell(encoded.c_str());
+      cacheResult(word, *pCorrect);
+      return Success();
+   }
+
+   Error checkSpelling(const std::vector<std::string>& words,
+                       std::vector<bool>* pCorrect)
+   {
+      pCorrect->assign(words.size(), true);
+
+      // answer what we can from the cache, collecting the remaining
+      // (distinct) words along with the positions they occur at
+      std::vector<std::string> uncached;
+      boost::unordered_map<std::string, std::vector<std::size_t> > positions;
+      for (std::size_t i = 0; i < words.size(); i++)
+      {
+         const std::string& word = words[i];
+         ResultCache::const_iterator it = results_.find(word);
+         if (it != results_.end())
+         {
+            (*pCorrect)[i] = it->second;
+            continue;
+         }
+
+         std::vector<std::size_t>& wordPositions = positions[word];
+         if (wordPositions.empty())
+            uncached.push_back(word);
+         wordPositions.push_back(i);
+      }
+
+      if (uncached.empty())
+         return Success();
+
+      std::vector<std::string> encoded;
+      encodeWords(uncached, &encoded);
+
+      for (std::size_t i = 0; i < uncached.size(); i++)
+      {
+         // words which couldn't be encoded are left as correct
+         if (encoded[i].empty())
+            continue;
+
+         bool correct = pHunspell_->spell(encoded[i].c_str());
+         cacheResult(uncached[i], correct);
+
+         if (!correct)
+         {
+            BOOST_FOREACH(std::size_t position, positions[uncached[i]])
+            {
+               (*pCorrect)[position] = false;
+            }
+         }
+      }
+
       return Success();
    }
 
@@ -311,6 +440,7 @@ public:
       // it seems the return value is always 0, meaning there's really no
       // error ever thrown if the method fails.
       *pAdded = (pHunspell_->add(encoded.c_str()) == 0);
+      results_.clear();
       return Success();
    }
 
@@ -338,6 +468,7 @@ public:
 
       *pAdded = (pHunspell_->add_with_affix(wordEncoded.c_str(),
                                             exampleEncoded.c_str()) == 0);
+      results_.clear();
       return Success();
    }
 
@@ -361,13 +492,19 @@ public:
       // Convert path to system encoding before sending to external api
       std::string systemDicPath = string_utils::utf8ToSystem(dicPath.absolutePath());
       *pAdded = (pHunspell_->add_dic(systemDicPath.c_str(),key.c_str()) == 0);
+      results_.clear();
       return Success();
    }
 
 private:
+   typedef boost::unordered_map<std::string, bool> ResultCache;
+
    boost::scoped_ptr<Hunspell> pHunspell_;
    IconvstrFunction iconvstrFunc_;
    std::string encoding_;
+
+   // previously checked words (known good and known bad)
+   ResultCache results_;
 };
 
 } // anonymous namespace
@@ -472,6 +609,12 @@ Error HunspellSpellingEngine::checkSpelling(const std::string& word,
    return pImpl_->spellChecker().checkSpelling(word, pCorrect);
 }
 
+Error HunspellSpellingEngine::checkSpelling(const std::vector<std::string>& words,
+                                            std::vector<bool>* pCorrect)
+{
+   return pImpl_->spellChecker().checkSpelling(words, pCorrect);
+}
+
 Error HunspellSpellingEngine::suggestionList(const std::string& word,
                                              std::vector<std::string>* pSugs)
 {
@@ -0,0 +1,221 @@
+/*
+ * FileScanSnapshot.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/system/FileScanner.hpp>
+
+#include <istream>
+#include <ostream>
+
+#include <boost/foreach.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/system/System.hpp>
+
+// snapshots are written as text, one line per directory followed by one
+// line per entry:
+//
+//   <modified> <entry count> <path>
+//   <type> <size> <last write time> <name>
+//
+// where paths and names are written as <length>:<characters> (they may
+// contain spaces or newlines) and the type is one of d (directory),
+// f (file) or D / F (symlink to a directory / file)
+
+namespace rstudio {
+namespace core {
+namespace system {
+
+namespace {
+
+const char * const kSnapshotHeader = "rstudio-file-scan-snapshot";
+const int kSnapshotVersion = 1;
+
+// guard against allocating huge strings for a corrupt snapshot
+const std::size_t kMaxStringSize = 65536;
+
+void writeString(const std::string& str, std::ostream& os)
+{
+   os << str.size() << ':' << str;
+}
+
+bool readString(std::istream& is, std::string* pStr)
+{
+   std::size_t size;
+   char separator;
+   if (!(is >> size) || !is.get(separator) || separator != ':' ||
+       size > kMaxStringSize)
+   {
+      return false;
+   }
+
+   pStr->resize(size);
+   return size == 0 || is.read(&(*pStr)[0], size);
+}
+
+char entryType(const FileInfo& fileInfo)
+{
+   if (fileInfo.isDirectory())
+      return fileInfo.isSymlink() ? 'D' : 'd';
+   else
+      return fileInfo.isSymlink() ? 'F' : 'f';
+}
+
+std::string entryName(const FileInfo& fileInfo)
+{
+   std::string path = fileInfo.absolutePath();
+   return path.substr(path.rfind('/') + 1);
+}
+
+std::string entryPath(const std::string& dirPath, const std::string& name)
+{
+   if (!dirPath.empty() && dirPath[dirPath.size() - 1] == '/')
+      return dirPath + name;
+   else
+      return dirPath + '/' + name;
+}
+
+bool readEntry(std::istream& is, const std::string& dirPath, FileInfo* pEntry)
+{
+   char type;
+   uintmax_t size;
+   std::time_t lastWriteTime;
+   std::string name;
+   if (!(is >> type >> size >> lastWriteTime) || !is.ignore() ||
+       !readString(is, &name) || name.empty())
+   {
+      return false;
+   }
+
+   std::string path = entryPath(dirPath, name);
+   switch (type)
+   {
+   case 'd':
+   case 'D':
+      *pEntry = FileInfo(path, true, type == 'D');
+      return true;
+   case 'f':
+   case 'F':
+      *pEntry = FileInfo(path, false, size, lastWriteTime, type == 'F');
+      return true;
+   default:
+      return false;
+   }
+}
+
+Error snapshotFormatError(const FilePath& snapshotPath,
+                          const ErrorLocation& location)
+{
+   Error error = systemError(boost::system::errc::bad_message, location);
+   error.addProperty("path", snapshotPath);
+   return error;
+}
+
+} // anonymous namespace
+
+Error readFileScanSnapshot(const FilePath& snapshotPath,
+                           FileScanSnapshot* pSnapshot)
+{
+   boost::shared_ptr<std::istream> pStream;
+   Error error = snapshotPath.open_r(&pStream);
+   if (error)
+      return error;
+
+   // check the header (a snapshot from another version is simply ignored)
+   std::string header;
+   int version;
+   if (!(*pStream >> header >> version) || header != kSnapshotHeader)
+      return snapshotFormatError(snapshotPath, ERROR_LOCATION);
+   if (version != kSnapshotVersion)
+      return Success();
+
+   // read the directory listings
+   FileScanSnapshot snapshot;
+   boost::int64_t modified;
+   std::size_t count;
+   while (*pStream >> modified >> count)
+   {
+      std::string dirPath;
+      if (!pStream->ignore() || !readString(*pStream, &dirPath))
+         return snapshotFormatError(snapshotPath, ERROR_LOCATION);
+
+      DirectoryListing& listing = snapshot[dirPath];
+      listing.modified = modified;
+      for (std::size_t i = 0; i < count; i++)
+      {
+         FileInfo entry;
+         if (!readEntry(*pStream, dirPath, &entry))
+            return snapshotFormatError(snapshotPath, ERROR_LOCATION);
+         listing.entries.push_back(entry);
+      }
+   }
+   if (!pStream->eof())
+      return snapshotFormatError(snapshotPath, ERROR_LOCATION);
+
+   pSnapshot->swap(snapshot);
+   return Success();
+}
+
+Error writeFileScanSnapshot(const FilePath& snapshotPath,
+                            const FileScanSnapshot& snapshot)
+{
+   // write to a temporary file then move it into place (so that readers,
+   // e.g. other sessions for the same project, never see a partial snapshot)
+   FilePath tempPath = snapshotPath.parent().complete(
+            snapshotPath.filename() + "." +
+            safe_convert::numberToString(core::system::currentProcessId()));
+
+   boost::shared_ptr<std::ostream> pStream;
+   Error error = tempPath.open_w(&pStream);
+   if (error)
+      return error;
+
+   *pStream << kSnapshotHeader << ' ' << kSnapshotVersion << '\n';
+   for (FileScanSnapshot::const_iterator it = snapshot.begin();
+        it != snapshot.end();
+        ++it)
+   {
+      const DirectoryListing& listing = it->second;
+      *pStream << listing.modified << ' ' << listing.entries.size() << ' ';
+      writeString(it->first, *pStream);
+      *pStream << '\n';
+
+      BOOST_FOREACH(const FileInfo& entry, listing.entries)
+      {
+         *pStream << entryType(entry) << ' '
+                  << entry.size() << ' '
+                  << entry.lastWriteTime() << ' ';
+         writeString(entryName(entry), *pStream);
+         *pStream << '\n';
+      }
+   }
+
+   pStream->flush();
+   if (!pStream->good())
+   {
+      error = systemError(boost::system::errc::io_error, ERROR_LOCATION);
+      error.addProperty("path", tempPath);
+      tempPath.removeIfExists();
+      return error;
+   }
+   pStream.reset();
+
+   return tempPath.move(snapshotPath);
+}
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
@@ -44,7 +44,6 @@
 #include <core/system/ShellUtils.hpp>
 #include <core/Thread.hpp>
 
-#include <core/PerformanceTimer.hpp>
 
 namespace rstudio {
 namespace core {
@@ -98,108 +98,254 @@ Error scanDir(const std::string& dirPath, std::vector<std::string>* pNames)
    return Success();
 }
 
-} // anonymous namespace
-
-Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
-                const FileScannerOptions& options,
-                tree<FileInfo>* pTree)
+// read the attributes of a directory entry (returns false if it can't be
+// read, logging errors other than the entry having gone away)
+bool statEntry(const std::string& path, FileInfo* pFileInfo)
 {
-   // clear all existing
-   pTree->erase_children(fromNode);
-
-   // create FilePath for root
-   FilePath rootPath(fromNode->absolutePath());
-
-   // yield if requested (only applies to recursive scans)
-   if (options.recursive && options.yield)
-      boost::this_thread::yield();
+   // get the attributes
+   struct stat st;
+   int res = ::lstat(path.c_str(), &st);
+   if (res == -1)
+   {
+      if (errno != ENOENT && errno != EACCES)
+      {
+         Error error = systemError(errno, ERROR_LOCATION);
+         error.addProperty("path", path);
+         LOG_ERROR(error);
+      }
+      return false;
+   }
 
-   // call onBeforeScanDir hook
-   if (options.onBeforeScanDir)
+   // create the FileInfo
+   bool isSymlink = S_ISLNK(st.st_mode);
+   if (S_ISDIR(st.st_mode))
    {
-      Error error = options.onBeforeScanDir(*fromNode);
-      if (error)
-         return error;
+      *pFileInfo = FileInfo(path, true, isSymlink);
+   }
+   else
+   {
+      *pFileInfo = FileInfo(path,
+                            false,
+                            st.st_size,
+#ifdef __APPLE__
+                            st.st_mtimespec.tv_sec,
+#else
+                            st.st_mtime,
+#endif
+                            isSymlink);
    }
+   return true;
+}
 
+// read the entries of a directory (errors reading individual entries are
+// logged and the entries skipped)
+Error listDir(const std::string& dirPath, std::vector<FileInfo>* pEntries)
+{
    // read directory contents
    std::vector<std::string> names;
-   Error error = scanDir(fromNode->absolutePath(), &names);
+   Error error = scanDir(dirPath, &names);
    if (error)
       return error;
 
+   // create FilePath for root
+   FilePath rootPath(dirPath);
+
    // iterate over the names
    BOOST_FOREACH(const std::string& name, names)
    {
-      // compute the path
-      std::string path = rootPath.childPath(name).absolutePath();
+      FileInfo fileInfo;
+      if (statEntry(rootPath.childPath(name).absolutePath(), &fileInfo))
+         pEntries->push_back(fileInfo);
+   }
 
-      // get the attributes
-      struct stat st;
-      int res = ::lstat(path.c_str(), &st);
-      if (res == -1)
-      {
-         if (errno != ENOENT && errno != EACCES)
-         {
-            Error error = systemError(errno, ERROR_LOCATION);
-            error.addProperty("path", path);
-            LOG_ERROR(error);
-         }
-         continue;
-      }
+   return Success();
+}
+
+// modification time of a directory in nanoseconds (0 if it can't be read or
+// is too recent to be relied upon)
+boost::int64_t directoryModified(const std::string& dirPath)
+{
+   struct stat st;
+   if (::stat(dirPath.c_str(), &st) == -1)
+      return 0;
 
-      // create the FileInfo
-      FileInfo fileInfo;
-      bool isSymlink = S_ISLNK(st.st_mode);
-      if (S_ISDIR(st.st_mode))
-      {
-         fileInfo = FileInfo(path, true, isSymlink);
-      }
-      else
-      {
-         fileInfo = FileInfo(path,
-                             false,
-                             st.st_size,
 #ifdef __APPLE__
-                             st.st_mtimespec.tv_sec,
+   const struct timespec& mtime = st.st_mtimespec;
 #else
-                             st.st_mtime,
+   const struct timespec& mtime = st.st_mtim;
 #endif
-                             isSymlink);
-      }
 
+   // file systems record times at a coarse granularity, so a directory
+   // modified within the last second could be modified again (after we've
+   // read it) without its time changing
+   if (mtime.tv_sec >= ::time(NULL) - 1)
+      return 0;
+
+   return static_cast<boost::int64_t>(mtime.tv_sec) * 1000000000 +
+          mtime.tv_nsec;
+}
+
+// apply the filter to the entries of a directory, adding those which pass
+// to the tree and (if requested) scanning subdirectories using scanDirFunc
+template <typename ScanDirFunction>
+void addEntries(const tree<FileInfo>::iterator_base& fromNode,
+                const std::vector<FileInfo>& entries,
+                const FileScannerOptions& options,
+                const ScanDirFunction& scanDirFunc,
+                tree<FileInfo>* pTree)
+{
+   BOOST_FOREACH(const FileInfo& fileInfo, entries)
+   {
       // apply the filter (if any)
-      if (!options.filter || options.filter(fileInfo))
+      if (options.filter && !options.filter(fileInfo))
+         continue;
+
+      // add the correct type of FileEntry
+      if (fileInfo.isDirectory())
       {
-         // add the correct type of FileEntry
-         if (fileInfo.isDirectory())
-         {
-            tree<FileInfo>::iterator_base child = pTree->append_child(fromNode,
-                                                                      fileInfo);
-            // recurse if requested and this isn't a link
-            if (options.recursive && !fileInfo.isSymlink())
-            {
-               // try to scan the files in the subdirectory -- if we fail
-               // we continue because we don't want one "bad" directory
-               // to cause us to abort the entire scan. yes the tree
-               // will be incomplete however it will be even more incompete
-               // if we fail entirely
-               Error error = scanFiles(child, options, pTree);
-               if (error)
-                  LOG_ERROR(error);
-            }
-         }
-         else
+         tree<FileInfo>::iterator_base child = pTree->append_child(fromNode,
+                                                                   fileInfo);
+         // recurse if requested and this isn't a link
+         if (options.recursive && !fileInfo.isSymlink())
          {
-            pTree->append_child(fromNode, fileInfo);
+            // try to scan the files in the subdirectory -- if we fail
+            // we continue because we don't want one "bad" directory
+            // to cause us to abort the entire scan. yes the tree
+            // will be incomplete however it will be even more incompete
+            // if we fail entirely
+            Error error = scanDirFunc(child);
+            if (error)
+               LOG_ERROR(error);
          }
       }
+      else
+      {
+         pTree->append_child(fromNode, fileInfo);
+      }
    }
+}
+
+Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
+                const FileScannerOptions& options,
+                const FileScanSnapshot& previous,
+                tree<FileInfo>* pTree,
+                FileScanSnapshot* pCurrent)
+{
+   // clear all existing
+   pTree->erase_children(fromNode);
+
+   // yield if requested (only applies to recursive scans)
+   if (options.recursive && options.yield)
+      boost::this_thread::yield();
+
+   // call onBeforeScanDir hook (before checking the directory, so that any
+   // changes made after the check are seen by e.g. a file monitor)
+   if (options.onBeforeScanDir)
+   {
+      Error error = options.onBeforeScanDir(*fromNode);
+      if (error)
+         return error;
+   }
+
+   // use the names from the previous listing if the directory hasn't changed
+   // since, otherwise read it again
+   std::string dirPath = fromNode->absolutePath();
+   boost::int64_t modified = directoryModified(dirPath);
+   DirectoryListing& listing = (*pCurrent)[dirPath];
+   listing = DirectoryListing();
+   listing.modified = modified;
+   FileScanSnapshot::const_iterator it = previous.find(dirPath);
+   if (modified != 0 && it != previous.end() && it->second.modified == modified)
+   {
+      // writing to a file doesn't modify its directory, so the attributes of
+      // the entries are read again (only reading the directory is skipped)
+      BOOST_FOREACH(const FileInfo& entry, it->second.entries)
+      {
+         FileInfo fileInfo;
+         if (statEntry(entry.absolutePath(), &fileInfo))
+            listing.entries.push_back(fileInfo);
+      }
+   }
+   else
+   {
+      Error error = listDir(dirPath, &listing.entries);
+      if (error)
+      {
+         pCurrent->erase(dirPath);
+         return error;
+      }
+   }
+
+   addEntries(fromNode,
+              listing.entries,
+              options,
+              [&](const tree<FileInfo>::iterator_base& child)
+              {
+                 return scanFiles(child, options, previous, pTree, pCurrent);
+              },
+              pTree);
+
+   // don't record listings we can't validate later
+   if (modified == 0)
+      pCurrent->erase(dirPath);
+
+   return Success();
+}
+
+} // anonymous namespace
+
+Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
+                const FileScannerOptions& options,
+                tree<FileInfo>* pTree)
+{
+   // clear all existing
+   pTree->erase_children(fromNode);
+
+   // yield if requested (only applies to recursive scans)
+   if (options.recursive && options.yield)
+      boost::this_thread::yield();
+
+   // call onBeforeScanDir hook
+   if (options.onBeforeScanDir)
+   {
+      Error error = options.onBeforeScanDir(*fromNode);
+      if (error)
+         return error;
+   }
+
+   // read directory contents
+   std::vector<FileInfo> entries;
+   Error error = listDir(fromNode->absolutePath(), &entries);
+   if (error)
+      return error;
+
+   // add them
+   addEntries(fromNode,
+              entries,
+              options,
+              [&](const tree<FileInfo>::iterator_base& child)
+              {
+                 return scanFiles(child, options, pTree);
+              },
+              pTree);
 
    // return success
    return Success();
 }
 
+Error scanFiles(const FileInfo& fromRoot,
+                const FileScannerOptions& options,
+                const FileScanSnapshot& previous,
+                tree<FileInfo>* pTree,
+                FileScanSnapshot* pCurrent)
+{
+   return scanFiles(pTree->set_head(fromRoot),
+                    options,
+                    previous,
+                    pTree,
+                    pCurrent);
+}
+
 } // namespace system
 } // namespace core
 } // namespace rstudio
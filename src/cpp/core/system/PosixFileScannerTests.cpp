@@ -0,0 +1,219 @@
+/*
+ * PosixFileScannerTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef _WIN32
+
+#include <sys/time.h>
+
+#include <algorithm>
+
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/system/FileScanner.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+namespace tests {
+
+namespace {
+
+// directory listings are only recorded once they are old enough to be
+// relied upon, so backdate the directory
+void backdate(const FilePath& dirPath, int seconds = 10)
+{
+   struct timeval times[2];
+   ::gettimeofday(&times[0], NULL);
+   times[0].tv_sec -= seconds;
+   times[1] = times[0];
+   ::utimes(dirPath.absolutePath().c_str(), times);
+}
+
+std::vector<std::string> scannedPaths(const tree<FileInfo>& files)
+{
+   std::vector<std::string> paths;
+   for (tree<FileInfo>::iterator it = files.begin(); it != files.end(); ++it)
+      paths.push_back(it->absolutePath());
+   return paths;
+}
+
+} // anonymous namespace
+
+context("PosixFileScannerTests")
+{
+   FilePath rootPath;
+   REQUIRE_FALSE(FilePath::tempFilePath(&rootPath));
+   REQUIRE_FALSE(rootPath.ensureDirectory());
+   FilePath subPath = rootPath.childPath("sub");
+   REQUIRE_FALSE(subPath.ensureDirectory());
+   REQUIRE_FALSE(writeStringToFile(rootPath.childPath("a.R"), "a"));
+   REQUIRE_FALSE(writeStringToFile(subPath.childPath("b.R"), "b"));
+   backdate(subPath);
+   backdate(rootPath);
+
+   FileScannerOptions options;
+   options.recursive = true;
+
+   test_that("Scanning with a snapshot records each directory listing")
+   {
+      tree<FileInfo> files;
+      FileScanSnapshot snapshot;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             FileScanSnapshot(),
+                             &files,
+                             &snapshot));
+
+      tree<FileInfo> expected;
+      expect_false(scanFiles(FileInfo(rootPath), options, &expected));
+      expect_true(scannedPaths(files) == scannedPaths(expected));
+
+      expect_true(snapshot.size() == 2);
+      expect_true(snapshot[rootPath.absolutePath()].entries.size() == 2);
+      expect_true(snapshot[subPath.absolutePath()].entries.size() == 1);
+   }
+
+   test_that("Snapshots can be written and read back")
+   {
+      tree<FileInfo> files;
+      FileScanSnapshot snapshot;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             FileScanSnapshot(),
+                             &files,
+                             &snapshot));
+
+      FilePath snapshotPath;
+      REQUIRE_FALSE(FilePath::tempFilePath(&snapshotPath));
+      expect_false(writeFileScanSnapshot(snapshotPath, snapshot));
+
+      FileScanSnapshot readSnapshot;
+      expect_false(readFileScanSnapshot(snapshotPath, &readSnapshot));
+      expect_true(readSnapshot.size() == snapshot.size());
+      for (FileScanSnapshot::const_iterator it = snapshot.begin();
+           it != snapshot.end();
+           ++it)
+      {
+         const DirectoryListing& listing = readSnapshot[it->first];
+         expect_true(listing.modified == it->second.modified);
+         expect_true(listing.entries == it->second.entries);
+      }
+
+      snapshotPath.removeIfExists();
+   }
+
+   test_that("Unchanged directories use their previous listing")
+   {
+      tree<FileInfo> files;
+      FileScanSnapshot snapshot;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             FileScanSnapshot(),
+                             &files,
+                             &snapshot));
+
+      // add an entry which only appears in the snapshot's listing (a file
+      // from elsewhere, as the entries of re-used listings are stat'ed)
+      std::string extraPath = rootPath.childPath("a.R").absolutePath();
+      snapshot[subPath.absolutePath()].entries.push_back(
+                                             FileInfo(extraPath, false));
+
+      tree<FileInfo> rescannedFiles;
+      FileScanSnapshot current;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             snapshot,
+                             &rescannedFiles,
+                             &current));
+      std::vector<std::string> paths = scannedPaths(rescannedFiles);
+      expect_true(std::count(paths.begin(), paths.end(), extraPath) == 2);
+
+      // modifying the directory causes it to be read again
+      REQUIRE_FALSE(writeStringToFile(subPath.childPath("c.R"), "c"));
+      backdate(subPath, 20);
+      tree<FileInfo> modifiedFiles;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             snapshot,
+                             &modifiedFiles,
+                             &current));
+      paths = scannedPaths(modifiedFiles);
+      expect_true(std::count(paths.begin(), paths.end(), extraPath) == 1);
+      expect_true(std::find(paths.begin(),
+                            paths.end(),
+                            subPath.childPath("c.R").absolutePath()) !=
+                  paths.end());
+   }
+
+   test_that("Entries of unchanged directories are up to date")
+   {
+      tree<FileInfo> files;
+      FileScanSnapshot snapshot;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             FileScanSnapshot(),
+                             &files,
+                             &snapshot));
+
+      // rewriting a file doesn't modify its directory
+      FilePath filePath = subPath.childPath("b.R");
+      REQUIRE_FALSE(writeStringToFile(filePath, "rewritten"));
+
+      tree<FileInfo> rescannedFiles;
+      FileScanSnapshot current;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             snapshot,
+                             &rescannedFiles,
+                             &current));
+      REQUIRE(current[subPath.absolutePath()].modified ==
+              snapshot[subPath.absolutePath()].modified);
+
+      tree<FileInfo>::iterator it = rescannedFiles.begin();
+      while (it != rescannedFiles.end() &&
+             it->absolutePath() != filePath.absolutePath())
+      {
+         ++it;
+      }
+      REQUIRE(it != rescannedFiles.end());
+      expect_true(it->size() == 9);
+   }
+
+   test_that("Recently modified directories aren't recorded")
+   {
+      REQUIRE_FALSE(writeStringToFile(subPath.childPath("d.R"), "d"));
+
+      tree<FileInfo> files;
+      FileScanSnapshot snapshot;
+      expect_false(scanFiles(FileInfo(rootPath),
+                             options,
+                             FileScanSnapshot(),
+                             &files,
+                             &snapshot));
+      expect_true(snapshot.count(subPath.absolutePath()) == 0);
+      expect_true(snapshot.count(rootPath.absolutePath()) == 1);
+   }
+
+   rootPath.removeIfExists();
+}
+
+} // end namespace tests
+} // end namespace system
+} // end namespace core
+} // end namespace rstudio
+
+#endif // !_WIN32
@@ -26,7 +26,6 @@
 #include <core/Log.hpp>
 #include <core/BoostThread.hpp>
 
-#include <core/PerformanceTimer.hpp>
 #include <core/system/ChildProcess.hpp>
 
 namespace rstudio {
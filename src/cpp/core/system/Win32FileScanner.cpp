@@ -141,6 +141,16 @@ Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
    return Success();
 }
 
+// directory listings aren't recorded on windows (so this is always a full scan)
+Error scanFiles(const FileInfo& fromRoot,
+                const core::system::FileScannerOptions& options,
+                const FileScanSnapshot& previous,
+                tree<FileInfo>* pTree,
+                FileScanSnapshot* pCurrent)
+{
+   return scanFiles(fromRoot, options, pTree);
+}
+
 
 } // namespace system
 } // namespace core
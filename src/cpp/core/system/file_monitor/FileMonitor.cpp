@@ -25,6 +25,7 @@
 #include <core/Log.hpp>
 #include <core/Error.hpp>
 #include <core/Thread.hpp>
+#include <core/Trace.hpp>
 #include <core/PeriodicCommand.hpp>
 
 #include <core/system/System.hpp>
@@ -372,6 +373,44 @@ Error discoverAndProcessFileChanges(
    return Success();
 }
 
+Error scanMonitoredFiles(const FileInfo& fromRoot,
+                         const FileScannerOptions& options,
+                         const FilePath& snapshotPath,
+                         tree<FileInfo>* pTree)
+{
+   if (snapshotPath.empty())
+      return core::system::scanFiles(fromRoot, options, pTree);
+
+   // read the listings saved by the last registration (if we can't then we
+   // just do a full scan)
+   FileScanSnapshot previous;
+   if (snapshotPath.exists())
+   {
+      Error error = readFileScanSnapshot(snapshotPath, &previous);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   // scan then save the listings for next time
+   FileScanSnapshot current;
+   Error error = core::system::scanFiles(fromRoot,
+                                         options,
+                                         previous,
+                                         pTree,
+                                         &current);
+   if (error)
+      return error;
+
+   if (!current.empty())
+   {
+      error = writeFileScanSnapshot(snapshotPath, current);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   return Success();
+}
+
 std::list<void*> activeEventContexts()
 {
    std::list<void*> contexts;
@@ -398,7 +437,8 @@ void run(const boost::function<void()>& checkForInput);
 Handle registerMonitor(const core::FilePath& filePath,
                        bool recursive,
                        const boost::function<bool(const FileInfo&)>& filter,
-                       const Callbacks& callbacks);
+                       const Callbacks& callbacks,
+                       const core::FilePath& snapshotPath);
 
 // unregister a file monitor
 void unregisterMonitor(Handle handle);
@@ -426,12 +466,14 @@ public:
    RegistrationCommand(const core::FilePath& filePath,
                        bool recursive,
                        const boost::function<bool(const FileInfo&)>& filter,
-                       const Callbacks& callbacks)
+                       const Callbacks& callbacks,
+                       const core::FilePath& snapshotPath)
       : type_(Register),
         filePath_(filePath),
         recursive_(recursive),
         filter_(filter),
-        callbacks_(callbacks)
+        callbacks_(callbacks),
+        snapshotPath_(snapshotPath)
    {
    }
 
@@ -449,6 +491,7 @@ public:
       return filter_;
    }
    const Callbacks& callbacks() const { return callbacks_; }
+   const core::FilePath& snapshotPath() const { return snapshotPath_; }
 
    Handle handle() const
    {
@@ -464,6 +507,7 @@ private:
    bool recursive_;
    boost::function<bool(const FileInfo&)> filter_;
    Callbacks callbacks_;
+   core::FilePath snapshotPath_;
 
    // unregister command data
    Handle handle_;
@@ -502,7 +546,8 @@ void checkForInput()
          Handle handle = detail::registerMonitor(command.filePath(),
                                                  command.recursive(),
                                                  command.filter(),
-                                                 command.callbacks());
+                                                 command.callbacks(),
+                                                 command.snapshotPath());
          if (!handle.empty())
             s_pActiveHandles->push_back(handle);
          break;
@@ -645,7 +690,8 @@ void stop()
 void registerMonitor(const FilePath& filePath,
                      bool recursive,
                      const boost::function<bool(const FileInfo&)>& filter,
-                     const Callbacks& callbacks)
+                     const Callbacks& callbacks,
+                     const FilePath& snapshotPath)
 {
    // bind a new version of the callbacks that puts them on the callback queue
    Callbacks qCallbacks;
@@ -663,7 +709,8 @@ void registerMonitor(const FilePath& filePath,
    registrationCommandQueue().enque(RegistrationCommand(filePath,
                                                         recursive,
                                                         filter,
-                                                        qCallbacks));
+                                                        qCallbacks,
+                                                        snapshotPath));
 }
 
 void unregisterMonitor(Handle handle)
@@ -675,7 +722,10 @@ void checkForChanges()
 {
    boost::function<void()> callback;
    while (callbackQueue().deque(&callback))
+   {
+      TRACE_SPAN("file_monitor.callback");
       callback();
+   }
 }
 
 namespace {
@@ -26,6 +26,7 @@
 #include <core/collection/Tree.hpp>
 
 #include <core/system/FileChangeEvent.hpp>
+#include <core/system/FileScanner.hpp>
 
 #include <core/system/FileMonitor.hpp>
 
@@ -98,6 +99,13 @@ inline Error discoverAndProcessFileChanges(
                                  onFilesChanged);
 }
 
+// scan the files for a new registration (using and then updating the
+// snapshot at snapshotPath if one is provided)
+Error scanMonitoredFiles(const FileInfo& fromRoot,
+                         const FileScannerOptions& options,
+                         const FilePath& snapshotPath,
+                         tree<FileInfo>* pTree);
+
 template <typename Iterator>
 Iterator findFile(Iterator begin, Iterator end, const std::string& path)
 {
@@ -439,7 +439,8 @@ namespace detail {
 Handle registerMonitor(const core::FilePath& filePath,
                        bool recursive,
                        const boost::function<bool(const FileInfo&)>& filter,
-                       const Callbacks& callbacks)
+                       const Callbacks& callbacks,
+                       const core::FilePath& snapshotPath)
 {
    // create and allocate FileEventContext
    // (also pack into unique_ptr to auto-delete if we return early;
@@ -482,7 +483,10 @@ Handle registerMonitor(const core::FilePath& filePath,
    options.yield = true;
    options.filter = filter;
    options.onBeforeScanDir = addWatchFunction(pContext, true);
-   Error error = scanFiles(FileInfo(filePath), options, &pContext->fileTree);
+   Error error = impl::scanMonitoredFiles(FileInfo(filePath),
+                                          options,
+                                          snapshotPath,
+                                          &pContext->fileTree);
    if (error)
    {
        // close context
@@ -166,7 +166,8 @@ namespace detail {
 Handle registerMonitor(const FilePath& filePath,
                        bool recursive,
                        const boost::function<bool(const FileInfo&)>& filter,
-                       const Callbacks& callbacks)
+                       const Callbacks& callbacks,
+                       const core::FilePath& snapshotPath)
 {
    // allocate file path
    CFStringRef filePathRef = ::CFStringCreateWithCString(
@@ -250,7 +251,10 @@ Handle registerMonitor(const FilePath& filePath,
    options.recursive = recursive;
    options.yield = true;
    options.filter = filter;
-   Error error = scanFiles(FileInfo(filePath), options, &pContext->fileTree);
+   Error error = impl::scanMonitoredFiles(FileInfo(filePath),
+                                          options,
+                                          snapshotPath,
+                                          &pContext->fileTree);
    if (error)
    {
        // stop, invalidate, release
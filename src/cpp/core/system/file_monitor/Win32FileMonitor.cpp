@@ -525,7 +525,8 @@ namespace detail {
 Handle registerMonitor(const core::FilePath& filePath,
                        bool recursive,
                        const boost::function<bool(const FileInfo&)>& filter,
-                       const Callbacks& callbacks)
+                       const Callbacks& callbacks,
+                       const core::FilePath& snapshotPath)
 {
    // create and allocate FileEventContext (create auto-ptr in case we
    // return early, we'll call release later before returning)
@@ -584,7 +585,10 @@ Handle registerMonitor(const core::FilePath& filePath,
    options.recursive = recursive;
    options.yield = true;
    options.filter = boost::bind(monitorFilter, _1, filter);
-   error = scanFiles(FileInfo(filePath), options, &pContext->fileTree);
+   error = impl::scanMonitoredFiles(FileInfo(filePath),
+                                    options,
+                                    snapshotPath,
+                                    &pContext->fileTree);
    if (error)
    {
        // cleanup
@@ -0,0 +1,684 @@
+/*
+ * SearchIndex.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/SearchIndex.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include <boost/foreach.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+// index file layout (all integers are native endian uint32):
+//
+//   IndexHeader
+//   IndexDocument[documentCount]
+//   IndexTerm[termCount]          (sorted by term text)
+//   IndexPosting[postingCount]    (grouped by term, sorted by document)
+//   char[stringsSize]             (nul terminated strings)
+//
+// index files are caches (they are rebuilt rather than migrated) so the
+// format version is simply bumped whenever the layout changes
+
+namespace {
+
+struct IndexHeader
+{
+   char magic[4];
+   boost::uint32_t version;
+   boost::uint32_t documentCount;
+   boost::uint32_t termCount;
+   boost::uint32_t postingCount;
+   boost::uint32_t stringsSize;
+};
+
+struct IndexDocument
+{
+   boost::uint32_t name;
+   boost::uint32_t title;
+   boost::uint32_t type;
+};
+
+struct IndexTerm
+{
+   boost::uint32_t text;
+   boost::uint32_t length;
+   boost::uint32_t firstPosting;
+   boost::uint32_t postingCount;
+};
+
+struct IndexPosting
+{
+   boost::uint32_t document;
+   boost::uint32_t fields;
+};
+
+const char kIndexMagic[4] = { 'R', 'S', 'I', 'X' };
+const boost::uint32_t kIndexVersion = 1;
+
+// relative weight of matches found in each field
+const double kFieldWeights[] = { 10.0, 8.0, 5.0, 4.0, 2.0, 1.0 };
+const std::size_t kFieldCount = sizeof(kFieldWeights) / sizeof(double);
+
+// relative quality of exact, prefix, and fuzzy term matches
+const double kExactMatch = 1.0;
+const double kPrefixMatch = 0.6;
+const double kFuzzyMatch = 0.3;
+
+// upper bound on the number of index terms a single prefix expands to
+const std::size_t kMaxPrefixExpansion = 256;
+
+bool isTermChar(unsigned char ch)
+{
+   return (ch >= 'a' && ch <= 'z') ||
+          (ch >= 'A' && ch <= 'Z') ||
+          (ch >= '0' && ch <= '9') ||
+          ch == '_' || ch == '.' ||
+          ch >= 0x80;
+}
+
+bool isSeparator(char ch)
+{
+   return ch == '.' || ch == '_';
+}
+
+bool isStopWord(const std::string& term)
+{
+   static const char* const kStopWords[] = {
+      "an", "and", "are", "as", "at", "be", "by", "for", "from", "in", "is",
+      "it", "of", "on", "or", "that", "the", "this", "to", "with"
+   };
+   static const std::set<std::string> stopWords(
+            kStopWords,
+            kStopWords + sizeof(kStopWords) / sizeof(kStopWords[0]));
+   return stopWords.count(term) > 0;
+}
+
+void addTerm(const std::string& term, std::vector<std::string>* pTerms)
+{
+   if (term.length() >= 2 && !isStopWord(term))
+      pTerms->push_back(term);
+}
+
+double fieldWeight(boost::uint32_t fields)
+{
+   double weight = 0;
+   for (std::size_t i = 0; i < kFieldCount; i++)
+   {
+      if ((fields & (1u << i)) && kFieldWeights[i] > weight)
+         weight = kFieldWeights[i];
+   }
+   return weight;
+}
+
+// levenshtein distance between a and b, or maxDistance + 1 if the distance
+// exceeds maxDistance
+std::size_t boundedEditDistance(const char* a, std::size_t aLength,
+                                const char* b, std::size_t bLength,
+                                std::size_t maxDistance)
+{
+   std::size_t lengthDiff = aLength > bLength ? aLength - bLength
+                                              : bLength - aLength;
+   if (lengthDiff > maxDistance)
+      return maxDistance + 1;
+
+   std::vector<std::size_t> previous(bLength + 1), current(bLength + 1);
+   for (std::size_t j = 0; j <= bLength; j++)
+      previous[j] = j;
+
+   for (std::size_t i = 1; i <= aLength; i++)
+   {
+      current[0] = i;
+      std::size_t rowMin = current[0];
+      for (std::size_t j = 1; j <= bLength; j++)
+      {
+         std::size_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+         current[j] = std::min(std::min(previous[j] + 1, current[j - 1] + 1),
+                               previous[j - 1] + cost);
+         rowMin = std::min(rowMin, current[j]);
+      }
+
+      if (rowMin > maxDistance)
+         return maxDistance + 1;
+
+      previous.swap(current);
+   }
+
+   return previous[bLength];
+}
+
+int compareTerm(const char* text, std::size_t length, const std::string& term)
+{
+   int result = std::memcmp(text, term.data(), std::min(length, term.length()));
+   if (result != 0)
+      return result;
+   else if (length < term.length())
+      return -1;
+   else if (length > term.length())
+      return 1;
+   else
+      return 0;
+}
+
+bool matchBetter(const SearchMatch& lhs, const SearchMatch& rhs)
+{
+   if (lhs.score != rhs.score)
+      return lhs.score > rhs.score;
+   else
+      return lhs.document < rhs.document;
+}
+
+Error invalidIndexError(const FilePath& filePath, const ErrorLocation& location)
+{
+   Error error = systemError(boost::system::errc::illegal_byte_sequence,
+                             location);
+   error.addProperty("path", filePath.absolutePath());
+   return error;
+}
+
+} // anonymous namespace
+
+std::vector<std::string> searchTerms(const std::string& text)
+{
+   std::vector<std::string> terms;
+
+   std::size_t i = 0;
+   while (i < text.length())
+   {
+      // skip to the start of the next word
+      while (i < text.length() && !isTermChar(text[i]))
+         i++;
+
+      std::size_t begin = i;
+      while (i < text.length() && isTermChar(text[i]))
+         i++;
+
+      // lower case, dropping leading and trailing separators (e.g. the
+      // leading dot of '.libPaths' or the trailing period of a sentence)
+      std::string word;
+      for (std::size_t j = begin; j < i; j++)
+      {
+         char ch = text[j];
+         if (ch >= 'A' && ch <= 'Z')
+            ch = ch - 'A' + 'a';
+         word.push_back(ch);
+      }
+      std::size_t first = 0;
+      while (first < word.length() && isSeparator(word[first]))
+         first++;
+      std::size_t last = word.length();
+      while (last > first && isSeparator(word[last - 1]))
+         last--;
+      word = word.substr(first, last - first);
+      if (word.empty())
+         continue;
+
+      addTerm(word, &terms);
+
+      // add the parts of compound identifiers
+      if (std::find_if(word.begin(), word.end(), isSeparator) != word.end())
+      {
+         std::size_t partBegin = 0;
+         for (std::size_t j = 0; j <= word.length(); j++)
+         {
+            if (j == word.length() || isSeparator(word[j]))
+            {
+               addTerm(word.substr(partBegin, j - partBegin), &terms);
+               partBegin = j + 1;
+            }
+         }
+      }
+   }
+
+   return terms;
+}
+
+void SearchIndexBuilder::addDocument(const SearchDocument& document)
+{
+   boost::uint32_t index = static_cast<boost::uint32_t>(documents_.size());
+
+   Document entry;
+   entry.name = document.name;
+   entry.title = document.title;
+   entry.type = document.type;
+   documents_.push_back(entry);
+
+   typedef std::pair<SearchField, std::string> FieldText;
+   BOOST_FOREACH(const FieldText& content, document.content)
+   {
+      std::vector<std::string> terms = searchTerms(content.second);
+      BOOST_FOREACH(const std::string& term, terms)
+      {
+         terms_[term][index] |= (1u << content.first);
+      }
+   }
+}
+
+Error SearchIndexBuilder::write(const FilePath& filePath) const
+{
+   // string pool (document strings are commonly repeated, e.g. the type)
+   std::vector<char> strings;
+   std::map<std::string, boost::uint32_t> stringOffsets;
+   struct Pool
+   {
+      static boost::uint32_t add(const std::string& value,
+                                 std::vector<char>* pStrings,
+                                 std::map<std::string, boost::uint32_t>* pOffsets)
+      {
+         std::map<std::string, boost::uint32_t>::const_iterator it =
+                                                         pOffsets->find(value);
+         if (it != pOffsets->end())
+            return it->second;
+
+         boost::uint32_t offset = static_cast<boost::uint32_t>(pStrings->size());
+         pStrings->insert(pStrings->end(), value.begin(), value.end());
+         pStrings->push_back('\0');
+         pOffsets->insert(std::make_pair(value, offset));
+         return offset;
+      }
+   };
+
+   std::vector<IndexDocument> documents;
+   documents.reserve(documents_.size());
+   BOOST_FOREACH(const Document& document, documents_)
+   {
+      IndexDocument entry;
+      entry.name = Pool::add(document.name, &strings, &stringOffsets);
+      entry.title = Pool::add(document.title, &strings, &stringOffsets);
+      entry.type = Pool::add(document.type, &strings, &stringOffsets);
+      documents.push_back(entry);
+   }
+
+   // terms are already sorted (by virtue of being map keys)
+   typedef std::map<boost::uint32_t, boost::uint32_t> Postings;
+   std::vector<IndexTerm> terms;
+   std::vector<IndexPosting> postings;
+   terms.reserve(terms_.size());
+   for (std::map<std::string, Postings>::const_iterator it = terms_.begin();
+        it != terms_.end();
+        ++it)
+   {
+      IndexTerm term;
+      term.text = Pool::add(it->first, &strings, &stringOffsets);
+      term.length = static_cast<boost::uint32_t>(it->first.length());
+      term.firstPosting = static_cast<boost::uint32_t>(postings.size());
+      term.postingCount = static_cast<boost::uint32_t>(it->second.size());
+      terms.push_back(term);
+
+      for (Postings::const_iterator pit = it->second.begin();
+           pit != it->second.end();
+           ++pit)
+      {
+         IndexPosting posting;
+         posting.document = pit->first;
+         posting.fields = pit->second;
+         postings.push_back(posting);
+      }
+   }
+
+   IndexHeader header;
+   std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+   header.version = kIndexVersion;
+   header.documentCount = static_cast<boost::uint32_t>(documents.size());
+   header.termCount = static_cast<boost::uint32_t>(terms.size());
+   header.postingCount = static_cast<boost::uint32_t>(postings.size());
+   header.stringsSize = static_cast<boost::uint32_t>(strings.size());
+
+   boost::shared_ptr<std::ostream> pStream;
+   Error error = filePath.open_w(&pStream);
+   if (error)
+      return error;
+
+   try
+   {
+      pStream->exceptions(std::ostream::failbit | std::ostream::badbit);
+
+      pStream->write(reinterpret_cast<const char*>(&header), sizeof(header));
+      if (!documents.empty())
+      {
+         pStream->write(reinterpret_cast<const char*>(&documents[0]),
+                        documents.size() * sizeof(IndexDocument));
+      }
+      if (!terms.empty())
+      {
+         pStream->write(reinterpret_cast<const char*>(&terms[0]),
+                        terms.size() * sizeof(IndexTerm));
+      }
+      if (!postings.empty())
+      {
+         pStream->write(reinterpret_cast<const char*>(&postings[0]),
+                        postings.size() * sizeof(IndexPosting));
+      }
+      if (!strings.empty())
+         pStream->write(&strings[0], strings.size());
+
+      pStream->flush();
+   }
+   catch(const std::exception& e)
+   {
+      Error error = systemError(boost::system::errc::io_error,
+                                ERROR_LOCATION);
+      error.addProperty("what", e.what());
+      error.addProperty("path", filePath.absolutePath());
+      return error;
+   }
+
+   return Success();
+}
+
+SearchIndex::SearchIndex()
+   : pDocuments_(NULL),
+     pTerms_(NULL),
+     pPostings_(NULL),
+     pStrings_(NULL),
+     documentCount_(0),
+     termCount_(0),
+     postingCount_(0),
+     stringsSize_(0)
+{
+}
+
+SearchIndex::~SearchIndex()
+{
+}
+
+Error SearchIndex::open(const FilePath& filePath)
+{
+   boost::shared_ptr<boost::iostreams::mapped_file_source> pFile;
+   try
+   {
+      pFile.reset(new boost::iostreams::mapped_file_source(
+                                               filePath.absolutePath()));
+   }
+   catch(const std::exception& e)
+   {
+      Error error = systemError(boost::system::errc::io_error,
+                                ERROR_LOCATION);
+      error.addProperty("what", e.what());
+      error.addProperty("path", filePath.absolutePath());
+      return error;
+   }
+
+   // validate the header and the overall size
+   const char* pData = pFile->data();
+   boost::uint64_t size = pFile->size();
+   if (size < sizeof(IndexHeader))
+      return invalidIndexError(filePath, ERROR_LOCATION);
+
+   const IndexHeader* pHeader = reinterpret_cast<const IndexHeader*>(pData);
+   if (std::memcmp(pHeader->magic, kIndexMagic, sizeof(kIndexMagic)) != 0 ||
+       pHeader->version != kIndexVersion)
+   {
+      return invalidIndexError(filePath, ERROR_LOCATION);
+   }
+
+   boost::uint64_t documentsOffset = sizeof(IndexHeader);
+   boost::uint64_t termsOffset = documentsOffset +
+         boost::uint64_t(pHeader->documentCount) * sizeof(IndexDocument);
+   boost::uint64_t postingsOffset = termsOffset +
+         boost::uint64_t(pHeader->termCount) * sizeof(IndexTerm);
+   boost::uint64_t stringsOffset = postingsOffset +
+         boost::uint64_t(pHeader->postingCount) * sizeof(IndexPosting);
+   if (stringsOffset + pHeader->stringsSize != size)
+      return invalidIndexError(filePath, ERROR_LOCATION);
+
+   const char* pStrings = pData + stringsOffset;
+   if (pHeader->stringsSize > 0 && pStrings[pHeader->stringsSize - 1] != '\0')
+      return invalidIndexError(filePath, ERROR_LOCATION);
+
+   // validate terms and postings up front so that searches needn't
+   const IndexTerm* pTerms =
+         reinterpret_cast<const IndexTerm*>(pData + termsOffset);
+   const IndexPosting* pPostings =
+         reinterpret_cast<const IndexPosting*>(pData + postingsOffset);
+   for (std::size_t i = 0; i < pHeader->termCount; i++)
+   {
+      const IndexTerm& term = pTerms[i];
+      if (boost::uint64_t(term.text) + term.length >= pHeader->stringsSize ||
+          boost::uint64_t(term.firstPosting) + term.postingCount >
+                                                      pHeader->postingCount)
+      {
+         return invalidIndexError(filePath, ERROR_LOCATION);
+      }
+   }
+   for (std::size_t i = 0; i < pHeader->postingCount; i++)
+   {
+      if (pPostings[i].document >= pHeader->documentCount)
+         return invalidIndexError(filePath, ERROR_LOCATION);
+   }
+
+   pFile_ = pFile;
+   pDocuments_ = pData + documentsOffset;
+   pTerms_ = pData + termsOffset;
+   pPostings_ = pData + postingsOffset;
+   pStrings_ = pStrings;
+   documentCount_ = pHeader->documentCount;
+   termCount_ = pHeader->termCount;
+   postingCount_ = pHeader->postingCount;
+   stringsSize_ = pHeader->stringsSize;
+
+   return Success();
+}
+
+std::size_t SearchIndex::documentCount() const
+{
+   return documentCount_;
+}
+
+std::string SearchIndex::documentName(std::size_t document) const
+{
+   if (document >= documentCount_)
+      return std::string();
+
+   return string(reinterpret_cast<const IndexDocument*>(pDocuments_)[document].name);
+}
+
+std::string SearchIndex::documentTitle(std::size_t document) const
+{
+   if (document >= documentCount_)
+      return std::string();
+
+   return string(reinterpret_cast<const IndexDocument*>(pDocuments_)[document].title);
+}
+
+std::string SearchIndex::documentType(std::size_t document) const
+{
+   if (document >= documentCount_)
+      return std::string();
+
+   return string(reinterpret_cast<const IndexDocument*>(pDocuments_)[document].type);
+}
+
+const char* SearchIndex::string(boost::uint32_t offset) const
+{
+   if (offset >= stringsSize_)
+      return "";
+
+   return pStrings_ + offset;
+}
+
+std::vector<SearchMatch> SearchIndex::search(const std::string& query,
+                                             const SearchOptions& options) const
+{
+   std::vector<SearchMatch> matches;
+
+   std::vector<std::string> queryTerms = searchTerms(query);
+   std::sort(queryTerms.begin(), queryTerms.end());
+   queryTerms.erase(std::unique(queryTerms.begin(), queryTerms.end()),
+                    queryTerms.end());
+   if (queryTerms.empty() || termCount_ == 0)
+      return matches;
+
+   // documents must match every query term; their score is the sum of the
+   // best match found for each term
+   std::map<std::size_t, double> scores;
+   for (std::size_t i = 0; i < queryTerms.size(); i++)
+   {
+      std::map<std::size_t, double> termScores;
+      matchTerm(queryTerms[i], options, &termScores);
+
+      if (i == 0)
+      {
+         scores.swap(termScores);
+      }
+      else
+      {
+         std::map<std::size_t, double> combined;
+         for (std::map<std::size_t, double>::const_iterator it = scores.begin();
+              it != scores.end();
+              ++it)
+         {
+            std::map<std::size_t, double>::const_iterator termIt =
+                                                   termScores.find(it->first);
+            if (termIt != termScores.end())
+               combined[it->first] = it->second + termIt->second;
+         }
+         scores.swap(combined);
+      }
+
+      if (scores.empty())
+         return matches;
+   }
+
+   for (std::map<std::size_t, double>::const_iterator it = scores.begin();
+        it != scores.end();
+        ++it)
+   {
+      matches.push_back(SearchMatch(it->first, it->second));
+   }
+
+   if (options.maxResults > 0 && matches.size() > options.maxResults)
+   {
+      std::partial_sort(matches.begin(),
+                        matches.begin() + options.maxResults,
+                        matches.end(),
+                        matchBetter);
+      matches.resize(options.maxResults);
+   }
+   else
+   {
+      std::sort(matches.begin(), matches.end(), matchBetter);
+   }
+
+   return matches;
+}
+
+void SearchIndex::matchTerm(const std::string& queryTerm,
+                            const SearchOptions& options,
+                            std::map<std::size_t, double>* pScores) const
+{
+   const IndexTerm* pTerms = reinterpret_cast<const IndexTerm*>(pTerms_);
+
+   // binary search for the first term not less than the query term
+   std::size_t lower = 0, upper = termCount_;
+   while (lower < upper)
+   {
+      std::size_t mid = lower + (upper - lower) / 2;
+      if (compareTerm(string(pTerms[mid].text), pTerms[mid].length, queryTerm) < 0)
+         lower = mid + 1;
+      else
+         upper = mid;
+   }
+
+   // exact and prefix matches follow the query term directly
+   std::size_t expanded = 0;
+   for (std::size_t i = lower; i < termCount_; i++)
+   {
+      const IndexTerm& term = pTerms[i];
+      if (term.length < queryTerm.length() ||
+          std::memcmp(string(term.text), queryTerm.data(), queryTerm.length()) != 0)
+      {
+         break;
+      }
+
+      if (term.length == queryTerm.length())
+      {
+         addPostings(i, kExactMatch, pScores);
+      }
+      else if (options.prefix)
+      {
+         // prefer prefixes that cover more of the term
+         double coverage = double(queryTerm.length()) / term.length;
+         addPostings(i, kPrefixMatch * (0.5 + 0.5 * coverage), pScores);
+         if (++expanded >= kMaxPrefixExpansion)
+            break;
+      }
+      else
+      {
+         break;
+      }
+   }
+
+   // fuzzy matches are restricted to terms sharing the first character
+   // (which keeps the number of candidates small)
+   if (!options.fuzzy || queryTerm.length() < 4)
+      return;
+
+   std::size_t maxDistance = queryTerm.length() < 8 ? 1 : 2;
+   std::size_t first = lower;
+   while (first > 0 && string(pTerms[first - 1].text)[0] == queryTerm[0])
+      first--;
+
+   for (std::size_t i = first; i < termCount_; i++)
+   {
+      const IndexTerm& term = pTerms[i];
+      const char* text = string(term.text);
+      if (text[0] != queryTerm[0])
+         break;
+
+      // exact and prefix matches were handled above
+      if (term.length >= queryTerm.length() &&
+          std::memcmp(text, queryTerm.data(), queryTerm.length()) == 0)
+      {
+         continue;
+      }
+
+      std::size_t distance = boundedEditDistance(text, term.length,
+                                                 queryTerm.data(),
+                                                 queryTerm.length(),
+                                                 maxDistance);
+      if (distance <= maxDistance)
+         addPostings(i, kFuzzyMatch / distance, pScores);
+   }
+}
+
+void SearchIndex::addPostings(std::size_t term,
+                              double quality,
+                              std::map<std::size_t, double>* pScores) const
+{
+   const IndexTerm& entry = reinterpret_cast<const IndexTerm*>(pTerms_)[term];
+   const IndexPosting* pPostings =
+         reinterpret_cast<const IndexPosting*>(pPostings_) + entry.firstPosting;
+
+   for (std::size_t i = 0; i < entry.postingCount; i++)
+   {
+      double score = quality * fieldWeight(pPostings[i].fields);
+      double& best = (*pScores)[pPostings[i].document];
+      if (score > best)
+         best = score;
+   }
+}
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
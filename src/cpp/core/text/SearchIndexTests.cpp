@@ -0,0 +1,165 @@
+/*
+ * SearchIndexTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/SearchIndex.hpp>
+
+#include <algorithm>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+using namespace core::text;
+
+namespace {
+
+bool hasTerm(const std::vector<std::string>& terms, const std::string& term)
+{
+   return std::find(terms.begin(), terms.end(), term) != terms.end();
+}
+
+FilePath buildTestIndex()
+{
+   SearchIndexBuilder builder;
+
+   SearchDocument readCsv("read.csv", "Data Input", "help");
+   readCsv.addText(SearchFieldName, "read.csv");
+   readCsv.addText(SearchFieldAlias, "read.csv read.table read.delim");
+   readCsv.addText(SearchFieldTitle, "Data Input");
+   readCsv.addText(SearchFieldDescription,
+                   "Reads a file in table format and creates a data frame.");
+   builder.addDocument(readCsv);
+
+   SearchDocument lm("lm", "Fitting Linear Models", "help");
+   lm.addText(SearchFieldName, "lm");
+   lm.addText(SearchFieldTitle, "Fitting Linear Models");
+   lm.addText(SearchFieldDescription,
+              "lm is used to fit linear models, including regression.");
+   builder.addDocument(lm);
+
+   SearchDocument intro("intro.Rmd", "Introduction", "vignette");
+   intro.addText(SearchFieldTitle, "Introduction");
+   intro.addText(SearchFieldText,
+                 "This vignette shows how to read a table of data and "
+                 "fit a regression model.");
+   builder.addDocument(intro);
+
+   FilePath indexPath;
+   REQUIRE(!FilePath::tempFilePath(&indexPath));
+   REQUIRE(!builder.write(indexPath));
+   return indexPath;
+}
+
+} // anonymous namespace
+
+TEST_CASE("search index")
+{
+   SECTION("search terms are lower cased and compound names split")
+   {
+      std::vector<std::string> terms = searchTerms("Use read.csv for .libPaths()");
+      CHECK(hasTerm(terms, "use"));
+      CHECK(hasTerm(terms, "read.csv"));
+      CHECK(hasTerm(terms, "read"));
+      CHECK(hasTerm(terms, "csv"));
+      CHECK(hasTerm(terms, "libpaths"));
+      CHECK(!hasTerm(terms, "for"));
+   }
+
+   SECTION("exact matches rank by field")
+   {
+      FilePath indexPath = buildTestIndex();
+
+      SearchIndex index;
+      REQUIRE(!index.open(indexPath));
+      CHECK(index.documentCount() == 3);
+
+      std::vector<SearchMatch> matches = index.search("regression", SearchOptions());
+      REQUIRE(matches.size() == 2);
+      CHECK(index.documentName(matches[0].document) == "lm");
+      CHECK(index.documentName(matches[1].document) == "intro.Rmd");
+      CHECK(index.documentType(matches[1].document) == "vignette");
+
+      matches = index.search("read.csv", SearchOptions());
+      REQUIRE(!matches.empty());
+      CHECK(index.documentName(matches[0].document) == "read.csv");
+      CHECK(index.documentTitle(matches[0].document) == "Data Input");
+
+      indexPath.remove();
+   }
+
+   SECTION("all query terms must match")
+   {
+      FilePath indexPath = buildTestIndex();
+
+      SearchIndex index;
+      REQUIRE(!index.open(indexPath));
+
+      std::vector<SearchMatch> matches = index.search("linear models", SearchOptions());
+      REQUIRE(matches.size() == 1);
+      CHECK(index.documentName(matches[0].document) == "lm");
+
+      CHECK(index.search("linear csv", SearchOptions()).empty());
+
+      indexPath.remove();
+   }
+
+   SECTION("prefix and fuzzy matches")
+   {
+      FilePath indexPath = buildTestIndex();
+
+      SearchIndex index;
+      REQUIRE(!index.open(indexPath));
+
+      std::vector<SearchMatch> matches = index.search("regr", SearchOptions());
+      CHECK(matches.size() == 2);
+
+      SearchOptions exactOnly;
+      exactOnly.prefix = false;
+      exactOnly.fuzzy = false;
+      CHECK(index.search("regr", exactOnly).empty());
+
+      // one edit away from 'linear'
+      matches = index.search("lineer", SearchOptions());
+      REQUIRE(matches.size() == 1);
+      CHECK(index.documentName(matches[0].document) == "lm");
+      CHECK(index.search("lineer", exactOnly).empty());
+
+      indexPath.remove();
+   }
+
+   SECTION("invalid index files are rejected")
+   {
+      FilePath indexPath;
+      REQUIRE(!FilePath::tempFilePath(&indexPath));
+      REQUIRE(!writeStringToFile(indexPath, "not an index file"));
+
+      SearchIndex index;
+      CHECK(index.open(indexPath));
+      CHECK(index.search("anything", SearchOptions()).empty());
+
+      indexPath.remove();
+   }
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
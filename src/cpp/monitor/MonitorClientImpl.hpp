@@ -41,6 +41,9 @@ public:
    void logEvent(const Event& event);
 
    void logConsoleAction(const audit::ConsoleAction& action);
+
+private:
+   void send(const std::string& uri, const std::string& body);
 };
 
 class AsyncClient : public Client
@@ -70,6 +73,8 @@ protected:
    boost::asio::io_service& ioService() { return ioService_; }
 
 private:
+   void send(const std::string& uri, const std::string& body);
+
    boost::asio::io_service& ioService_;
 };
 
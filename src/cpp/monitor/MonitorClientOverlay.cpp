@@ -16,53 +16,157 @@
 #include <monitor/MonitorClient.hpp>
 #include "MonitorClientImpl.hpp"
 
+#include <boost/foreach.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <core/Error.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+#include <core/json/Json.hpp>
+
+#ifndef _WIN32
+#include <core/http/LocalStreamAsyncClient.hpp>
+#include <core/http/LocalStreamBlockingClient.hpp>
+#endif
+
+using namespace rstudio::core;
+
 namespace rstudio {
 namespace monitor {
 
+// Metrics and events are posted (as json) to rserver over the metrics socket,
+// which records them in its metrics store. Delivery is best effort: failures
+// are ignored rather than logged (logging could itself feed back into the
+// monitor, and rserver may simply not be running, e.g. in desktop mode).
+// Synchronous sends are made on the caller's thread (e.g. the R thread in
+// sessions), so they give up quickly rather than waiting on a busy rserver.
+
+namespace {
+
+const boost::posix_time::time_duration kSyncSendTimeout =
+                                    boost::posix_time::milliseconds(500);
+
+template <typename MetricType>
+std::string metricsBody(const std::vector<MetricType>& metrics)
+{
+   json::Array metricsJson;
+   BOOST_FOREACH(const MetricType& metric, metrics)
+   {
+      metricsJson.push_back(metrics::metricToJson(metric));
+   }
+
+   json::Object bodyJson;
+   bodyJson["pid"] = static_cast<int>(core::system::currentProcessId());
+   bodyJson["metrics"] = metricsJson;
+   return json::write(bodyJson);
+}
+
+void buildRequest(const std::string& uri,
+                  const std::string& body,
+                  const std::string& sharedSecret,
+                  http::Request* pRequest)
+{
+   pRequest->setMethod("POST");
+   pRequest->setUri(uri);
+   pRequest->setHeader("Connection", "close");
+   pRequest->setHeader(kMonitorSharedSecretHeader, sharedSecret);
+   pRequest->setBody(body);
+   pRequest->setContentType("application/json");
+}
+
+void ignoreResponse(const http::Response& response)
+{
+}
+
+void ignoreError(const Error& error)
+{
+}
+
+} // anonymous namespace
+
 void SyncClient::logMessage(const std::string& programIdentity,
                             core::system::LogLevel level,
                             const std::string& message)
 {
+   // log messages are already written to the system log
 }
 
 void SyncClient::sendMetrics(const std::vector<metrics::Metric>& metrics)
 {
+   send(kMonitorMetricsUri, metricsBody(metrics));
 }
 
 void SyncClient::sendMultiMetrics(
                         const std::vector<metrics::MultiMetric>& metrics)
 {
+   send(kMonitorMultiMetricsUri, metricsBody(metrics));
+}
+
+void SyncClient::send(const std::string& uri, const std::string& body)
+{
+#ifndef _WIN32
+   // without a shared secret rserver would reject us
+   if (sharedSecret().empty())
+      return;
+
+   http::Request request;
+   buildRequest(uri, body, sharedSecret(), &request);
+   http::Response response;
+   http::sendRequest(FilePath(metricsSocket()), request, &response,
+                     kSyncSendTimeout);
+#endif
 }
 
 void AsyncClient::logMessage(const std::string& programIdentity,
                              core::system::LogLevel level,
                              const std::string& message)
 {
+   // log messages are already written to the system log
 }
 
 void AsyncClient::sendMetrics(const std::vector<metrics::Metric>& metrics)
 {
+   send(kMonitorMetricsUri, metricsBody(metrics));
 }
 
 void AsyncClient::sendMultiMetrics(
                               const std::vector<metrics::MultiMetric>& metrics)
 {
+   send(kMonitorMultiMetricsUri, metricsBody(metrics));
+}
+
+void AsyncClient::send(const std::string& uri, const std::string& body)
+{
+#ifndef _WIN32
+   if (sharedSecret().empty())
+      return;
+
+   boost::shared_ptr<http::IAsyncClient> pClient(
+      new http::LocalStreamAsyncClient(ioService(),
+                                       FilePath(metricsSocket())));
+   buildRequest(uri, body, sharedSecret(), &pClient->request());
+   pClient->execute(ignoreResponse, ignoreError);
+#endif
 }
 
 void SyncClient::logEvent(const Event& event)
 {
+   send(kMonitorEventsUri, json::write(eventToJson(event)));
 }
 
 void AsyncClient::logEvent(const Event& event)
 {
+   send(kMonitorEventsUri, json::write(eventToJson(event)));
 }
 
 void SyncClient::logConsoleAction(const audit::ConsoleAction& action)
 {
+   // console actions are audited by the commercial monitor only
 }
 
 void AsyncClient::logConsoleAction(const audit::ConsoleAction& action)
 {
+   // console actions are audited by the commercial monitor only
 }
 
 } // namespace monitor
@@ -17,8 +17,12 @@
 
 #include <iostream>
 
+#include <core/DateTime.hpp>
+#include <core/Error.hpp>
 #include <core/StringUtils.hpp>
 
+#include <core/json/JsonRpc.hpp>
+
 #include <core/http/Util.hpp>
 
 namespace rstudio {
@@ -95,6 +99,49 @@ std::ostream& operator<<(std::ostream& ostr, const Event& event)
    return ostr;
 }
 
+core::json::Object eventToJson(const Event& event)
+{
+   using namespace rstudio::core;
+   json::Object eventJson;
+   eventJson["scope"] = static_cast<int>(event.scope());
+   eventJson["id"] = event.id();
+   eventJson["name"] = eventScopeAndIdAsString(event);
+   eventJson["username"] = event.username();
+   eventJson["pid"] = static_cast<int>(event.pid());
+   eventJson["ts"] = date_time::secondsSinceEpoch(event.timestamp());
+   eventJson["data"] = event.data();
+   return eventJson;
+}
+
+core::Error eventFromJson(const core::json::Object& eventJson, Event* pEvent)
+{
+   using namespace rstudio::core;
+   int scope, id, pid;
+   std::string username, data;
+   double ts;
+   Error error = json::readObject(eventJson,
+                                  "scope", &scope,
+                                  "id", &id,
+                                  "username", &username,
+                                  "pid", &pid,
+                                  "ts", &ts,
+                                  "data", &data);
+   if (error)
+      return error;
+
+   if (scope != kAuthScope && scope != kSessionScope)
+      return Error(json::errc::ParamInvalid, ERROR_LOCATION);
+
+   *pEvent = Event(static_cast<EventScope>(scope),
+                   id,
+                   data,
+                   username,
+                   pid,
+                   date_time::timeFromSecondsSinceEpoch(ts));
+
+   return Success();
+}
+
 } // namespace monitor
 } // namespace rstudio
 
@@ -19,6 +19,17 @@
 #define kMonitorSocketPath         "/tmp/rstudio-rserver/rserver-monitor.socket"
 #define kMonitorSharedSecretEnvVar "RS_MONITOR_SHARED_SECRET"
 #define kMonitorIntervalSeconds    "monitor-interval-seconds"
+#define kMonitorMetricsHistory     "monitor-metrics-history"
+
+#define kMonitorIntervalSecondsEnvVar "RS_MONITOR_INTERVAL_SECONDS"
+#define kMonitorSharedSecretHeader    "X-RS-Monitor-Shared-Secret"
+
+// uris served over the monitor socket
+#define kMonitorMetricsUri         "/metrics"
+#define kMonitorMultiMetricsUri    "/multi_metrics"
+#define kMonitorEventsUri          "/events"
+#define kMonitorQueryUri           "/query"
+#define kMonitorTraceUri           "/trace"
 
 #endif // MONITOR_CONSTANTS_HPP
 
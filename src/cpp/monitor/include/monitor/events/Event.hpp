@@ -20,8 +20,15 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <core/json/Json.hpp>
 #include <core/system/System.hpp>
 
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
 namespace rstudio {
 namespace monitor {
 
@@ -91,6 +98,10 @@ std::string eventScopeAndIdAsString(const Event& event);
 
 std::ostream& operator<<(std::ostream& ostr, const Event& event);
 
+// json serialization
+core::json::Object eventToJson(const Event& event);
+core::Error eventFromJson(const core::json::Object& eventJson, Event* pEvent);
+
 } // namespace monitor
 } // namespace rstudio
 
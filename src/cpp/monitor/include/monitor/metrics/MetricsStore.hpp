@@ -0,0 +1,160 @@
+/*
+ * MetricsStore.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef MONITOR_METRICS_METRICS_STORE_HPP
+#define MONITOR_METRICS_METRICS_STORE_HPP
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/json/Json.hpp>
+
+#include <monitor/events/Event.hpp>
+#include <monitor/metrics/Metric.hpp>
+
+namespace rstudio {
+namespace monitor {
+namespace metrics {
+
+struct Sample
+{
+   Sample() : value(0) {}
+
+   Sample(const boost::posix_time::ptime& timestamp, double value)
+      : timestamp(timestamp), value(value)
+   {
+   }
+
+   boost::posix_time::ptime timestamp;
+   double value;
+};
+
+// aggregate of the samples in a series (or of several series)
+struct Summary
+{
+   Summary() : count(0), latest(0), min(0), max(0), total(0) {}
+
+   void add(double value);
+   void add(const Summary& summary);
+
+   double mean() const { return count > 0 ? total / count : 0; }
+
+   std::size_t count;
+   double latest;
+   double min;
+   double max;
+   double total;
+};
+
+// Fixed capacity series of samples (once full, each new sample replaces
+// the oldest one). Samples are expected to arrive in time order.
+class TimeSeries
+{
+public:
+   explicit TimeSeries(std::size_t capacity);
+
+   void add(const Sample& sample);
+
+   bool empty() const { return samples_.empty(); }
+   std::size_t size() const { return samples_.size(); }
+   std::size_t capacity() const { return capacity_; }
+
+   // samples are indexed oldest first
+   const Sample& at(std::size_t index) const;
+   const Sample& latest() const { return at(size() - 1); }
+
+   // summarize the samples taken at or after since
+   Summary summarize(const boost::posix_time::ptime& since) const;
+
+private:
+   std::size_t capacity_;
+   std::vector<Sample> samples_;
+   std::size_t oldest_;
+};
+
+// In-process store for the metrics and events reported by sessions (and the
+// server itself). Each session's metrics are kept in fixed size series, and
+// sessions which stop reporting are dropped, so memory use is bounded.
+// Thread safe.
+class MetricsStore : boost::noncopyable
+{
+public:
+   MetricsStore(std::size_t samplesPerSeries,
+                std::size_t maxEvents,
+                const boost::posix_time::time_duration& sessionTimeout);
+
+   // record metrics reported by the session with the given pid
+   void addMetric(const std::string& username,
+                  PidType pid,
+                  const Metric& metric);
+   void addMetric(const std::string& username,
+                  PidType pid,
+                  const MultiMetric& multiMetric);
+
+   void addEvent(const Event& event);
+
+   // describe the sessions, per user totals, and events in the window ending
+   // now (optionally only for one user and including the raw samples)
+   core::json::Object toJson(const boost::posix_time::time_duration& window,
+                             const std::string& username = std::string(),
+                             bool includeSamples = false) const;
+
+private:
+   struct Series
+   {
+      explicit Series(std::size_t capacity) : samples(capacity) {}
+
+      std::string unit;
+      TimeSeries samples;
+   };
+
+   typedef std::map<std::string, Series> SeriesMap;
+
+   struct Session
+   {
+      std::string username;
+      PidType pid;
+      boost::posix_time::ptime lastReported;
+      SeriesMap series;
+   };
+
+   typedef std::pair<std::string, PidType> SessionKey;
+   typedef std::map<SessionKey, Session> Sessions;
+
+   Session& session(const std::string& username, PidType pid);
+   void addSample(Session* pSession,
+                  const MetricBase& metric,
+                  const MetricData& data);
+   void removeInactiveSessions();
+
+   mutable boost::mutex mutex_;
+   std::size_t samplesPerSeries_;
+   std::size_t maxEvents_;
+   boost::posix_time::time_duration sessionTimeout_;
+   Sessions sessions_;
+   std::deque<Event> events_;
+};
+
+} // namespace metrics
+} // namespace monitor
+} // namespace rstudio
+
+#endif // MONITOR_METRICS_METRICS_STORE_HPP
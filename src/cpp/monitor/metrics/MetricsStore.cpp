@@ -0,0 +1,343 @@
+/*
+ * MetricsStore.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <monitor/metrics/MetricsStore.hpp>
+
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include <core/DateTime.hpp>
+
+using namespace rstudio::core;
+using namespace boost::posix_time;
+
+namespace rstudio {
+namespace monitor {
+namespace metrics {
+
+namespace {
+
+// limits on what a single (possibly misbehaving) reporter can consume
+const std::size_t kMaxSeriesPerSession = 64;
+const std::size_t kMaxSessions = 4096;
+
+std::string seriesName(const MetricBase& metric, const MetricData& data)
+{
+   return metric.scope() + "." + data.name;
+}
+
+json::Object summaryToJson(const Summary& summary,
+                           const std::string& latestName = "latest")
+{
+   json::Object summaryJson;
+   summaryJson["count"] = static_cast<int>(summary.count);
+   summaryJson[latestName] = summary.latest;
+   summaryJson["min"] = summary.min;
+   summaryJson["max"] = summary.max;
+   summaryJson["mean"] = summary.mean();
+   return summaryJson;
+}
+
+json::Array samplesToJson(const TimeSeries& series, const ptime& since)
+{
+   json::Array samplesJson;
+   for (std::size_t i = 0; i < series.size(); i++)
+   {
+      const Sample& sample = series.at(i);
+      if (sample.timestamp < since)
+         continue;
+
+      json::Array sampleJson;
+      sampleJson.push_back(date_time::secondsSinceEpoch(sample.timestamp));
+      sampleJson.push_back(sample.value);
+      samplesJson.push_back(sampleJson);
+   }
+   return samplesJson;
+}
+
+} // anonymous namespace
+
+void Summary::add(double value)
+{
+   if (count == 0)
+   {
+      min = value;
+      max = value;
+   }
+   else
+   {
+      min = std::min(min, value);
+      max = std::max(max, value);
+   }
+   latest = value;
+   total += value;
+   count++;
+}
+
+void Summary::add(const Summary& summary)
+{
+   if (summary.count == 0)
+      return;
+
+   if (count == 0)
+   {
+      min = summary.min;
+      max = summary.max;
+   }
+   else
+   {
+      min = std::min(min, summary.min);
+      max = std::max(max, summary.max);
+   }
+
+   // the latest values of different series are summed (e.g. the memory used
+   // by all of a user's sessions)
+   latest += summary.latest;
+   total += summary.total;
+   count += summary.count;
+}
+
+TimeSeries::TimeSeries(std::size_t capacity)
+   : capacity_(std::max<std::size_t>(capacity, 1)), oldest_(0)
+{
+}
+
+void TimeSeries::add(const Sample& sample)
+{
+   if (samples_.size() < capacity_)
+   {
+      samples_.push_back(sample);
+   }
+   else
+   {
+      samples_[oldest_] = sample;
+      oldest_ = (oldest_ + 1) % capacity_;
+   }
+}
+
+const Sample& TimeSeries::at(std::size_t index) const
+{
+   return samples_[(oldest_ + index) % samples_.size()];
+}
+
+Summary TimeSeries::summarize(const ptime& since) const
+{
+   Summary summary;
+   for (std::size_t i = 0; i < size(); i++)
+   {
+      const Sample& sample = at(i);
+      if (sample.timestamp >= since)
+         summary.add(sample.value);
+   }
+   return summary;
+}
+
+MetricsStore::MetricsStore(std::size_t samplesPerSeries,
+                           std::size_t maxEvents,
+                           const time_duration& sessionTimeout)
+   : samplesPerSeries_(samplesPerSeries),
+     maxEvents_(maxEvents),
+     sessionTimeout_(sessionTimeout)
+{
+}
+
+void MetricsStore::addMetric(const std::string& username,
+                             PidType pid,
+                             const Metric& metric)
+{
+   boost::mutex::scoped_lock lock(mutex_);
+
+   removeInactiveSessions();
+   addSample(&session(username, pid), metric, metric.data());
+}
+
+void MetricsStore::addMetric(const std::string& username,
+                             PidType pid,
+                             const MultiMetric& multiMetric)
+{
+   boost::mutex::scoped_lock lock(mutex_);
+
+   removeInactiveSessions();
+   Session& target = session(username, pid);
+   BOOST_FOREACH(const MetricData& data, multiMetric.data())
+   {
+      addSample(&target, multiMetric, data);
+   }
+}
+
+void MetricsStore::addEvent(const Event& event)
+{
+   boost::mutex::scoped_lock lock(mutex_);
+
+   events_.push_back(event);
+   while (events_.size() > maxEvents_)
+      events_.pop_front();
+}
+
+json::Object MetricsStore::toJson(const time_duration& window,
+                                  const std::string& username,
+                                  bool includeSamples) const
+{
+   boost::mutex::scoped_lock lock(mutex_);
+
+   ptime since = microsec_clock::universal_time() - window;
+
+   // sessions (summarizing each of their series), accumulating totals
+   // for each user as we go
+   typedef std::map<std::string, Summary> Summaries;
+   typedef std::map<std::string, Summaries> UserSummaries;
+   UserSummaries userSummaries;
+   std::map<std::string, int> userSessions;
+   json::Array sessionsJson;
+   BOOST_FOREACH(const Sessions::value_type& entry, sessions_)
+   {
+      const Session& session = entry.second;
+      if (!username.empty() && session.username != username)
+         continue;
+
+      json::Object metricsJson;
+      BOOST_FOREACH(const SeriesMap::value_type& seriesEntry, session.series)
+      {
+         const Series& series = seriesEntry.second;
+         Summary summary = series.samples.summarize(since);
+         if (summary.count == 0)
+            continue;
+
+         json::Object seriesJson = summaryToJson(summary);
+         seriesJson["unit"] = series.unit;
+         if (includeSamples)
+            seriesJson["samples"] = samplesToJson(series.samples, since);
+         metricsJson[seriesEntry.first] = seriesJson;
+
+         userSummaries[session.username][seriesEntry.first].add(summary);
+      }
+
+      if (metricsJson.empty())
+         continue;
+
+      json::Object sessionJson;
+      sessionJson["username"] = session.username;
+      sessionJson["pid"] = static_cast<int>(session.pid);
+      sessionJson["last_reported"] =
+                     date_time::secondsSinceEpoch(session.lastReported);
+      sessionJson["metrics"] = metricsJson;
+      sessionsJson.push_back(sessionJson);
+
+      userSessions[session.username]++;
+   }
+
+   // per user totals (the total is the sum of the latest value of each session)
+   json::Array usersJson;
+   BOOST_FOREACH(const UserSummaries::value_type& entry, userSummaries)
+   {
+      json::Object metricsJson;
+      BOOST_FOREACH(const Summaries::value_type& summary, entry.second)
+      {
+         metricsJson[summary.first] = summaryToJson(summary.second, "total");
+      }
+
+      json::Object userJson;
+      userJson["username"] = entry.first;
+      userJson["sessions"] = userSessions[entry.first];
+      userJson["metrics"] = metricsJson;
+      usersJson.push_back(userJson);
+   }
+
+   // events in the window
+   json::Array eventsJson;
+   BOOST_FOREACH(const Event& event, events_)
+   {
+      if (event.timestamp() < since)
+         continue;
+      if (!username.empty() && event.username() != username)
+         continue;
+
+      eventsJson.push_back(eventToJson(event));
+   }
+
+   json::Object resultJson;
+   resultJson["window"] = static_cast<double>(window.total_seconds());
+   resultJson["users"] = usersJson;
+   resultJson["sessions"] = sessionsJson;
+   resultJson["events"] = eventsJson;
+   return resultJson;
+}
+
+MetricsStore::Session& MetricsStore::session(const std::string& username,
+                                             PidType pid)
+{
+   SessionKey key(username, pid);
+   Sessions::iterator it = sessions_.find(key);
+   if (it == sessions_.end())
+   {
+      // make room by dropping the session that reported least recently
+      if (sessions_.size() >= kMaxSessions)
+      {
+         Sessions::iterator oldest = sessions_.begin();
+         for (Sessions::iterator candidate = sessions_.begin();
+              candidate != sessions_.end();
+              ++candidate)
+         {
+            if (candidate->second.lastReported < oldest->second.lastReported)
+               oldest = candidate;
+         }
+         sessions_.erase(oldest);
+      }
+
+      Session session;
+      session.username = username;
+      session.pid = pid;
+      it = sessions_.insert(std::make_pair(key, session)).first;
+   }
+
+   it->second.lastReported = microsec_clock::universal_time();
+   return it->second;
+}
+
+void MetricsStore::addSample(Session* pSession,
+                             const MetricBase& metric,
+                             const MetricData& data)
+{
+   std::string name = seriesName(metric, data);
+   SeriesMap::iterator it = pSession->series.find(name);
+   if (it == pSession->series.end())
+   {
+      if (pSession->series.size() >= kMaxSeriesPerSession)
+         return;
+
+      it = pSession->series.insert(
+               std::make_pair(name, Series(samplesPerSeries_))).first;
+   }
+
+   it->second.unit = metric.unit();
+   it->second.samples.add(Sample(metric.timestamp(), data.value));
+}
+
+void MetricsStore::removeInactiveSessions()
+{
+   ptime cutoff = microsec_clock::universal_time() - sessionTimeout_;
+   for (Sessions::iterator it = sessions_.begin(); it != sessions_.end(); )
+   {
+      if (it->second.lastReported < cutoff)
+         sessions_.erase(it++);
+      else
+         ++it;
+   }
+}
+
+} // namespace metrics
+} // namespace monitor
+} // namespace rstudio
@@ -0,0 +1,202 @@
+/*
+ * MetricsStoreTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <monitor/metrics/MetricsStore.hpp>
+
+#include <boost/thread/thread.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace monitor {
+namespace metrics {
+namespace tests {
+
+using namespace rstudio::core;
+using namespace boost::posix_time;
+
+namespace {
+
+Metric metric(const std::string& name, double value, const ptime& timestamp)
+{
+   return Metric("session", 60, MetricData(name, value), "gauge", "MB",
+                 timestamp);
+}
+
+const json::Array& arrayField(const json::Object& object,
+                              const std::string& name)
+{
+   return object.find(name)->second.get_array();
+}
+
+// the summary of a session's series (or of a user's series if no pid)
+bool findSummary(const json::Object& storeJson,
+                 const std::string& username,
+                 PidType pid,
+                 const std::string& series,
+                 json::Object* pSummary)
+{
+   const json::Array& entries = arrayField(storeJson,
+                                           pid ? "sessions" : "users");
+   for (std::size_t i = 0; i < entries.size(); i++)
+   {
+      const json::Object& entry = entries[i].get_obj();
+      if (entry.find("username")->second.get_str() != username)
+         continue;
+      if (pid && entry.find("pid")->second.get_int() != static_cast<int>(pid))
+         continue;
+
+      const json::Object& metrics = entry.find("metrics")->second.get_obj();
+      json::Object::const_iterator it = metrics.find(series);
+      if (it == metrics.end())
+         return false;
+
+      *pSummary = it->second.get_obj();
+      return true;
+   }
+   return false;
+}
+
+double numberField(const json::Object& object, const std::string& name)
+{
+   return object.find(name)->second.get_value<double>();
+}
+
+} // anonymous namespace
+
+context("MetricsStoreTests")
+{
+   ptime now = microsec_clock::universal_time();
+
+   test_that("Time series keep the newest samples once full")
+   {
+      TimeSeries series(3);
+      for (int i = 0; i < 5; i++)
+         series.add(Sample(now + seconds(i), i));
+
+      REQUIRE(series.size() == 3);
+      expect_true(series.capacity() == 3);
+      expect_true(series.at(0).value == 2);
+      expect_true(series.at(1).value == 3);
+      expect_true(series.latest().value == 4);
+
+      // wrapping around again keeps them in order
+      series.add(Sample(now + seconds(5), 5));
+      series.add(Sample(now + seconds(6), 6));
+      expect_true(series.at(0).value == 4);
+      expect_true(series.latest().value == 6);
+   }
+
+   test_that("Time series summarize the samples since a time")
+   {
+      TimeSeries series(4);
+      series.add(Sample(now - seconds(30), 100));
+      series.add(Sample(now - seconds(20), 1));
+      series.add(Sample(now - seconds(10), 5));
+      series.add(Sample(now, 3));
+
+      Summary summary = series.summarize(now - seconds(20));
+      expect_true(summary.count == 3);
+      expect_true(summary.latest == 3);
+      expect_true(summary.min == 1);
+      expect_true(summary.max == 5);
+      expect_true(summary.mean() == 3);
+
+      expect_true(series.summarize(now + seconds(1)).count == 0);
+   }
+
+   test_that("Store summaries only include samples in the window")
+   {
+      MetricsStore store(10, 10, hours(1));
+      store.addMetric("alice", 100, metric("memory", 500, now - minutes(10)));
+      store.addMetric("alice", 100, metric("memory", 200, now - seconds(30)));
+      store.addMetric("alice", 100, metric("memory", 400, now));
+
+      json::Object summary;
+      REQUIRE(findSummary(store.toJson(minutes(1)), "alice", 100,
+                          "session.memory", &summary));
+      expect_true(numberField(summary, "count") == 2);
+      expect_true(numberField(summary, "latest") == 400);
+      expect_true(numberField(summary, "max") == 400);
+      expect_true(numberField(summary, "mean") == 300);
+      expect_true(summary.find("unit")->second.get_str() == "MB");
+
+      REQUIRE(findSummary(store.toJson(hours(1)), "alice", 100,
+                          "session.memory", &summary));
+      expect_true(numberField(summary, "count") == 3);
+
+      // sessions with no samples in the window are omitted
+      json::Object storeJson = store.toJson(seconds(0));
+      expect_false(findSummary(storeJson, "alice", 100, "session.memory",
+                               &summary));
+   }
+
+   test_that("User totals add up the latest values of their sessions")
+   {
+      MetricsStore store(10, 10, hours(1));
+      store.addMetric("alice", 100, metric("memory", 100, now));
+      store.addMetric("alice", 101, metric("memory", 250, now));
+      store.addMetric("bob", 102, metric("memory", 1000, now));
+
+      json::Object storeJson = store.toJson(minutes(1));
+      json::Object summary;
+      REQUIRE(findSummary(storeJson, "alice", 0, "session.memory", &summary));
+      expect_true(numberField(summary, "total") == 350);
+      expect_true(numberField(summary, "max") == 250);
+
+      // results can be limited to one user
+      storeJson = store.toJson(minutes(1), "bob");
+      expect_true(arrayField(storeJson, "sessions").size() == 1);
+      expect_true(arrayField(storeJson, "users").size() == 1);
+      expect_false(findSummary(storeJson, "alice", 0, "session.memory",
+                               &summary));
+   }
+
+   test_that("Sessions which stop reporting are evicted")
+   {
+      MetricsStore store(10, 10, milliseconds(50));
+      store.addMetric("alice", 100, metric("memory", 100, now));
+      store.addMetric("bob", 101, metric("memory", 100, now));
+      expect_true(arrayField(store.toJson(minutes(1)), "sessions").size() == 2);
+
+      // once their sessions time out the next report evicts them
+      boost::this_thread::sleep(milliseconds(100));
+      store.addMetric("carol", 102, metric("memory", 100, now));
+
+      json::Object storeJson = store.toJson(minutes(1));
+      json::Object summary;
+      expect_true(arrayField(storeJson, "sessions").size() == 1);
+      expect_false(findSummary(storeJson, "alice", 100, "session.memory",
+                               &summary));
+      expect_true(findSummary(storeJson, "carol", 102, "session.memory",
+                              &summary));
+   }
+
+   test_that("Only the most recent events are kept")
+   {
+      MetricsStore store(10, 2, hours(1));
+      for (int i = 0; i < 3; i++)
+         store.addEvent(Event(kSessionScope, kSessionStartEvent, "", "alice",
+                              100 + i, now));
+
+      json::Object storeJson = store.toJson(minutes(1));
+      expect_true(arrayField(storeJson, "events").size() == 2);
+   }
+}
+
+} // namespace tests
+} // namespace metrics
+} // namespace monitor
+} // namespace rstudio
@@ -19,8 +19,12 @@
 #include <core/FilePath.hpp>
 #include <core/Log.hpp>
 #include <core/StringUtils.hpp>
+#include <core/Trace.hpp>
 #include <core/system/Environment.hpp>
 
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/unordered_map.hpp>
+
 #include <r/RErrorCategory.hpp>
 #include <r/RSourceManager.hpp>
 #include <r/RInterface.hpp>
@@ -210,6 +214,73 @@ void SEXPTopLevelExec(void *data)
    *(pContext->pReturnSEXP) = pContext->function();
 }
    
+// RFunction handles for the .rs.* functions. these are called very
+// frequently, so rather than resolving (and preserving, then releasing) the
+// function on each call we keep a preserved handle. a handle is reused for as
+// long as an ordinary lookup of the name (from the global environment, via
+// R's global cache) still finds the same function, so re-sourcing,
+// redefining or masking a function is picked up on the next call, at which
+// point the replaced handle is released (RFunctions are stack objects which
+// resolve their function when constructed, so don't hold on to it)
+struct CachedFunction
+{
+   CachedFunction()
+      : functionSEXP(R_UnboundValue), symbolSEXP(R_NilValue)
+   {
+   }
+
+   SEXP functionSEXP;
+   SEXP symbolSEXP;
+};
+
+typedef boost::unordered_map<std::string, CachedFunction> FunctionCache;
+
+FunctionCache& functionCache()
+{
+   static FunctionCache instance;
+   return instance;
+}
+
+bool isCacheableFunction(const std::string& name)
+{
+   return boost::algorithm::starts_with(name, ".rs.");
+}
+
+SEXP cachedFunction(const std::string& name)
+{
+   FunctionCache& cache = functionCache();
+   FunctionCache::iterator it = cache.find(name);
+   if (it != cache.end())
+   {
+      const CachedFunction& cached = it->second;
+      if (Rf_findVar(cached.symbolSEXP, R_GlobalEnv) == cached.functionSEXP)
+         return cached.functionSEXP;
+
+      // the name now refers to something else; drop the old handle
+      R_ReleaseObject(cached.functionSEXP);
+      cache.erase(it);
+   }
+
+   SEXP functionSEXP = sexp::findFunction(name);
+   if (functionSEXP == R_UnboundValue)
+      return functionSEXP;
+
+   // only cache functions which are directly bound where an ordinary lookup
+   // finds them (not e.g. promises, or functions found after skipping a
+   // masking non-function binding) so that the check above holds
+   SEXP symbolSEXP = Rf_install(name.c_str());
+   if (Rf_findVar(symbolSEXP, R_GlobalEnv) != functionSEXP)
+      return R_UnboundValue;
+
+   R_PreserveObject(functionSEXP);
+
+   CachedFunction cached;
+   cached.functionSEXP = functionSEXP;
+   cached.symbolSEXP = symbolSEXP;
+   cache[name] = cached;
+   return functionSEXP;
+}
+
 } // anonymous namespace
    
 Error executeSafely(boost::function<void()> function)
@@ -280,6 +351,8 @@ Error evaluateString(const std::string& str,
                      SEXP* pSEXP, 
                      sexp::Protect* pProtect)
 {
+   TRACE_SPAN("r.evaluateString");
+
    // refresh source if necessary (no-op in production)
    r::sourceManager().reloadIfNecessary();
    
@@ -356,6 +429,15 @@ void RFunction::commonInit(const std::string& functionName)
       name = functionName_; 
    }
    
+   // use cached handles for .rs.* functions (these are preserved by the
+   // cache so needn't be preserved here)
+   if (ns.empty() && isCacheableFunction(name))
+   {
+      functionSEXP_ = cachedFunction(name);
+      if (functionSEXP_ != R_UnboundValue)
+         return;
+   }
+
    // lookup function
    functionSEXP_ = sexp::findFunction(name, ns);
    if (functionSEXP_ != R_UnboundValue)
@@ -387,6 +469,8 @@ Error RFunction::call(SEXP evalNS, SEXP* pResultSEXP, sexp::Protect* pProtect)
 Error RFunction::call(SEXP evalNS, bool safely, SEXP* pResultSEXP,
                       sexp::Protect* pProtect)
 {
+   TRACE_SPAN_DETAIL("r.call", functionName_);
+
    // verify the function
    if (functionSEXP_ == R_UnboundValue)
    {
@@ -22,7 +22,9 @@
 
 #include <core/Error.hpp>
 #include <core/FilePath.hpp>
+#include <core/Hash.hpp>
 #include <core/Log.hpp>
+#include <core/SafeConvert.hpp>
 
 #include <r/RExec.hpp>
 
@@ -95,6 +97,16 @@ void SourceManager::reSourceTools(const core::FilePath& filePath)
    
 Error SourceManager::source(const FilePath& filePath, bool local)
 {
+   // in release builds evaluate local sources from the compiled cache
+   // (debug builds keep source references so always source directly)
+#ifdef NDEBUG
+   if (local && !compiledCachePath_.empty())
+   {
+      recordSourcedFile(filePath, local);
+      return sourceCompiled(filePath);
+   }
+#endif
+
    std::string localPrefix = local ? "local(" : "";
    std::string localParam = local ? "TRUE" : "FALSE" ;
    std::string localSuffix = local ? ")" : "";
@@ -125,6 +137,50 @@ Error SourceManager::source(const FilePath& filePath, bool local)
    return r::exec::executeString(rCode); 
 }
 
+// evaluate the expressions of a file (as 'local(source(...))' would) using
+// byte-compiled expressions cached from a previous session if possible. the
+// cache is keyed by the file's path, size, and modification time (and the R
+// version, as byte code isn't portable across versions) so edited or
+// reinstalled files are simply recompiled
+Error SourceManager::sourceCompiled(const FilePath& filePath)
+{
+   Error error = compiledCachePath_.ensureDirectory();
+   if (error)
+      return error;
+
+   std::string key = filePath.absolutePath() + ":" +
+         safe_convert::numberToString(filePath.size()) + ":" +
+         safe_convert::numberToString(filePath.lastWriteTime());
+   std::string cacheName = filePath.stem() + "-" + hash::crc32HexHash(key);
+   FilePath cacheStem = compiledCachePath_.complete(cacheName);
+
+   // do \ escaping (for windows)
+   std::string path = filePath.absolutePath();
+   boost::algorithm::replace_all(path, "\\", "\\\\");
+   std::string cache = cacheStem.absolutePath();
+   boost::algorithm::replace_all(cache, "\\", "\\\\");
+
+   std::string rCode =
+      "local({\n"
+      "   cache <- paste0(\"" + cache + "\", \"-\", getRversion(), \".rds\")\n"
+      "   exprs <- tryCatch(readRDS(cache), error = function(e) NULL)\n"
+      "   if (!is.list(exprs)) {\n"
+      "      lines <- readLines(\"" + path + "\", encoding = \"UTF-8\", warn = FALSE)\n"
+      "      exprs <- as.list(parse(text = lines, keep.source = FALSE, encoding = \"UTF-8\"))\n"
+      "      if (requireNamespace(\"compiler\", quietly = TRUE))\n"
+      "         exprs <- suppressWarnings(suppressMessages(lapply(exprs, compiler::compile)))\n"
+      "      tmp <- paste(cache, Sys.getpid(), sep = \".\")\n"
+      "      if (!inherits(try(saveRDS(exprs, tmp), silent = TRUE), \"try-error\"))\n"
+      "         file.rename(tmp, cache)\n"
+      "   }\n"
+      "   envir <- new.env(parent = globalenv())\n"
+      "   for (expr in exprs) eval(expr, envir)\n"
+      "   invisible(NULL)\n"
+      "})";
+
+   return r::exec::executeString(rCode);
+}
+
 void SourceManager::recordSourcedFile(const FilePath& filePath, bool local)
 {
    SourcedFileInfo fileInfo(filePath.lastWriteTime(), local); 
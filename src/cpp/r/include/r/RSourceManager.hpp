@@ -50,6 +50,13 @@ public:
    
    bool autoReload() const { return autoReload_; }
    void setAutoReload(bool autoReload) { autoReload_ = autoReload; }
+
+   // directory used to cache the byte-compiled expressions of sourced
+   // files (if not set files are always parsed and evaluated from source)
+   void setCompiledCachePath(const core::FilePath& compiledCachePath)
+   {
+      compiledCachePath_ = compiledCachePath;
+   }
    
    core::Error sourceTools(const core::FilePath& filePath);
    void ensureToolsLoaded();
@@ -75,12 +82,14 @@ private:
    
    // helper functions
    core::Error source(const core::FilePath& filePath, bool local);
+   core::Error sourceCompiled(const core::FilePath& filePath);
    void reSourceTools(const core::FilePath& filePath);
    void recordSourcedFile(const core::FilePath& filePath, bool local);
    void reloadSourceIfNecessary(const SourcedFileMap::value_type& value);
    
    // members
    bool autoReload_ ;
+   core::FilePath compiledCachePath_;
    SourcedFileMap sourcedFiles_ ;
    std::vector<core::FilePath> toolsFilePaths_;
 };
@@ -66,6 +66,8 @@ core::FilePath sessionScratchPath();
 
 core::FilePath scopedScratchPath();
 
+core::FilePath userScratchPath();
+
 core::FilePath clientStatePath();
 
 core::FilePath projectClientStatePath();
@@ -224,6 +224,10 @@ Error initialize()
    // initialize console history capacity
    r::session::consoleHistory().setCapacityFromRHistsize();
 
+   // cache byte-compiled R tool sources across sessions
+   r::sourceManager().setCompiledCachePath(
+            utils::userScratchPath().complete("r-source-cache"));
+
    // install R tools
    FilePath toolsFilePath = utils::rSourcePath().complete("Tools.R");
    Error error = r::sourceManager().sourceTools(toolsFilePath);
@@ -522,6 +522,11 @@ FilePath scopedScratchPath()
    return s_options.scopedScratchPath;
 }
 
+FilePath userScratchPath()
+{
+   return s_options.userScratchPath;
+}
+
 FilePath safeCurrentPath()
 {
    return FilePath::safeCurrentPath(userHomePath());
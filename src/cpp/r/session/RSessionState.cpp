@@ -325,6 +325,9 @@ bool save(const FilePath& statePath,
    Settings settings;
    bool saved = true;
    initSaveContext(statePath, &settings, &saved);
+
+   // write the settings once all of them have been collected
+   settings.beginUpdate();
    
    // check and save packrat mode status
    bool packratModeOn = r::session::utils::isPackratModeOn();
@@ -421,6 +424,8 @@ bool save(const FilePath& statePath,
       }
    }
 
+   settings.endUpdate();
+
    // return status
    return saved;
 }
@@ -434,6 +439,9 @@ bool saveMinimal(const core::FilePath& statePath,
    bool saved = true;
    initSaveContext(statePath, &settings, &saved);
 
+   // write the settings once all of them have been collected
+   settings.beginUpdate();
+
    // set r profile on restore
    settings.set(kRProfileOnRestore, true);
 
@@ -462,7 +470,7 @@ bool saveMinimal(const core::FilePath& statePath,
       }
    }
 
-
+   settings.endUpdate();
 
    // return status
    return saved;
@@ -56,6 +56,7 @@
 #include "ServerEval.hpp"
 #include "ServerInit.hpp"
 #include "ServerMeta.hpp"
+#include "ServerMonitor.hpp"
 #include "ServerOffline.hpp"
 #include "ServerPAMAuth.hpp"
 #include "ServerREnvironment.hpp"
@@ -190,7 +191,8 @@ void httpServerAddHandlers()
 
    // establish content handlers
    uri_handlers::add("/graphics", secureAsyncHttpHandler(proxyContentRequest));
-   uri_handlers::add("/upload", secureAsyncUploadHandler(proxyContentRequest));
+   uri_handlers::addStreaming("/upload",
+                              secureAsyncUploadHandler(proxyContentRequest));
    uri_handlers::add("/export", secureAsyncHttpHandler(proxyContentRequest));
    uri_handlers::add("/source", secureAsyncHttpHandler(proxyContentRequest));
    uri_handlers::add("/content", secureAsyncHttpHandler(proxyContentRequest));
@@ -381,6 +383,12 @@ void addProxyHandler(const std::string& prefix,
    s_pHttpServer->addProxyHandler(prefix, handler);
 }
 
+void addStreaming(const std::string& prefix,
+                  const http::AsyncUriHandlerFunction& handler)
+{
+   s_pHttpServer->addStreamingHandler(prefix, handler);
+}
+
 void addBlocking(const std::string& prefix,
                  const http::UriHandlerFunction& handler)
 {
@@ -507,6 +515,17 @@ int main(int argc, char * const argv[])
       if (error)
          return core::system::exitFailure(error, ERROR_LOCATION);
 
+      // initialize the session manager (also needs the scheduled command list)
+      error = sessionManager().initialize();
+      if (error)
+         return core::system::exitFailure(error, ERROR_LOCATION);
+
+      // initialize the monitor server (creates the metrics socket so must
+      // happen while we are still privileged)
+      error = monitor_server::initialize();
+      if (error)
+         return core::system::exitFailure(error, ERROR_LOCATION);
+
       // initialize monitor (needs to happen post http server init for access
       // to the server's io service)
       monitor::initializeMonitorClient(kMonitorSocketPath,
@@ -584,6 +603,11 @@ int main(int argc, char * const argv[])
       // add http server not found handler
       s_pHttpServer->setNotFoundHandler(pageNotFoundHandler);
 
+      // run monitor server
+      error = monitor_server::startup();
+      if (error)
+         return core::system::exitFailure(error, ERROR_LOCATION);
+
       // run http server
       error = s_pHttpServer->run(options.wwwThreadPoolSize());
       if (error)
@@ -0,0 +1,256 @@
+/*
+ * ServerMonitor.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "ServerMonitor.hpp"
+
+#include <sstream>
+
+#include <boost/foreach.hpp>
+
+#include <core/Error.hpp>
+#include <core/Log.hpp>
+#include <core/Trace.hpp>
+#include <core/json/JsonRpc.hpp>
+#include <core/http/LocalStreamAsyncServer.hpp>
+#include <core/system/PosixUser.hpp>
+
+#include <monitor/MonitorConstants.hpp>
+#include <monitor/metrics/MetricsStore.hpp>
+
+#include <server/ServerOptions.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace server {
+namespace monitor_server {
+
+namespace {
+
+using namespace rstudio::monitor;
+
+// maximum number of events retained
+const std::size_t kMaxEvents = 1000;
+
+boost::shared_ptr<http::LocalStreamAsyncServer> s_pServer;
+boost::shared_ptr<metrics::MetricsStore> s_pStore;
+
+// rserver itself (or root) may report events on behalf of any user and
+// query the store; sessions may only report for the user they run as
+bool isPrivilegedPeer(const http::Request& request)
+{
+   int uid = request.remoteUid();
+   return uid == 0 ||
+          uid == static_cast<int>(core::system::user::currentUserIdentity().userId);
+}
+
+bool peerUsername(const http::Request& request,
+                  http::Response* pResponse,
+                  std::string* pUsername)
+{
+   if (request.headerValue(kMonitorSharedSecretHeader) !=
+       options().monitorSharedSecret())
+   {
+      pResponse->setError(http::status::Forbidden, "Forbidden");
+      return false;
+   }
+
+   core::system::user::User user;
+   Error error = core::system::user::userFromId(request.remoteUid(), &user);
+   if (error)
+   {
+      LOG_ERROR(error);
+      pResponse->setError(http::status::Forbidden, "Forbidden");
+      return false;
+   }
+
+   *pUsername = user.username;
+   return true;
+}
+
+bool parseBody(const http::Request& request,
+               http::Response* pResponse,
+               json::Object* pBodyJson)
+{
+   json::Value bodyJson;
+   if (!json::parse(request.body(), &bodyJson) ||
+       !json::isType<json::Object>(bodyJson))
+   {
+      pResponse->setError(http::status::BadRequest, "Invalid request body");
+      return false;
+   }
+
+   *pBodyJson = bodyJson.get_obj();
+   return true;
+}
+
+template <typename MetricType>
+void handleMetrics(const http::Request& request, http::Response* pResponse)
+{
+   std::string username;
+   if (!peerUsername(request, pResponse, &username))
+      return;
+
+   json::Object bodyJson;
+   if (!parseBody(request, pResponse, &bodyJson))
+      return;
+
+   int pid;
+   json::Array metricsJson;
+   Error error = json::readObject(bodyJson,
+                                  "pid", &pid,
+                                  "metrics", &metricsJson);
+   if (error)
+   {
+      pResponse->setError(http::status::BadRequest, error.summary());
+      return;
+   }
+
+   BOOST_FOREACH(const json::Value& metricJson, metricsJson)
+   {
+      if (!json::isType<json::Object>(metricJson))
+      {
+         pResponse->setError(http::status::BadRequest, "Invalid metric");
+         return;
+      }
+
+      MetricType metric;
+      Error error = metrics::metricFromJson(metricJson.get_obj(), &metric);
+      if (error)
+      {
+         pResponse->setError(http::status::BadRequest, error.summary());
+         return;
+      }
+
+      s_pStore->addMetric(username, pid, metric);
+   }
+
+   pResponse->setStatusCode(http::status::Ok);
+}
+
+void handleEvent(const http::Request& request, http::Response* pResponse)
+{
+   std::string username;
+   if (!peerUsername(request, pResponse, &username))
+      return;
+
+   json::Object eventJson;
+   if (!parseBody(request, pResponse, &eventJson))
+      return;
+
+   Event event;
+   Error error = eventFromJson(eventJson, &event);
+   if (error)
+   {
+      pResponse->setError(http::status::BadRequest, error.summary());
+      return;
+   }
+
+   // attribute events from sessions to the user they run as
+   if (!isPrivilegedPeer(request))
+   {
+      event = Event(event.scope(),
+                    event.id(),
+                    event.data(),
+                    username,
+                    event.pid(),
+                    event.timestamp());
+   }
+
+   s_pStore->addEvent(event);
+   pResponse->setStatusCode(http::status::Ok);
+}
+
+void handleQuery(const http::Request& request, http::Response* pResponse)
+{
+   if (!isPrivilegedPeer(request))
+   {
+      pResponse->setError(http::status::Forbidden, "Forbidden");
+      return;
+   }
+
+   int windowSeconds = request.queryParamValue("window", 3600);
+   std::string username = request.queryParamValue("user");
+   std::string samples = request.queryParamValue("samples");
+   bool includeSamples = samples == "1" || samples == "true";
+
+   json::Object resultJson = s_pStore->toJson(
+            boost::posix_time::seconds(std::max(windowSeconds, 0)),
+            username,
+            includeSamples);
+
+   pResponse->setNoCacheHeaders();
+   pResponse->setContentType("application/json");
+   pResponse->setBody(json::write(resultJson));
+}
+
+void handleTrace(const http::Request& request, http::Response* pResponse)
+{
+   if (!isPrivilegedPeer(request))
+   {
+      pResponse->setError(http::status::Forbidden, "Forbidden");
+      return;
+   }
+
+   std::ostringstream ostr;
+   core::trace::writeChromeTrace(ostr);
+
+   pResponse->setNoCacheHeaders();
+   pResponse->setContentType("application/json");
+   pResponse->setBody(ostr.str());
+}
+
+} // anonymous namespace
+
+Error initialize()
+{
+   // sessions report every monitor interval; forget any which have missed
+   // a few reports in a row
+   int intervalSeconds = std::max(options().monitorIntervalSeconds(), 60);
+   s_pStore.reset(new metrics::MetricsStore(
+                     std::max(options().monitorMetricsHistory(), 1),
+                     kMaxEvents,
+                     boost::posix_time::seconds(intervalSeconds * 3)));
+
+   // sessions run as other users, so everyone needs access to the socket
+   // (reports are authenticated with the monitor shared secret)
+   s_pServer.reset(new http::LocalStreamAsyncServer(
+                      "Monitor",
+                      std::string(),
+                      core::system::EveryoneReadWriteMode));
+
+   Error error = s_pServer->init(FilePath(kMonitorSocketPath));
+   if (error)
+      return error;
+
+   s_pServer->addBlockingHandler(kMonitorMetricsUri,
+                                 handleMetrics<metrics::Metric>);
+   s_pServer->addBlockingHandler(kMonitorMultiMetricsUri,
+                                 handleMetrics<metrics::MultiMetric>);
+   s_pServer->addBlockingHandler(kMonitorEventsUri, handleEvent);
+   s_pServer->addBlockingHandler(kMonitorQueryUri, handleQuery);
+   s_pServer->addBlockingHandler(kMonitorTraceUri, handleTrace);
+
+   return Success();
+}
+
+Error startup()
+{
+   return s_pServer->run();
+}
+
+} // namespace monitor_server
+} // namespace server
+} // namespace rstudio
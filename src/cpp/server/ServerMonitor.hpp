@@ -0,0 +1,50 @@
+/*
+ * ServerMonitor.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SERVER_MONITOR_HPP
+#define SERVER_MONITOR_HPP
+
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace server {
+namespace monitor_server {
+
+// Listens on the metrics socket, recording the metrics and events sent by
+// sessions (and by rserver itself) in an in-process store. The store can be
+// queried by root (or the server user) at kMonitorQueryUri, e.g.
+//
+//   curl --unix-socket <socket> "http://localhost/query?window=3600&user=jsmith"
+//
+// (window is in seconds; pass samples=1 to include each session's samples)
+//
+// rserver's own trace spans (see core/Trace.hpp) can be fetched in the same
+// way from kMonitorTraceUri, in Chrome trace event format
+
+// create the metrics socket (must be called while still privileged)
+core::Error initialize();
+
+// start serving requests
+core::Error startup();
+
+} // namespace monitor_server
+} // namespace server
+} // namespace rstudio
+
+#endif // SERVER_MONITOR_HPP
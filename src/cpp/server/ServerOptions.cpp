@@ -263,6 +263,12 @@ ProgramStatus Options::read(int argc,
       ("rsession-proxy-max-wait-secs",
         value<int>(&rsessionProxyMaxWaitSeconds_)->default_value(10),
          "max time to wait when proxying requests to rsession")
+      ("rsession-prelaunch-max",
+        value<int>(&rsessionPrelaunchMax_)->default_value(0),
+         "max sessions launched at sign-in and not yet in use (0 to disable)")
+      ("rsession-prelaunch-timeout-mins",
+        value<int>(&rsessionPrelaunchTimeoutMinutes_)->default_value(5),
+         "minutes before an unused pre-launched session is terminated")
       ("rsession-memory-limit-mb",
          value<int>(&dep.memoryLimitMb)->default_value(dep.memoryLimitMb),
          "rsession memory limit (mb) - DEPRECATED")
@@ -303,6 +309,15 @@ ProgramStatus Options::read(int argc,
       ("auth-pam-helper-path",
         value<std::string>(&authPamHelperPath_)->default_value("rserver-pam"),
        "path to PAM helper binary")
+      ("auth-pam-max-concurrent",
+        value<int>(&authPamMaxConcurrent_)->default_value(16),
+        "maximum number of PAM authentications to run at once")
+      ("auth-pam-timeout-seconds",
+        value<int>(&authPamTimeoutSeconds_)->default_value(30),
+        "seconds after which a PAM authentication is abandoned")
+      ("auth-pam-user-attempts-per-minute",
+        value<int>(&authPamUserAttemptsPerMinute_)->default_value(10),
+        "maximum number of sign-in attempts per user per minute")
       ("auth-pam-requires-priv",
         value<bool>(&dep.authPamRequiresPriv)->default_value(
                                                    dep.authPamRequiresPriv),
@@ -312,7 +327,10 @@ ProgramStatus Options::read(int argc,
    monitor.add_options()
       (kMonitorIntervalSeconds,
        value<int>(&monitorIntervalSeconds_)->default_value(300),
-       "monitoring interval");
+       "monitoring interval")
+      (kMonitorMetricsHistory,
+       value<int>(&monitorMetricsHistory_)->default_value(288),
+       "number of samples of each session metric to retain");
 
    // define program options
    FilePath defaultConfigPath("/etc/rstudio/rserver.conf");
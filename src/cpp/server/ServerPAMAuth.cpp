@@ -15,6 +15,11 @@
  */
 #include "ServerPAMAuth.hpp"
 
+#include <deque>
+#include <map>
+
+#include <boost/bind.hpp>
+
 #include <core/Error.hpp>
 #include <core/PeriodicCommand.hpp>
 #include <core/Thread.hpp>
@@ -39,8 +44,11 @@
 #include <server/auth/ServerSecureUriHandler.hpp>
 #include <server/auth/ServerAuthHandler.hpp>
 
+#include <server/ServerObject.hpp>
 #include <server/ServerOptions.hpp>
+#include <server/ServerProcessSupervisor.hpp>
 #include <server/ServerUriHandlers.hpp>
+#include <server/ServerSessionManager.hpp>
 #include <server/ServerSessionProxy.hpp>
 
 namespace rstudio {
@@ -310,9 +318,72 @@ void setSignInCookies(const core::http::Request& request,
    auth::csrf::setCSRFTokenCookie(request, expiry, "", pResponse);
 }
 
-void doSignIn(const http::Request& request,
-              http::Response* pResponse)
+void onPamLoginCompleted(boost::shared_ptr<http::AsyncConnection> pConnection,
+                         const std::string& username,
+                         const std::string& password,
+                         bool persist,
+                         std::string appUri,
+                         const Error& error,
+                         bool authenticated)
 {
+   const http::Request& request = pConnection->request();
+   http::Response* pResponse = &(pConnection->response());
+
+   if (error)
+   {
+      LOG_ERROR(error);
+      pResponse->setMovedTemporarily(
+            request,
+            applicationSignInURL(request,
+                                 appUri,
+                                 kErrorServer));
+   }
+   else if (authenticated && server::auth::validateUser(username))
+   {
+      if (appUri.size() > 0 && appUri[0] != '/')
+         appUri = "/" + appUri;
+
+      setSignInCookies(request, username, persist, pResponse);
+      pResponse->setMovedTemporarily(request, appUri);
+
+      // register login with monitor
+      using namespace monitor;
+      client().logEvent(Event(kAuthScope,
+                              kAuthLoginEvent,
+                              "",
+                              username));
+
+      onUserAuthenticated(username, password);
+
+      // start the user's session while the browser follows the redirect
+      // (no-op unless session pre-launching is enabled)
+      sessionManager().prelaunchSession(server::server()->ioService(),
+                                        r_util::SessionContext(username));
+   }
+   else
+   {
+      // register failed login with monitor
+      using namespace monitor;
+      client().logEvent(Event(kAuthScope,
+                              kAuthLoginFailedEvent,
+                              "",
+                              username));
+
+      pResponse->setMovedTemporarily(
+            request,
+            applicationSignInURL(request,
+                                 appUri,
+                                 kErrorInvalidLogin));
+   }
+
+   pConnection->writeResponse();
+}
+
+void doSignIn(boost::shared_ptr<http::AsyncConnection> pConnection)
+{
+   const http::Request& request = pConnection->request();
+   http::Response* pResponse = &(pConnection->response());
+
    std::string appUri = request.formFieldValue(kAppUri);
    if (appUri.empty())
       appUri = "/";
@@ -336,6 +407,7 @@ void doSignIn(const http::Request& request,
                applicationSignInURL(request,
                                     appUri,
                                     kErrorServer));
+         pConnection->writeResponse();
          return;
       }
 
@@ -348,6 +420,7 @@ void doSignIn(const http::Request& request,
                applicationSignInURL(request,
                                     appUri,
                                     kErrorServer));
+         pConnection->writeResponse();
          return;
       }
 
@@ -367,38 +440,18 @@ void doSignIn(const http::Request& request,
 
    onUserUnauthenticated(username);
 
-   if ( pamLogin(username, password) && server::auth::validateUser(username))
-   {
-      if (appUri.size() > 0 && appUri[0] != '/')
-         appUri = "/" + appUri;
-
-      setSignInCookies(request, username, persist, pResponse);
-      pResponse->setMovedTemporarily(request, appUri);
-
-      // register login with monitor
-      using namespace monitor;
-      client().logEvent(Event(kAuthScope,
-                              kAuthLoginEvent,
-                              "",
-                              username));
-
-      onUserAuthenticated(username, password);
-   }
-   else
-   {
-      // register failed login with monitor
-      using namespace monitor;
-      client().logEvent(Event(kAuthScope,
-                              kAuthLoginFailedEvent,
-                              "",
-                              username));
-
-      pResponse->setMovedTemporarily(
-            request,
-            applicationSignInURL(request,
-                                 appUri,
-                                 kErrorInvalidLogin));
-   }
+   // authenticate without tying up this thread (PAM can take several
+   // seconds, e.g. when it goes through Kerberos or LDAP)
+   pamLoginAsync(username,
+                 password,
+                 boost::bind(onPamLoginCompleted,
+                             pConnection,
+                             username,
+                             password,
+                             persist,
+                             appUri,
+                             _1,
+                             _2));
 }
 
 void signOut(const http::Request& request,
@@ -431,6 +484,168 @@ void signOut(const http::Request& request,
    pResponse->setMovedTemporarily(request, auth::handler::kSignIn);
 }
 
+// sign-ins waiting for a PAM helper to become available
+struct PendingLogin
+{
+   std::string username;
+   std::string password;
+   PamLoginCallback onCompleted;
+};
+
+// sign-ins beyond this many are turned away rather than queued
+const std::size_t kMaxPendingLogins = 1024;
+
+// mutex that protects the sign-in queue and attempt history
+boost::mutex s_loginMutex;
+std::deque<PendingLogin> s_pendingLogins;
+int s_activeLogins = 0;
+std::map<std::string, std::deque<boost::posix_time::ptime> > s_loginAttempts;
+
+void postLoginResult(const PamLoginCallback& onCompleted,
+                     const Error& error,
+                     bool authenticated)
+{
+   server::server()->ioService().post(
+            boost::bind(onCompleted, error, authenticated));
+}
+
+// record a sign-in attempt, returning false if the user has already made
+// as many attempts as they are allowed in the last minute (must be called
+// with s_loginMutex held)
+bool recordLoginAttempt(const std::string& username)
+{
+   using namespace boost::posix_time;
+   ptime now = microsec_clock::universal_time();
+   ptime cutoff = now - minutes(1);
+
+   // forget attempts which are more than a minute old (for all users, so
+   // that the history doesn't grow without bound)
+   typedef std::map<std::string, std::deque<ptime> >::iterator iterator;
+   for (iterator it = s_loginAttempts.begin(); it != s_loginAttempts.end(); )
+   {
+      std::deque<ptime>& attempts = it->second;
+      while (!attempts.empty() && attempts.front() <= cutoff)
+         attempts.pop_front();
+
+      if (attempts.empty())
+         s_loginAttempts.erase(it++);
+      else
+         ++it;
+   }
+
+   int maxAttempts = server::options().authPamUserAttemptsPerMinute();
+   if (maxAttempts <= 0)
+      return true;
+
+   std::deque<ptime>& attempts = s_loginAttempts[username];
+   if (attempts.size() >= static_cast<std::size_t>(maxAttempts))
+      return false;
+
+   attempts.push_back(now);
+   return true;
+}
+
+bool checkPamHelperDeadline(const boost::posix_time::ptime& deadline,
+                            boost::shared_ptr<bool> pTimedOut)
+{
+   if (boost::posix_time::microsec_clock::universal_time() < deadline)
+      return true;
+
+   // returning false terminates the helper
+   *pTimedOut = true;
+   return false;
+}
+
+void startPendingLogins();
+
+void onLoginFinished(const PamLoginCallback& onCompleted,
+                     const Error& error,
+                     bool authenticated)
+{
+   LOCK_MUTEX(s_loginMutex)
+   {
+      s_activeLogins--;
+      startPendingLogins();
+   }
+   END_LOCK_MUTEX
+
+   onCompleted(error, authenticated);
+}
+
+void onPamHelperCompleted(const std::string& username,
+                          const PamLoginCallback& onCompleted,
+                          boost::shared_ptr<bool> pTimedOut,
+                          const core::system::ProcessResult& result)
+{
+   Error error;
+   if (*pTimedOut)
+   {
+      error = systemError(boost::system::errc::timed_out, ERROR_LOCATION);
+      error.addProperty("description", "PAM authentication timed out");
+      error.addProperty("user", username);
+   }
+
+   // this is called by the process supervisor (with its lock held), so the
+   // queue is updated on an HTTP server thread instead
+   postLoginResult(boost::bind(onLoginFinished, onCompleted, _1, _2),
+                   error,
+                   !error && result.exitStatus == 0);
+}
+
+Error runPamHelper(const PendingLogin& login)
+{
+   // form args
+   std::vector<std::string> args;
+   args.push_back(login.username);
+
+   // options (assume priv after fork)
+   core::system::ProcessOptions options;
+   options.onAfterFork = assumeRootPriv;
+
+   // run pam helper (passing it the password), terminating it if it
+   // doesn't complete in time
+   boost::shared_ptr<bool> pTimedOut(new bool(false));
+   core::system::ProcessCallbacks cb = core::system::createProcessCallbacks(
+            login.password,
+            boost::bind(onPamHelperCompleted,
+                        login.username,
+                        login.onCompleted,
+                        pTimedOut,
+                        _1));
+
+   int timeoutSeconds = server::options().authPamTimeoutSeconds();
+   if (timeoutSeconds > 0)
+   {
+      boost::posix_time::ptime deadline =
+            boost::posix_time::microsec_clock::universal_time() +
+            boost::posix_time::seconds(timeoutSeconds);
+      cb.onContinue = boost::bind(checkPamHelperDeadline, deadline, pTimedOut);
+   }
+
+   return process_supervisor::runProgram(server::options().authPamHelperPath(),
+                                         args,
+                                         options,
+                                         cb);
+}
+
+// start as many waiting sign-ins as the concurrency limit allows (must be
+// called with s_loginMutex held)
+void startPendingLogins()
+{
+   int maxActive = std::max(server::options().authPamMaxConcurrent(), 1);
+   while (s_activeLogins < maxActive && !s_pendingLogins.empty())
+   {
+      PendingLogin login = s_pendingLogins.front();
+      s_pendingLogins.pop_front();
+
+      Error error = runPamHelper(login);
+      if (error)
+         postLoginResult(login.onCompleted, error, false);
+      else
+         s_activeLogins++;
+   }
+}
+
 } // anonymous namespace
 
 
@@ -477,6 +692,62 @@ bool pamLogin(const std::string& username, const std::string& password)
    return result.exitStatus == 0;
 }
 
+void pamLoginAsync(const std::string& username,
+                   const std::string& password,
+                   const PamLoginCallback& onCompleted)
+{
+   // get path to pam helper
+   FilePath pamHelperPath(server::options().authPamHelperPath());
+   if (!pamHelperPath.exists())
+   {
+      LOG_ERROR_MESSAGE("PAM helper binary does not exist at " +
+                        pamHelperPath.absolutePath());
+      postLoginResult(onCompleted, Success(), false);
+      return;
+   }
+
+   // don't try to login with an empty password (this hangs PAM as it waits for input)
+   if (password.empty())
+   {
+      LOG_WARNING_MESSAGE("No PAM password provided for user '" + username + "'; refusing login");
+      postLoginResult(onCompleted, Success(), false);
+      return;
+   }
+
+   LOCK_MUTEX(s_loginMutex)
+   {
+      if (!recordLoginAttempt(username))
+      {
+         Error error = systemError(
+                  boost::system::errc::resource_unavailable_try_again,
+                  ERROR_LOCATION);
+         error.addProperty("description", "Too many sign-in attempts");
+         error.addProperty("user", username);
+         postLoginResult(onCompleted, error, false);
+         return;
+      }
+
+      if (s_pendingLogins.size() >= kMaxPendingLogins)
+      {
+         Error error = systemError(
+                  boost::system::errc::resource_unavailable_try_again,
+                  ERROR_LOCATION);
+         error.addProperty("description", "Too many sign-ins in progress");
+         postLoginResult(onCompleted, error, false);
+         return;
+      }
+
+      PendingLogin login;
+      login.username = username;
+      login.password = password;
+      login.onCompleted = onCompleted;
+      s_pendingLogins.push_back(login);
+
+      startPendingLogins();
+   }
+   END_LOCK_MUTEX
+}
+
 Error initialize()
 {
    // register ourselves as the auth handler
@@ -493,7 +764,7 @@ Error initialize()
    auth::handler::registerHandler(pamHandler);
 
    // add pam-specific auth handlers
-   uri_handlers::addBlocking(kDoSignIn, doSignIn);
+   uri_handlers::add(kDoSignIn, doSignIn);
    uri_handlers::addBlocking(kPublicKey, publicKey);
 
    // initialize overlay
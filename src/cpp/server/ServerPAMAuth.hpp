@@ -18,6 +18,8 @@
 
 #include <string>
 
+#include <boost/function.hpp>
+
 namespace rstudio {
 namespace core {
    class Error;
@@ -30,6 +32,17 @@ namespace pam_auth {
    
 bool pamLogin(const std::string& username, const std::string& password);
 
+// called with whether the user was authenticated, or with an error if
+// authentication couldn't be completed (too many sign-ins are waiting, the
+// user has made too many attempts, or the PAM helper timed out)
+typedef boost::function<void(const core::Error&, bool)> PamLoginCallback;
+
+// authenticate without blocking the calling thread; the PAM helper is run by
+// a bounded pool and onCompleted is invoked on an HTTP server thread
+void pamLoginAsync(const std::string& username,
+                   const std::string& password,
+                   const PamLoginCallback& onCompleted);
+
 core::Error initialize();
 
 namespace overlay {
@@ -18,6 +18,7 @@
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 
+#include <core/PeriodicCommand.hpp>
 #include <core/SafeConvert.hpp>
 #include <core/system/PosixUser.hpp>
 #include <core/system/Environment.hpp>
@@ -26,11 +27,14 @@
 #include <session/SessionConstants.hpp>
 
 #include <server/ServerOptions.hpp>
+#include <server/ServerScheduler.hpp>
 
 #include <server/ServerErrorCategory.hpp>
 
 #include <server/auth/ServerValidateUser.hpp>
 
+#include <server_core/sessions/SessionLocalStreams.hpp>
+
 #include "ServerREnvironment.hpp"
 #include "server-config.h"
 
@@ -139,6 +143,10 @@ core::system::ProcessConfig sessionProcessConfig(
    // add monitor shared secret
    environment.push_back(std::make_pair(kMonitorSharedSecretEnvVar,
                                         options.monitorSharedSecret()));
+   core::system::setenv(&environment,
+                        kMonitorIntervalSecondsEnvVar,
+                        safe_convert::numberToString(
+                                 options.monitorIntervalSeconds()));
 
    // stamp the version number of the rserver process that is launching this session
    // the session should log an error if its version does not match, as that is
@@ -179,9 +187,11 @@ Error SessionManager::launchSession(boost::asio::io_service& ioService,
                                     const http::ErrorHandler& onError)
 {
    using namespace boost::posix_time;
+   PidType stalePrelaunchPid = 0;
    LOCK_MUTEX(launchesMutex_)
    {
-      // check whether we already have a launch pending
+      // check whether we already have a launch pending (pre-launches are
+      // recorded as pending launches too, so are subject to the same limit)
       LaunchMap::const_iterator pos = pendingLaunches_.find(context);
       if (pos != pendingLaunches_.end())
       {
@@ -200,6 +210,15 @@ Error SessionManager::launchSession(boost::asio::io_service& ioService,
                                 "user " + context.username +" (aborting wait)");
 
             pendingLaunches_.erase(context);
+
+            // a pre-launched session which still isn't serving requests
+            // has failed or hung, so terminate it in favor of this launch
+            PrelaunchMap::iterator it = prelaunches_.find(context);
+            if (it != prelaunches_.end())
+            {
+               stalePrelaunchPid = it->second.pid;
+               prelaunches_.erase(it);
+            }
          }
       }
 
@@ -208,6 +227,28 @@ Error SessionManager::launchSession(boost::asio::io_service& ioService,
    }
    END_LOCK_MUTEX
 
+   if (stalePrelaunchPid > 0)
+   {
+      Error error = core::system::terminateProcess(stalePrelaunchPid);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   // launch the session
+   Error error = sessionLaunchFunction_(ioService, launchProfile(context),
+                                        request, onLaunch, onError);
+   if (error)
+   {
+      removePendingLaunch(context);
+      return error;
+   }
+
+   return Success();
+}
+
+r_util::SessionLaunchProfile SessionManager::launchProfile(
+                                    const r_util::SessionContext& context)
+{
    // determine launch options
    r_util::SessionLaunchProfile profile;
    profile.context = context;
@@ -220,17 +261,128 @@ Error SessionManager::launchSession(boost::asio::io_service& ioService,
       f(&profile);
    }
 
-   // launch the session
-   Error error = sessionLaunchFunction_(ioService, profile, request, onLaunch, onError);
-   if (error)
+   return profile;
+}
+
+Error SessionManager::initialize()
+{
+   // periodically terminate pre-launched sessions that were never used
+   if (server::options().rsessionPrelaunchMax() > 0)
    {
-      removePendingLaunch(context);
-      return error;
+      scheduler::addCommand(
+         boost::shared_ptr<ScheduledCommand>(new PeriodicCommand(
+            boost::posix_time::seconds(30),
+            boost::bind(&SessionManager::reapPrelaunchedSessions, this),
+            false)));
    }
 
    return Success();
 }
 
+void SessionManager::prelaunchSession(boost::asio::io_service& ioService,
+                                      const r_util::SessionContext& context)
+{
+   int maxPrelaunches = server::options().rsessionPrelaunchMax();
+   if (maxPrelaunches <= 0)
+      return;
+
+   // don't pre-launch if the session is already running
+   std::string streamFile = r_util::sessionContextFile(context);
+   FilePath streamPath = server_core::sessions::local_streams::streamPath(streamFile);
+   if (streamPath.exists())
+      return;
+
+   Error error = server_core::sessions::local_streams::ensureStreamsDir();
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   LOCK_MUTEX(launchesMutex_)
+   {
+      // skip if a launch is already pending or we are at capacity
+      if (pendingLaunches_.find(context) != pendingLaunches_.end() ||
+          prelaunches_.size() >= static_cast<std::size_t>(maxPrelaunches))
+      {
+         return;
+      }
+
+      // record the launch; it is claimed by the first proxied response
+      // (see removePendingLaunch) or terminated when it times out
+      using namespace boost::posix_time;
+      ptime now = microsec_clock::universal_time();
+      pendingLaunches_[context] = now;
+      prelaunches_[context].launched = now;
+   }
+   END_LOCK_MUTEX
+
+   // launch with an empty request (there is no client connection yet)
+   http::Request request;
+   error = sessionLaunchFunction_(ioService,
+                                  launchProfile(context),
+                                  request,
+                                  http::ResponseHandler(),
+                                  boost::bind(&SessionManager::onPrelaunchError,
+                                              this,
+                                              context,
+                                              _1));
+   if (error)
+      onPrelaunchError(context, error);
+}
+
+void SessionManager::onPrelaunchError(const r_util::SessionContext& context,
+                                      const Error& error)
+{
+   LOG_ERROR(error);
+
+   // forget the pre-launch so that the next request launches the session
+   // (unless it has already been claimed by a launch for a request)
+   LOCK_MUTEX(launchesMutex_)
+   {
+      if (prelaunches_.erase(context) > 0)
+         pendingLaunches_.erase(context);
+   }
+   END_LOCK_MUTEX
+}
+
+bool SessionManager::reapPrelaunchedSessions()
+{
+   using namespace boost::posix_time;
+   ptime now = microsec_clock::universal_time();
+   time_duration timeout = minutes(server::options().rsessionPrelaunchTimeoutMinutes());
+
+   std::vector<PidType> expired;
+   LOCK_MUTEX(launchesMutex_)
+   {
+      for (PrelaunchMap::iterator it = prelaunches_.begin(); it != prelaunches_.end(); )
+      {
+         if (it->second.launched + timeout < now)
+         {
+            if (it->second.pid > 0)
+               expired.push_back(it->second.pid);
+            pendingLaunches_.erase(it->first);
+            prelaunches_.erase(it++);
+         }
+         else
+         {
+            ++it;
+         }
+      }
+   }
+   END_LOCK_MUTEX
+
+   // terminate outside the lock; the process tracker reaps the children
+   BOOST_FOREACH(PidType pid, expired)
+   {
+      Error error = core::system::terminateProcess(pid);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   return true;
+}
+
 namespace {
 
 boost::mutex s_configFilterMutex;
@@ -276,14 +428,44 @@ Error SessionManager::launchAndTrackSession(
       return error;
 
    // track it for subsequent reaping
-   processTracker_.addProcess(pid, boost::bind(onProcessExit,
-                                               profile.context.username,
+   processTracker_.addProcess(pid, boost::bind(&SessionManager::onSessionExit,
+                                               this,
+                                               profile.context,
                                                pid));
 
+   // note the pid of pre-launched sessions so they can be terminated if
+   // they are never used
+   LOCK_MUTEX(launchesMutex_)
+   {
+      PrelaunchMap::iterator it = prelaunches_.find(profile.context);
+      if (it != prelaunches_.end())
+         it->second.pid = pid;
+   }
+   END_LOCK_MUTEX
+
    // return success
    return Success();
 }
 
+void SessionManager::onSessionExit(const r_util::SessionContext& context,
+                                   PidType pid)
+{
+   onProcessExit(context.username, pid);
+
+   // a pre-launched session that exits before being used (e.g. failed to
+   // start) should not block subsequent launches
+   LOCK_MUTEX(launchesMutex_)
+   {
+      PrelaunchMap::iterator it = prelaunches_.find(context);
+      if (it != prelaunches_.end() && it->second.pid == pid)
+      {
+         prelaunches_.erase(it);
+         pendingLaunches_.erase(context);
+      }
+   }
+   END_LOCK_MUTEX
+}
+
 void SessionManager::setSessionLaunchFunction(
                            const SessionLaunchFunction& launchFunction)
 {
@@ -301,6 +483,7 @@ void SessionManager::removePendingLaunch(const r_util::SessionContext& context)
    LOCK_MUTEX(launchesMutex_)
    {
       pendingLaunches_.erase(context);
+      prelaunches_.erase(context);
    }
    END_LOCK_MUTEX
 }
@@ -34,6 +34,7 @@
 #include <core/BoostErrors.hpp>
 #include <core/Log.hpp>
 #include <core/Thread.hpp>
+#include <core/Trace.hpp>
 #include <core/WaitUtils.hpp>
 #include <core/RegexUtils.hpp>
 
@@ -180,18 +181,39 @@ bool sessionContextForRequest(
    }
 }
 
+// called once the session's response has been read, whether it was
+// buffered or streamed through a chunk proxy
+void onProxyResponseRead(const r_util::SessionContext& context,
+                         boost::shared_ptr<core::trace::Span> pRequestSpan)
+{
+   pRequestSpan->end();
+
+   // if there was a launch pending then remove it
+   sessionManager().removePendingLaunch(context);
+}
+
 void handleProxyResponse(
       boost::shared_ptr<core::http::AsyncConnection> ptrConnection,
       const r_util::SessionContext& context,
+      boost::shared_ptr<core::trace::Span> pRequestSpan,
       const http::Response& response)
 {
-   // if there was a launch pending then remove it
-   sessionManager().removePendingLaunch(context);
+   onProxyResponseRead(context, pRequestSpan);
+
+   TRACE_SPAN("proxy.response");
 
    // write the response
    ptrConnection->writeResponse(response);
 }
 
+void handleProxyError(boost::shared_ptr<core::trace::Span> pRequestSpan,
+                      const http::ErrorHandler& errorHandler,
+                      const Error& error)
+{
+   pRequestSpan->end();
+   errorHandler(error);
+}
+
 void rewriteLocalhostAddressHeader(const std::string& headerName,
                                    const http::Request& originalRequest,
                                    const std::string& port,
@@ -559,6 +581,12 @@ void proxyRequest(
       const http::ErrorHandler& errorHandler,
       const http::ConnectionRetryProfile& connectionRetryProfile)
 {
+   // time the request through to its response (or error)
+   boost::shared_ptr<core::trace::Span> pRequestSpan(
+                                 new core::trace::Span("proxy.request"));
+   if (pRequestSpan->active())
+      pRequestSpan->setDetail(ptrConnection->request().uri());
+
    // apply optional proxy filter
    if (applyProxyFilter(ptrConnection, context))
       return;
@@ -628,11 +656,28 @@ void proxyRequest(
    // assign request
    pClient->request().assign(*pRequest);
 
+   // relay the rest of the body of streamed requests (e.g. large uploads)
+   // as it arrives; the filters above only see the start of such bodies.
+   // for other requests the body has already been read, so this just ends it
+   pClient->setRequestBodyReader(boost::bind(
+                                    &http::AsyncConnection::readRequestBody,
+                                    ptrConnection,
+                                    _1));
+
    // proxy the request
    boost::shared_ptr<http::ChunkProxy> chunkProxy(new http::ChunkProxy(ptrConnection));
-   chunkProxy->proxy(pClient);
-   pClient->execute(boost::bind(handleProxyResponse, ptrConnection, context, _1),
-                    errorHandler);
+   chunkProxy->proxy(pClient, boost::bind(onProxyResponseRead,
+                                          context,
+                                          pRequestSpan));
+   pClient->execute(boost::bind(handleProxyResponse,
+                                ptrConnection,
+                                context,
+                                pRequestSpan,
+                                _1),
+                    boost::bind(handleProxyError,
+                                pRequestSpan,
+                                errorHandler,
+                                _1));
 }
 
 // function used to periodically validate that the user is valid (has an
@@ -179,6 +179,21 @@ public:
       return std::string(authPamHelperPath_.c_str());
    }
 
+   int authPamMaxConcurrent() const
+   {
+      return authPamMaxConcurrent_;
+   }
+
+   int authPamTimeoutSeconds() const
+   {
+      return authPamTimeoutSeconds_;
+   }
+
+   int authPamUserAttemptsPerMinute() const
+   {
+      return authPamUserAttemptsPerMinute_;
+   }
+
    // rsession
    std::string rsessionWhichR() const
    {
@@ -210,6 +225,16 @@ public:
       return rsessionProxyMaxWaitSeconds_;
    }
 
+   int rsessionPrelaunchMax()
+   {
+      return rsessionPrelaunchMax_;
+   }
+
+   int rsessionPrelaunchTimeoutMinutes()
+   {
+      return rsessionPrelaunchTimeoutMinutes_;
+   }
+
    std::string monitorSharedSecret() const
    {
       return std::string(monitorSharedSecret_.c_str());
@@ -220,6 +245,11 @@ public:
       return monitorIntervalSeconds_;
    }
 
+   int monitorMetricsHistory() const
+   {
+      return monitorMetricsHistory_;
+   }
+
    std::string gwtPrefix() const;
 
    core::FilePath secureCookieKeyFile() const
@@ -290,14 +320,20 @@ private:
    std::string authRequiredUserGroup_;
    unsigned int authMinimumUserId_;
    std::string authPamHelperPath_;
+   int authPamMaxConcurrent_;
+   int authPamTimeoutSeconds_;
+   int authPamUserAttemptsPerMinute_;
    std::string rsessionWhichR_;
    std::string rsessionPath_;
    std::string rldpathPath_;
    std::string rsessionConfigFile_;
    std::string rsessionLdLibraryPath_;
    int rsessionProxyMaxWaitSeconds_;
+   int rsessionPrelaunchMax_;
+   int rsessionPrelaunchTimeoutMinutes_;
    std::string monitorSharedSecret_;
    int monitorIntervalSeconds_;
+   int monitorMetricsHistory_;
    std::string secureCookieKeyFile_;
    std::map<std::string,std::string> overlayOptions_;
 };
@@ -67,6 +67,16 @@ public:
                              const core::http::ErrorHandler& onError = core::http::ErrorHandler());
    void removePendingLaunch(const core::r_util::SessionContext& context);
 
+   // pre-launching: sessions may be launched ahead of their first use (e.g.
+   // at sign-in) so that R and module initialization are already underway
+   // (or complete) by the time the client connects. at most
+   // rsession-prelaunch-max such sessions are outstanding at once, and
+   // sessions that are never used are terminated after
+   // rsession-prelaunch-timeout-mins
+   core::Error initialize();
+   void prelaunchSession(boost::asio::io_service& ioService,
+                         const core::r_util::SessionContext& context);
+
    // set a custom session launcher
    typedef boost::function<core::Error(
                            boost::asio::io_service&,
@@ -87,6 +97,20 @@ public:
    void notifySIGCHLD();
 
 private:
+   // build the launch profile for a session
+   core::r_util::SessionLaunchProfile launchProfile(
+                        const core::r_util::SessionContext& context);
+
+   // terminate pre-launched sessions that were never used
+   bool reapPrelaunchedSessions();
+
+   // notification that a pre-launch failed (possibly asynchronously)
+   void onPrelaunchError(const core::r_util::SessionContext& context,
+                         const core::Error& error);
+
+   // notification that a tracked session process exited
+   void onSessionExit(const core::r_util::SessionContext& context, PidType pid);
+
    // default session launcher -- runs the process then uses the
    // ChildProcessTracker to track it's pid for later reaping
    core::Error launchAndTrackSession(
@@ -100,6 +124,16 @@ private:
                     boost::posix_time::ptime> LaunchMap;
    LaunchMap pendingLaunches_;
 
+   // pre-launched sessions that have not yet served a request
+   struct Prelaunch
+   {
+      Prelaunch() : pid(0) {}
+      boost::posix_time::ptime launched;
+      PidType pid;
+   };
+   typedef std::map<core::r_util::SessionContext, Prelaunch> PrelaunchMap;
+   PrelaunchMap prelaunches_;
+
    // session launch function
    SessionLaunchFunction sessionLaunchFunction_;
 
@@ -34,6 +34,12 @@ void add(const std::string& prefix,
 void addProxyHandler(const std::string& prefix,
                      const core::http::AsyncUriHandlerFunction& handler);
 
+// add streaming handler
+// streaming handlers are passed requests with large bodies once their
+// headers are read, and read the rest of the body themselves
+void addStreaming(const std::string& prefix,
+                  const core::http::AsyncUriHandlerFunction& handler);
+
 // add blocking uri handler
 void addBlocking(const std::string& prefix,
                  const core::http::UriHandlerFunction& handler);
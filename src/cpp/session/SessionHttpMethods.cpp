@@ -38,6 +38,7 @@
 #include <core/system/Crypto.hpp>
 
 #include <core/text/TemplateFilter.hpp>
+#include <core/Trace.hpp>
 
 #include <r/RExec.hpp>
 #include <r/session/RSession.hpp>
@@ -165,7 +166,18 @@ bool isMethod(boost::shared_ptr<HttpConnection> ptrConnection,
 Error startHttpConnectionListener()
 {
    initializeHttpConnectionListener();
-   Error error = httpConnectionListener().start();
+
+   // spool large uploads into the session's scratch directory (the system
+   // temp directory is often memory backed)
+   FilePath uploadSpoolPath =
+         module_context::sessionScratchPath().childPath("uploads");
+   Error error = uploadSpoolPath.ensureDirectory();
+   if (error)
+      LOG_ERROR(error);
+   else
+      httpConnectionListener().setUploadSpoolPath(uploadSpoolPath);
+
+   error = httpConnectionListener().start();
    if (error)
       return error;
 
@@ -562,6 +574,8 @@ void handleConnection(boost::shared_ptr<HttpConnection> ptrConnection,
    // check for a uri handler registered by a module
    const core::http::Request& request = ptrConnection->request();
    std::string uri = request.uri();
+   TRACE_SPAN_DETAIL("session.handleConnection", uri);
+
    core::http::UriAsyncHandlerFunction uriHandler = 
      uri_handlers::handlers().handlerFor(uri);
 
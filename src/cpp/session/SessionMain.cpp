@@ -52,6 +52,7 @@
 #include <core/Scope.hpp>
 #include <core/Settings.hpp>
 #include <core/Thread.hpp>
+#include <core/Trace.hpp>
 #include <core/Log.hpp>
 #include <core/LogWriter.hpp>
 #include <core/system/System.hpp>
@@ -134,6 +135,7 @@
 #include "modules/SessionDirty.hpp"
 #include "modules/SessionWorkbench.hpp"
 #include "modules/SessionHelp.hpp"
+#include "modules/SessionHelpIndex.hpp"
 #include "modules/SessionPlots.hpp"
 #include "modules/SessionPath.hpp"
 #include "modules/SessionPackages.hpp"
@@ -180,6 +182,7 @@
 #include "modules/SessionRAddins.hpp"
 #include "modules/mathjax/SessionMathJax.hpp"
 #include "modules/SessionLibPathsIndexer.hpp"
+#include "modules/SessionMetrics.hpp"
 #include "modules/SessionObjectExplorer.hpp"
 #include "modules/SessionReticulate.hpp"
 
@@ -351,6 +354,20 @@ Error ping(const core::json::JsonRpcRequest& request,
    return Success();
 }
 
+Error exportTrace(const core::json::JsonRpcRequest& request,
+                  json::JsonRpcResponse* pResponse)
+{
+   // write the spans recorded so far to a temp file; the file can be
+   // loaded into chrome://tracing (or any Chrome trace viewer)
+   FilePath traceFile = module_context::tempFile("rsession-trace-", "json");
+   Error error = core::trace::writeChromeTrace(traceFile);
+   if (error)
+      return error;
+
+   pResponse->setResult(traceFile.absolutePath());
+   return Success();
+}
+
 Error startClientEventService()
 {
    return clientEventService().start(rsession::persistentState().activeClientId());
@@ -468,6 +485,7 @@ Error rInit(const rstudio::r::session::RInitInfo& rInitInfo)
       (bind(registerRpcMethod, kConsoleInput, bufferConsoleInput))
       (bind(registerRpcMethod, "suspend_for_restart", suspendForRestart))
       (bind(registerRpcMethod, "ping", ping))
+      (bind(registerRpcMethod, "export_trace", exportTrace))
 
       // signal handlers
       (registerSignalHandlers)
@@ -520,6 +538,7 @@ Error rInit(const rstudio::r::session::RInitInfo& rInitInfo)
       (modules::workbench::initialize)
       (modules::data::initialize)
       (modules::help::initialize)
+      (modules::help_index::initialize)
       (modules::presentation::initialize)
       (modules::preview::initialize)
       (modules::plots::initialize)
@@ -560,6 +579,7 @@ Error rInit(const rstudio::r::session::RInitInfo& rInitInfo)
       (modules::mathjax::initialize)
       (modules::rstudioapi::initialize)
       (modules::libpaths::initialize)
+      (modules::metrics::initialize)
       (modules::explorer::initialize)
       (modules::ask_secret::initialize)
       (modules::reticulate::initialize)
@@ -1152,6 +1172,9 @@ void rCleanup(bool terminatedNormally)
       // fire shutdown event to modules
       module_context::events().onShutdown(terminatedNormally);
 
+      // write any deferred persistent state
+      rsession::persistentState().settings().flush();
+
       // destroy session if requested
       if (s_destroySession)
       {
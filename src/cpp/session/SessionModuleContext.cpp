@@ -681,7 +681,9 @@ void onSuspended(const r::session::RSuspendOptions& options,
    pPersistentState->beginUpdate();
    s_suspendHandlers.suspend(options, pPersistentState);
    pPersistentState->endUpdate();
-   
+
+   // the process is about to exit so write deferred changes now
+   pPersistentState->flush();
 }
 
 void onResumed(const Settings& persistentState)
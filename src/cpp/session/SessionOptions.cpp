@@ -89,6 +89,10 @@ core::ProgramStatus Options::read(int argc, char * const argv[], std::ostream& o
    monitorSharedSecret_ = core::system::getenv(kMonitorSharedSecretEnvVar);
    core::system::unsetenv(kMonitorSharedSecretEnvVar);
 
+   // get the monitoring interval (metrics aren't reported if there is none)
+   monitorIntervalSeconds_ = safe_convert::stringTo<int>(
+            core::system::getenv(kMonitorIntervalSecondsEnvVar), 0);
+
    // compute the resource path
    Error error = core::system::installPath("..", argv[0], &resourcePath_);
    if (error)
@@ -15,6 +15,8 @@
 
 #include <session/SessionPersistentState.hpp>
 
+#include <boost/bind.hpp>
+
 #include <core/Log.hpp>
 #include <core/Error.hpp>
 #include <core/FilePath.hpp>
@@ -38,6 +40,14 @@ namespace session {
 namespace {
 const char * const kActiveClientId = "active-client-id";
 const char * const kAbend = "abend";
+
+void scheduleFlush(Settings* pSettings)
+{
+   module_context::scheduleDelayedWork(
+            boost::posix_time::seconds(1),
+            boost::bind(&Settings::flush, pSettings),
+            false);
+}
 }
    
 PersistentState& persistentState()
@@ -62,6 +72,11 @@ Error PersistentState::initialize()
    if (error)
       return error;
 
+   // state changes tend to arrive in bursts so coalesce their writes (the
+   // session settings below hold the abend flag and active client id, which
+   // need to be on disk as soon as they change, so are written immediately)
+   settings_.setDeferredWrites(boost::bind(scheduleFlush, &settings_));
+
    // session settings
    scratchPath = module_context::sessionScratchPath();
    statePath = scratchPath.complete("session-persistent-state");
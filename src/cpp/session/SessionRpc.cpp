@@ -19,10 +19,13 @@
 #include "SessionHttpMethods.hpp"
 #include "SessionClientEventQueue.hpp"
 
+#include "modules/SessionMetrics.hpp"
+
 #include <core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 #include <core/Exec.hpp>
 #include <core/Log.hpp>
+#include <core/Trace.hpp>
 
 #include <r/RExec.hpp>
 #include <r/RSexp.hpp>
@@ -69,6 +72,11 @@ void endHandleRpcRequestDirect(boost::shared_ptr<HttpConnection> ptrConnection,
       // send the response
       ptrConnection->sendJsonRpcResponse(*pJsonRpcResponse);
 
+      // note how long it took (reported with the session's metrics)
+      modules::metrics::recordRpcLatency(
+            boost::posix_time::microsec_clock::universal_time() -
+            executeStartTime);
+
       // run after response if we have one (then detect changes again)
       if (pJsonRpcResponse->hasAfterResponse())
       {
@@ -256,6 +264,8 @@ void handleRpcRequest(const core::json::JsonRpcRequest& request,
                       boost::shared_ptr<HttpConnection> ptrConnection,
                       http_methods::ConnectionType connectionType)
 {
+   TRACE_SPAN_DETAIL("session.rpc", request.method);
+
    // record the time just prior to execution of the event
    // (so we can determine if any events were added during execution)
    using namespace boost::posix_time; 
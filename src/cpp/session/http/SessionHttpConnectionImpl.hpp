@@ -58,9 +58,13 @@ public:
 
 public:
    HttpConnectionImpl(boost::asio::io_service& ioService,
+                      const core::FilePath& uploadSpoolPath,
                       const Handler& handler)
       : socket_(ioService), handler_(handler)
    {
+      // write large uploads to disk as they arrive rather than holding
+      // the entire request in memory
+      requestParser_.setFormSpoolThreshold(1024 * 1024, uploadSpoolPath);
    }
 
    virtual ~HttpConnectionImpl()
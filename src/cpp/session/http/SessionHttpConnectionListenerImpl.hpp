@@ -106,6 +106,11 @@ public:
       }
    }
 
+   virtual void setUploadSpoolPath(const core::FilePath& spoolPath)
+   {
+      uploadSpoolPath_ = spoolPath;
+   }
+
    virtual void stop()
    {
       // don't stop if we never started
@@ -179,6 +184,7 @@ private:
       // create the connection
       ptrNextConnection_.reset( new HttpConnectionImpl<ProtocolType>(
             ioService(),
+            uploadSpoolPath_,
             boost::bind(
                  &HttpConnectionListenerImpl<ProtocolType>::enqueConnection,
                  this,
@@ -274,6 +280,9 @@ private:
       if (connection::checkForInterrupt(ptrHttpConnection))
          return;
 
+      if (connection::checkForCachedHelp(ptrHttpConnection))
+         return;
+
       // place the connection on the correct queue
       if (connection::isGetEvents(ptrHttpConnection))
          eventsConnectionQueue_.enqueConnection(ptrHttpConnection);
@@ -289,6 +298,9 @@ private:
    // next connection
    boost::shared_ptr<HttpConnectionImpl<ProtocolType> > ptrNextConnection_;
 
+   // directory into which large uploads are spooled
+   core::FilePath uploadSpoolPath_;
+
    // connection queues
    HttpConnectionQueue mainConnectionQueue_;
    HttpConnectionQueue eventsConnectionQueue_;
@@ -39,6 +39,8 @@
 #include <session/SessionOptions.hpp>
 #include <session/projects/ProjectsSettings.hpp>
 
+#include "../modules/SessionHelp.hpp"
+
 namespace rstudio {
 namespace session {
 
@@ -255,6 +257,21 @@ bool checkForInterrupt(boost::shared_ptr<HttpConnection> ptrConnection)
    return true;
 }
 
+bool checkForCachedHelp(boost::shared_ptr<HttpConnection> ptrConnection)
+{
+   // help pages which have already been rendered can be served without
+   // waiting on R (which may be busy running a long computation)
+   core::http::Response response;
+   if (!modules::help::handleCachedHelpRequest(ptrConnection->request(),
+                                               &response))
+   {
+      return false;
+   }
+
+   ptrConnection->sendResponse(response);
+   return true;
+}
+
 bool authenticate(boost::shared_ptr<HttpConnection> ptrConnection,
                   const std::string& secret)
 {
@@ -27,6 +27,7 @@
 
 #include <core/Log.hpp>
 #include <core/Error.hpp>
+#include <core/FilePath.hpp>
 #include <core/Thread.hpp>
 
 #include <core/http/Request.hpp>
@@ -63,8 +64,8 @@ class NamedPipeHttpConnection : public HttpConnection,
                                 boost::noncopyable
 {
 public:
-   explicit NamedPipeHttpConnection(HANDLE hPipe)
-      : hPipe_(hPipe)
+   NamedPipeHttpConnection(HANDLE hPipe, const FilePath& uploadSpoolPath)
+      : hPipe_(hPipe), uploadSpoolPath_(uploadSpoolPath)
    {
    }
 
@@ -79,7 +80,10 @@ public:
 
    bool readRequest()
    {
+      // write large uploads to disk as they arrive rather than holding
+      // the entire request in memory
       core::http::RequestParser parser;
+      parser.setFormSpoolThreshold(1024 * 1024, uploadSpoolPath_);
       CHAR buff[kReadBufferSize];
       DWORD bytesRead;
 
@@ -219,6 +223,7 @@ public:
 
 private:
    HANDLE hPipe_;
+   FilePath uploadSpoolPath_;
    core::http::Request request_;
    std::string requestId_;
 };
@@ -250,6 +255,11 @@ public:
 
    }
 
+   virtual void setUploadSpoolPath(const FilePath& spoolPath)
+   {
+      uploadSpoolPath_ = spoolPath;
+   }
+
    // connection queues
    virtual HttpConnectionQueue& mainConnectionQueue()
    {
@@ -321,7 +331,8 @@ private:
             {
                // create connection
                boost::shared_ptr<NamedPipeHttpConnection> ptrPipeConnection(
-                                         new NamedPipeHttpConnection(hPipe));
+                                         new NamedPipeHttpConnection(
+                                                   hPipe, uploadSpoolPath_));
 
                // if we can successfully read a request then enque it
                if (ptrPipeConnection->readRequest())
@@ -375,6 +386,9 @@ private:
       if (connection::checkForInterrupt(ptrHttpConnection))
          return;
 
+      if (connection::checkForCachedHelp(ptrHttpConnection))
+         return;
+
       // place the connection on the correct queue
       if (connection::isGetEvents(ptrHttpConnection))
          eventsConnectionQueue_.enqueConnection(ptrHttpConnection);
@@ -497,6 +511,7 @@ private:
 private:
    std::string pipeName_;
    std::string secret_;
+   FilePath uploadSpoolPath_;
    HttpConnectionQueue mainConnectionQueue_;
    HttpConnectionQueue eventsConnectionQueue_;
 };
@@ -73,6 +73,7 @@
 namespace rstudio {
 namespace core {
 	class Error;
+	class FilePath;
 }
 }
 
@@ -96,6 +97,10 @@ public:
 	virtual core::Error start() = 0;
    virtual void stop() = 0;
 
+   // directory into which large uploads are spooled as they're received
+   // (must be set before the listener is started)
+   virtual void setUploadSpoolPath(const core::FilePath& spoolPath) = 0;
+
    // connection queues
 	virtual HttpConnectionQueue& mainConnectionQueue() = 0;
 	virtual HttpConnectionQueue& eventsConnectionQueue() = 0;
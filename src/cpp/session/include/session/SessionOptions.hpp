@@ -518,6 +518,11 @@ public:
       return monitorSharedSecret_.c_str();
    }
 
+   int monitorIntervalSeconds() const
+   {
+      return monitorIntervalSeconds_;
+   }
+
    bool standalone() const
    {
       return standalone_;
@@ -737,6 +742,7 @@ private:
 
    // monitor
    std::string monitorSharedSecret_;
+   int monitorIntervalSeconds_;
 
    // connect
    std::string defaultRSConnectServer_;
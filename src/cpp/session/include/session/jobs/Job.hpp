@@ -17,8 +17,11 @@
 #define SESSION_JOBS_JOB_HPP
 
 #include <string>
+#include <iosfwd>
 #include <core/json/Json.hpp>
 #include <r/RSexp.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 namespace rstudio {
@@ -148,6 +151,15 @@ public:
 private:
    core::FilePath jobCacheFolder();
    core::FilePath outputCacheFile();
+   core::FilePath outputIndexFile();
+
+   // persistent output log; the log is newline-delimited JSON and the index
+   // holds the byte offset at which each line begins, so that output can be
+   // replayed from any position without re-reading the whole log
+   core::Error openOutputLog();
+   void closeOutputLog();
+   core::Error rebuildOutputIndex();
+   core::json::Array readOutput(std::istream& is, int skip);
 
    std::string id_;
    std::string name_;
@@ -173,6 +185,10 @@ private:
    r::sexp::PreservedSEXP actions_;
 
    std::vector<std::string> tags_;
+
+   boost::shared_ptr<std::ostream> pOutputStream_;
+   boost::shared_ptr<std::ostream> pIndexStream_;
+   boost::uint64_t outputBytes_;
 };
 
 
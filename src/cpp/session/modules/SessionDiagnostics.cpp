@@ -24,12 +24,17 @@
 #include "SessionAsyncPackageInformation.hpp"
 #include "SessionRParser.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <set>
 
 #include <core/Debug.hpp>
 #include <core/Exec.hpp>
 #include <core/Error.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
+#include <core/Thread.hpp>
 #include <core/YamlUtil.hpp>
 
 #include <session/SessionRUtil.hpp>
@@ -42,7 +47,10 @@
 
 #include <boost/shared_ptr.hpp>
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/enable_shared_from_this.hpp>
 #include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/range/adaptor/map.hpp>
 
 #include <r/RSexp.hpp>
@@ -64,6 +72,7 @@ namespace diagnostics {
 using namespace core;
 using namespace core::r_util;
 using namespace core::r_util::token_utils;
+using namespace core::r_util::token_cursor;
 using namespace core::collection;
 using namespace rparser;
 
@@ -405,7 +414,7 @@ void addTestPackageSymbols(std::set<std::string>* pSymbols)
 
 Error getAllAvailableRSymbols(const FilePath& filePath,
                               const std::string& documentId,
-                              const ParseResults& results,
+                              const std::set<std::string>& globals,
                               std::set<std::string>* pSymbols)
 {
    // If this file lies within the current project, then
@@ -459,7 +468,7 @@ Error getAllAvailableRSymbols(const FilePath& filePath,
       registry.fillNamespaceSymbols("shiny", pSymbols, false);
    }
    
-   pSymbols->insert(results.globals().begin(), results.globals().end());
+   pSymbols->insert(globals.begin(), globals.end());
    
    return error;
       
@@ -478,7 +487,7 @@ void checkNoDefinitionInScope(const FilePath& origin,
    // or symbols that would otherwise be made available at runtime (e.g.
    // package imports)
    std::set<std::string> objects;
-   Error error = getAllAvailableRSymbols(origin, documentId, results, &objects);
+   Error error = getAllAvailableRSymbols(origin, documentId, results.globals(), &objects);
    if (error)
    {
       LOG_ERROR(error);
@@ -632,14 +641,8 @@ void setFileLocalParseOptions(const std::wstring& rCode,
    applyOptions(options, pOptions);
 }
 
-} // end anonymous namespace
-
-ParseResults parse(const std::wstring& rCode,
-                   const FilePath& origin,
-                   const std::string& documentId = std::string(),
-                   bool isExplicit = false)
+ParseOptions diagnosticsParseOptions(bool isExplicit)
 {
-   ParseResults results;
    ParseOptions options;
    
    options.setLintRFunctions(
@@ -660,12 +663,17 @@ ParseResults parse(const std::wstring& rCode,
    options.setRecordStyleLint(
             userSettings().enableStyleDiagnostics());
    
-   bool noLint = false;
-   setFileLocalParseOptions(rCode, &options, &noLint);
-   if (noLint)
-      return ParseResults();
-   
-   results = rparser::parse(origin, rCode, options);
+   return options;
+}
+
+} // end anonymous namespace
+
+ParseResults lintDocument(const std::wstring& rCode,
+                          const FilePath& origin,
+                          const std::string& documentId,
+                          const ParseOptions& options)
+{
+   ParseResults results = rparser::parse(origin, rCode, options);
    
    ParseNode* pRoot = results.parseTree();
    if (!pRoot)
@@ -693,6 +701,21 @@ ParseResults parse(const std::wstring& rCode,
    return results;
 }
 
+ParseResults parse(const std::wstring& rCode,
+                   const FilePath& origin,
+                   const std::string& documentId = std::string(),
+                   bool isExplicit = false)
+{
+   ParseOptions options = diagnosticsParseOptions(isExplicit);
+   
+   bool noLint = false;
+   setFileLocalParseOptions(rCode, &options, &noLint);
+   if (noLint)
+      return ParseResults();
+   
+   return lintDocument(rCode, origin, documentId, options);
+}
+
 ParseResults parse(const std::string& rCode,
                    const FilePath& origin,
                    const std::string& documentId)
@@ -700,6 +723,179 @@ ParseResults parse(const std::string& rCode,
    return parse(string_utils::utf8ToWide(rCode), origin, documentId);
 }
 
+ParseResults lintDocument(const std::string& rCode,
+                          const FilePath& origin,
+                          const ParseOptions& options)
+{
+   return lintDocument(string_utils::utf8ToWide(rCode), origin, std::string(), options);
+}
+
+namespace {
+
+bool isIdentifierCharacter(char ch)
+{
+   // bytes of multibyte UTF-8 characters are treated as identifier
+   // characters; they never collide with the ASCII punctuation we scan for
+   return std::isalnum(static_cast<unsigned char>(ch)) ||
+          ch == '.' || ch == '_' ||
+          static_cast<unsigned char>(ch) >= 0x80;
+}
+
+// operators which, when ending a line, continue the expression onto the next
+bool isContinuationOperator(char ch)
+{
+   return std::strchr("+-*/^<>=!&|~?:$@,%", ch) != NULL;
+}
+
+// keywords which, when followed by a parenthesized list, expect an
+// expression (which may begin on the next line)
+bool isHeaderKeyword(const std::string& word)
+{
+   return word == "function" || word == "if" || word == "for" || word == "while";
+}
+
+bool lineBeginsWithElse(const std::string& rCode, std::size_t offset)
+{
+   std::size_t n = rCode.size();
+   while (offset < n && (rCode[offset] == ' ' || rCode[offset] == '\t' || rCode[offset] == '\r'))
+      ++offset;
+   
+   return rCode.compare(offset, 4, "else") == 0 &&
+          (offset + 4 == n || !isIdentifierCharacter(rCode[offset + 4]));
+}
+
+} // anonymous namespace
+
+// split code into regions at line ends where R would end a top-level
+// expression: outside of any string or bracket, after a token which can
+// complete an expression, and not followed by an 'else'. this is a
+// character level scan (no tokens are produced) so it's cheap enough to
+// run over a whole document on every lint. splitting errs on the side of
+// larger regions; code that doesn't parse (e.g. an unclosed bracket)
+// simply extends its region to the end of the document
+std::vector<TopLevelRegion> splitTopLevelRegions(const std::string& rCode)
+{
+   std::vector<TopLevelRegion> regions;
+   
+   std::size_t regionStart = 0;
+   std::size_t regionRow = 0;
+   std::size_t row = 0;
+   
+   int depth = 0;
+   char quote = 0;
+   bool hasCode = false;
+   bool continues = false;
+   bool inHeader = false;
+   char lastChar = 0;
+   std::string lastWord;
+   
+   std::size_t n = rCode.size();
+   for (std::size_t i = 0; i < n; ++i)
+   {
+      char ch = rCode[i];
+      
+      if (quote)
+      {
+         if (ch == '\\')
+            ++i;
+         else if (ch == quote)
+            quote = 0;
+         else if (ch == '\n')
+            ++row;
+         continue;
+      }
+      
+      if (ch == '\n')
+      {
+         ++row;
+         if (depth == 0 && hasCode && !continues &&
+             !lineBeginsWithElse(rCode, i + 1))
+         {
+            regions.push_back(TopLevelRegion(
+                                 regionRow,
+                                 rCode.substr(regionStart, i - regionStart)));
+            regionStart = i + 1;
+            regionRow = row;
+            hasCode = false;
+         }
+         continue;
+      }
+      
+      if (std::isspace(static_cast<unsigned char>(ch)))
+         continue;
+      
+      if (ch == '#')
+      {
+         while (i + 1 < n && rCode[i + 1] != '\n')
+            ++i;
+         continue;
+      }
+      
+      hasCode = true;
+      
+      if (isIdentifierCharacter(ch))
+      {
+         std::size_t start = i;
+         while (i + 1 < n && isIdentifierCharacter(rCode[i + 1]))
+            ++i;
+         
+         if (depth == 0)
+         {
+            lastWord = rCode.substr(start, i - start + 1);
+            continues = lastWord == "else" || lastWord == "repeat" || lastWord == "function";
+         }
+         lastChar = rCode[i];
+         continue;
+      }
+      
+      switch (ch)
+      {
+      case '"':
+      case '\'':
+      case '`':
+         quote = ch;
+         if (depth == 0)
+            continues = false;
+         break;
+         
+      case '(':
+      case '[':
+      case '{':
+         if (depth == 0)
+            inHeader = ch == '(' && (isHeaderKeyword(lastWord) || lastChar == '\\');
+         ++depth;
+         break;
+         
+      case ')':
+      case ']':
+      case '}':
+         if (depth > 0)
+            --depth;
+         if (depth == 0)
+         {
+            // the expression following e.g. 'function(x)' may begin on
+            // the next line
+            continues = ch == ')' && inHeader;
+            inHeader = false;
+         }
+         break;
+         
+      default:
+         if (depth == 0)
+            continues = isContinuationOperator(ch);
+         break;
+      }
+      
+      lastWord.clear();
+      lastChar = ch;
+   }
+   
+   if (regionStart < n || regions.empty())
+      regions.push_back(TopLevelRegion(regionRow, rCode.substr(regionStart)));
+   
+   return regions;
+}
+
 namespace {
 
 json::Array lintAsJson(const LintItems& items)
@@ -770,6 +966,607 @@ module_context::SourceMarkerSet asSourceMarkerSet(
    return SourceMarkerSet("Diagnostics", markers);
 }
 
+// Incremental diagnostics
+//
+// Documents are linted one top-level region at a time, with the results of
+// each region cached (keyed by its code) so that after an edit only the
+// regions which changed need to be tokenized and parsed again.
+//
+// Lint for a region can depend on earlier regions: a function defined
+// earlier is used to check the arguments of calls to it, and symbols
+// defined earlier are in scope. Each region is therefore first parsed on its
+// own (with syntax-only options) to find the symbols it defines and the
+// symbols it references without defining. It's then linted after a
+// 'prelude' holding stub definitions of the symbols it references: functions
+// are defined with their formals and an empty body (argument checks only
+// consult the formals) and other symbols are defined as NULL. Preludes are
+// therefore proportional to the number of symbols a region references, and
+// editing (say) the body of a function or the right hand side of an
+// assignment doesn't require any of the regions using it to be linted again.
+//
+// Parse results also depend on the functions visible from R (for argument
+// checks), so results referencing functions which were (re)defined in the
+// console are dropped at the next console prompt.
+
+struct RegionSymbols
+{
+   ParseNode::SymbolPositions defined;
+   
+   // function name => its definition with an empty body
+   std::map<std::string, std::string> functions;
+   
+   std::set<std::string> unresolved;
+   
+   // every identifier used within the region
+   std::set<std::string> identifiers;
+};
+
+struct RegionParse
+{
+   ParseResults results;
+   std::size_t preludeRows;
+   boost::shared_ptr<RegionSymbols> pSymbols;
+};
+
+std::string parseOptionsKey(const ParseOptions& options)
+{
+   // note that only the options which affect parsing are included (those
+   // applied to the parse results are checked on every lint)
+   std::string key;
+   key += options.lintRFunctions() ? "1" : "0";
+   key += options.checkArgumentsToRFunctionCalls() ? "1" : "0";
+   key += options.checkUnexpectedAssignmentInFunctionCall() ? "1" : "0";
+   key += options.warnIfNoSuchVariableInScope() ? "1" : "0";
+   key += options.recordStyleLint() ? "1" : "0";
+   return key;
+}
+
+LintItem shiftLintItem(LintItem item, int rows)
+{
+   item.startRow += rows;
+   item.endRow += rows;
+   return item;
+}
+
+Position shiftPosition(const Position& position,
+                       std::size_t fromRow,
+                       std::size_t toRow)
+{
+   return Position(position.row - fromRow + toRow, position.column);
+}
+
+// the identifiers used within R code (used to decide which lint to drop
+// when functions are redefined)
+std::set<std::string> findIdentifiers(const RTokens& rTokens)
+{
+   std::set<std::string> identifiers;
+   for (std::size_t i = 0; i < rTokens.size(); ++i)
+   {
+      const RToken& token = rTokens.atUnsafe(i);
+      if (token.isType(RToken::ID))
+         identifiers.insert(string_utils::strippedOfBackQuotes(token.contentAsUtf8()));
+   }
+   return identifiers;
+}
+
+bool referencesAny(const std::set<std::string>& identifiers,
+                   const std::set<std::string>& symbols)
+{
+   BOOST_FOREACH(const std::string& symbol, symbols)
+   {
+      if (identifiers.count(symbol))
+         return true;
+   }
+   return false;
+}
+
+// find the function defined at 'position' and return its definition with
+// the body replaced by NULL, e.g. 'function(x, y = 1) NULL'
+bool functionStub(const RTokens& rTokens,
+                  const Position& position,
+                  std::string* pStub)
+{
+   RTokenCursor cursor(rTokens);
+   if (!cursor.moveToPosition(position))
+      return false;
+   
+   while (!cursor.contentEquals(L"function"))
+      if (!cursor.moveToNextSignificantToken())
+         return false;
+   
+   const RToken& begin = cursor.currentToken();
+   if (!cursor.moveToNextSignificantToken() ||
+       !cursor.isType(RToken::LPAREN) ||
+       !cursor.fwdToMatchingToken())
+   {
+      return false;
+   }
+   
+   const RToken& end = cursor.currentToken();
+   *pStub = string_utils::wideToUtf8(std::wstring(begin.begin(), end.end())) + " NULL";
+   return true;
+}
+
+class DocumentDiagnostics : boost::noncopyable
+{
+public:
+   
+   ParseResults lint(const std::string& rCode,
+                     const FilePath& origin,
+                     const std::string& documentId,
+                     const ParseOptions& options);
+   
+   // drop results which may depend on the state of the R session (e.g.
+   // the formals of functions on the search path)
+   void clearParseResults()
+   {
+      parses_.clear();
+   }
+   
+   // drop results for regions using any of the given symbols
+   void clearParseResults(const std::set<std::string>& symbols)
+   {
+      ParseCache::iterator it = parses_.begin();
+      while (it != parses_.end())
+      {
+         if (referencesAny(it->second->pSymbols->identifiers, symbols))
+            parses_.erase(it++);
+         else
+            ++it;
+      }
+   }
+   
+private:
+   
+   typedef std::map<std::string, boost::shared_ptr<RegionSymbols> > SymbolsCache;
+   typedef std::map<std::string, boost::shared_ptr<RegionParse> > ParseCache;
+   
+   boost::shared_ptr<RegionSymbols> regionSymbols(const std::string& code,
+                                                  const FilePath& origin,
+                                                  SymbolsCache* pUsed);
+   
+   boost::shared_ptr<RegionParse> regionParse(const std::string& key,
+                                              const std::string& prelude,
+                                              const std::string& code,
+                                              const boost::shared_ptr<RegionSymbols>& pSymbols,
+                                              const FilePath& origin,
+                                              const ParseOptions& options,
+                                              ParseCache* pUsed);
+   
+   SymbolsCache symbols_;
+   ParseCache parses_;
+};
+
+boost::shared_ptr<RegionSymbols> DocumentDiagnostics::regionSymbols(
+      const std::string& code,
+      const FilePath& origin,
+      SymbolsCache* pUsed)
+{
+   boost::shared_ptr<RegionSymbols> pSymbols;
+   
+   SymbolsCache::const_iterator it = symbols_.find(code);
+   if (it != symbols_.end())
+   {
+      pSymbols = it->second;
+   }
+   else
+   {
+      pSymbols.reset(new RegionSymbols());
+      
+      std::wstring wCode = string_utils::utf8ToWide(code);
+      ParseResults results = rparser::parse(origin, wCode, ParseOptions());
+      RTokens rTokens(wCode);
+      
+      ParseNode* pRoot = results.parseTree();
+      pSymbols->defined = pRoot->getDefinedSymbols();
+      
+      BOOST_FOREACH(const boost::shared_ptr<ParseNode>& pChild, pRoot->getChildren())
+      {
+         std::string stub;
+         if (functionStub(rTokens, pChild->position(), &stub))
+            pSymbols->functions[pChild->name()] = stub;
+      }
+      
+      pSymbols->identifiers = findIdentifiers(rTokens);
+      
+      std::vector<ParseItem> unresolved;
+      pRoot->findAllUnresolvedSymbols(&unresolved);
+      BOOST_FOREACH(const ParseItem& item, unresolved)
+      {
+         pSymbols->unresolved.insert(item.symbol);
+      }
+   }
+   
+   (*pUsed)[code] = pSymbols;
+   return pSymbols;
+}
+
+boost::shared_ptr<RegionParse> DocumentDiagnostics::regionParse(
+      const std::string& key,
+      const std::string& prelude,
+      const std::string& code,
+      const boost::shared_ptr<RegionSymbols>& pSymbols,
+      const FilePath& origin,
+      const ParseOptions& options,
+      ParseCache* pUsed)
+{
+   boost::shared_ptr<RegionParse> pParse;
+   
+   ParseCache::const_iterator it = parses_.find(key);
+   if (it != parses_.end())
+   {
+      pParse = it->second;
+   }
+   else
+   {
+      pParse.reset(new RegionParse());
+      pParse->results = rparser::parse(
+               origin,
+               string_utils::utf8ToWide(prelude + code),
+               options);
+      pParse->preludeRows = std::count(prelude.begin(), prelude.end(), '\n');
+      pParse->pSymbols = pSymbols;
+   }
+   
+   (*pUsed)[key] = pParse;
+   return pParse;
+}
+
+ParseResults DocumentDiagnostics::lint(const std::string& rCode,
+                                       const FilePath& origin,
+                                       const std::string& documentId,
+                                       const ParseOptions& options)
+{
+   std::vector<TopLevelRegion> regions = splitTopLevelRegions(rCode);
+   std::size_t n = regions.size();
+   
+   SymbolsCache usedSymbols;
+   ParseCache usedParses;
+   
+   std::vector< boost::shared_ptr<RegionSymbols> > symbols;
+   symbols.reserve(n);
+   for (std::size_t i = 0; i < n; ++i)
+      symbols.push_back(regionSymbols(regions[i].code, origin, &usedSymbols));
+   
+   std::string optionsKey = parseOptionsKey(options);
+   
+   // symbol => the (earlier) regions defining it
+   std::map<std::string, std::vector<std::size_t> > definitions;
+   
+   std::vector< boost::shared_ptr<RegionParse> > parses;
+   parses.reserve(n);
+   for (std::size_t i = 0; i < n; ++i)
+   {
+      const RegionSymbols& current = *symbols[i];
+      
+      // find the earlier definitions this region depends on
+      std::map<std::size_t, std::set<std::string> > dependencies;
+      BOOST_FOREACH(const std::string& symbol, current.unresolved)
+      {
+         std::map<std::string, std::vector<std::size_t> >::const_iterator it =
+               definitions.find(symbol);
+         if (it == definitions.end())
+            continue;
+         
+         BOOST_FOREACH(std::size_t region, it->second)
+         {
+            dependencies[region].insert(symbol);
+         }
+      }
+      
+      std::string prelude;
+      for (std::map<std::size_t, std::set<std::string> >::const_iterator it = dependencies.begin();
+           it != dependencies.end();
+           ++it)
+      {
+         const RegionSymbols& dependency = *symbols[it->first];
+         BOOST_FOREACH(const std::string& symbol, it->second)
+         {
+            std::map<std::string, std::string>::const_iterator function =
+                  dependency.functions.find(symbol);
+            
+            if (function != dependency.functions.end())
+               prelude += symbol + " <- " + function->second + "\n";
+            else
+               prelude += symbol + " <- NULL\n";
+         }
+      }
+      
+      std::string key = optionsKey + "\n" + prelude + '\x1f' + regions[i].code;
+      parses.push_back(regionParse(key,
+                                   prelude,
+                                   regions[i].code,
+                                   symbols[i],
+                                   origin,
+                                   options,
+                                   &usedParses));
+      
+      for (ParseNode::SymbolPositions::const_iterator it = current.defined.begin();
+           it != current.defined.end();
+           ++it)
+      {
+         definitions[it->first].push_back(i);
+      }
+   }
+   
+   // keep only the entries used by this lint
+   symbols_.swap(usedSymbols);
+   parses_.swap(usedParses);
+   
+   // collect lint from each region, dropping lint found within preludes
+   // and translating rows to document rows
+   LintItems lintItems(options);
+   for (std::size_t i = 0; i < n; ++i)
+   {
+      const RegionParse& parse = *parses[i];
+      int rows = static_cast<int>(regions[i].row) - static_cast<int>(parse.preludeRows);
+      BOOST_FOREACH(const LintItem& item, parse.results.lint())
+      {
+         if (item.startRow >= static_cast<int>(parse.preludeRows))
+            lintItems.push_back(shiftLintItem(item, rows));
+      }
+   }
+   
+   if (options.warnIfNoSuchVariableInScope())
+   {
+      bool haveObjects = false;
+      std::set<std::string> objects;
+      
+      for (std::size_t i = 0; i < n; ++i)
+      {
+         const RegionParse& parse = *parses[i];
+         
+         std::vector<ParseItem> unresolvedItems;
+         parse.results.parseTree()->findAllUnresolvedSymbols(&unresolvedItems);
+         BOOST_FOREACH(const ParseItem& item, unresolvedItems)
+         {
+            if (item.position.row < parse.preludeRows)
+               continue;
+            
+            if (r::util::isRKeyword(item.symbol) ||
+                r::util::isWindowsOnlyFunction(item.symbol))
+            {
+               continue;
+            }
+            
+            if (!haveObjects)
+            {
+               Error error = getAllAvailableRSymbols(origin, documentId, options.globals(), &objects);
+               if (error)
+                  LOG_ERROR(error);
+               haveObjects = true;
+            }
+            
+            if (objects.count(string_utils::strippedOfBackQuotes(item.symbol)))
+               continue;
+            
+            // as addUnreferencedSymbol, but with positions in document rows
+            const ParseNode* pNode = item.pNode;
+            ParseItem documentItem(
+                     item.symbol,
+                     shiftPosition(item.position, parse.preludeRows, regions[i].row),
+                     pNode);
+            
+            lintItems.noSymbolNamed(documentItem, pNode->suggestSimilarSymbolFor(item));
+            
+            const ParseNode::SymbolPositions& defined = pNode->getDefinedSymbols();
+            ParseNode::SymbolPositions::const_iterator it = defined.find(item.symbol);
+            if (it != defined.end())
+            {
+               BOOST_FOREACH(const Position& position, it->second)
+               {
+                  if (position.row >= parse.preludeRows)
+                     lintItems.symbolDefinedAfterUsage(
+                              documentItem,
+                              shiftPosition(position, parse.preludeRows, regions[i].row));
+               }
+            }
+            
+            // top-level symbols may also be defined by later regions
+            if (!pNode->isRootNode())
+               continue;
+            
+            for (std::size_t j = i + 1; j < n; ++j)
+            {
+               it = symbols[j]->defined.find(item.symbol);
+               if (it == symbols[j]->defined.end())
+                  continue;
+               
+               BOOST_FOREACH(const Position& position, it->second)
+               {
+                  lintItems.symbolDefinedAfterUsage(
+                           documentItem,
+                           shiftPosition(position, 0, regions[j].row));
+               }
+            }
+         }
+      }
+   }
+   
+   if (options.warnIfVariableIsDefinedButNotUsed())
+   {
+      for (std::size_t i = 0; i < n; ++i)
+      {
+         const RegionParse& parse = *parses[i];
+         int rows = static_cast<int>(regions[i].row) - static_cast<int>(parse.preludeRows);
+         
+         BOOST_FOREACH(const boost::shared_ptr<ParseNode>& pChild,
+                       parse.results.parseTree()->getChildren())
+         {
+            if (pChild->position().row < parse.preludeRows)
+               continue;
+            
+            ParseResults childResults;
+            childResults.globals() = options.globals();
+            doCheckDefinedButNotUsed(pChild.get(), childResults);
+            
+            const LintItems& childLint = childResults.lint();
+            BOOST_FOREACH(const LintItem& item, childLint)
+            {
+               lintItems.push_back(shiftLintItem(item, rows));
+            }
+         }
+      }
+   }
+   
+   return ParseResults(ParseNode::createRootNode(), lintItems, options.globals());
+}
+
+typedef std::map<std::string, boost::shared_ptr<DocumentDiagnostics> > DocumentDiagnosticsMap;
+
+DocumentDiagnosticsMap& documentDiagnostics()
+{
+   static DocumentDiagnosticsMap instance;
+   return instance;
+}
+
+ParseResults lintIncrementally(const std::string& rCode,
+                               const FilePath& origin,
+                               const std::string& documentId,
+                               bool isExplicit)
+{
+   ParseOptions options = diagnosticsParseOptions(isExplicit);
+   
+   // only convert the document if it might contain lint comments
+   if (rCode.find("!diagnostics") != std::string::npos)
+   {
+      bool noLint = false;
+      setFileLocalParseOptions(string_utils::utf8ToWide(rCode), &options, &noLint);
+      if (noLint)
+         return ParseResults();
+   }
+   
+   boost::shared_ptr<DocumentDiagnostics>& pDiagnostics =
+         documentDiagnostics()[documentId];
+   if (!pDiagnostics)
+      pDiagnostics.reset(new DocumentDiagnostics());
+   
+   return pDiagnostics->lint(rCode, origin, documentId, options);
+}
+
+} // anonymous namespace
+
+ParseResults lintDocumentByRegion(const std::string& rCode,
+                                  const FilePath& origin,
+                                  const ParseOptions& options)
+{
+   DocumentDiagnostics diagnostics;
+   return diagnostics.lint(rCode, origin, std::string(), options);
+}
+
+namespace {
+
+void onDocRemoved(const std::string& id, const std::string&)
+{
+   documentDiagnostics().erase(id);
+}
+
+void onRemoveAll()
+{
+   documentDiagnostics().clear();
+}
+
+// the state of the R session which lint can depend on: the environments on
+// the search path and the functions defined in the global environment
+struct RSessionState
+{
+   std::vector<SEXP> searchPath;
+   std::map<std::string, SEXP> globalFunctions;
+};
+
+RSessionState& lastRSessionState()
+{
+   static RSessionState instance;
+   return instance;
+}
+
+r::sexp::PreservedSEXP& lastRSessionStateSEXP()
+{
+   // allocated on the heap so that it's never released after R exits
+   static r::sexp::PreservedSEXP* pInstance = new r::sexp::PreservedSEXP();
+   return *pInstance;
+}
+
+void readRSessionState(RSessionState* pState)
+{
+   for (SEXP envSEXP = ENCLOS(R_GlobalEnv);
+        envSEXP != R_EmptyEnv;
+        envSEXP = ENCLOS(envSEXP))
+   {
+      pState->searchPath.push_back(envSEXP);
+   }
+   
+   r::sexp::Protect protect;
+   std::vector<r::sexp::Variable> variables;
+   r::sexp::listEnvironment(R_GlobalEnv, true, false, &protect, &variables);
+   BOOST_FOREACH(const r::sexp::Variable& variable, variables)
+   {
+      if (r::sexp::isFunction(variable.second))
+         pState->globalFunctions[variable.first] = variable.second;
+   }
+   
+   // keep these objects alive until the next check, so that their addresses
+   // can't be reused by newly created objects
+   SEXP stateSEXP;
+   protect.add(stateSEXP = Rf_allocVector(
+                  VECSXP,
+                  pState->searchPath.size() + pState->globalFunctions.size()));
+   
+   R_xlen_t index = 0;
+   BOOST_FOREACH(SEXP envSEXP, pState->searchPath)
+   {
+      SET_VECTOR_ELT(stateSEXP, index++, envSEXP);
+   }
+   BOOST_FOREACH(SEXP functionSEXP, pState->globalFunctions | boost::adaptors::map_values)
+   {
+      SET_VECTOR_ELT(stateSEXP, index++, functionSEXP);
+   }
+   lastRSessionStateSEXP().set(stateSEXP);
+}
+
+// compares the state of the R session with that at the last check, returning
+// false if the search path changed (in which case any lint may be affected)
+// and otherwise the names of global functions which were (re)defined or
+// removed
+bool checkRSessionState(std::set<std::string>* pChangedFunctions)
+{
+   RSessionState state;
+   readRSessionState(&state);
+   
+   RSessionState& lastState = lastRSessionState();
+   bool searchPathUnchanged = state.searchPath == lastState.searchPath;
+   
+   typedef std::map<std::string, SEXP>::const_iterator Iterator;
+   Iterator before = lastState.globalFunctions.begin();
+   Iterator after = state.globalFunctions.begin();
+   while (before != lastState.globalFunctions.end() ||
+          after != state.globalFunctions.end())
+   {
+      if (after == state.globalFunctions.end() ||
+          (before != lastState.globalFunctions.end() && before->first < after->first))
+      {
+         pChangedFunctions->insert(before->first);
+         ++before;
+      }
+      else if (before == lastState.globalFunctions.end() ||
+               after->first < before->first)
+      {
+         pChangedFunctions->insert(after->first);
+         ++after;
+      }
+      else
+      {
+         if (before->second != after->second)
+            pChangedFunctions->insert(after->first);
+         ++before;
+         ++after;
+      }
+   }
+   
+   lastState = state;
+   return searchPathUnchanged;
+}
+
 Error lintRSourceDocument(const json::JsonRpcRequest& request,
                           json::JsonRpcResponse* pResponse)
 {
@@ -816,8 +1613,8 @@ Error lintRSourceDocument(const json::JsonRpcRequest& request,
    if (error)
       return error;
    
-   ParseResults results = diagnostics::parse(
-            string_utils::utf8ToWide(content),
+   ParseResults results = lintIncrementally(
+            content,
             origin,
             documentId,
             isExplicit);
@@ -897,11 +1694,30 @@ SEXP rs_lintRFile(SEXP filePathSEXP)
    return r::sexp::create(builder, &protect);
 }
 
+// project lint, keyed by file path (see ProjectLint below)
+struct CachedProjectLint
+{
+   std::string key;
+   LintItems lint;
+   std::set<std::string> identifiers;
+};
+
+typedef std::map<std::string, CachedProjectLint> ProjectLintCache;
+
+ProjectLintCache& projectLintCache()
+{
+   static ProjectLintCache instance;
+   return instance;
+}
+
 void onNAMESPACEchanged()
 {
    using namespace r::exec;
    using namespace r::sexp;
    
+   // symbols available to package code have changed
+   projectLintCache().clear();
+   
    if (!projects::projectContext().hasProject())
       return;
    
@@ -973,32 +1789,198 @@ void afterSessionInitHook(bool newSession)
    }
 }
 
-bool collectLint(int depth,
-                 const FilePath& path,
-                 std::map<FilePath, LintItems>* pLint)
+// Project lint
+//
+// Linting a project reads and decodes its R files on a small pool of
+// threads, while the files themselves are linted on the main thread during
+// idle time (the parser may need R to resolve functions), with markers
+// shown as lint accumulates. Lint is cached by file contents (and options)
+// so that linting the project again only lints the files which changed (or
+// which use functions redefined in the console since they were linted).
+
+const std::size_t kMaxProjectLintThreads = 4;
+const int kProjectLintMarkerIntervalMs = 500;
+
+// how long the main thread waits for the next file to be read; this bounds
+// how far a slice of lint work can overrun while keeping the main thread
+// from spinning while the readers catch up
+const int kProjectLintReadWaitMs = 10;
+
+struct ProjectLintFile
 {
-   if (path.extensionLowerCase() != ".r")
-      return true;
+   FilePath path;
+   Error error;
+   std::string hash;
+   std::wstring contents;
+};
+
+class ProjectLint : boost::noncopyable,
+                    public boost::enable_shared_from_this<ProjectLint>
+{
+public:
    
-   std::string contents;
-   Error error = core::readStringFromFile(
-            path,
-            &contents,
-            string_utils::LineEndingPosix);
+   static boost::shared_ptr<ProjectLint> create(const std::vector<FilePath>& files)
+   {
+      boost::shared_ptr<ProjectLint> pLint(new ProjectLint(files.size()));
+      BOOST_FOREACH(const FilePath& file, files)
+      {
+         pLint->files_.enque(file);
+      }
+      return pLint;
+   }
    
-   if (error)
+   void start()
    {
-      LOG_ERROR(error);
+      startReading();
+      module_context::scheduleIncrementalWork(
+               boost::posix_time::milliseconds(50),
+               boost::bind(&ProjectLint::lintFiles, shared_from_this()));
+   }
+   
+   // lint all the files before returning (without showing markers)
+   const std::map<FilePath, LintItems>& run()
+   {
+      startReading();
+      while (remaining_ > 0)
+         lintNextFile();
+      return lint_;
+   }
+   
+   void cancel()
+   {
+      cancelled_.set(true);
+   }
+   
+private:
+   
+   explicit ProjectLint(std::size_t count)
+      : files_(true),
+        read_(true),
+        remaining_(count),
+        cancelled_(false),
+        lastShown_(boost::posix_time::microsec_clock::universal_time())
+   {
+   }
+   
+   void startReading()
+   {
+      std::size_t threads = std::min<std::size_t>(
+               std::max<std::size_t>(boost::thread::hardware_concurrency(), 1),
+               kMaxProjectLintThreads);
+      
+      for (std::size_t i = 0; i < threads; ++i)
+      {
+         core::thread::safeLaunchThread(
+                  boost::bind(&ProjectLint::readFiles, shared_from_this()));
+      }
+   }
+   
+   // runs on the reader threads
+   void readFiles()
+   {
+      FilePath path;
+      while (!cancelled_.get() && files_.deque(&path))
+      {
+         boost::shared_ptr<ProjectLintFile> pFile(new ProjectLintFile());
+         pFile->path = path;
+         
+         std::string contents;
+         Error error = core::readStringFromFile(
+                  path,
+                  &contents,
+                  string_utils::LineEndingPosix);
+         
+         // errors are logged (and the file skipped) on the main thread
+         if (error)
+            pFile->error = error;
+         else
+         {
+            pFile->hash = hash::crc32HexHash(contents);
+            pFile->contents = string_utils::utf8ToWide(contents);
+         }
+         
+         read_.enque(pFile);
+      }
+   }
+   
+   // runs on the main thread
+   bool lintFiles()
+   {
+      if (cancelled_.get())
+         return false;
+      
+      if (!lintNextFile())
+         return true;
+      
+      // show the lint found so far every so often (and when done)
+      using namespace boost::posix_time;
+      ptime now = microsec_clock::universal_time();
+      if (remaining_ == 0 || now - lastShown_ > milliseconds(kProjectLintMarkerIntervalMs))
+      {
+         module_context::showSourceMarkers(asSourceMarkerSet(lint_),
+                                           module_context::MarkerAutoSelectNone);
+         lastShown_ = now;
+      }
+      
+      return remaining_ > 0;
+   }
+   
+   // lint the next file read (if one is read soon enough)
+   bool lintNextFile()
+   {
+      boost::shared_ptr<ProjectLintFile> pFile;
+      if (!read_.deque(&pFile, boost::posix_time::milliseconds(kProjectLintReadWaitMs)))
+         return false;
+      
+      --remaining_;
+      lintFile(*pFile);
       return true;
    }
    
-   ParseResults results = diagnostics::parse(
-            string_utils::utf8ToWide(contents),
-            path,
-            std::string(),
-            true);
+   void lintFile(const ProjectLintFile& file)
+   {
+      if (file.error)
+      {
+         LOG_ERROR(file.error);
+         return;
+      }
+      
+      ParseOptions options = diagnosticsParseOptions(true);
+      std::string key = file.hash + ":" + parseOptionsKey(options) +
+            (options.warnIfVariableIsDefinedButNotUsed() ? "1" : "0");
+      
+      CachedProjectLint& cached = projectLintCache()[file.path.absolutePath()];
+      if (cached.key != key)
+      {
+         cached.key = key;
+         cached.lint = diagnostics::parse(file.contents,
+                                          file.path,
+                                          std::string(),
+                                          true).lint();
+         cached.identifiers = findIdentifiers(RTokens(file.contents));
+      }
+      
+      if (!cached.lint.empty())
+         lint_[file.path] = cached.lint;
+   }
+   
+   core::thread::ThreadsafeQueue<FilePath> files_;
+   core::thread::ThreadsafeQueue< boost::shared_ptr<ProjectLintFile> > read_;
    
-   (*pLint)[path] = results.lint();
+   std::size_t remaining_;
+   core::thread::ThreadsafeValue<bool> cancelled_;
+   boost::posix_time::ptime lastShown_;
+   std::map<FilePath, LintItems> lint_;
+};
+
+boost::shared_ptr<ProjectLint> s_pProjectLint;
+
+bool collectRFile(int depth,
+                  const FilePath& path,
+                  std::vector<FilePath>* pFiles)
+{
+   if (path.extensionLowerCase() == ".r")
+      pFiles->push_back(path);
    return true;
 }
 
@@ -1009,23 +1991,82 @@ SEXP rs_lintDirectory(SEXP directorySEXP)
    if (!dirPath.exists())
       return R_NilValue;
    
-   std::map<FilePath, LintItems> lint;
+   std::vector<FilePath> files;
    Error error = dirPath.childrenRecursive(
-            boost::bind(collectLint, _1, _2, &lint));
+            boost::bind(collectRFile, _1, _2, &files));
    if (error)
    {
       LOG_ERROR(error);
       return R_NilValue;
    }
    
+   // clear markers from any previous lint
    using namespace module_context;
-   SourceMarkerSet markers = asSourceMarkerSet(lint);
-   showSourceMarkers(markers, MarkerAutoSelectNone);
+   std::map<FilePath, LintItems> lint;
+   showSourceMarkers(asSourceMarkerSet(lint), MarkerAutoSelectNone);
+   
+   if (s_pProjectLint)
+      s_pProjectLint->cancel();
+   
+   s_pProjectLint = ProjectLint::create(files);
+   if (!files.empty())
+      s_pProjectLint->start();
+   
    return R_NilValue;
 }
 
+void onConsolePrompt(const std::string&)
+{
+   if (documentDiagnostics().empty() && projectLintCache().empty())
+      return;
+   
+   // code run in the console may have attached packages or (re)defined
+   // functions, so lint which could depend on those may no longer apply
+   std::set<std::string> changedFunctions;
+   bool searchPathUnchanged = checkRSessionState(&changedFunctions);
+   if (searchPathUnchanged && changedFunctions.empty())
+      return;
+   
+   BOOST_FOREACH(const boost::shared_ptr<DocumentDiagnostics>& pDiagnostics,
+                 documentDiagnostics() | boost::adaptors::map_values)
+   {
+      if (searchPathUnchanged)
+         pDiagnostics->clearParseResults(changedFunctions);
+      else
+         pDiagnostics->clearParseResults();
+   }
+   
+   if (!searchPathUnchanged)
+   {
+      projectLintCache().clear();
+      return;
+   }
+   
+   ProjectLintCache& cache = projectLintCache();
+   ProjectLintCache::iterator it = cache.begin();
+   while (it != cache.end())
+   {
+      if (referencesAny(it->second.identifiers, changedFunctions))
+         cache.erase(it++);
+      else
+         ++it;
+   }
+}
+
+void onPackageLibraryMutated()
+{
+   // lint may depend on installed packages
+   projectLintCache().clear();
+}
+
 } // anonymous namespace
 
+void lintProjectFiles(const std::vector<FilePath>& files,
+                      std::map<FilePath, LintItems>* pLint)
+{
+   *pLint = ProjectLint::create(files)->run();
+}
+
 core::Error initialize()
 {
    using namespace rstudio::core;
@@ -1033,6 +2074,10 @@ core::Error initialize()
    using namespace module_context;
    
    events().afterSessionInitHook.connect(afterSessionInitHook);
+   events().onConsolePrompt.connect(onConsolePrompt);
+   events().onPackageLibraryMutated.connect(onPackageLibraryMutated);
+   source_database::events().onDocRemoved.connect(onDocRemoved);
+   source_database::events().onRemoveAll.connect(onRemoveAll);
    
    session::projects::FileMonitorCallbacks cb;
    cb.onFilesChanged = onFilesChanged;
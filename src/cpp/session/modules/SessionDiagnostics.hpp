@@ -16,9 +16,28 @@
 #ifndef SESSION_MODULES_DIAGNOSTICS_HPP
 #define SESSION_MODULES_DIAGNOSTICS_HPP
 
+#include <map>
+#include <string>
+#include <vector>
+
 namespace rstudio {
 namespace core {
    class Error;
+   class FilePath;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace rparser {
+   namespace linter {
+      class LintItems;
+   }
+   class ParseOptions;
+   class ParseResults;
+}
+}
 }
 }
 
@@ -27,6 +46,38 @@ namespace session {
 namespace modules {
 namespace diagnostics {
 
+// a run of whole lines holding one or more complete top-level R expressions
+// (along with any blank or comment lines preceding them). documents are
+// linted region by region so that only the regions touched by an edit need
+// to be parsed again
+struct TopLevelRegion
+{
+   TopLevelRegion(std::size_t row, const std::string& code)
+      : row(row), code(code)
+   {
+   }
+
+   std::size_t row;
+   std::string code;
+};
+
+std::vector<TopLevelRegion> splitTopLevelRegions(const std::string& rCode);
+
+// lint R code as a whole, and region by region (as documents open in the
+// editor are linted); both produce the same lint
+rparser::ParseResults lintDocument(const std::string& rCode,
+                                   const core::FilePath& origin,
+                                   const rparser::ParseOptions& options);
+
+rparser::ParseResults lintDocumentByRegion(const std::string& rCode,
+                                           const core::FilePath& origin,
+                                           const rparser::ParseOptions& options);
+
+// lint files as when linting a project (reusing lint cached for unchanged
+// files), returning the lint for each file which has any
+void lintProjectFiles(const std::vector<core::FilePath>& files,
+                      std::map<core::FilePath, rparser::linter::LintItems>* pLint);
+
 core::Error initialize();
 
 } // namespace diagnostics
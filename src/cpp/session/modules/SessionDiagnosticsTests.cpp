@@ -17,10 +17,13 @@
 
 #include "SessionDiagnostics.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 
 #include <core/collection/Tree.hpp>
 #include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
 #include <core/system/FileScanner.hpp>
 #include <core/FileUtils.hpp>
 
@@ -75,6 +78,42 @@ using namespace core::r_util;
       expect_true(results.lint().get().empty());                               \
    } while (0)
 
+std::vector<std::string> lintSummary(const LintItems& lint)
+{
+   std::vector<std::string> summary;
+   BOOST_FOREACH(const LintItem& item, lint.get())
+   {
+      std::stringstream ss;
+      ss << item.startRow << ":" << item.startColumn << "-"
+         << item.endRow << ":" << item.endColumn << " "
+         << lintTypeToString(item.type) << " " << item.message;
+      summary.push_back(ss.str());
+   }
+   std::sort(summary.begin(), summary.end());
+   return summary;
+}
+
+bool lintsSameByRegion(const std::string& rCode)
+{
+   std::vector<std::string> whole = lintSummary(
+            lintDocument(rCode, FilePath(), s_parseOptions).lint());
+   std::vector<std::string> byRegion = lintSummary(
+            lintDocumentByRegion(rCode, FilePath(), s_parseOptions).lint());
+   
+   if (whole != byRegion)
+   {
+      std::cerr << "Lint differs for code:\n" << rCode << "\n";
+      std::cerr << "Whole document:\n";
+      BOOST_FOREACH(const std::string& item, whole)
+         std::cerr << "   " << item << "\n";
+      std::cerr << "By region:\n";
+      BOOST_FOREACH(const std::string& item, byRegion)
+         std::cerr << "   " << item << "\n";
+   }
+   
+   return whole == byRegion;
+}
+
 bool isRFile(const FileInfo& info)
 {
    std::string ext = string_utils::getExtension(info.absolutePath());
@@ -278,6 +317,92 @@ context("Diagnostics")
       EXPECT_LINT("list(a <- 1, b <- 2)");
    }
    
+   test_that("documents are split into top-level regions")
+   {
+      std::vector<TopLevelRegion> regions =
+            splitTopLevelRegions("# setup\na <- 1\nb <- c(1,\n  2)\nc <- a +\n  b\n");
+      expect_true(regions.size() == 3);
+      expect_true(regions[0].row == 0 && regions[0].code == "# setup\na <- 1");
+      expect_true(regions[1].row == 2 && regions[1].code == "b <- c(1,\n  2)");
+      expect_true(regions[2].row == 4 && regions[2].code == "c <- a +\n  b");
+      
+      // function bodies and else clauses may begin on the next line
+      regions = splitTopLevelRegions("f <- function(x)\n  x\nif (a) {\n}\nelse b\nd");
+      expect_true(regions.size() == 3);
+      expect_true(regions[1].row == 2 && regions[1].code == "if (a) {\n}\nelse b");
+      
+      // brackets and comment characters within strings are ignored
+      regions = splitTopLevelRegions("s <- 'a ( # b\nc'\nt <- \"}\"\nu");
+      expect_true(regions.size() == 3);
+      expect_true(regions[0].code == "s <- 'a ( # b\nc'");
+      expect_true(regions[2].row == 3);
+      
+      // an unclosed bracket extends to the end of the document
+      regions = splitTopLevelRegions("a <- 1\nf(\nb\nc");
+      expect_true(regions.size() == 2);
+      expect_true(regions[1].code == "f(\nb\nc");
+   }
+   
+   test_that("documents linted by region get the same lint as whole documents")
+   {
+      // calls to functions defined in earlier regions
+      expect_true(lintsSameByRegion(
+                     "f <- function(a, b = 1) {\n  a + b\n}\n"
+                     "f(1, 2, 3)\nf(c = 1)\nf(b = 2, 1)\n"));
+      
+      // symbols which are never defined
+      expect_true(lintsSameByRegion(
+                     "x <- 1\ny <- x + qqqzzz\nprint(y)\n"));
+      
+      // symbols defined but not used
+      expect_true(lintsSameByRegion(
+                     "g <- function() {\n  unused <- 1\n  2\n}\ng()\n"));
+      
+      // symbols used before they're defined
+      expect_true(lintsSameByRegion(
+                     "h <- function(n) n\nh(value)\nvalue <- 1\n"));
+   }
+   
+   test_that("project files are linted, and linted again once changed")
+   {
+      FilePath dirPath;
+      REQUIRE_FALSE(FilePath::tempFilePath(&dirPath));
+      REQUIRE_FALSE(dirPath.ensureDirectory());
+      
+      FilePath cleanPath = dirPath.childPath("clean.R");
+      FilePath errorPath = dirPath.childPath("error.R");
+      REQUIRE_FALSE(writeStringToFile(cleanPath, "x <- 1\nprint(x)\n"));
+      REQUIRE_FALSE(writeStringToFile(errorPath, "y <- c(1, 2))\nprint(y)\n"));
+      
+      std::vector<FilePath> files;
+      files.push_back(cleanPath);
+      files.push_back(errorPath);
+      
+      std::map<FilePath, LintItems> lint;
+      lintProjectFiles(files, &lint);
+      expect_true(lint.count(cleanPath) == 0);
+      expect_true(lint.count(errorPath) == 1);
+      expect_true(lint[errorPath].hasErrors());
+      
+      // linting again gives the same (cached) lint
+      std::map<FilePath, LintItems> cachedLint;
+      lintProjectFiles(files, &cachedLint);
+      expect_true(cachedLint.size() == lint.size());
+      expect_true(cachedLint[errorPath].get().size() == lint[errorPath].get().size());
+      
+      // files which are fixed are linted again
+      REQUIRE_FALSE(writeStringToFile(errorPath, "y <- c(1, 2)\nprint(y)\n"));
+      lintProjectFiles(files, &lint);
+      expect_true(lint.count(errorPath) == 0);
+      
+      // files which can't be read are skipped
+      files.push_back(dirPath.childPath("missing.R"));
+      lintProjectFiles(files, &lint);
+      expect_true(lint.empty());
+      
+      dirPath.removeIfExists();
+   }
+   
    lintRStudioRFiles();
 }
 
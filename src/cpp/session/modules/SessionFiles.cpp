@@ -26,6 +26,7 @@
 
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
 
 #include <core/Error.hpp>
 #include <core/Log.hpp>
@@ -36,6 +37,7 @@
 #include <core/Settings.hpp>
 #include <core/Exec.hpp>
 #include <core/DateTime.hpp>
+#include <core/Zip.hpp>
 
 #include <core/http/Util.hpp>
 #include <core/http/Request.hpp>
@@ -57,6 +59,7 @@
 
 #include <session/SessionClientEvent.hpp>
 #include <session/SessionModuleContext.hpp>
+#include <session/worker_safe/session/SessionWorkerContext.hpp>
 #include <session/SessionOptions.hpp>
 #include <session/SessionSourceDatabase.hpp>
 
@@ -251,6 +254,84 @@ Error listFiles(const json::JsonRpcRequest& request, json::JsonRpcResponse* pRes
 }
 
 
+// IN: String path, Boolean monitor, Boolean includeHidden, String sortColumn,
+//     Boolean ascending, String filter, Int offset, Int count
+// OUT: { files, total, offset, is_parent_browseable }
+Error listFilesWindow(const json::JsonRpcRequest& request,
+                      json::JsonRpcResponse* pResponse)
+{
+   // get args
+   std::string path, sortColumn, filter;
+   bool monitor, includeHidden, ascending;
+   int offset, count;
+   Error error = json::readParams(request.params,
+                                  &path,
+                                  &monitor,
+                                  &includeHidden,
+                                  &sortColumn,
+                                  &ascending,
+                                  &filter,
+                                  &offset,
+                                  &count);
+   if (error)
+      return error;
+   FilePath targetPath = module_context::resolveAliasedPath(path);
+
+   // start monitoring (and caching) the directory if requested; subsequent
+   // pages are then served from the cache and changes arrive as file
+   // change events. directories the project monitors are listed from its
+   // index of the project's files instead
+   if (monitor)
+   {
+      if (session::projects::projectContext().isMonitoringDirectory(targetPath))
+      {
+         s_filesListingMonitor.stop();
+      }
+      else if (!s_filesListingMonitor.isMonitoring(targetPath, includeHidden))
+      {
+         error = s_filesListingMonitor.start(targetPath, includeHidden);
+         if (error)
+            return error;
+      }
+   }
+
+   ListingWindow window;
+   window.sortColumn = sortColumn;
+   window.ascending = ascending;
+   window.filter = filter;
+   window.offset = std::max(offset, 0);
+   window.count = std::max(count, 0);
+
+   std::size_t total = 0;
+   core::json::Array jsonFiles;
+   error = s_filesListingMonitor.listWindow(targetPath,
+                                            includeHidden,
+                                            window,
+                                            &total,
+                                            &jsonFiles);
+   if (error)
+      return error;
+
+   json::Object result;
+   result["files"] = jsonFiles;
+   result["total"] = static_cast<int>(total);
+   result["offset"] = static_cast<int>(window.offset);
+
+   bool browseable = true;
+
+#ifndef _WIN32
+   // on *nix systems, see if browsing above this path is possible
+   error = core::system::isFileReadable(targetPath.parent(), &browseable);
+   if (error && !core::isPathNotFoundError(error))
+      LOG_ERROR(error);
+#endif
+
+   result["is_parent_browseable"] = browseable;
+
+   pResponse->setResult(result);
+   return Success();
+}
+
 // IN: String path
 core::Error createFolder(const core::json::JsonRpcRequest& request,
                          json::JsonRpcResponse* pResponse)
@@ -543,10 +624,8 @@ Error completeUpload(const core::json::JsonRpcRequest& request,
       if (uploadedTempFilePath.extensionLowerCase() == ".zip")
       {
          // expand the archive
-         r::exec::RFunction unzip("unzip");
-         unzip.addParam("zipfile", uploadedTempFilePath.absolutePath());
-         unzip.addParam("exdir", targetDirectoryPath.absolutePath());
-         Error unzipError = unzip.call();
+         Error unzipError = zip::extractArchive(uploadedTempFilePath,
+                                                targetDirectoryPath);
          if (unzipError)
             return unzipError;
          
@@ -567,14 +646,14 @@ Error completeUpload(const core::json::JsonRpcRequest& request,
          if (removeError)
             return removeError;
          
-         // copy the source to the destination
-         Error copyError = uploadedTempFilePath.copy(targetPath);
-         if (copyError)
-            return copyError;
+         // move the source to the destination
+         Error moveError = uploadedTempFilePath.move(targetPath);
+         if (moveError)
+            return moveError;
       }
 
       // remove the uploaded temp file
-      error = uploadedTempFilePath.remove();
+      error = uploadedTempFilePath.removeIfExists();
       if (error)
          LOG_ERROR(error);
       
@@ -601,9 +680,7 @@ Error detectZipFileOverwrites(const FilePath& uploadedZipFile,
 {
    // query for all of the paths in the zip file
    std::vector<std::string> zipFileListing;
-   r::exec::RFunction listZipFile(".rs.listZipFile",
-                                  uploadedZipFile.absolutePath());
-   Error unzipError = listZipFile.call(&zipFileListing);
+   Error unzipError = zip::listArchive(uploadedZipFile, &zipFileListing);
    if (unzipError)
       return unzipError;
    
@@ -633,8 +710,11 @@ bool validateUploadedFile(const http::File& file, http::Response* pResponse)
    // convert limit to bytes
    size_t byteLimit = mbLimit * 1024 * 1024;
    
-   // compare to file size
-   if (file.contents.size() > byteLimit)
+   // compare to file size (large uploads are spooled to disk by the
+   // request parser rather than held in memory)
+   uintmax_t fileSize = file.pSpoolFile ?
+            file.pSpoolFile->path().size() : file.contents.size();
+   if (fileSize > byteLimit)
    {
       Error fileTooLargeError = systemError(boost::system::errc::file_too_large,
                                             ERROR_LOCATION);
@@ -659,7 +739,7 @@ void handleFileUploadRequest(const http::Request& request,
    // get fields
    const http::File& file = request.uploadedFile("file");
    std::string targetDirectory = request.formFieldValue("targetDirectory");
-   
+
    // first validate that we got the required fields
    if (file.name.empty() || targetDirectory.empty())
    {
@@ -681,7 +761,9 @@ void handleFileUploadRequest(const http::Request& request,
                                                     isZip ? "zip" : "bin");
    
    // attempt to write the temp file
-   Error saveError = core::writeStringToFile(tempFilePath, file.contents);
+   Error saveError = file.pSpoolFile ?
+            file.pSpoolFile->moveTo(tempFilePath) :
+            core::writeStringToFile(tempFilePath, file.contents);
    if (saveError)
    {
       LOG_ERROR(saveError);
@@ -720,10 +802,9 @@ void handleFileUploadRequest(const http::Request& request,
    json::setJsonRpcResult(uploadJson, pResponse);   
 }
    
-void setAttachmentResponse(const http::Request& request,
-                           const std::string& filename,
-                           const FilePath& attachmentPath,
-                           http::Response* pResponse)
+void setAttachmentHeaders(const http::Request& request,
+                          const std::string& filename,
+                          http::Response* pResponse)
 {
    if (request.headerValue("User-Agent").find("MSIE") == std::string::npos)
    {
@@ -743,8 +824,56 @@ void setAttachmentResponse(const http::Request& request,
                         "attachment; filename*=UTF-8''"
                         + http::util::urlEncode(filename, false));
    pResponse->setHeader("Content-Type", "application/octet-stream");
+}
+
+void setAttachmentResponse(const http::Request& request,
+                           const std::string& filename,
+                           const FilePath& attachmentPath,
+                           http::Response* pResponse)
+{
+   setAttachmentHeaders(request, filename, pResponse);
    pResponse->setStreamFile(attachmentPath, request);
 }
+
+// streams a zip archive to the client as it's compressed (this happens as
+// the connection is written to, so the R thread isn't involved)
+class ZipStreamResponse : public http::StreamResponse
+{
+public:
+   explicit ZipStreamResponse(const std::vector<zip::ZipEntry>& entries)
+      : writer_(entries)
+   {
+   }
+
+   Error initialize()
+   {
+      return Success();
+   }
+
+   boost::shared_ptr<http::StreamBuffer> nextBuffer()
+   {
+      std::string chunk;
+      Error error = writer_.nextChunk(kZipChunkSize, &chunk);
+      if (error)
+      {
+         // the response is underway so we can only end it early (leaving
+         // the client with a truncated archive)
+         LOG_ERROR(error);
+         return boost::shared_ptr<http::StreamBuffer>();
+      }
+
+      if (chunk.empty())
+         return boost::shared_ptr<http::StreamBuffer>();
+
+      char* buffer = new char[chunk.size()];
+      std::copy(chunk.begin(), chunk.end(), buffer);
+      return boost::make_shared<http::StreamBuffer>(buffer, chunk.size());
+   }
+
+private:
+   static const std::size_t kZipChunkSize = 65536;
+   zip::ZipWriter writer_;
+};
    
 void handleMultipleFileExportRequest(const http::Request& request, 
                                      http::Response* pResponse)
@@ -794,12 +923,9 @@ void handleMultipleFileExportRequest(const http::Request& request,
       files.push_back(file);
    }
    
-   // create the zip file
-   FilePath tempZipFilePath = module_context::tempFile("export", "zip");
-   Error error = r::exec::RFunction(".rs.createZipFile",
-                                    tempZipFilePath.absolutePath(),
-                                    parentPath.absolutePath(),
-                                    files).call();
+   // list the files to be zipped
+   std::vector<zip::ZipEntry> entries;
+   Error error = zip::listEntries(parentPath, files, &entries);
    if (error)
    {
       LOG_ERROR(error);
@@ -807,8 +933,10 @@ void handleMultipleFileExportRequest(const http::Request& request,
       return;
    }
    
-   // return attachment
-   setAttachmentResponse(request, name, tempZipFilePath, pResponse);
+   // return attachment (compressed as it's sent)
+   setAttachmentHeaders(request, name, pResponse);
+   pResponse->setStreamResponse(
+            boost::shared_ptr<http::StreamResponse>(new ZipStreamResponse(entries)));
 }
    
 void handleFileExportRequest(const http::Request& request, 
@@ -1022,6 +1150,17 @@ Error initialize()
    // subscribe to events
    events().onClientInit.connect(bind(onClientInit));
 
+   // index the project's files so that the directories it monitors can be
+   // listed without being scanned
+   session::projects::FileMonitorCallbacks cb;
+   cb.onMonitoringEnabled = bind(&FilesListingMonitor::onProjectMonitoringEnabled,
+                                 &s_filesListingMonitor, _1);
+   cb.onFilesChanged = bind(&FilesListingMonitor::onProjectFilesChanged,
+                            &s_filesListingMonitor, _1);
+   cb.onMonitoringDisabled = bind(&FilesListingMonitor::onProjectMonitoringDisabled,
+                                  &s_filesListingMonitor);
+   session::projects::projectContext().subscribeToFileMonitor("", cb);
+
    RS_REGISTER_CALL_METHOD(rs_readLines, 1);
    RS_REGISTER_CALL_METHOD(rs_pathInfo, 1);
 
@@ -1033,6 +1172,7 @@ Error initialize()
       (bind(registerRpcMethod, "is_text_file", isTextFile))
       (bind(registerRpcMethod, "get_file_contents", getFileContents))
       (bind(registerRpcMethod, "list_files", listFiles))
+      (bind(registerRpcMethod, "list_files_window", listFilesWindow))
       (bind(registerRpcMethod, "create_folder", createFolder))
       (bind(registerRpcMethod, "delete_files", deleteFiles))
       (bind(registerRpcMethod, "copy_file", copyFile))
@@ -1041,7 +1181,7 @@ Error initialize()
       (bind(registerUriHandler, "/files", handleFilesRequest))
       (bind(registerUriHandler, "/upload", handleFileUploadRequest))
       (bind(registerUriHandler, "/export", handleFileExportRequest))
-      (bind(registerRpcMethod, "complete_upload", completeUpload))
+      (bind(worker_context::registerWorkerRpcMethod, "complete_upload", completeUpload))
       (bind(registerRpcMethod, "write_json", writeJSON))
       (bind(registerRpcMethod, "read_json", readJSON))
       (bind(sourceModuleRFile, "SessionFiles.R"))
@@ -17,6 +17,7 @@
 
 #include <algorithm>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
@@ -24,6 +25,7 @@
 #include <core/Log.hpp>
 #include <core/FileInfo.hpp>
 #include <core/FilePath.hpp>
+#include <core/StringUtils.hpp>
 
 #include <core/json/JsonRpc.hpp>
 
@@ -41,14 +43,179 @@ namespace session {
 namespace modules { 
 namespace files {
 
+const char * const ListingWindow::kSortByName = "name";
+const char * const ListingWindow::kSortBySize = "size";
+const char * const ListingWindow::kSortByModified = "modified";
+
 // filter for listing files which shows all files (hidden or not)
 bool acceptAllFiles(const FileInfo&)
 {
    return true;
 }
 
+namespace {
+
+// scan a directory, returning the files which should be listed
+Error scanDirectory(const FilePath& rootPath,
+                    bool includeHidden,
+                    std::vector<FileInfo>* pFiles)
+{
+   std::vector<FilePath> children;
+   Error error = rootPath.children(&children);
+   if (error)
+      return error;
+
+   BOOST_FOREACH(const FilePath& child, children)
+   {
+      // files which may have been deleted after the listing or which
+      // are not end-user visible
+      FileInfo fileInfo(child);
+      if (child.exists() &&
+          (includeHidden || module_context::fileListingFilter(fileInfo)))
+      {
+         pFiles->push_back(fileInfo);
+      }
+   }
+
+   return Success();
+}
+
+class CompareFiles
+{
+public:
+   CompareFiles(const std::string& sortColumn, bool ascending)
+      : sortColumn_(sortColumn), ascending_(ascending)
+   {
+   }
+
+   bool operator()(const FileInfo* pA, const FileInfo* pB) const
+   {
+      return ascending_ ? lessThan(*pA, *pB) : lessThan(*pB, *pA);
+   }
+
+private:
+   bool lessThan(const FileInfo& a, const FileInfo& b) const
+   {
+      if (sortColumn_ == ListingWindow::kSortBySize && a.size() != b.size())
+         return a.size() < b.size();
+      if (sortColumn_ == ListingWindow::kSortByModified &&
+          a.lastWriteTime() != b.lastWriteTime())
+         return a.lastWriteTime() < b.lastWriteTime();
+
+      // otherwise order by name (ignoring case)
+      return string_utils::toLower(a.absolutePath()) <
+             string_utils::toLower(b.absolutePath());
+   }
+
+   std::string sortColumn_;
+   bool ascending_;
+};
+
+// filter and sort a listing and produce json for the requested window of it
+// (json and source control decorations are produced only for that window)
+void listFilesWindow(const FilePath& rootPath,
+                     const std::vector<const FileInfo*>& listing,
+                     const ListingWindow& window,
+                     std::size_t* pTotal,
+                     json::Array* pJsonFiles)
+{
+   std::vector<const FileInfo*> files;
+   selectListingWindow(listing, window, &files, pTotal);
+
+   using namespace source_control;
+   boost::shared_ptr<FileDecorationContext> pCtx =
+                  source_control::fileDecorationContext(rootPath);
+   BOOST_FOREACH(const FileInfo* pFileInfo, files)
+   {
+      core::json::Object fileObject = module_context::createFileSystemItem(*pFileInfo);
+      pCtx->decorateFile(FilePath(pFileInfo->absolutePath()), &fileObject);
+      pJsonFiles->push_back(fileObject);
+   }
+}
+
+void listFilesWindow(const FilePath& rootPath,
+                     const std::map<std::string, FileInfo>& files,
+                     const ListingWindow& window,
+                     std::size_t* pTotal,
+                     json::Array* pJsonFiles)
+{
+   std::vector<const FileInfo*> listing;
+   for (std::map<std::string, FileInfo>::const_iterator it = files.begin();
+        it != files.end();
+        ++it)
+   {
+      listing.push_back(&it->second);
+   }
+
+   listFilesWindow(rootPath, listing, window, pTotal, pJsonFiles);
+}
+
+Error listFilesWindow(const FilePath& rootPath,
+                      bool includeHidden,
+                      const ListingWindow& window,
+                      std::size_t* pTotal,
+                      json::Array* pJsonFiles)
+{
+   std::vector<FileInfo> files;
+   Error error = scanDirectory(rootPath, includeHidden, &files);
+   if (error)
+      return error;
+
+   std::vector<const FileInfo*> listing;
+   BOOST_FOREACH(const FileInfo& fileInfo, files)
+   {
+      listing.push_back(&fileInfo);
+   }
+
+   listFilesWindow(rootPath, listing, window, pTotal, pJsonFiles);
+   return Success();
+}
+
+} // anonymous namespace
+
+void selectListingWindow(const std::vector<const FileInfo*>& listing,
+                         const ListingWindow& window,
+                         std::vector<const FileInfo*>* pWindowFiles,
+                         std::size_t* pTotal)
+{
+   std::vector<const FileInfo*> files;
+   BOOST_FOREACH(const FileInfo* pFileInfo, listing)
+   {
+      if (window.filter.empty() ||
+          boost::algorithm::icontains(
+             FilePath(pFileInfo->absolutePath()).filename(), window.filter))
+      {
+         files.push_back(pFileInfo);
+      }
+   }
+   *pTotal = files.size();
+
+   std::size_t offset = std::min(window.offset, files.size());
+   std::size_t count = files.size() - offset;
+   if (window.count > 0)
+      count = std::min(count, window.count);
+
+   // only the files in the window need to be fully sorted
+   CompareFiles compare(window.sortColumn, window.ascending);
+   std::partial_sort(files.begin(), files.begin() + offset + count, files.end(),
+                     compare);
+
+   pWindowFiles->assign(files.begin() + offset, files.begin() + offset + count);
+}
+
 Error FilesListingMonitor::start(const FilePath& filePath, bool includeHidden, 
       json::Array* pJsonFiles)
+{
+   Error error = start(filePath, includeHidden);
+   if (error)
+      return error;
+
+   // list the entire directory (from the cache populated above)
+   std::size_t total = 0;
+   return listWindow(filePath, includeHidden, ListingWindow(), &total, pJsonFiles);
+}
+
+Error FilesListingMonitor::start(const FilePath& filePath, bool includeHidden)
 {
    // always stop existing
    stop();
@@ -56,26 +223,27 @@ Error FilesListingMonitor::start(const FilePath& filePath, bool includeHidden,
    // save include hidden setting
    includeHidden_ = includeHidden;
 
-   // scan the directory (populates pJsonFiles out parameter)
-   std::vector<FilePath> files;
-   Error error = listFiles(filePath, &files, includeHidden, pJsonFiles);
+   // scan the directory and cache the listing; this also serves as the
+   // listing which is compared with the initial scan of the file monitor
+   // for changes
+   std::vector<FileInfo> prevFiles;
+   Error error = scanDirectory(filePath, includeHidden, &prevFiles);
    if (error)
       return error;
 
-   // copy the file listing into a vector of FileInfo which we will order so that it can
-   // be compared with the initial scan of the file montor for changes
-   std::vector<FileInfo> prevFiles;
-   std::transform(files.begin(),
-                  files.end(),
-                  std::back_inserter(prevFiles),
-                  core::toFileInfo);
+   BOOST_FOREACH(const FileInfo& fileInfo, prevFiles)
+   {
+      cachedFiles_[fileInfo.absolutePath()] = fileInfo;
+   }
+   cachedPath_ = filePath;
 
    // kickoff new monitor
    core::system::file_monitor::Callbacks cb;
    cb.onRegistered = boost::bind(&FilesListingMonitor::onRegistered,
                                     this, _1, filePath, prevFiles, _2);
    cb.onRegistrationError =  boost::bind(core::log::logError, _1, ERROR_LOCATION);
-   cb.onFilesChanged = boost::bind(module_context::enqueFileChangedEvents, filePath, _1);
+   cb.onFilesChanged = boost::bind(&FilesListingMonitor::onFilesChanged,
+                                   this, filePath, _1);
    cb.onMonitoringError = boost::bind(core::log::logError, _1, ERROR_LOCATION);
    cb.onUnregistered = boost::bind(&FilesListingMonitor::onUnregistered, this, _1);
    core::system::file_monitor::registerMonitor(filePath,
@@ -92,6 +260,8 @@ void FilesListingMonitor::stop()
 {
    // reset monitored path and unregister any existing handle
    currentPath_ = FilePath();
+   cachedPath_ = FilePath();
+   cachedFiles_.clear();
    if (!currentHandle_.empty())
    {
       core::system::file_monitor::unregisterMonitor(currentHandle_);
@@ -104,6 +274,40 @@ const FilePath& FilesListingMonitor::currentMonitoredPath() const
    return currentPath_;
 }
 
+bool FilesListingMonitor::isMonitoring(const FilePath& filePath,
+                                       bool includeHidden) const
+{
+   return !cachedPath_.empty() &&
+          filePath == cachedPath_ &&
+          includeHidden == includeHidden_;
+}
+
+Error FilesListingMonitor::listWindow(const FilePath& rootPath,
+                                      bool includeHidden,
+                                      const ListingWindow& window,
+                                      std::size_t* pTotal,
+                                      json::Array* pJsonFiles) const
+{
+   if (isMonitoring(rootPath, includeHidden))
+   {
+      listFilesWindow(rootPath, cachedFiles_, window, pTotal, pJsonFiles);
+      return Success();
+   }
+
+   if (!includeHidden)
+   {
+      DirectoryIndex::const_iterator it =
+                              projectFiles_.find(rootPath.absolutePath());
+      if (it != projectFiles_.end())
+      {
+         listFilesWindow(rootPath, it->second, window, pTotal, pJsonFiles);
+         return Success();
+      }
+   }
+
+   return listFilesWindow(rootPath, includeHidden, window, pTotal, pJsonFiles);
+}
+
 namespace {
 
 // Convert fileInfo returned from file monitor into a normalized path which
@@ -167,7 +371,112 @@ void FilesListingMonitor::onRegistered(core::system::file_monitor::Handle handle
 
    // enque any events we discovered
    if (!events.empty())
-      module_context::enqueFileChangedEvents(filePath, events);
+      onFilesChanged(filePath, events);
+}
+
+void FilesListingMonitor::onFilesChanged(
+      const FilePath& filePath,
+      const std::vector<core::system::FileChangeEvent>& events)
+{
+   // keep the cached listing in step with what the client is told
+   if (filePath == cachedPath_)
+      updateCachedFiles(events);
+
+   module_context::enqueFileChangedEvents(filePath, events);
+}
+
+void FilesListingMonitor::updateCachedFiles(
+      const std::vector<core::system::FileChangeEvent>& events)
+{
+   using namespace core::system;
+   BOOST_FOREACH(const FileChangeEvent& event, events)
+   {
+      // only the directory's immediate children are listed
+      FilePath filePath(event.fileInfo().absolutePath());
+      if (filePath.parent() != cachedPath_)
+         continue;
+
+      switch (event.type())
+      {
+         case FileChangeEvent::FileAdded:
+         case FileChangeEvent::FileModified:
+            // see normalizeFileScannerPath for why symlinks are re-read
+            cachedFiles_[filePath.absolutePath()] =
+                  normalizeFileScannerPath(event.fileInfo());
+            break;
+         case FileChangeEvent::FileRemoved:
+            cachedFiles_.erase(filePath.absolutePath());
+            break;
+         case FileChangeEvent::None:
+            break;
+      }
+   }
+}
+
+void FilesListingMonitor::onProjectMonitoringEnabled(
+                                          const tree<FileInfo>& files)
+{
+   projectFiles_.clear();
+   for (tree<FileInfo>::iterator it = files.begin(); it != files.end(); ++it)
+   {
+      // index directories even if they're empty
+      if (it->isDirectory())
+         projectFiles_[it->absolutePath()];
+
+      if (it == files.begin())
+         continue;
+
+      // see normalizeFileScannerPath for why symlinks are re-read
+      FilePath filePath(it->absolutePath());
+      projectFiles_[filePath.parent().absolutePath()][filePath.absolutePath()] =
+            it->isSymlink() ? normalizeFileScannerPath(*it) : *it;
+   }
+}
+
+void FilesListingMonitor::onProjectFilesChanged(
+      const std::vector<core::system::FileChangeEvent>& events)
+{
+   using namespace core::system;
+   BOOST_FOREACH(const FileChangeEvent& event, events)
+   {
+      const FileInfo& fileInfo = event.fileInfo();
+      FilePath filePath(fileInfo.absolutePath());
+      std::string parentPath = filePath.parent().absolutePath();
+
+      switch (event.type())
+      {
+         case FileChangeEvent::FileAdded:
+         case FileChangeEvent::FileModified:
+            if (fileInfo.isDirectory())
+               projectFiles_[filePath.absolutePath()];
+            projectFiles_[parentPath][filePath.absolutePath()] =
+                  fileInfo.isSymlink() ? normalizeFileScannerPath(fileInfo) :
+                                         fileInfo;
+            break;
+         case FileChangeEvent::FileRemoved:
+         {
+            projectFiles_[parentPath].erase(filePath.absolutePath());
+
+            // remove the directory's listing and those beneath it
+            projectFiles_.erase(filePath.absolutePath());
+            std::string prefix = filePath.absolutePath() + "/";
+            DirectoryIndex::iterator it = projectFiles_.lower_bound(prefix);
+            while (it != projectFiles_.end() &&
+                   boost::algorithm::starts_with(it->first, prefix))
+            {
+               projectFiles_.erase(it++);
+            }
+            break;
+         }
+         case FileChangeEvent::None:
+            break;
+      }
+   }
+}
+
+void FilesListingMonitor::onProjectMonitoringDisabled()
+{
+   projectFiles_.clear();
 }
 
 void FilesListingMonitor::onUnregistered(core::system::file_monitor::Handle handle)
@@ -180,42 +489,20 @@ void FilesListingMonitor::onUnregistered(core::system::file_monitor::Handle hand
    {
       currentPath_ = FilePath();
       currentHandle_ = core::system::file_monitor::Handle();
+
+      // the cache is no longer kept up to date
+      cachedPath_ = FilePath();
+      cachedFiles_.clear();
    }
 }
 
 Error FilesListingMonitor::listFiles(const FilePath& rootPath,
-                                     std::vector<FilePath>* pFiles,
                                      bool includeHidden,
                                      json::Array* pJsonFiles)
 {
-   // enumerate the files
-   pFiles->clear();
-   core::Error error = rootPath.children(pFiles);
-   if (error)
-      return error;
-
-   using namespace source_control;
-   boost::shared_ptr<FileDecorationContext> pCtx =
-                  source_control::fileDecorationContext(rootPath);
-
-   // sort the files by name
-   std::sort(pFiles->begin(), pFiles->end(), core::compareAbsolutePathNoCase);
-
-   // produce json listing
-   BOOST_FOREACH( core::FilePath& filePath, *pFiles)
-   {
-      // files which may have been deleted after the listing or which
-      // are not end-user visible
-      if (filePath.exists() && 
-            (includeHidden || module_context::fileListingFilter(core::FileInfo(filePath))))
-      {
-         core::json::Object fileObject = module_context::createFileSystemItem(filePath);
-         pCtx->decorateFile(filePath, &fileObject);
-         pJsonFiles->push_back(fileObject) ;
-      }
-   }
-
-   return Success();
+   std::size_t total = 0;
+   return listFilesWindow(rootPath, includeHidden, ListingWindow(), &total,
+                          pJsonFiles);
 }
 
 
@@ -16,11 +16,13 @@
 #ifndef SESSION_SESSION_FILES_LISTING_MONITOR_HPP
 #define SESSION_SESSION_FILES_LISTING_MONITOR_HPP
 
+#include <map>
 #include <string>
 #include <vector>
 
 #include <boost/utility.hpp>
 
+#include <core/FileInfo.hpp>
 #include <core/collection/Tree.hpp>
 
 #include <core/json/Json.hpp>
@@ -30,7 +32,6 @@ namespace rstudio {
 namespace core {
    class Error;
    class FilePath;
-   class FileInfo;
    namespace system {
       class FileChangeEvent;
    }
@@ -47,6 +48,38 @@ namespace modules {
 
 namespace files {
 
+// a window onto a directory listing; listings are sorted, filtered, and
+// paged before they're sent to the client so that a huge directory can be
+// browsed without transferring (or decorating) every file in it
+struct ListingWindow
+{
+   ListingWindow()
+      : sortColumn(kSortByName), ascending(true), offset(0), count(0)
+   {
+   }
+
+   static const char * const kSortByName;
+   static const char * const kSortBySize;
+   static const char * const kSortByModified;
+
+   std::string sortColumn;
+   bool ascending;
+
+   // only files whose names contain the filter (ignoring case) are listed
+   std::string filter;
+
+   // range of the sorted, filtered files to list (a count of 0 lists all)
+   std::size_t offset;
+   std::size_t count;
+};
+
+// select the files in a window onto a listing, in order, returning the
+// number of files which pass its filter in pTotal
+void selectListingWindow(const std::vector<const core::FileInfo*>& listing,
+                         const ListingWindow& window,
+                         std::vector<const core::FileInfo*>* pWindowFiles,
+                         std::size_t* pTotal);
+
 class FilesListingMonitor : boost::noncopyable
 {
 public:
@@ -54,20 +87,40 @@ public:
    core::Error start(const core::FilePath& filePath, 
          bool includeHidden, core::json::Array* pJsonFiles);
 
+   // kickoff monitoring without listing the directory
+   core::Error start(const core::FilePath& filePath, bool includeHidden);
+
    void stop();
 
    // what path are we currently monitoring?
    const core::FilePath& currentMonitoredPath() const;
 
+   // are we already monitoring (and caching) the given listing?
+   bool isMonitoring(const core::FilePath& filePath, bool includeHidden) const;
+
+   // keep an index of the files in the project (whose directories the
+   // project monitors in place of us) so that windows onto them are also
+   // listed without scanning the directory
+   void onProjectMonitoringEnabled(const tree<core::FileInfo>& files);
+   void onProjectFilesChanged(
+                  const std::vector<core::system::FileChangeEvent>& events);
+   void onProjectMonitoringDisabled();
+
+   // list a window of the files in a directory, returning the number of
+   // files which pass its filter in pTotal. the files in the monitored
+   // directory are cached (and kept up to date by the monitor) so windows
+   // onto it are listed without scanning the directory again
+   core::Error listWindow(const core::FilePath& rootPath,
+                          bool includeHidden,
+                          const ListingWindow& window,
+                          std::size_t* pTotal,
+                          core::json::Array* pJsonFiles) const;
+
    // convenience method which is also called by listFiles for requests that
    // don't specify monitoring (e.g. file dialog listing)
    static core::Error listFiles(const core::FilePath& rootPath,
                                 bool includeHidden,
-                                core::json::Array* pJsonFiles)
-   {
-      std::vector<core::FilePath> files;
-      return listFiles(rootPath, &files, includeHidden, pJsonFiles);
-   }
+                                core::json::Array* pJsonFiles);
 
 private:
    // stateful handlers for registration and unregistration
@@ -78,16 +131,25 @@ private:
 
    void onUnregistered(core::system::file_monitor::Handle handle);
 
-   // helpers
-   static core::Error listFiles(const core::FilePath& rootPath,
-                                std::vector<core::FilePath>* pFiles,
-                                bool includeHidden, 
-                                core::json::Array* pJsonFiles);
+   void onFilesChanged(const core::FilePath& filePath,
+                       const std::vector<core::system::FileChangeEvent>& events);
+
+   void updateCachedFiles(const std::vector<core::system::FileChangeEvent>& events);
 
 private:
    core::FilePath currentPath_;
    bool includeHidden_;
    core::system::file_monitor::Handle currentHandle_;
+
+   // the files in the directory being monitored (keyed by path)
+   core::FilePath cachedPath_;
+   std::map<std::string, core::FileInfo> cachedFiles_;
+
+   // the files in the project's directories (keyed by directory then path;
+   // hidden files aren't monitored by the project so aren't included)
+   typedef std::map<std::string, std::map<std::string, core::FileInfo> >
+                                                              DirectoryIndex;
+   DirectoryIndex projectFiles_;
 };
 
 
@@ -0,0 +1,143 @@
+/*
+ * SessionFilesListingMonitorTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionFilesListingMonitor.hpp"
+
+#include <string>
+#include <vector>
+
+#include <core/FileInfo.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace files {
+namespace tests {
+
+using namespace rstudio::core;
+
+namespace {
+
+// the names of the files in a window onto a listing
+std::string windowNames(const std::vector<FileInfo>& files,
+                        const ListingWindow& window,
+                        std::size_t* pTotal)
+{
+   std::vector<const FileInfo*> listing;
+   for (std::size_t i = 0; i < files.size(); i++)
+      listing.push_back(&files[i]);
+
+   std::vector<const FileInfo*> windowFiles;
+   selectListingWindow(listing, window, &windowFiles, pTotal);
+
+   std::string names;
+   for (std::size_t i = 0; i < windowFiles.size(); i++)
+   {
+      std::string path = windowFiles[i]->absolutePath();
+      if (!names.empty())
+         names += " ";
+      names += path.substr(path.rfind('/') + 1);
+   }
+   return names;
+}
+
+} // anonymous namespace
+
+context("Files listing windows")
+{
+   // name, size and modification times all sort differently
+   std::vector<FileInfo> files;
+   files.push_back(FileInfo("/dir/c.R", false, 10, 300));
+   files.push_back(FileInfo("/dir/A.R", false, 30, 100));
+   files.push_back(FileInfo("/dir/b.txt", false, 20, 500));
+   files.push_back(FileInfo("/dir/D.txt", false, 50, 200));
+   files.push_back(FileInfo("/dir/e.R", false, 40, 400));
+
+   std::size_t total = 0;
+
+   test_that("Windows are sorted by name ignoring case")
+   {
+      ListingWindow window;
+      expect_true(windowNames(files, window, &total) == "A.R b.txt c.R D.txt e.R");
+      expect_true(total == 5);
+
+      window.ascending = false;
+      expect_true(windowNames(files, window, &total) == "e.R D.txt c.R b.txt A.R");
+   }
+
+   test_that("Windows can be sorted by size or modification time")
+   {
+      ListingWindow window;
+      window.sortColumn = ListingWindow::kSortBySize;
+      expect_true(windowNames(files, window, &total) == "c.R b.txt A.R e.R D.txt");
+
+      window.sortColumn = ListingWindow::kSortByModified;
+      window.ascending = false;
+      expect_true(windowNames(files, window, &total) == "b.txt e.R c.R D.txt A.R");
+   }
+
+   test_that("Windows select a range of the sorted files")
+   {
+      ListingWindow window;
+      window.offset = 1;
+      window.count = 2;
+      expect_true(windowNames(files, window, &total) == "b.txt c.R");
+      expect_true(total == 5);
+
+      // a range which runs past the end is truncated
+      window.offset = 3;
+      window.count = 10;
+      expect_true(windowNames(files, window, &total) == "D.txt e.R");
+
+      // as is one which starts past the end
+      window.offset = 5;
+      expect_true(windowNames(files, window, &total).empty());
+      expect_true(total == 5);
+
+      // a count of 0 lists the rest of the files
+      window.offset = 2;
+      window.count = 0;
+      expect_true(windowNames(files, window, &total) == "c.R D.txt e.R");
+   }
+
+   test_that("Filters are applied before the range is selected")
+   {
+      ListingWindow window;
+      window.filter = "r";
+      window.offset = 1;
+      window.count = 1;
+      expect_true(windowNames(files, window, &total) == "c.R");
+      expect_true(total == 3);
+
+      window.filter = "TXT";
+      window.offset = 0;
+      window.count = 0;
+      expect_true(windowNames(files, window, &total) == "b.txt D.txt");
+      expect_true(total == 2);
+
+      // only file names (not their directories) are matched
+      window.filter = "dir";
+      expect_true(windowNames(files, window, &total).empty());
+      expect_true(total == 0);
+   }
+}
+
+} // namespace tests
+} // namespace files
+} // namespace modules
+} // namespace session
+} // namespace rstudio
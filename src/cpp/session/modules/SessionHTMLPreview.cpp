@@ -33,7 +33,6 @@
 #include <core/FileSerializer.hpp>
 #include <core/HtmlUtils.hpp>
 #include <core/http/Util.hpp>
-#include <core/PerformanceTimer.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/text/TemplateFilter.hpp>
 #include <core/system/Process.hpp>
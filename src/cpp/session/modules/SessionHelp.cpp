@@ -16,8 +16,11 @@
 #include "SessionHelp.hpp"
 
 #include <algorithm>
+#include <deque>
+#include <map>
 
 #include <boost/regex.hpp>
+#include <boost/foreach.hpp>
 #include <boost/function.hpp>
 #include <boost/format.hpp>
 #include <boost/range/iterator_range.hpp>
@@ -28,12 +31,17 @@
 #include <core/Error.hpp>
 #include <core/Exec.hpp>
 #include <core/Log.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/Thread.hpp>
+
+#include <core/collection/LruCache.hpp>
 
 #include <core/http/Request.hpp>
 #include <core/http/Response.hpp>
 #include <core/http/URL.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/system/Process.hpp>
+#include <core/system/System.hpp>
 #include <core/system/ShellUtils.hpp>
 #include <core/r_util/RPackageInfo.hpp>
 
@@ -369,7 +377,8 @@ template <typename Filter>
 void handleHttpdResult(SEXP httpdSEXP, 
                        const http::Request& request, 
                        const Filter& htmlFilter,
-                       http::Response* pResponse)
+                       http::Response* pResponse,
+                       std::string* pHtmlContent = NULL)
 {
    // NOTE: this function is a port of process_request in Rhttpd.c
    // (that function is coupled to sending its results via the R http daemon, 
@@ -493,6 +502,10 @@ void handleHttpdResult(SEXP httpdSEXP,
             // set body (apply filter to html)
             if (pResponse->contentType() == kTextHtml)
             {
+               // provide the (unfiltered) html to the caller
+               if (pHtmlContent)
+                  *pHtmlContent = content;
+
                setDynamicContentResponse(content, 
                                          request, 
                                          htmlFilter, 
@@ -736,6 +749,315 @@ void handleRdPreviewRequest(const http::Request& request,
    }
 }
 
+// rendered help topics are cached by package, package version and topic so
+// that they can be served from the connection listener thread (and therefore
+// while R is busy). pages are kept in memory as well as persisted within the
+// user scratch path so that they survive across sessions.
+const char * const kHelpCacheDir = "help-cache";
+const std::size_t kHelpCacheMemoryBytes = 16 * 1024 * 1024;
+const std::size_t kHelpCacheMaxPrepopulate = 2000;
+const boost::posix_time::time_duration kHelpCacheMaxUnusedAge =
+                                             boost::posix_time::hours(24 * 30);
+
+std::size_t helpPageCost(const std::string& key, const std::string& content)
+{
+   return key.size() + content.size();
+}
+
+class HelpCache : boost::noncopyable
+{
+public:
+   HelpCache()
+      : pages_(kHelpCacheMemoryBytes, 4, helpPageCost)
+   {
+   }
+
+   void setRoot(const FilePath& root)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         root_ = root;
+      }
+      END_LOCK_MUTEX
+   }
+
+   void setPackageVersion(const std::string& package, const std::string& version)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         if (version.empty())
+            versions_.erase(package);
+         else
+            versions_[package] = version;
+      }
+      END_LOCK_MUTEX
+   }
+
+   // forget the versions we know about along with the pages held in
+   // memory (pages on disk are keyed by install, so needn't be removed)
+   void clearPackageVersions()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         versions_.clear();
+      }
+      END_LOCK_MUTEX
+
+      pages_.clear();
+   }
+
+   bool packageVersion(const std::string& package, std::string* pVersion)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         std::map<std::string, std::string>::const_iterator it =
+                                                      versions_.find(package);
+         if (it == versions_.end())
+            return false;
+
+         *pVersion = it->second;
+         return true;
+      }
+      END_LOCK_MUTEX
+
+      return false;
+   }
+
+   // safe to call from any thread (does not touch R)
+   bool lookup(const std::string& package,
+               const std::string& topic,
+               std::string* pContent)
+   {
+      std::string version;
+      if (!packageVersion(package, &version))
+         return false;
+
+      std::string key = pageKey(package, version, topic);
+      if (pages_.get(key, pContent))
+         return true;
+
+      FilePath pageFile = pagePath(package, version, topic);
+      if (pageFile.empty() || !pageFile.exists())
+         return false;
+
+      Error error = readStringFromFile(pageFile, pContent);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return false;
+      }
+
+      pages_.insert(key, *pContent);
+      return true;
+   }
+
+   bool contains(const std::string& package,
+                 const std::string& version,
+                 const std::string& topic)
+   {
+      FilePath pageFile = pagePath(package, version, topic);
+      return !pageFile.empty() && pageFile.exists();
+   }
+
+   // called only from the main thread
+   void store(const std::string& package,
+              const std::string& version,
+              const std::string& topic,
+              const std::string& content)
+   {
+      FilePath pageFile = pagePath(package, version, topic);
+      if (pageFile.empty())
+         return;
+
+      // write to a temporary file and then move it into place so that
+      // readers on the listener thread never see a partially written page
+      Error error = pageFile.parent().ensureDirectory();
+      if (!error)
+      {
+         // (the cache is shared by all of the user's sessions, so the
+         // temporary file is unique to this process)
+         FilePath tempFile = pageFile.parent().childPath(
+                  topic + "." +
+                  safe_convert::numberToString(core::system::currentProcessId()) +
+                  ".tmp");
+         error = writeStringToFile(tempFile, content);
+         if (!error)
+            error = tempFile.move(pageFile);
+      }
+      if (error)
+         LOG_ERROR(error);
+
+      pages_.insert(pageKey(package, version, topic), content);
+   }
+
+   // note that this session is using a version of a package (so that its
+   // pages aren't pruned while in use)
+   void markVersionUsed(const std::string& package, const std::string& version)
+   {
+      FilePath packageDir = packagePath(package);
+      if (packageDir.empty())
+         return;
+
+      FilePath versionDir = packageDir.childPath(version);
+      if (versionDir.exists())
+         versionDir.setLastWriteTime();
+   }
+
+   // remove the pages of package versions which no session has used (or
+   // rendered pages for) recently. other sessions may be using other
+   // versions (e.g. from another library) so we can't prune by version
+   void removeUnusedVersions(const boost::posix_time::time_duration& maxAge)
+   {
+      FilePath root;
+      LOCK_MUTEX(mutex_)
+      {
+         root = root_;
+      }
+      END_LOCK_MUTEX
+
+      if (root.empty() || !root.exists())
+         return;
+
+      std::time_t cutoff = ::time(NULL) - maxAge.total_seconds();
+
+      std::vector<FilePath> packageDirs;
+      Error error = root.children(&packageDirs);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return;
+      }
+
+      BOOST_FOREACH(const FilePath& packageDir, packageDirs)
+      {
+         std::vector<FilePath> versionDirs;
+         error = packageDir.children(&versionDirs);
+         if (error)
+         {
+            LOG_ERROR(error);
+            continue;
+         }
+
+         BOOST_FOREACH(const FilePath& versionDir, versionDirs)
+         {
+            if (versionDir.lastWriteTime() >= cutoff)
+               continue;
+
+            error = versionDir.remove();
+            if (error)
+               LOG_ERROR(error);
+         }
+      }
+   }
+
+private:
+   static std::string pageKey(const std::string& package,
+                              const std::string& version,
+                              const std::string& topic)
+   {
+      return package + "/" + version + "/" + topic;
+   }
+
+   FilePath packagePath(const std::string& package)
+   {
+      FilePath root;
+      LOCK_MUTEX(mutex_)
+      {
+         root = root_;
+      }
+      END_LOCK_MUTEX
+
+      if (root.empty())
+         return FilePath();
+
+      return root.childPath(package);
+   }
+
+   FilePath pagePath(const std::string& package,
+                     const std::string& version,
+                     const std::string& topic)
+   {
+      FilePath packageDir = packagePath(package);
+      if (packageDir.empty())
+         return FilePath();
+
+      return packageDir.childPath(version).childPath(topic + ".html");
+   }
+
+   boost::mutex mutex_;
+   FilePath root_;
+   std::map<std::string, std::string> versions_;
+   core::collection::LruCache<std::string, std::string> pages_;
+};
+
+HelpCache s_helpCache;
+
+// help topic pages are requested as /library/<package>/html/<topic>.html
+bool helpTopicForPath(const std::string& path,
+                      const http::Request& request,
+                      std::string* pPackage,
+                      std::string* pTopic)
+{
+   if (request.method() != "GET" || !request.queryString().empty())
+      return false;
+
+   static const boost::regex reTopic(
+            "^/library/([A-Za-z0-9._]+)/html/([A-Za-z0-9._+-]+)\\.html$");
+
+   boost::smatch match;
+   if (!regex_utils::match(path, match, reTopic))
+      return false;
+
+   *pPackage = match[1];
+   *pTopic = match[2];
+   return true;
+}
+
+bool isValidHelpTopic(const std::string& topic)
+{
+   static const boost::regex reTopic("^[A-Za-z0-9._+-]+$");
+   return regex_utils::match(topic, reTopic);
+}
+
+void setCachedHelpResponse(const std::string& content,
+                           const http::Request& request,
+                           http::Response* pResponse)
+{
+   pResponse->setStatusCode(http::status::Ok);
+   pResponse->setContentType("text/html");
+   setDynamicContentResponse(content,
+                             request,
+                             HelpContentsFilter(request),
+                             pResponse);
+}
+
+std::string helpCachePackageVersion(const std::string& package)
+{
+   std::string version;
+   if (s_helpCache.packageVersion(package, &version))
+      return version;
+
+   Error error = r::exec::RFunction(".rs.helpCachePackageVersion", package)
+                                                               .call(&version);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return std::string();
+   }
+
+   s_helpCache.setPackageVersion(package, version);
+   return version;
+}
+
+void storeHelpTopic(const std::string& package,
+                    const std::string& topic,
+                    const std::string& content)
+{
+   std::string version = helpCachePackageVersion(package);
+   if (!version.empty())
+      s_helpCache.store(package, version, topic, content);
+}
+
 template <typename Filter>
 void handleHttpdRequest(const std::string& location,
                         const HandlerSource& handlerSource,
@@ -800,6 +1122,20 @@ void handleHttpdRequest(const std::string& location,
       return;
    }
 
+   // serve rendered help topics from the cache when we can
+   std::string package, topic;
+   bool isHelpTopic = location == kHelpLocation &&
+                      helpTopicForPath(path, request, &package, &topic);
+   if (isHelpTopic)
+   {
+      std::string content;
+      if (s_helpCache.lookup(package, topic, &content))
+      {
+         setCachedHelpResponse(content, request, pResponse);
+         return;
+      }
+   }
+
    // evalute the handler
    r::sexp::Protect rp;
    SEXP httpdSEXP;
@@ -828,7 +1164,10 @@ void handleHttpdRequest(const std::string& location,
    // content returned from httpd
    else if (TYPEOF(httpdSEXP) == VECSXP && LENGTH(httpdSEXP) > 0)
    {
-      handleHttpdResult(httpdSEXP, request, filter, pResponse);
+      std::string content;
+      handleHttpdResult(httpdSEXP, request, filter, pResponse, &content);
+      if (isHelpTopic && !content.empty())
+         storeHelpTopic(package, topic, content);
    }
    
    // unexpected SEXP type returned from httpd
@@ -960,6 +1299,165 @@ void handleHelpRequest(const http::Request& request, http::Response* pResponse)
                       pResponse);
 }
 
+// renders help topics for the attached packages into the help cache during
+// idle time (one topic per call so we never hold up the console for long)
+class HelpCachePrepopulator : boost::noncopyable
+{
+public:
+   void add(const std::string& package, const std::string& topic)
+   {
+      topics_.push_back(std::make_pair(package, topic));
+   }
+
+   std::size_t size() const { return topics_.size(); }
+
+   bool execute()
+   {
+      if (topics_.empty())
+         return false;
+
+      std::string package = topics_.front().first;
+      std::string topic = topics_.front().second;
+      topics_.pop_front();
+
+      // synthesize the request the help pane would make for this topic
+      http::Request request;
+      request.setMethod("GET");
+      request.setUri(std::string(kHelpLocation) +
+                     "/library/" + package + "/html/" + topic + ".html");
+      std::string path = http::util::pathAfterPrefix(request, kHelpLocation);
+
+      r::sexp::Protect rp;
+      SEXP httpdSEXP;
+      Error error = r::exec::executeSafely<SEXP>(
+            boost::bind(callHandler,
+                        path,
+                        boost::cref(request),
+                        HandlerSource(boost::bind(r::sexp::findFunction,
+                                                  "httpd", "tools")),
+                        &rp),
+            &httpdSEXP);
+      if (error)
+      {
+         LOG_ERROR(error);
+      }
+      else if (TYPEOF(httpdSEXP) == VECSXP && LENGTH(httpdSEXP) > 0)
+      {
+         http::Response response;
+         std::string content;
+         handleHttpdResult(httpdSEXP,
+                           request,
+                           http::NullOutputFilter(),
+                           &response,
+                           &content);
+         if (!content.empty())
+            storeHelpTopic(package, topic, content);
+      }
+
+      return !topics_.empty();
+   }
+
+private:
+   std::deque<std::pair<std::string, std::string> > topics_;
+};
+
+void updateHelpCachePackageVersions()
+{
+   r::sexp::Protect protect;
+   SEXP attachedSEXP;
+   Error error = r::exec::RFunction(".rs.helpCacheAttachedPackages")
+                                             .call(&attachedSEXP, &protect);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   std::vector<std::string> packages, versions;
+   error = r::sexp::getNamedListElement(attachedSEXP, "packages", &packages);
+   if (!error)
+      error = r::sexp::getNamedListElement(attachedSEXP, "versions", &versions);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   for (std::size_t i = 0; i < packages.size() && i < versions.size(); i++)
+   {
+      s_helpCache.setPackageVersion(packages[i], versions[i]);
+      if (!versions[i].empty())
+         s_helpCache.markVersionUsed(packages[i], versions[i]);
+   }
+}
+
+void prepopulateHelpCache()
+{
+   r::sexp::Protect protect;
+   SEXP candidatesSEXP;
+   Error error = r::exec::RFunction(".rs.helpCacheCandidates")
+                                             .call(&candidatesSEXP, &protect);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   std::vector<std::string> packages, topics;
+   error = r::sexp::getNamedListElement(candidatesSEXP, "packages", &packages);
+   if (!error)
+      error = r::sexp::getNamedListElement(candidatesSEXP, "topics", &topics);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // queue the topics which aren't already cached
+   boost::shared_ptr<HelpCachePrepopulator> pPrepopulator(
+                                                new HelpCachePrepopulator());
+   for (std::size_t i = 0; i < packages.size() && i < topics.size(); i++)
+   {
+      if (pPrepopulator->size() >= kHelpCacheMaxPrepopulate)
+         break;
+
+      std::string version;
+      if (!s_helpCache.packageVersion(packages[i], &version) ||
+          version.empty() ||
+          !isValidHelpTopic(topics[i]) ||
+          s_helpCache.contains(packages[i], version, topics[i]))
+      {
+         continue;
+      }
+
+      pPrepopulator->add(packages[i], topics[i]);
+   }
+
+   if (pPrepopulator->size() > 0)
+   {
+      module_context::scheduleIncrementalWork(
+               boost::posix_time::milliseconds(20),
+               boost::bind(&HelpCachePrepopulator::execute, pPrepopulator));
+   }
+}
+
+void onDeferredInit(bool newSession)
+{
+   s_helpCache.removeUnusedVersions(kHelpCacheMaxUnusedAge);
+   updateHelpCachePackageVersions();
+   prepopulateHelpCache();
+}
+
+void onPackageLibraryMutated()
+{
+   // packages may have been installed or updated (possibly reinstalled at
+   // the same version), so forget the versions and pages we know about
+   // (we'll learn the versions, which identify the install, again as topics
+   // are rendered)
+   s_helpCache.clearPackageVersions();
+   updateHelpCachePackageVersions();
+}
+
 SEXP rs_previewRd(SEXP rdFileSEXP)
 {
    std::string rdFile = r::sexp::safeAsString(rdFileSEXP);
@@ -981,6 +1479,26 @@ SEXP rs_showPythonHelp(SEXP codeSEXP)
 }
 
 } // anonymous namespace
+
+bool handleCachedHelpRequest(const http::Request& request,
+                             http::Response* pResponse)
+{
+   std::string helpPrefix = std::string(kHelpLocation) + "/";
+   if (!boost::algorithm::starts_with(request.uri(), helpPrefix))
+      return false;
+
+   std::string path = http::util::pathAfterPrefix(request, kHelpLocation);
+   std::string package, topic;
+   if (!helpTopicForPath(path, request, &package, &topic))
+      return false;
+
+   std::string content;
+   if (!s_helpCache.lookup(package, topic, &content))
+      return false;
+
+   setCachedHelpResponse(content, request, pResponse);
+   return true;
+}
    
 Error initialize()
 {
@@ -1013,6 +1531,14 @@ Error initialize()
    if (error)
       LOG_ERROR(error);
 
+   // rendered help cache (persisted per R version)
+   s_helpCache.setRoot(module_context::userScratchPath()
+                          .complete(kHelpCacheDir)
+                          .complete(module_context::rVersion()));
+   module_context::events().onDeferredInit.connect(onDeferredInit);
+   module_context::events().onPackageLibraryMutated.connect(
+                                                      onPackageLibraryMutated);
+
    // handle /custom and /session urls internally if necessary (always in
    // server mode, in desktop mode if the internal http server can't
    // bind to a port)
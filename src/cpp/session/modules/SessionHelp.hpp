@@ -19,6 +19,10 @@
 namespace rstudio {
 namespace core {
    class Error;
+namespace http {
+   class Request;
+   class Response;
+}
 }
 }
  
@@ -28,6 +32,11 @@ namespace modules {
 namespace help {
    
 core::Error initialize();
+
+// serve a help topic from the rendered help cache. this doesn't require R
+// so may be called from any thread; returns false if the topic isn't cached
+bool handleCachedHelpRequest(const core::http::Request& request,
+                             core::http::Response* pResponse);
                        
 } // namespace help
 } // namespace modules
@@ -0,0 +1,461 @@
+/*
+ * SessionHelpIndex.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionHelpIndex.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <core/Error.hpp>
+#include <core/Exec.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/system/System.hpp>
+#include <core/text/SearchIndex.hpp>
+
+#include <r/RExec.hpp>
+#include <r/RSexp.hpp>
+
+#include <session/SessionModuleContext.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace help_index {
+
+namespace {
+
+// per-package index files live here, named <package>_<version>.idx; they
+// are built once for each installed package version and then reused
+// (memory mapped) by subsequent sessions
+const char * const kHelpIndexDir = "help-index";
+const char * const kHelpIndexExt = ".idx";
+
+// upper bound on the amount of vignette source we index
+const std::size_t kMaxVignetteText = 512 * 1024;
+
+struct InstalledPackage
+{
+   std::string name;
+   std::string version;
+   FilePath path;
+};
+
+struct IndexedPackage
+{
+   std::string version;
+   boost::shared_ptr<text::SearchIndex> pIndex;
+};
+
+// indexes which are currently open, by package
+std::map<std::string, IndexedPackage> s_indexes;
+
+// packages waiting to be indexed
+std::deque<InstalledPackage> s_pending;
+
+// number of installed packages (for reporting indexing progress)
+std::size_t s_installedCount = 0;
+
+FilePath helpIndexDir()
+{
+   return module_context::userScratchPath().complete(kHelpIndexDir);
+}
+
+FilePath indexFilePath(const std::string& package, const std::string& version)
+{
+   return helpIndexDir().complete(package + "_" + version + kHelpIndexExt);
+}
+
+Error installedPackages(std::vector<InstalledPackage>* pPackages)
+{
+   r::sexp::Protect protect;
+   SEXP installedSEXP;
+   Error error = r::exec::RFunction(".rs.helpIndexInstalledPackages")
+                                             .call(&installedSEXP, &protect);
+   if (error)
+      return error;
+
+   std::vector<std::string> names, versions, paths;
+   error = r::sexp::getNamedListElement(installedSEXP, "packages", &names);
+   if (!error)
+      error = r::sexp::getNamedListElement(installedSEXP, "versions", &versions);
+   if (!error)
+      error = r::sexp::getNamedListElement(installedSEXP, "paths", &paths);
+   if (error)
+      return error;
+
+   for (std::size_t i = 0;
+        i < names.size() && i < versions.size() && i < paths.size();
+        i++)
+   {
+      InstalledPackage package;
+      package.name = names[i];
+      package.version = versions[i];
+      package.path = FilePath(paths[i]);
+      pPackages->push_back(package);
+   }
+
+   return Success();
+}
+
+Error readDocuments(SEXP documentsSEXP,
+                    const std::string& name,
+                    std::vector<std::string>* pValues)
+{
+   return r::sexp::getNamedListElement(documentsSEXP, name, pValues);
+}
+
+std::string elementAt(const std::vector<std::string>& values, std::size_t i)
+{
+   return i < values.size() ? values[i] : std::string();
+}
+
+Error buildIndex(const InstalledPackage& package, const FilePath& indexFile)
+{
+   r::sexp::Protect protect;
+   SEXP documentsSEXP;
+   Error error = r::exec::RFunction(".rs.helpIndexDocuments",
+                                    package.name,
+                                    package.path.absolutePath())
+                                             .call(&documentsSEXP, &protect);
+   if (error)
+      return error;
+
+   std::vector<std::string> topics, titles, aliases, keywords, descriptions;
+   std::vector<std::string> vignetteSources, vignetteOutputs, vignetteTitles;
+   if (!error) error = readDocuments(documentsSEXP, "topics", &topics);
+   if (!error) error = readDocuments(documentsSEXP, "titles", &titles);
+   if (!error) error = readDocuments(documentsSEXP, "aliases", &aliases);
+   if (!error) error = readDocuments(documentsSEXP, "keywords", &keywords);
+   if (!error) error = readDocuments(documentsSEXP, "descriptions", &descriptions);
+   if (!error) error = readDocuments(documentsSEXP, "vignetteSources", &vignetteSources);
+   if (!error) error = readDocuments(documentsSEXP, "vignetteOutputs", &vignetteOutputs);
+   if (!error) error = readDocuments(documentsSEXP, "vignetteTitles", &vignetteTitles);
+   if (error)
+      return error;
+
+   text::SearchIndexBuilder builder;
+
+   for (std::size_t i = 0; i < topics.size(); i++)
+   {
+      std::string title = elementAt(titles, i);
+      text::SearchDocument document(topics[i], title, "help");
+      document.addText(text::SearchFieldName, topics[i]);
+      document.addText(text::SearchFieldAlias, elementAt(aliases, i));
+      document.addText(text::SearchFieldTitle, title);
+      document.addText(text::SearchFieldKeyword, elementAt(keywords, i));
+      document.addText(text::SearchFieldDescription, elementAt(descriptions, i));
+      builder.addDocument(document);
+   }
+
+   for (std::size_t i = 0; i < vignetteSources.size(); i++)
+   {
+      std::string title = elementAt(vignetteTitles, i);
+      text::SearchDocument document(elementAt(vignetteOutputs, i),
+                                    title,
+                                    "vignette");
+      document.addText(text::SearchFieldTitle, title);
+
+      std::string source;
+      FilePath sourcePath(vignetteSources[i]);
+      if (sourcePath.exists())
+      {
+         Error error = readStringFromFile(sourcePath, &source);
+         if (error)
+            LOG_ERROR(error);
+         else if (source.size() > kMaxVignetteText)
+            source.resize(kMaxVignetteText);
+      }
+      document.addText(text::SearchFieldText, source);
+
+      builder.addDocument(document);
+   }
+
+   // write to a temporary file then move it into place so that a partially
+   // written index is never picked up by another session
+   error = indexFile.parent().ensureDirectory();
+   if (error)
+      return error;
+
+   std::string tempName = indexFile.stem() + "-" +
+                          core::system::generateUuid(false) + ".tmp";
+   FilePath tempFile = indexFile.parent().complete(tempName);
+   error = builder.write(tempFile);
+   if (!error)
+      error = tempFile.move(indexFile);
+   if (error)
+   {
+      tempFile.removeIfExists();
+      return error;
+   }
+
+   return Success();
+}
+
+Error openIndex(const InstalledPackage& package, const FilePath& indexFile)
+{
+   boost::shared_ptr<text::SearchIndex> pIndex(new text::SearchIndex());
+   Error error = pIndex->open(indexFile);
+   if (error)
+      return error;
+
+   IndexedPackage indexed;
+   indexed.version = package.version;
+   indexed.pIndex = pIndex;
+   s_indexes[package.name] = indexed;
+   return Success();
+}
+
+bool indexNextPackage()
+{
+   if (s_pending.empty())
+      return false;
+
+   InstalledPackage package = s_pending.front();
+   s_pending.pop_front();
+
+   FilePath indexFile = indexFilePath(package.name, package.version);
+   Error error = buildIndex(package, indexFile);
+   if (!error)
+      error = openIndex(package, indexFile);
+   if (error)
+   {
+      error.addProperty("package", package.name);
+      LOG_ERROR(error);
+   }
+
+   return !s_pending.empty();
+}
+
+void updateIndexes()
+{
+   std::vector<InstalledPackage> packages;
+   Error error = installedPackages(&packages);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   bool wasIndexing = !s_pending.empty();
+   s_pending.clear();
+   s_installedCount = packages.size();
+
+   std::set<std::string> installed;
+   std::set<std::string> indexFiles;
+   BOOST_FOREACH(const InstalledPackage& package, packages)
+   {
+      installed.insert(package.name);
+
+      FilePath indexFile = indexFilePath(package.name, package.version);
+      indexFiles.insert(indexFile.filename());
+
+      // already open at this version?
+      std::map<std::string, IndexedPackage>::const_iterator it =
+                                                   s_indexes.find(package.name);
+      if (it != s_indexes.end() && it->second.version == package.version)
+         continue;
+
+      s_indexes.erase(package.name);
+      if (indexFile.exists())
+      {
+         // unreadable indexes (e.g. written by an older version) are rebuilt
+         error = openIndex(package, indexFile);
+         if (!error)
+            continue;
+
+         LOG_ERROR(error);
+         indexFile.removeIfExists();
+      }
+
+      s_pending.push_back(package);
+   }
+
+   // forget packages which are no longer installed
+   for (std::map<std::string, IndexedPackage>::iterator it = s_indexes.begin();
+        it != s_indexes.end(); )
+   {
+      if (installed.count(it->first) == 0)
+         s_indexes.erase(it++);
+      else
+         ++it;
+   }
+
+   // remove index files for package versions which are no longer installed
+   // (only those we know to be stale; another session may be using a
+   // different set of library paths so this is best effort)
+   FilePath indexDir = helpIndexDir();
+   if (indexDir.exists())
+   {
+      std::vector<FilePath> children;
+      error = indexDir.children(&children);
+      if (error)
+         LOG_ERROR(error);
+
+      BOOST_FOREACH(const FilePath& child, children)
+      {
+         if (child.extensionLowerCase() != kHelpIndexExt)
+            continue;
+
+         std::string filename = child.filename();
+         std::size_t pos = filename.rfind('_');
+         if (pos == std::string::npos)
+            continue;
+
+         std::string package = filename.substr(0, pos);
+         if (installed.count(package) && !indexFiles.count(filename))
+         {
+            error = child.remove();
+            if (error)
+               LOG_ERROR(error);
+         }
+      }
+   }
+
+   // index any new package versions during idle time
+   if (!s_pending.empty() && !wasIndexing)
+   {
+      module_context::scheduleIncrementalWork(
+               boost::posix_time::milliseconds(200),
+               indexNextPackage);
+   }
+}
+
+struct PackageMatch
+{
+   std::string package;
+   std::string name;
+   std::string title;
+   std::string type;
+   double score;
+};
+
+bool packageMatchBetter(const PackageMatch& lhs, const PackageMatch& rhs)
+{
+   if (lhs.score != rhs.score)
+      return lhs.score > rhs.score;
+   else if (lhs.package != rhs.package)
+      return lhs.package < rhs.package;
+   else
+      return lhs.name < rhs.name;
+}
+
+Error searchHelpIndex(const json::JsonRpcRequest& request,
+                      json::JsonRpcResponse* pResponse)
+{
+   std::string query;
+   int maxResults = 0;
+   Error error = json::readParams(request.params, &query, &maxResults);
+   if (error)
+      return error;
+
+   text::SearchOptions options;
+   if (maxResults > 0)
+      options.maxResults = maxResults;
+
+   std::vector<PackageMatch> matches;
+   for (std::map<std::string, IndexedPackage>::const_iterator it = s_indexes.begin();
+        it != s_indexes.end();
+        ++it)
+   {
+      const text::SearchIndex& index = *it->second.pIndex;
+      std::vector<text::SearchMatch> packageMatches = index.search(query, options);
+      BOOST_FOREACH(const text::SearchMatch& packageMatch, packageMatches)
+      {
+         PackageMatch match;
+         match.package = it->first;
+         match.name = index.documentName(packageMatch.document);
+         match.title = index.documentTitle(packageMatch.document);
+         match.type = index.documentType(packageMatch.document);
+         match.score = packageMatch.score;
+         matches.push_back(match);
+      }
+   }
+
+   if (matches.size() > options.maxResults)
+   {
+      std::partial_sort(matches.begin(),
+                        matches.begin() + options.maxResults,
+                        matches.end(),
+                        packageMatchBetter);
+      matches.resize(options.maxResults);
+   }
+   else
+   {
+      std::sort(matches.begin(), matches.end(), packageMatchBetter);
+   }
+
+   json::Array resultsJson;
+   BOOST_FOREACH(const PackageMatch& match, matches)
+   {
+      json::Object matchJson;
+      matchJson["package"] = match.package;
+      matchJson["name"] = match.name;
+      matchJson["title"] = match.title;
+      matchJson["type"] = match.type;
+      matchJson["score"] = match.score;
+      resultsJson.push_back(matchJson);
+   }
+
+   json::Object resultJson;
+   resultJson["results"] = resultsJson;
+   resultJson["indexed_packages"] = static_cast<int>(s_indexes.size());
+   resultJson["installed_packages"] = static_cast<int>(s_installedCount);
+   resultJson["complete"] = s_pending.empty();
+   pResponse->setResult(resultJson);
+
+   return Success();
+}
+
+void onDeferredInit(bool newSession)
+{
+   updateIndexes();
+}
+
+void onPackageLibraryMutated()
+{
+   updateIndexes();
+}
+
+} // anonymous namespace
+
+Error initialize()
+{
+   using boost::bind;
+   using namespace module_context;
+
+   events().onDeferredInit.connect(onDeferredInit);
+   events().onPackageLibraryMutated.connect(onPackageLibraryMutated);
+
+   ExecBlock initBlock;
+   initBlock.addFunctions()
+      (bind(registerRpcMethod, "search_help_index", searchHelpIndex))
+      (bind(sourceModuleRFile, "SessionHelpIndex.R"));
+
+   return initBlock.execute();
+}
+
+} // namespace help_index
+} // namespace modules
+} // namespace session
+} // namespace rstudio
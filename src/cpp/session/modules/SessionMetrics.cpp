@@ -0,0 +1,175 @@
+/*
+ * SessionMetrics.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionMetrics.hpp"
+
+#include <fstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Error.hpp>
+
+#include <monitor/MonitorClient.hpp>
+
+#include <session/SessionConstants.hpp>
+#include <session/SessionModuleContext.hpp>
+#include <session/SessionOptions.hpp>
+
+using namespace rstudio::core;
+using namespace boost::posix_time;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace metrics {
+
+namespace {
+
+using rstudio::monitor::metrics::Metric;
+using rstudio::monitor::metrics::MetricData;
+
+// resource usage as of the last report
+ptime s_lastReportTime;
+double s_lastCpuSeconds = 0;
+
+// rpcs handled since the last report
+int s_rpcCount = 0;
+time_duration s_rpcTotalLatency;
+time_duration s_rpcMaxLatency;
+
+#ifndef _WIN32
+
+double toSeconds(const struct timeval& time)
+{
+   return time.tv_sec + time.tv_usec / 1.0e6;
+}
+
+// cpu time (user and system) used by this process
+double cpuSeconds()
+{
+   struct rusage usage;
+   if (::getrusage(RUSAGE_SELF, &usage) != 0)
+      return 0;
+
+   return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+}
+
+// resident memory used by this process (in MB)
+double residentMemory()
+{
+#ifdef __linux__
+   // statm reports sizes in pages
+   std::ifstream statm("/proc/self/statm");
+   long size = 0, resident = 0;
+   if (statm >> size >> resident)
+      return resident * static_cast<double>(::sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+#endif
+
+   // otherwise fall back to the peak (which macOS reports in bytes)
+   struct rusage usage;
+   if (::getrusage(RUSAGE_SELF, &usage) != 0)
+      return 0;
+   return usage.ru_maxrss / (1024.0 * 1024.0);
+}
+
+double milliseconds(const time_duration& duration)
+{
+   return duration.total_microseconds() / 1000.0;
+}
+
+bool reportMetrics()
+{
+   ptime now = microsec_clock::universal_time();
+   double elapsedSeconds = (now - s_lastReportTime).total_microseconds() / 1.0e6;
+   double cpu = cpuSeconds();
+   double cpuPercent = elapsedSeconds > 0 ?
+                  100 * (cpu - s_lastCpuSeconds) / elapsedSeconds : 0;
+
+   int interval = options().monitorIntervalSeconds();
+   std::vector<Metric> metrics;
+   metrics.push_back(Metric("session", interval,
+                            MetricData("cpu", cpuPercent),
+                            "gauge", "percent", now));
+   metrics.push_back(Metric("session", interval,
+                            MetricData("memory", residentMemory()),
+                            "gauge", "MB", now));
+   metrics.push_back(Metric("session", interval,
+                            MetricData("rpc_count", s_rpcCount),
+                            "gauge", "requests", now));
+   if (s_rpcCount > 0)
+   {
+      metrics.push_back(Metric("session", interval,
+                               MetricData("rpc_latency_mean",
+                                          milliseconds(s_rpcTotalLatency) / s_rpcCount),
+                               "gauge", "ms", now));
+      metrics.push_back(Metric("session", interval,
+                               MetricData("rpc_latency_max",
+                                          milliseconds(s_rpcMaxLatency)),
+                               "gauge", "ms", now));
+   }
+   monitor::client().sendMetrics(metrics);
+
+   s_lastReportTime = now;
+   s_lastCpuSeconds = cpu;
+   s_rpcCount = 0;
+   s_rpcTotalLatency = time_duration();
+   s_rpcMaxLatency = time_duration();
+
+   return true;
+}
+
+#endif
+
+} // anonymous namespace
+
+void recordRpcLatency(const time_duration& latency)
+{
+   s_rpcCount++;
+   s_rpcTotalLatency += latency;
+   if (latency > s_rpcMaxLatency)
+      s_rpcMaxLatency = latency;
+}
+
+Error initialize()
+{
+#ifndef _WIN32
+   // metrics are collected by rserver (which provides the interval)
+   int interval = options().monitorIntervalSeconds();
+   if (options().programMode() != kSessionProgramModeServer || interval <= 0)
+      return Success();
+
+   s_lastReportTime = microsec_clock::universal_time();
+   s_lastCpuSeconds = cpuSeconds();
+
+   // report even when busy (so that runaway sessions are visible)
+   module_context::schedulePeriodicWork(seconds(interval),
+                                        reportMetrics,
+                                        false,
+                                        false);
+#endif
+
+   return Success();
+}
+
+} // namespace metrics
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -104,7 +104,8 @@ Error checkSpelling(const json::JsonRpcRequest& request,
    if (error)
       return error;
 
-   json::Array misspelledIndexes;
+   std::vector<std::string> wordStrings;
+   std::vector<std::size_t> wordIndexes;
    for (std::size_t i=0; i<words.size(); i++)
    {
       if (!json::isType<std::string>(words[i]))
@@ -113,20 +114,23 @@ Error checkSpelling(const json::JsonRpcRequest& request,
          continue;
       }
 
-      std::string word = words[i].get_str();
-      bool isCorrect = true;
-      error = s_pSpellingEngine->checkSpelling(word, &isCorrect);
-      if (error)
-      {
-         // if we can't check a word, ignore it; some combinations of platform, non-ASCII
-         // characters, and locale are known to fail in iconv, and we don't want to put those
-         // failures in front of the user (we just won't be able to spell check those words)
-         LOG_ERROR(error);
-      }
-      else if (!isCorrect) 
-      {
-         misspelledIndexes.push_back(static_cast<int>(i));
-      }
+      wordStrings.push_back(words[i].get_str());
+      wordIndexes.push_back(i);
+   }
+
+   // check all of the words in a single batch (words which can't be
+   // checked are reported as correct so we don't put those failures in
+   // front of the user)
+   std::vector<bool> correct;
+   error = s_pSpellingEngine->checkSpelling(wordStrings, &correct);
+   if (error)
+      return error;
+
+   json::Array misspelledIndexes;
+   for (std::size_t i=0; i<correct.size(); i++)
+   {
+      if (!correct[i])
+         misspelledIndexes.push_back(static_cast<int>(wordIndexes[i]));
    }
 
    pResponse->setResult(misspelledIndexes);
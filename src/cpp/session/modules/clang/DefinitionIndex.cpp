@@ -19,7 +19,6 @@
 
 #include <core/FilePath.hpp>
 #include <core/DateTime.hpp>
-#include <core/PerformanceTimer.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/libclang/LibClang.hpp>
 #include <core/system/ProcessArgs.hpp>
@@ -24,7 +24,6 @@
 
 #include <core/Hash.hpp>
 #include <core/Algorithm.hpp>
-#include <core/PerformanceTimer.hpp>
 #include <core/FileSerializer.hpp>
 
 #include <core/r_util/RToolsInfo.hpp>
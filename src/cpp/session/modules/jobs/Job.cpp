@@ -87,7 +87,8 @@ Job::Job(const std::string& id,
    saveOutput_(saveOutput),
    show_(show),
    actions_(actions),
-   tags_(tags)
+   tags_(tags),
+   outputBytes_(0)
 {
    setState(state);
 }
@@ -104,7 +105,8 @@ Job::Job():
    listening_(false),
    saveOutput_(true),
    show_(true),
-   actions_(R_NilValue)
+   actions_(R_NilValue),
+   outputBytes_(0)
 {
 }
 
@@ -302,6 +304,10 @@ void Job::setState(JobState state)
    // if we don't already have it
    if (complete() && completed_ == 0)
       completed_ = ::time(0);
+
+   // completed jobs produce no further output, so release the output log
+   if (complete())
+      closeOutputLog();
 }
 
 void Job::setListening(bool listening)
@@ -359,6 +365,92 @@ FilePath Job::outputCacheFile()
    return jobCacheFolder().complete(id_ + "-output.json");
 }
 
+FilePath Job::outputIndexFile()
+{
+   return jobCacheFolder().complete(id_ + "-output.idx");
+}
+
+Error Job::openOutputLog()
+{
+   // already open
+   if (pOutputStream_ && pIndexStream_)
+      return Success();
+
+   Error error;
+   FilePath outputFile = outputCacheFile();
+
+   // create parent folder if necessary
+   if (!outputFile.parent().exists())
+   {
+      error = outputFile.parent().ensureDirectory();
+      if (error)
+         return error;
+   }
+
+   // if we have output but no index (e.g. output written by an older
+   // version), build the index before appending to it
+   if (outputFile.exists() && !outputIndexFile().exists())
+   {
+      error = rebuildOutputIndex();
+      if (error)
+         return error;
+   }
+
+   error = outputFile.open_w(&pOutputStream_, false /* don't truncate */);
+   if (error)
+      return error;
+
+   error = outputIndexFile().open_w(&pIndexStream_, false /* don't truncate */);
+   if (error)
+   {
+      pOutputStream_.reset();
+      return error;
+   }
+
+   outputBytes_ = outputFile.exists() ? outputFile.size() : 0;
+   return Success();
+}
+
+void Job::closeOutputLog()
+{
+   pOutputStream_.reset();
+   pIndexStream_.reset();
+}
+
+Error Job::rebuildOutputIndex()
+{
+   boost::shared_ptr<std::istream> pIfs;
+   Error error = outputCacheFile().open_r(&pIfs);
+   if (error)
+      return error;
+
+   boost::shared_ptr<std::ostream> pIdx;
+   error = outputIndexFile().open_w(&pIdx, true /* truncate */);
+   if (error)
+      return error;
+
+   try
+   {
+      std::string content;
+      boost::uint64_t offset = 0;
+      while (std::getline(*pIfs, content))
+      {
+         pIdx->write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+         offset += content.size() + 1;
+      }
+   }
+   catch(const std::exception& e)
+   {
+      error = systemError(boost::system::errc::io_error,
+                                ERROR_LOCATION);
+      error.addProperty("what", e.what());
+      error.addProperty("path", outputIndexFile().absolutePath());
+      return error;
+   }
+
+   return Success();
+}
+
 void Job::addOutput(const std::string& output, bool asError)
 {
    // don't bother the client with empty output events
@@ -385,55 +477,48 @@ void Job::addOutput(const std::string& output, bool asError)
    if (!saveOutput_)
       return;
 
-   // look up output file
-   Error error;
-   FilePath outputFile = outputCacheFile();
-
-   // create parent folder if necessary
-   if (!outputFile.parent().exists())
-   {
-      error = outputFile.parent().ensureDirectory();
-      if (error)
-      {
-         LOG_ERROR(error);
-         return;
-      }
-   }
-
-   // open output file for writing
-   boost::shared_ptr<std::ostream> file;
-   error = outputFile.open_w(&file, false /* don't truncate */);
+   // open the output log (it stays open until the job completes)
+   Error error = openOutputLog();
    if (error)
    {
       LOG_ERROR(error);
       return;
    }
 
-   // create json array with output and write it to the file
+   // create json array with output and serialize it
    json::Array contents;
    contents.push_back(type);
    contents.push_back(output);
-   json::write(contents, *file);
+   std::string line = json::write(contents);
 
-   // append a newline (the file is newline-delimited JSON)
-   *file << std::endl;
-}
+   // record the offset of this line in the index, then append the line (the
+   // file is newline-delimited JSON)
+   pIndexStream_->write(reinterpret_cast<const char*>(&outputBytes_),
+                        sizeof(outputBytes_));
+   *pOutputStream_ << line << '\n';
 
-json::Array Job::output(int position)
-{
-   // read the lines from the file
-   json::Array output;
-   FilePath outputFile = outputCacheFile();
-   boost::shared_ptr<std::istream> pIfs;
-   Error error = outputFile.open_r(&pIfs);
-   if (error)
+   // flush so readers see the output immediately
+   pOutputStream_->flush();
+   pIndexStream_->flush();
+
+   if (pOutputStream_->fail() || pIndexStream_->fail())
    {
-      // path not found is expected if the job hasn't produced any output yet
-      if (!isPathNotFoundError(error))
-         LOG_ERROR(error);
-      return json::Array();
+      error = systemError(boost::system::errc::io_error, ERROR_LOCATION);
+      error.addProperty("path", outputCacheFile().absolutePath());
+      LOG_ERROR(error);
+
+      // discard the index; it will be rebuilt from the log on next use
+      closeOutputLog();
+      outputIndexFile().removeIfExists();
+      return;
    }
 
+   outputBytes_ += line.size() + 1;
+}
+
+json::Array Job::readOutput(std::istream& is, int skip)
+{
+   json::Array output;
    try
    {
       int line = 0;
@@ -441,14 +526,13 @@ json::Array Job::output(int position)
       json::Value val;
 
       // reading eof can trigger a failbit
-      pIfs->exceptions(std::istream::badbit);
+      is.exceptions(std::istream::badbit);
 
       // read each line; parse it as JSON and add it to the output array if it's past the sought
       // position
-      while (!pIfs->eof())
+      while (std::getline(is, content))
       {
-         std::getline(*pIfs, content);
-         if (++line > position)
+         if (++line > skip)
          {
             if (json::parse(content, &val))
             {
@@ -459,19 +543,74 @@ json::Array Job::output(int position)
    }
    catch(const std::exception& e)
    {
-      error = systemError(boost::system::errc::io_error, 
+      Error error = systemError(boost::system::errc::io_error, 
                                 ERROR_LOCATION);
       error.addProperty("what", e.what());
-      error.addProperty("path", outputFile.absolutePath());
+      error.addProperty("path", outputCacheFile().absolutePath());
       LOG_ERROR(error);
    }
 
    return output;
 }
 
+json::Array Job::output(int position)
+{
+   FilePath outputFile = outputCacheFile();
+   boost::shared_ptr<std::istream> pIfs;
+   Error error = outputFile.open_r(&pIfs);
+   if (error)
+   {
+      // path not found is expected if the job hasn't produced any output yet
+      if (!isPathNotFoundError(error))
+         LOG_ERROR(error);
+      return json::Array();
+   }
+
+   if (position <= 0)
+      return readOutput(*pIfs, 0);
+
+   // use the index to seek directly to the requested line
+   FilePath indexFile = outputIndexFile();
+   if (indexFile.exists())
+   {
+      boost::uint64_t entry = static_cast<boost::uint64_t>(position) * sizeof(boost::uint64_t);
+
+      // no index entry for this position means no new output since then
+      if (indexFile.size() < entry + sizeof(boost::uint64_t))
+         return json::Array();
+
+      boost::shared_ptr<std::istream> pIdx;
+      error = indexFile.open_r(&pIdx);
+      if (!error)
+      {
+         boost::uint64_t offset = 0;
+         pIdx->seekg(static_cast<std::streamoff>(entry));
+         pIdx->read(reinterpret_cast<char*>(&offset), sizeof(offset));
+         if (*pIdx && offset <= outputFile.size())
+         {
+            pIfs->seekg(static_cast<std::streamoff>(offset));
+            if (*pIfs)
+               return readOutput(*pIfs, 0);
+         }
+      }
+      else
+      {
+         LOG_ERROR(error);
+      }
+
+      // fall back to a linear scan from the beginning
+      pIfs->clear();
+      pIfs->seekg(0);
+   }
+
+   return readOutput(*pIfs, position);
+}
+
 void Job::cleanup()
 {
+   closeOutputLog();
    outputCacheFile().removeIfExists();
+   outputIndexFile().removeIfExists();
 }
 
 std::string Job::stateAsString(JobState state)
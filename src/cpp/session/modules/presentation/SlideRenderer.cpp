@@ -25,6 +25,7 @@
 #include <core/FilePath.hpp>
 #include <core/StringUtils.hpp>
 #include <core/json/Json.hpp>
+#include <core/collection/LruCache.hpp>
 
 #include <core/markdown/Markdown.hpp>
 
@@ -59,14 +60,43 @@ std::string commandsAsJsonArray(const Slide& slide)
    return ostr.str();
 }
 
+// maximum size (in bytes of markdown and html) of rendered slides to cache
+const std::size_t kMaxRenderedSlidesCacheSize = 4 * 1024 * 1024;
+
+typedef collection::LruCache<std::string, std::string> RenderedSlidesCache;
+
+std::size_t renderedSlideCost(const std::string& markdown,
+                              const std::string& html)
+{
+   return markdown.size() + html.size();
+}
+
+// the whole deck is re-rendered each time it's previewed but typically only
+// the slide being edited has changed, so rendered html is cached by content
+RenderedSlidesCache& renderedSlidesCache()
+{
+   static RenderedSlidesCache instance(kMaxRenderedSlidesCacheSize,
+                                       1,
+                                       renderedSlideCost);
+   return instance;
+}
+
 Error renderMarkdown(const std::string& content, std::string* pHTML)
 {
+   if (renderedSlidesCache().get(content, pHTML))
+      return Success();
+
    markdown::Extensions extensions;
    markdown::HTMLOptions htmlOptions;
-   return markdown::markdownToHTML(content,
-                                   extensions,
-                                   htmlOptions,
-                                   pHTML);
+   Error error = markdown::markdownToHTML(content,
+                                          extensions,
+                                          htmlOptions,
+                                          pHTML);
+   if (error)
+      return error;
+
+   renderedSlidesCache().insert(content, *pHTML);
+   return Success();
 }
 
 
@@ -256,6 +256,172 @@ std::string extractKnitrError(const std::string& stdError)
 
 }
 
+// split presentation source (or the markdown knitted from it) into segments
+// which each begin at a slide's title line; the first segment holds anything
+// preceding the first slide. the segments concatenate to the original text
+std::vector<std::string> splitSlideSegments(const std::string& source)
+{
+   static const boost::regex reHeader("^\\={3,}\\s*$");
+
+   std::vector<std::string> segments;
+   std::size_t segmentBegin = 0;
+   std::size_t previousLineBegin = 0;
+   std::size_t lineBegin = 0;
+   while (lineBegin < source.size())
+   {
+      std::size_t lineEnd = source.find('\n', lineBegin);
+      if (lineEnd == std::string::npos)
+         lineEnd = source.size();
+
+      std::string line = source.substr(lineBegin, lineEnd - lineBegin);
+      if (regex_utils::match(line, reHeader))
+      {
+         // the slide begins at its title (the line before the header)
+         std::size_t slideBegin = lineBegin > 0 ? previousLineBegin : 0;
+         if (slideBegin > segmentBegin)
+         {
+            segments.push_back(source.substr(segmentBegin,
+                                             slideBegin - segmentBegin));
+            segmentBegin = slideBegin;
+         }
+      }
+
+      previousLineBegin = lineBegin;
+      lineBegin = lineEnd + 1;
+   }
+
+   segments.push_back(source.substr(segmentBegin));
+   return segments;
+}
+
+// does a segment of presentation source contain any R code (chunks or
+// inline code)? segments without code knit to themselves
+bool segmentHasCode(const std::string& segment)
+{
+   return segment.find("```{") != std::string::npos ||
+          segment.find("`r ") != std::string::npos;
+}
+
+// the source and knitted markdown of each slide of a presentation as of its
+// last knit
+struct KnitSegment
+{
+   std::string source;
+   std::string markdown;
+   bool hasCode;
+};
+
+typedef std::map<std::string, std::vector<KnitSegment> > KnitSegmentsCache;
+
+KnitSegmentsCache& knitSegmentsCache()
+{
+   static KnitSegmentsCache instance;
+   return instance;
+}
+
+void updateKnitSegments(const FilePath& rmdPath, const FilePath& mdPath)
+{
+   KnitSegmentsCache& cache = knitSegmentsCache();
+   cache.erase(rmdPath.absolutePath());
+
+   std::string source, markdown;
+   Error error = core::readStringFromFile(rmdPath, &source);
+   if (!error)
+      error = core::readStringFromFile(mdPath, &markdown);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // only cache the knit if its output lines up slide by slide with the
+   // source (it won't if e.g. chunk output includes a slide header)
+   std::vector<std::string> sourceSegments = splitSlideSegments(source);
+   std::vector<std::string> markdownSegments = splitSlideSegments(markdown);
+   if (sourceSegments.size() != markdownSegments.size())
+      return;
+
+   std::vector<KnitSegment> segments;
+   for (std::size_t i = 0; i < sourceSegments.size(); i++)
+   {
+      KnitSegment segment;
+      segment.source = sourceSegments[i];
+      segment.markdown = markdownSegments[i];
+      segment.hasCode = segmentHasCode(segment.source);
+      segments.push_back(segment);
+   }
+   cache[rmdPath.absolutePath()] = segments;
+}
+
+// attempt to bring the markdown for a presentation up to date without
+// running knitr. this is possible when the only slides which have changed
+// since the last knit contain no R code (before or after the change): since
+// no code has changed the output of all of the other slides is unchanged
+bool knitIncrementally(const FilePath& rmdPath,
+                       const FilePath& mdPath,
+                       const std::string& encoding)
+{
+   // we splice source text directly into the knitted output so the two
+   // need to share an encoding
+   if (encoding != "UTF-8")
+      return false;
+
+   KnitSegmentsCache& cache = knitSegmentsCache();
+   KnitSegmentsCache::iterator it = cache.find(rmdPath.absolutePath());
+   if (it == cache.end())
+      return false;
+   std::vector<KnitSegment>& segments = it->second;
+
+   std::string source;
+   Error error = core::readStringFromFile(rmdPath, &source);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return false;
+   }
+
+   std::vector<std::string> sourceSegments = splitSlideSegments(source);
+   if (sourceSegments.size() != segments.size())
+      return false;
+
+   std::string markdown;
+   std::vector<std::size_t> changed;
+   for (std::size_t i = 0; i < sourceSegments.size(); i++)
+   {
+      const KnitSegment& segment = segments[i];
+      if (sourceSegments[i] == segment.source)
+      {
+         markdown.append(segment.markdown);
+      }
+      else if (!segment.hasCode && !segmentHasCode(sourceSegments[i]))
+      {
+         markdown.append(sourceSegments[i]);
+         changed.push_back(i);
+      }
+      else
+      {
+         // code has changed so this and every later slide needs to be
+         // re-executed
+         return false;
+      }
+   }
+
+   error = core::writeStringToFile(mdPath, markdown);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return false;
+   }
+
+   BOOST_FOREACH(std::size_t i, changed)
+   {
+      segments[i].source = sourceSegments[i];
+      segments[i].markdown = sourceSegments[i];
+   }
+
+   return true;
+}
+
 bool performKnit(const FilePath& rmdPath,
                  bool clearCache,
                  ErrorResponse* pErrorResponse)
@@ -269,6 +435,8 @@ bool performKnit(const FilePath& rmdPath,
       Error error = mdPath.removeIfExists();
       if (error)
          LOG_ERROR(error);
+
+      knitSegmentsCache().erase(rmdPath.absolutePath());
    }
 
    // Now detect whether we even need to knit -- if there is an .md
@@ -276,6 +444,12 @@ bool performKnit(const FilePath& rmdPath,
    if (mdPath.exists() && (mdPath.lastWriteTime() > rmdPath.lastWriteTime()))
       return true;
 
+   // if only slides without code have changed we can skip knitr
+   std::string encoding = projects::projectContext().defaultEncoding();
+   if(encoding.empty()) encoding = "UTF-8";
+   if (knitIncrementally(rmdPath, mdPath, encoding))
+      return true;
+
    // R binary
    FilePath rProgramPath;
    Error error = module_context::rScriptPath(&rProgramPath);
@@ -326,8 +500,6 @@ bool performKnit(const FilePath& rmdPath,
                                     "comment=NA); "
                      "render_markdown(); "
                      "knit('%2%', output = '%3%', encoding='%4%');");
-   std::string encoding = projects::projectContext().defaultEncoding();
-   if(encoding.empty()) encoding = "UTF-8";
    std::string cmd = boost::str(
       fmt % string_utils::utf8ToSystem(rmdPath.stem())
           % string_utils::utf8ToSystem(rmdPath.filename())
@@ -354,6 +526,8 @@ bool performKnit(const FilePath& rmdPath,
    }
    else if (result.exitStatus != EXIT_SUCCESS)
    {
+      knitSegmentsCache().erase(rmdPath.absolutePath());
+
       // if the markdown file doesn't exist then create one to
       // play the error text back into
       if (!mdPath.exists())
@@ -380,6 +554,7 @@ bool performKnit(const FilePath& rmdPath,
    }
    else
    {
+      updateKnitSegments(rmdPath, mdPath);
       return true;
    }
 }
@@ -203,6 +203,48 @@ Error removeStaleSavedChunks(FilePath& docPath, FilePath& cachePath)
    return Success();
 }
 
+bool linkCacheItem(const FilePath& from, const FilePath& to,
+                   const FilePath& path)
+{
+   FilePath target = to.complete(path.relativePath(from));
+
+   Error error;
+   if (path.isDirectory())
+   {
+      error = target.ensureDirectory();
+   }
+   else if (path.filename() == kNotebookChunkDefFilename)
+   {
+      // chunk definitions are rewritten in place, so each cache needs its own
+      // copy
+      error = path.copy(target);
+   }
+   else
+   {
+      // outputs and libraries are replaced rather than modified once written,
+      // so caches can share them; fall back to a copy if the file system
+      // can't link them
+      error = path.link(target);
+      if (error)
+         error = path.copy(target);
+   }
+
+   if (error)
+      LOG_ERROR(error);
+   return true;
+}
+
+// populate a cache folder from another one without duplicating its contents
+Error linkCacheFolder(const FilePath& source, const FilePath& target)
+{
+   Error error = target.ensureDirectory();
+   if (error)
+      return error;
+
+   return source.childrenRecursive(
+         boost::bind(linkCacheItem, source, target, _2));
+}
+
 void onDocPendingRemove(boost::shared_ptr<source_database::SourceDocument> pDoc)
 {
    // ignore if doc is unsaved (no path)
@@ -292,7 +334,7 @@ void onDocRenamed(const std::string& oldPath,
          return;
    }
 
-   error = oldCacheDir.copyDirectoryRecursive(newCacheDir);
+   error = linkCacheFolder(oldCacheDir, newCacheDir);
    if (error)
    {
       LOG_ERROR(error);
@@ -51,7 +51,7 @@ SEXP rs_recordHtmlWidget(SEXP htmlFileSEXP, SEXP depFileSEXP, SEXP metadata)
    return R_NilValue;
 }
 
-bool copyLibFile(const FilePath& from, const FilePath& to,
+bool moveLibFile(const FilePath& from, const FilePath& to,
       const FilePath& path)
 {
    std::string relativePath = path.relativePath(from);
@@ -60,9 +60,11 @@ bool copyLibFile(const FilePath& from, const FilePath& to,
    if (target.exists())
        return true;
 
+   // the source library is removed once it's merged, so its files can be 
+   // moved into place rather than copied
    Error error = path.isDirectory() ?
                      target.ensureDirectory() :
-                     path.copy(target);
+                     path.move(target);
    if (error)
       LOG_ERROR(error);
    return true;
@@ -115,7 +117,7 @@ core::Error mergeLib(const core::FilePath& source,
                      const core::FilePath& target)
 {
    Error error = source.childrenRecursive(
-         boost::bind(copyLibFile, source, target, _2));
+         boost::bind(moveLibFile, source, target, _2));
 
    if (error) return error;
 
@@ -47,6 +47,8 @@ private:
 
 core::Error initHtmlWidgets();
 
+// merge the library folder source into target (files already present in 
+// target are kept); source is consumed by the merge
 core::Error mergeLib(const core::FilePath& source, 
                      const core::FilePath& target);
 
@@ -16,6 +16,7 @@
 #include "SessionRmdNotebook.hpp"
 #include "NotebookCache.hpp"
 #include "NotebookOutput.hpp"
+#include "NotebookOutputPack.hpp"
 #include "NotebookPlots.hpp"
 
 #include <boost/foreach.hpp>
@@ -25,6 +26,7 @@
 #include <core/Algorithm.hpp>
 #include <core/Base64.hpp>
 #include <core/Exec.hpp>
+#include <core/FileInfo.hpp>
 #include <core/FilePath.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/SafeConvert.hpp>
@@ -41,7 +43,10 @@
 #include <session/SessionUserSettings.hpp>
 #include <session/SessionModuleContext.hpp>
 
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <set>
 
 #define kRequestId    "request_id"
 #define kChunkOutputs "chunk_outputs"
@@ -62,6 +67,10 @@ namespace {
 typedef std::map<std::string, OutputPair> LastChunkOutput;
 LastChunkOutput s_lastChunkOutputs;
 
+// chunk output folders which we know have no output pack (because we've
+// removed it since the pack was last written)
+std::set<std::string> s_unpackedOutputDirs;
+
 ChunkOutputType chunkOutputType(const FilePath& outputPath)
 {
    ChunkOutputType outputType = ChunkOutputNone;
@@ -99,13 +108,8 @@ std::string chunkOutputExt(ChunkOutputType outputType)
    return "";
 }
 
-Error chunkConsoleContents(const FilePath& consoleFile, json::Array* pArray)
+void chunkConsoleContents(std::string contents, json::Array* pArray)
 {
-   std::string contents;
-   Error error = readStringFromFile(consoleFile, &contents);
-   if (error)
-      return error;
-
    // parse each line of the CSV file
    std::pair<std::vector<std::string>, std::string::iterator> line;
    line = text::parseCsvLine(contents.begin(), contents.end());
@@ -128,26 +132,93 @@ Error chunkConsoleContents(const FilePath& consoleFile, json::Array* pArray)
       // read next line
       line = text::parseCsvLine(line.second, contents.end());
    }
+}
+
+// read the contents of an output which are sent to the client inline
+Error readOutputContents(const FilePath& path, ChunkOutputType outputType,
+      PackedOutput* pOutput)
+{
+   pOutput->name = path.filename();
+   pOutput->outputType = outputType;
+
+   if (outputType == ChunkOutputError)
+   {
+      return readStringFromFile(path, &pOutput->contents);
+   }
+   else if (outputType == ChunkOutputText)
+   {
+      // console output which can't be read is sent as empty output
+      Error error = readStringFromFile(path, &pOutput->contents);
+      if (error)
+         LOG_ERROR(error);
+   }
 
    return Success();
 }
 
+// read the outputs in a chunk output folder from their individual files
+void readOutputs(const FilePath& outputDir,
+                 const std::vector<FilePath>& outputPaths,
+                 std::vector<PackedOutput>* pOutputs)
+{
+   // the folder's listing tells us which sidecar files exist, so we don't
+   // need to probe for them
+   std::set<std::string> names;
+   BOOST_FOREACH(const FilePath& outputPath, outputPaths)
+   {
+      names.insert(outputPath.filename());
+   }
+
+   BOOST_FOREACH(const FilePath& outputPath, outputPaths)
+   {
+      // ascertain chunk output type from file extension; skip if extension 
+      // unknown
+      ChunkOutputType outputType = chunkOutputType(outputPath);
+      if (outputType == ChunkOutputNone)
+         continue;
+
+      PackedOutput output;
+      Error error = readOutputContents(outputPath, outputType, &output);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      // extract ordinal from filename
+      output.ordinal = ::strtol(outputPath.stem().c_str(), NULL, 16);
+
+      // plots without a display list can't be resized
+      if (outputType == ChunkOutputPlot)
+         output.fixedSize = names.count(outputPath.stem() + kDisplayListExt) == 0;
+
+      // extract metadata if present
+      std::string metadataName = outputPath.stem() + ".metadata";
+      if (names.count(metadataName))
+      {
+         error = readStringFromFile(outputDir.complete(metadataName),
+               &output.metadata);
+         if (error)
+            LOG_ERROR(error);
+      }
+
+      pOutputs->push_back(output);
+   }
+}
+
 Error fillOutputObject(const std::string& docId, const std::string& chunkId,
-      const std::string& nbCtxId, unsigned ordinal, ChunkOutputType outputType, 
-      const FilePath& path, json::Object* pObj)
+      const std::string& nbCtxId, const FilePath& path,
+      const PackedOutput& output, json::Object* pObj)
 {
+   ChunkOutputType outputType = output.outputType;
    (*pObj)[kChunkOutputType]    = static_cast<int>(outputType);
-   (*pObj)[kChunkOutputOrdinal] = static_cast<int>(ordinal);
+   (*pObj)[kChunkOutputOrdinal] = static_cast<int>(output.ordinal);
 
    if (outputType == ChunkOutputError)
    {
-      // error outputs can be directly read from the file
-      std::string fileContents;
+      // error outputs are stored as JSON
       json::Value errorVal;
-      Error error = core::readStringFromFile(path, &fileContents);
-      if (error)
-         return error;
-      if (!json::parse(fileContents, &errorVal))
+      if (!json::parse(output.contents, &errorVal))
          return Error(json::errc::ParseError, ERROR_LOCATION);
 
      (*pObj)[kChunkOutputValue] = errorVal;
@@ -156,7 +227,7 @@ Error fillOutputObject(const std::string& docId, const std::string& chunkId,
    {
       // deserialize console output
       json::Array consoleOutput;
-      Error error = chunkConsoleContents(path, &consoleOutput);
+      chunkConsoleContents(output.contents, &consoleOutput);
       (*pObj)[kChunkOutputValue] = consoleOutput;
    }
    else if (outputType == ChunkOutputPlot || outputType == ChunkOutputHtml)
@@ -164,18 +235,12 @@ Error fillOutputObject(const std::string& docId, const std::string& chunkId,
       // plot/HTML outputs should be requested by the client, so pass the path
       std::string url(kChunkOutputPath "/" + nbCtxId + "/" + 
                          docId + "/" + chunkId + "/" + 
-                         path.filename());
+                         output.name);
 
       // if this is a plot and it doesn't have a display list, hint to client
       // that plot can't be resized
-      if (outputType == ChunkOutputPlot)
-      {
-         // form the path to where we'd expect the snapshot to be
-         FilePath snapshotPath = path.parent().complete(
-               path.stem() + kDisplayListExt);
-         if (!snapshotPath.exists())
-            url.append("?fixed_size=1");
-      }
+      if (outputType == ChunkOutputPlot && output.fixedSize)
+         url.append("?fixed_size=1");
 
       (*pObj)[kChunkOutputValue] = url;
    }
@@ -419,7 +484,18 @@ FilePath chunkOutputFile(const std::string& docId,
                          const std::string& nbCtxId,
                          const OutputPair& output)
 {
-   return chunkOutputPath(docId, chunkId, nbCtxId, ContextExact).complete(
+   FilePath outputDir = chunkOutputPath(docId, chunkId, nbCtxId, ContextExact);
+
+   // an output is about to be written, so any pack describing the folder is
+   // now out of date
+   if (s_unpackedOutputDirs.insert(outputDir.absolutePath()).second)
+   {
+      Error error = removeOutputPack(outputDir);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   return outputDir.complete(
          (boost::format("%|1$06x|%2%") 
                      % (output.ordinal % MAX_ORDINAL)
                      % chunkOutputExt(output.outputType)).str());
@@ -452,9 +528,24 @@ void enqueueChunkOutput(const std::string& docId,
       ChunkOutputType outputType, const FilePath& path, 
       const core::json::Value& metadata)
 {
+   PackedOutput packed;
+   Error error = readOutputContents(path, outputType, &packed);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+   packed.ordinal = ordinal;
+   if (outputType == ChunkOutputPlot)
+   {
+      // form the path to where we'd expect the snapshot to be
+      FilePath snapshotPath = path.parent().complete(
+            path.stem() + kDisplayListExt);
+      packed.fixedSize = !snapshotPath.exists();
+   }
+
    json::Object output;
-   Error error = fillOutputObject(docId, chunkId, nbCtxId, ordinal, outputType, 
-         path, &output);
+   error = fillOutputObject(docId, chunkId, nbCtxId, path, packed, &output);
    if (error)
    {
       LOG_ERROR(error);
@@ -488,47 +579,53 @@ Error enqueueChunkOutput(
    // object for the client
    if (outputDir.exists())
    {
-      Error error = outputDir.children(&outputPaths);
+      // list the folder's files along with their sizes and write times
+      // (which validate the pack)
+      std::vector<FileInfo> outputFiles;
+      Error error = listOutputFiles(outputDir, &outputFiles);
       if (error) 
          LOG_ERROR(error);
+      std::transform(outputFiles.begin(), outputFiles.end(),
+                     std::back_inserter(outputPaths), toFilePath);
 
       // arrange by filename (use FilePath's < operator)
       std::sort(outputPaths.begin(), outputPaths.end());
 
-      // loop through each and build an array of the outputs
-      BOOST_FOREACH(const FilePath& outputPath, outputPaths)
+      // read the outputs from the folder's pack if it's up to date; otherwise
+      // read them from their files and pack them for next time
+      std::vector<PackedOutput> packed;
+      bool found = false;
+      error = readOutputPack(outputDir, outputFiles, &packed, &found);
+      if (error)
+         LOG_ERROR(error);
+      if (!found)
       {
-         json::Object output;
-
-         // ascertain chunk output type from file extension; skip if extension 
-         // unknown
-         ChunkOutputType outputType = chunkOutputType(outputPath);
-         if (outputType == ChunkOutputNone)
-            continue;
+         readOutputs(outputDir, outputPaths, &packed);
+         error = writeOutputPack(outputDir, outputFiles, packed);
+         if (error)
+            LOG_ERROR(error);
+         else
+            s_unpackedOutputDirs.erase(outputDir.absolutePath());
+      }
 
-         // extract ordinal from filename
-         unsigned ordinal = ::strtol(outputPath.stem().c_str(), NULL, 16);
+      // loop through each and build an array of the outputs
+      BOOST_FOREACH(const PackedOutput& output, packed)
+      {
+         json::Object outputObj;
 
          // extract metadata if present
          json::Value meta;
-         FilePath metadata = outputDir.complete(
-               outputPath.stem() + ".metadata");
-         if (metadata.exists())
-         {
-            std::string contents;
-            error = readStringFromFile(metadata, &contents);
-            if (!contents.empty())
-               json::parse(contents, &meta);
-         }
-         output[kChunkOutputMetadata] = meta;
+         if (!output.metadata.empty())
+            json::parse(output.metadata, &meta);
+         outputObj[kChunkOutputMetadata] = meta;
          
          // format/parse chunk output for client consumption
-         error = fillOutputObject(docId, chunkId, ctxId, ordinal, outputType, 
-               outputPath, &output);
+         error = fillOutputObject(docId, chunkId, ctxId,
+               outputDir.complete(output.name), output, &outputObj);
          if (error)
             LOG_ERROR(error);
          else
-            outputs.push_back(output);
+            outputs.push_back(outputObj);
       }
    }
    
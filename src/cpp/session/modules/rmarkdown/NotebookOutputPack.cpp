@@ -0,0 +1,289 @@
+/*
+ * NotebookOutputPack.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "NotebookOutputPack.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <core/Error.hpp>
+#include <core/FileInfo.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/system/FileScanner.hpp>
+#include <core/system/System.hpp>
+
+// the pack is laid out as:
+//
+//    header line
+//    listing line (the folder's files as <name>:<size>:<mtime>, separated by '/')
+//    count line
+//    one index line per output:
+//       <ordinal> <type> <fixed-size> <offset> <metadata-size> <contents-size> <name>
+//    data (each output's metadata followed by its contents, at <offset>)
+#define kOutputPackHeader "rnb-output-pack 1"
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace rmarkdown {
+namespace notebook {
+
+namespace {
+
+FilePath outputPackFile(const FilePath& outputDir)
+{
+   return outputDir.childPath(kOutputPackFile);
+}
+
+Error invalidPackError(const FilePath& packFile, const ErrorLocation& location)
+{
+   Error error = systemError(boost::system::errc::illegal_byte_sequence,
+                             location);
+   error.addProperty("path", packFile);
+   return error;
+}
+
+// the listing the pack is validated against; dotfiles (the pack itself and
+// any temporary files used to write it) are excluded. the size and write
+// time of each file are included so that outputs written after the pack
+// (e.g. console output appended while the chunk is still running) make it
+// out of date
+std::string packListing(const std::vector<FileInfo>& outputFiles)
+{
+   std::vector<std::string> entries;
+   BOOST_FOREACH(const FileInfo& outputFile, outputFiles)
+   {
+      std::string name = FilePath(outputFile.absolutePath()).filename();
+      if (!name.empty() && name[0] != '.')
+      {
+         entries.push_back(
+                  name + ":" +
+                  safe_convert::numberToString(outputFile.size()) + ":" +
+                  safe_convert::numberToString(outputFile.lastWriteTime()));
+      }
+   }
+   std::sort(entries.begin(), entries.end());
+
+   std::string listing;
+   BOOST_FOREACH(const std::string& entry, entries)
+   {
+      if (!listing.empty())
+         listing.push_back('/');
+      listing.append(entry);
+   }
+   return listing;
+}
+
+bool nextLine(const std::string& contents, std::size_t* pPos, std::string* pLine)
+{
+   std::size_t end = contents.find('\n', *pPos);
+   if (end == std::string::npos)
+      return false;
+   *pLine = contents.substr(*pPos, end - *pPos);
+   *pPos = end + 1;
+   return true;
+}
+
+bool parseIndexLine(const std::string& line,
+                    std::size_t* pOffset,
+                    std::size_t* pMetadataSize,
+                    std::size_t* pContentsSize,
+                    PackedOutput* pOutput)
+{
+   std::istringstream is(line);
+   int outputType = 0;
+   int fixedSize = 0;
+   is >> pOutput->ordinal >> outputType >> fixedSize
+      >> *pOffset >> *pMetadataSize >> *pContentsSize;
+   if (is.fail() || is.get() != ' ')
+      return false;
+   std::getline(is, pOutput->name);
+   if (pOutput->name.empty())
+      return false;
+
+   pOutput->outputType = static_cast<ChunkOutputType>(outputType);
+   pOutput->fixedSize = fixedSize != 0;
+   return true;
+}
+
+} // anonymous namespace
+
+Error listOutputFiles(const FilePath& outputDir,
+                      std::vector<FileInfo>* pOutputFiles)
+{
+   // the scanner reads each entry's attributes as it lists the folder
+   core::system::FileScannerOptions options;
+   options.recursive = false;
+   tree<FileInfo> files;
+   Error error = core::system::scanFiles(
+            FileInfo(outputDir.absolutePath(), true), options, &files);
+   if (error)
+      return error;
+
+   for (tree<FileInfo>::sibling_iterator it = files.begin(files.begin());
+        it != files.end(files.begin());
+        ++it)
+   {
+      pOutputFiles->push_back(*it);
+   }
+   return Success();
+}
+
+Error readOutputPack(const FilePath& outputDir,
+                     const std::vector<FileInfo>& outputFiles,
+                     std::vector<PackedOutput>* pOutputs,
+                     bool* pFound)
+{
+   *pFound = false;
+   pOutputs->clear();
+
+   // the pack is among the folder's files if it exists, so we don't need
+   // to ask the file system about it separately
+   FilePath packFile = outputPackFile(outputDir);
+   if (std::find_if(outputFiles.begin(),
+                    outputFiles.end(),
+                    boost::bind(fileInfoHasPath,
+                                _1,
+                                packFile.absolutePath())) ==
+       outputFiles.end())
+   {
+      return Success();
+   }
+
+   std::string contents;
+   Error error = readStringFromFile(packFile, &contents);
+   if (error)
+      return error;
+
+   std::size_t pos = 0;
+   std::string line;
+   if (!nextLine(contents, &pos, &line) || line != kOutputPackHeader)
+      return invalidPackError(packFile, ERROR_LOCATION);
+
+   // a pack built from different files is out of date; this is
+   // expected (e.g. outputs were added by R or by an older version) so it
+   // isn't an error
+   if (!nextLine(contents, &pos, &line))
+      return invalidPackError(packFile, ERROR_LOCATION);
+   if (line != packListing(outputFiles))
+      return Success();
+
+   if (!nextLine(contents, &pos, &line))
+      return invalidPackError(packFile, ERROR_LOCATION);
+   std::size_t count = safe_convert::stringTo<std::size_t>(line, 0);
+
+   std::vector<PackedOutput> outputs;
+   std::vector<std::size_t> offsets, metadataSizes, contentsSizes;
+   for (std::size_t i = 0; i < count; i++)
+   {
+      PackedOutput output;
+      std::size_t offset, metadataSize, contentsSize;
+      if (!nextLine(contents, &pos, &line) ||
+          !parseIndexLine(line, &offset, &metadataSize, &contentsSize, &output))
+      {
+         return invalidPackError(packFile, ERROR_LOCATION);
+      }
+      outputs.push_back(output);
+      offsets.push_back(offset);
+      metadataSizes.push_back(metadataSize);
+      contentsSizes.push_back(contentsSize);
+   }
+
+   // the index is followed by the data section, which is read in place
+   std::size_t dataSize = contents.size() - pos;
+   for (std::size_t i = 0; i < count; i++)
+   {
+      if (offsets[i] > dataSize ||
+          metadataSizes[i] > dataSize - offsets[i] ||
+          contentsSizes[i] > dataSize - offsets[i] - metadataSizes[i])
+      {
+         return invalidPackError(packFile, ERROR_LOCATION);
+      }
+      std::size_t start = pos + offsets[i];
+      outputs[i].metadata = contents.substr(start, metadataSizes[i]);
+      outputs[i].contents = contents.substr(start + metadataSizes[i],
+                                            contentsSizes[i]);
+   }
+
+   pOutputs->swap(outputs);
+   *pFound = true;
+   return Success();
+}
+
+Error writeOutputPack(const FilePath& outputDir,
+                      const std::vector<FileInfo>& outputFiles,
+                      const std::vector<PackedOutput>& outputs)
+{
+   std::ostringstream index;
+   std::string data;
+   BOOST_FOREACH(const PackedOutput& output, outputs)
+   {
+      index << output.ordinal << " "
+            << static_cast<int>(output.outputType) << " "
+            << (output.fixedSize ? 1 : 0) << " "
+            << data.size() << " "
+            << output.metadata.size() << " "
+            << output.contents.size() << " "
+            << output.name << "\n";
+      data.append(output.metadata);
+      data.append(output.contents);
+   }
+
+   std::string pack;
+   pack.append(kOutputPackHeader "\n");
+   pack.append(packListing(outputFiles) + "\n");
+   pack.append(safe_convert::numberToString(outputs.size()) + "\n");
+   pack.append(index.str());
+   pack.append(data);
+
+   // write the pack under a temporary name and move it into place, so that a
+   // partially written pack is never read
+   FilePath packFile = outputPackFile(outputDir);
+   FilePath tempFile = outputDir.childPath(
+            packFile.filename() + "-" + core::system::generateShortenedUuid());
+   Error error = writeStringToFile(tempFile, pack);
+   if (error)
+      return error;
+
+   error = tempFile.move(packFile, FilePath::MoveDirect);
+   if (error)
+   {
+      Error removeError = tempFile.removeIfExists();
+      if (removeError)
+         LOG_ERROR(removeError);
+      return error;
+   }
+
+   return Success();
+}
+
+Error removeOutputPack(const FilePath& outputDir)
+{
+   return outputPackFile(outputDir).removeIfExists();
+}
+
+} // namespace notebook
+} // namespace rmarkdown
+} // namespace modules
+} // namespace session
+} // namespace rstudio
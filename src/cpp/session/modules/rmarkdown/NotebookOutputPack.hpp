@@ -0,0 +1,102 @@
+/*
+ * NotebookOutputPack.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+
+#ifndef SESSION_NOTEBOOK_OUTPUT_PACK_HPP
+#define SESSION_NOTEBOOK_OUTPUT_PACK_HPP
+
+#include <string>
+#include <vector>
+
+#include "NotebookOutput.hpp"
+
+// name of the pack file inside a chunk output folder; it's a dotfile so that
+// it's ignored by code which enumerates the outputs themselves (including the
+// R code which builds .nb.html files from the cache)
+#define kOutputPackFile ".outputs"
+
+namespace rstudio {
+namespace core {
+   class FilePath;
+   class FileInfo;
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace rmarkdown {
+namespace notebook {
+
+// a single chunk output as recorded in an output pack
+struct PackedOutput
+{
+   PackedOutput() :
+      ordinal(0), outputType(ChunkOutputNone), fixedSize(false)
+   {}
+
+   // name of the output's file inside the chunk output folder
+   std::string name;
+   unsigned ordinal;
+   ChunkOutputType outputType;
+
+   // true for plots which have no display list (and so can't be resized)
+   bool fixedSize;
+
+   // serialized JSON metadata (empty if the output has none)
+   std::string metadata;
+
+   // contents of console and error outputs; other output types are served
+   // from (or read by R from) their files, so their contents aren't packed
+   std::string contents;
+};
+
+// Chunk outputs are written as individual files in the chunk's output folder,
+// which is what the client, the plot replayer and the notebook builder
+// consume. Replaying a chunk from those files costs several file operations
+// per output, so the first replay of a chunk packs its outputs (and their
+// metadata) into a single file which later replays read in one pass. The pack
+// records the folder listing it was built from (including each file's size
+// and write time) and is ignored once the listing changes; writers of chunk
+// outputs also remove it explicitly.
+
+// list the files in a chunk output folder, along with their sizes and write
+// times (read with a single stat of each file)
+core::Error listOutputFiles(const core::FilePath& outputDir,
+                            std::vector<core::FileInfo>* pOutputFiles);
+
+// read the pack in the given chunk output folder (given its listing); pFound
+// is set to false if there's no pack or it doesn't describe the folder's
+// current contents
+core::Error readOutputPack(const core::FilePath& outputDir,
+                           const std::vector<core::FileInfo>& outputFiles,
+                           std::vector<PackedOutput>* pOutputs,
+                           bool* pFound);
+
+// write a pack describing the given outputs of a chunk output folder
+core::Error writeOutputPack(const core::FilePath& outputDir,
+                            const std::vector<core::FileInfo>& outputFiles,
+                            const std::vector<PackedOutput>& outputs);
+
+core::Error removeOutputPack(const core::FilePath& outputDir);
+
+} // namespace notebook
+} // namespace rmarkdown
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif
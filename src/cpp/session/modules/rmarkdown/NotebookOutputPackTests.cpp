@@ -0,0 +1,177 @@
+/*
+ * NotebookOutputPackTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "NotebookOutputPack.hpp"
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+#include <core/Error.hpp>
+#include <core/FileInfo.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace rmarkdown {
+namespace notebook {
+namespace tests {
+
+using namespace rstudio::core;
+
+namespace {
+
+FilePath createOutputDir()
+{
+   FilePath outputDir;
+   REQUIRE(!FilePath::tempFilePath(&outputDir));
+   REQUIRE(!outputDir.ensureDirectory());
+   REQUIRE(!writeStringToFile(outputDir.childPath("000001.csv"), "1,\"a\"\n"));
+   REQUIRE(!writeStringToFile(outputDir.childPath("000002.png"), "png"));
+   REQUIRE(!writeStringToFile(outputDir.childPath("000002.metadata"), "{}"));
+   return outputDir;
+}
+
+std::vector<PackedOutput> testOutputs()
+{
+   std::vector<PackedOutput> outputs;
+
+   PackedOutput console;
+   console.name = "000001.csv";
+   console.ordinal = 1;
+   console.outputType = ChunkOutputText;
+   console.contents = "1,\"a\"\n1,\"line with\nnewline\"\n";
+   outputs.push_back(console);
+
+   PackedOutput plot;
+   plot.name = "000002.png";
+   plot.ordinal = 2;
+   plot.outputType = ChunkOutputPlot;
+   plot.fixedSize = true;
+   plot.metadata = "{\"height\": 5, \"width\": 7}";
+   outputs.push_back(plot);
+
+   return outputs;
+}
+
+std::vector<FileInfo> listing(const FilePath& outputDir)
+{
+   std::vector<FileInfo> files;
+   REQUIRE(!listOutputFiles(outputDir, &files));
+   return files;
+}
+
+} // anonymous namespace
+
+TEST_CASE("notebook output packs")
+{
+   SECTION("outputs round trip through a pack")
+   {
+      FilePath outputDir = createOutputDir();
+      std::vector<PackedOutput> outputs = testOutputs();
+      REQUIRE(!writeOutputPack(outputDir, listing(outputDir), outputs));
+
+      std::vector<PackedOutput> read;
+      bool found = false;
+      REQUIRE(!readOutputPack(outputDir, listing(outputDir), &read, &found));
+      REQUIRE(found);
+      REQUIRE(read.size() == outputs.size());
+      for (std::size_t i = 0; i < outputs.size(); i++)
+      {
+         CHECK(read[i].name == outputs[i].name);
+         CHECK(read[i].ordinal == outputs[i].ordinal);
+         CHECK(read[i].outputType == outputs[i].outputType);
+         CHECK(read[i].fixedSize == outputs[i].fixedSize);
+         CHECK(read[i].metadata == outputs[i].metadata);
+         CHECK(read[i].contents == outputs[i].contents);
+      }
+
+      outputDir.remove();
+   }
+
+   SECTION("packs are ignored when the folder changes")
+   {
+      FilePath outputDir = createOutputDir();
+      REQUIRE(!writeOutputPack(outputDir, listing(outputDir), testOutputs()));
+
+      REQUIRE(!writeStringToFile(outputDir.childPath("000003.html"), "html"));
+
+      std::vector<PackedOutput> read;
+      bool found = true;
+      REQUIRE(!readOutputPack(outputDir, listing(outputDir), &read, &found));
+      CHECK(!found);
+      CHECK(read.empty());
+
+      outputDir.remove();
+   }
+
+   SECTION("packs are ignored when an output is appended to")
+   {
+      FilePath outputDir = createOutputDir();
+      REQUIRE(!writeOutputPack(outputDir, listing(outputDir), testOutputs()));
+
+      // as when console output is written after a replay mid-run
+      REQUIRE(!appendToFile(outputDir.childPath("000001.csv"), "1,\"b\"\n"));
+
+      std::vector<PackedOutput> read;
+      bool found = true;
+      REQUIRE(!readOutputPack(outputDir, listing(outputDir), &read, &found));
+      CHECK(!found);
+
+      outputDir.remove();
+   }
+
+   SECTION("folders without a pack")
+   {
+      FilePath outputDir = createOutputDir();
+      REQUIRE(!writeOutputPack(outputDir, listing(outputDir), testOutputs()));
+      REQUIRE(!removeOutputPack(outputDir));
+
+      std::vector<PackedOutput> read;
+      bool found = true;
+      REQUIRE(!readOutputPack(outputDir, listing(outputDir), &read, &found));
+      CHECK(!found);
+
+      outputDir.remove();
+   }
+
+   SECTION("damaged packs are rejected")
+   {
+      FilePath outputDir = createOutputDir();
+      REQUIRE(!writeOutputPack(outputDir, listing(outputDir), testOutputs()));
+
+      // truncate the data section
+      FilePath packFile = outputDir.childPath(kOutputPackFile);
+      std::string contents;
+      REQUIRE(!readStringFromFile(packFile, &contents));
+      REQUIRE(!writeStringToFile(packFile,
+                                 contents.substr(0, contents.size() - 10)));
+
+      std::vector<PackedOutput> read;
+      bool found = true;
+      CHECK(readOutputPack(outputDir, listing(outputDir), &read, &found));
+      CHECK(!found);
+
+      outputDir.remove();
+   }
+}
+
+} // namespace tests
+} // namespace notebook
+} // namespace rmarkdown
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -466,11 +466,14 @@ void ProjectContext::onDeferredInit(bool newSession)
                             this, _1);
    cb.onUnregistered = bind(&ProjectContext::fileMonitorTermination,
                             this, Success());
+   // (the listings read are saved in the scratch path, so that when the
+   // project is next opened only directories which have changed are re-read)
    core::system::file_monitor::registerMonitor(
-                                         directory(),
-                                         true,
-                                         module_context::fileListingFilter,
-                                         cb);
+                                 directory(),
+                                 true,
+                                 module_context::fileListingFilter,
+                                 cb,
+                                 scratchPath().childPath("file_monitor_snapshot"));
 }
 
 void ProjectContext::fileMonitorRegistered(